@@ -0,0 +1,72 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/AdaptiveSubscriber.h"
+
+namespace rsocket {
+
+std::shared_ptr<AdaptiveSubscriber> AdaptiveSubscriber::create(
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber,
+    Options options) {
+  return std::make_shared<AdaptiveSubscriber>(
+      std::move(subscriber), std::move(options));
+}
+
+AdaptiveSubscriber::AdaptiveSubscriber(
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber,
+    Options options)
+    : subscriber_(std::move(subscriber)), window_(std::move(options)) {
+  CHECK(subscriber_);
+}
+
+void AdaptiveSubscriber::onSubscribeImpl() {
+  std::weak_ptr<AdaptiveSubscriber> weak = ref_from_this(this);
+  subscriber_->onSubscribe(yarpl::flowable::Subscription::create([weak] {
+    if (auto self = weak.lock()) {
+      self->cancel();
+    }
+  }));
+  request(static_cast<int64_t>(
+      window_.start(AdaptiveRequestWindow::Clock::now())));
+}
+
+void AdaptiveSubscriber::onNextImpl(Payload payload) {
+  // Top up the credit before handing the item over, so the producer does not
+  // wait on the application.
+  if (auto const credit =
+          window_.onDelivered(AdaptiveRequestWindow::Clock::now())) {
+    request(static_cast<int64_t>(credit));
+  }
+  if (subscriber_) {
+    subscriber_->onNext(std::move(payload));
+  }
+}
+
+void AdaptiveSubscriber::onCompleteImpl() {
+  if (auto subscriber = std::move(subscriber_)) {
+    subscriber->onComplete();
+  }
+}
+
+void AdaptiveSubscriber::onErrorImpl(folly::exception_wrapper ew) {
+  if (auto subscriber = std::move(subscriber_)) {
+    subscriber->onError(std::move(ew));
+  }
+}
+
+void AdaptiveSubscriber::onTerminateImpl() {
+  subscriber_ = nullptr;
+}
+
+} // namespace rsocket
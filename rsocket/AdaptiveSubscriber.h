@@ -0,0 +1,64 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "rsocket/Payload.h"
+#include "rsocket/internal/AdaptiveRequestWindow.h"
+#include "yarpl/flowable/Subscriber.h"
+
+namespace rsocket {
+
+/// Subscriber adapter that requests credit on behalf of the subscriber it
+/// wraps, sizing the outstanding REQUEST_N with an AdaptiveRequestWindow.
+///
+/// Use it instead of requesting one item at a time, which is bound by the
+/// round trip time, or requesting kNoFlowControl, which lets the producer
+/// queue up without bounds:
+///
+///   requester->requestStream(std::move(request))
+///       ->subscribe(AdaptiveSubscriber::create(std::move(subscriber)));
+///
+/// The wrapped subscriber's request() calls are ignored, since the adapter
+/// owns the stream's credit.  Its cancel() calls cancel the stream.
+/// Items must be delivered on a single thread, as they are by RSocket.
+class AdaptiveSubscriber : public yarpl::flowable::BaseSubscriber<Payload> {
+ public:
+  using Options = AdaptiveRequestWindow::Options;
+
+  static std::shared_ptr<AdaptiveSubscriber> create(
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber,
+      Options options = Options());
+
+  AdaptiveSubscriber(
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber,
+      Options options);
+
+  const AdaptiveRequestWindow& window() const {
+    return window_;
+  }
+
+ protected:
+  void onSubscribeImpl() override;
+  void onNextImpl(Payload) override;
+  void onCompleteImpl() override;
+  void onErrorImpl(folly::exception_wrapper) override;
+  void onTerminateImpl() override;
+
+ private:
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber_;
+  AdaptiveRequestWindow window_;
+};
+
+} // namespace rsocket
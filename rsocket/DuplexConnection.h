@@ -15,7 +15,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include <folly/Function.h>
 #include <folly/io/IOBuf.h>
 
 #include "yarpl/flowable/Subscriber.h"
@@ -41,6 +43,14 @@ class DuplexConnection {
  public:
   using Subscriber = yarpl::flowable::Subscriber<std::unique_ptr<folly::IOBuf>>;
 
+  /// Input subscriber which can also consume all the frames parsed out of a
+  /// single read in one call.  Connections which cut a byte stream into frames
+  /// deliver through onNextBatch() when their input implements it.
+  class BatchSubscriber : public Subscriber {
+   public:
+    virtual void onNextBatch(std::vector<std::unique_ptr<folly::IOBuf>>) = 0;
+  };
+
   virtual ~DuplexConnection() = default;
 
   /// Sets a Subscriber that will consume received frames (a reader).
@@ -58,6 +68,22 @@ class DuplexConnection {
   virtual bool isFramed() const {
     return false;
   }
+
+  /// Bytes passed to send() which are still buffered in userspace, because the
+  /// underlying socket couldn't take them yet.  Connections which don't buffer
+  /// report zero.
+  virtual size_t getQueuedWriteBytes() const {
+    return 0;
+  }
+
+  /// Call `callback` once getQueuedWriteBytes() has dropped to `threshold` or
+  /// below, which may be right away.  Replaces a previously set callback.  The
+  /// callback is dropped if the connection closes first.
+  virtual void setWriteDrainedCallback(
+      size_t /* threshold */,
+      folly::Function<void()> callback) {
+    callback();
+  }
 };
 
 } // namespace rsocket
@@ -0,0 +1,299 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/HedgingRequester.h"
+
+#include <folly/io/async/HHWheelTimer.h>
+
+#include <atomic>
+
+#include "rsocket/RSocketClient.h"
+#include "rsocket/RSocketRequester.h"
+#include "rsocket/internal/RequestPolicy.h"
+#include "rsocket/internal/ScheduledSingleObserver.h"
+#include "rsocket/internal/ScheduledSingleSubscription.h"
+
+namespace rsocket {
+
+struct HedgingRequesterState {
+  HedgingRequesterState(
+      std::vector<std::shared_ptr<RSocketClient>> c,
+      folly::EventBase& evb,
+      HedgingRequester::Options o)
+      : clients(std::move(c)),
+        eventBase(evb),
+        options(std::move(o)),
+        budget(options.budgetRatio, options.maxBudget),
+        latencies(options.latencyWindow) {}
+
+  const std::vector<std::shared_ptr<RSocketClient>> clients;
+  folly::EventBase& eventBase;
+  const HedgingRequester::Options options;
+
+  // Only touched on the EventBase.
+  RetryBudget budget;
+  LatencyWindow latencies;
+  size_t nextClient{0};
+
+  std::atomic<size_t> requests{0};
+  std::atomic<size_t> hedges{0};
+  std::atomic<size_t> hedgeWins{0};
+  std::atomic<size_t> retries{0};
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool isRetryable(
+    const HedgingRequester::Options& options,
+    const folly::exception_wrapper& ew) {
+  if (options.retryable) {
+    return options.retryable(ew);
+  }
+  return !ew.with_exception([](const ErrorWithPayload&) {});
+}
+
+/// One request, sent as one or more attempts.  Lives on the requester's
+/// EventBase, and is its own hedge timer.
+class HedgedCall : public yarpl::single::SingleSubscription,
+                   public folly::HHWheelTimer::Callback,
+                   public std::enable_shared_from_this<HedgedCall> {
+ public:
+  HedgedCall(
+      std::shared_ptr<HedgingRequesterState> state,
+      Payload request,
+      std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer)
+      : state_(std::move(state)),
+        request_(std::move(request)),
+        observer_(std::move(observer)) {}
+
+  void start() {
+    ++state_->requests;
+    state_->budget.deposit();
+    firstClient_ = state_->nextClient++;
+    start_ = Clock::now();
+
+    observer_->onSubscribe(std::make_shared<ScheduledSingleSubscription>(
+        shared_from_this(), state_->eventBase));
+    if (done_) {
+      return;
+    }
+    startAttempt();
+    if (!done_ && state_->options.maxHedges > 0) {
+      scheduleHedge();
+    }
+  }
+
+  void cancel() override {
+    if (!done_) {
+      finish();
+    }
+  }
+
+  void onAttemptSubscribe(
+      size_t index,
+      std::shared_ptr<yarpl::single::SingleSubscription> subscription) {
+    if (done_ || attempts_[index].finished) {
+      subscription->cancel();
+      return;
+    }
+    attempts_[index].subscription = std::move(subscription);
+  }
+
+  void onAttemptSuccess(size_t index, Payload response) {
+    auto& attempt = attempts_[index];
+    attempt.finished = true;
+    attempt.subscription = nullptr;
+    --inFlight_;
+    if (done_) {
+      return;
+    }
+
+    // Timed from the first attempt: a hedge that wins cuts the wait short,
+    // but the original would have taken at least this long.  Timing only the
+    // winner would leave the slow responses out, and pull the hedge delay
+    // down with every hedge that wins.
+    state_->latencies.add(std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - start_));
+    if (attempt.hedge) {
+      ++state_->hedgeWins;
+    }
+    finish()->onSuccess(std::move(response));
+  }
+
+  void onAttemptError(size_t index, folly::exception_wrapper ew) {
+    auto& attempt = attempts_[index];
+    attempt.finished = true;
+    attempt.subscription = nullptr;
+    --inFlight_;
+    if (done_) {
+      return;
+    }
+
+    if (retries_ < state_->options.maxRetries &&
+        isRetryable(state_->options, ew) && state_->budget.tryWithdraw()) {
+      ++retries_;
+      ++state_->retries;
+      startAttempt();
+      return;
+    }
+    // A hedge may still succeed.
+    if (inFlight_ == 0) {
+      finish()->onError(std::move(ew));
+    }
+  }
+
+ private:
+  struct Attempt {
+    std::shared_ptr<yarpl::single::SingleSubscription> subscription;
+    bool hedge{false};
+    bool finished{false};
+  };
+
+  class AttemptObserver : public yarpl::single::SingleObserver<Payload> {
+   public:
+    AttemptObserver(std::shared_ptr<HedgedCall> call, size_t index)
+        : call_(std::move(call)), index_(index) {}
+
+    void onSubscribe(std::shared_ptr<yarpl::single::SingleSubscription>
+                         subscription) override {
+      call_->onAttemptSubscribe(index_, std::move(subscription));
+    }
+
+    void onSuccess(Payload response) override {
+      call_->onAttemptSuccess(index_, std::move(response));
+    }
+
+    void onError(folly::exception_wrapper ew) override {
+      call_->onAttemptError(index_, std::move(ew));
+    }
+
+   private:
+    const std::shared_ptr<HedgedCall> call_;
+    const size_t index_;
+  };
+
+  void startAttempt(bool hedge = false) {
+    auto const index = attempts_.size();
+    Attempt attempt;
+    attempt.hedge = hedge;
+    attempts_.push_back(std::move(attempt));
+    ++inFlight_;
+
+    // Every attempt goes to the next client, away from the ones that are
+    // slow or failing.
+    auto const& clients = state_->clients;
+    auto const& client = clients[(firstClient_ + index) % clients.size()];
+    client->getRequester()
+        ->requestResponse(request_.clone())
+        ->subscribe(std::make_shared<ScheduledSingleObserver<Payload>>(
+            std::make_shared<AttemptObserver>(shared_from_this(), index),
+            state_->eventBase));
+  }
+
+  void scheduleHedge() {
+    auto const& options = state_->options;
+    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+        state_->latencies.percentile(options.hedgePercentile)
+            .value_or(options.initialHedgeDelay));
+    delay = std::max(delay, options.minHedgeDelay);
+
+    state_->eventBase.timer().scheduleTimeout(this, delay);
+  }
+
+  void timeoutExpired() noexcept override {
+    // The new attempt may finish the call, and drop the last reference to it.
+    auto const self = shared_from_this();
+    if (done_ || hedges_ >= state_->options.maxHedges ||
+        !state_->budget.tryWithdraw()) {
+      return;
+    }
+    ++hedges_;
+    ++state_->hedges;
+    startAttempt(true /* hedge */);
+    if (!done_ && hedges_ < state_->options.maxHedges) {
+      scheduleHedge();
+    }
+  }
+
+  void callbackCanceled() noexcept override {}
+
+  /// Cancels the hedge timer and the attempts still in flight, and hands
+  /// back the observer.
+  std::shared_ptr<yarpl::single::SingleObserver<Payload>> finish() {
+    done_ = true;
+    cancelTimeout();
+    for (auto& attempt : attempts_) {
+      if (auto subscription = std::move(attempt.subscription)) {
+        subscription->cancel();
+      }
+    }
+    return std::move(observer_);
+  }
+
+  const std::shared_ptr<HedgingRequesterState> state_;
+  const Payload request_;
+  std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer_;
+
+  std::vector<Attempt> attempts_;
+  Clock::time_point start_;
+  size_t firstClient_{0};
+  size_t inFlight_{0};
+  size_t hedges_{0};
+  size_t retries_{0};
+  bool done_{false};
+};
+
+} // namespace
+
+HedgingRequester::HedgingRequester(
+    std::vector<std::shared_ptr<RSocketClient>> clients,
+    folly::EventBase& eventBase,
+    Options options)
+    : state_(std::make_shared<HedgingRequesterState>(
+          std::move(clients),
+          eventBase,
+          std::move(options))) {
+  CHECK(!state_->clients.empty());
+}
+
+HedgingRequester::~HedgingRequester() = default;
+
+std::shared_ptr<yarpl::single::Single<Payload>>
+HedgingRequester::requestResponse(Payload request) {
+  return yarpl::single::Single<Payload>::create(
+      [state = state_, req = std::move(request)](
+          std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
+        auto call = std::make_shared<HedgedCall>(
+            state, req.clone(), std::move(observer));
+        if (state->eventBase.isInEventBaseThread()) {
+          call->start();
+        } else {
+          state->eventBase.runInEventBaseThread(
+              [call = std::move(call)] { call->start(); });
+        }
+      });
+}
+
+HedgingRequester::Counters HedgingRequester::counters() const {
+  Counters counters;
+  counters.requests = state_->requests.load();
+  counters.hedges = state_->hedges.load();
+  counters.hedgeWins = state_->hedgeWins.load();
+  counters.retries = state_->retries.load();
+  return counters;
+}
+
+} // namespace rsocket
@@ -0,0 +1,115 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/io/async/EventBase.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "rsocket/Payload.h"
+#include "yarpl/Single.h"
+
+namespace rsocket {
+
+class RSocketClient;
+struct HedgingRequesterState;
+
+/// Sends request/responses through a set of RSocketClients connected to
+/// equivalent servers, hedging against slow servers and retrying failed
+/// requests.
+///
+/// A request goes to one client, chosen round robin.  If no response has
+/// arrived once the request has waited longer than a percentile of recent
+/// response times, a copy is sent through the next client, and whichever
+/// responds first wins; the others are cancelled.  A request that fails is
+/// sent again through the next client.  Hedges and retries both draw from a
+/// RetryBudget, so that they stay a small share of the load.
+///
+/// Only use it for requests that are safe to process more than once.
+///
+///   HedgingRequester requester(clients, eventBase);
+///   requester.requestResponse(Payload("request"))->subscribe(observer);
+///
+/// Bookkeeping happens on `eventBase`, where the observer is called.  Requests
+/// may be made, and cancelled, from any thread.
+class HedgingRequester {
+ public:
+  struct Options {
+    /// Copies of a request sent while no response has arrived, at most.
+    size_t maxHedges{1};
+
+    /// A copy is sent once the request has waited for longer than this
+    /// percentile of the recent response times.
+    double hedgePercentile{0.95};
+
+    /// Wait used before enough response times have been seen.
+    std::chrono::milliseconds initialHedgeDelay{10};
+
+    /// Never hedge sooner than this.
+    std::chrono::milliseconds minHedgeDelay{1};
+
+    /// Number of recent response times the percentile is taken over.  A
+    /// request's response time runs from its first attempt, whichever
+    /// attempt answers.
+    size_t latencyWindow{1000};
+
+    /// Times a request is sent again after it failed, at most.
+    size_t maxRetries{1};
+
+    /// Whether a failed request is worth sending again.  By default every
+    /// error is, except for the responder's application errors.
+    std::function<bool(const folly::exception_wrapper&)> retryable;
+
+    /// Every request adds this much to the budget for hedges and retries...
+    double budgetRatio{0.1};
+
+    /// ...which holds this many at most.
+    double maxBudget{10};
+  };
+
+  HedgingRequester(
+      std::vector<std::shared_ptr<RSocketClient>> clients,
+      folly::EventBase& eventBase,
+      Options options = Options());
+
+  ~HedgingRequester();
+
+  HedgingRequester(const HedgingRequester&) = delete;
+  HedgingRequester& operator=(const HedgingRequester&) = delete;
+
+  std::shared_ptr<yarpl::single::Single<Payload>> requestResponse(
+      Payload request);
+
+  struct Counters {
+    size_t requests{0};
+    size_t hedges{0};
+    /// Requests answered first by a hedge rather than by the original.
+    size_t hedgeWins{0};
+    size_t retries{0};
+  };
+
+  /// May be called from any thread.
+  Counters counters() const;
+
+ private:
+  /// Shared with the requests in flight, which can outlive the requester.
+  const std::shared_ptr<HedgingRequesterState> state_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,45 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "rsocket/LeaseSender.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "rsocket/framing/Frame.h"
+
+namespace rsocket {
+
+LoadBasedLeaseSender::LoadBasedLeaseSender(Options options)
+    : options_(std::move(options)) {
+  CHECK_GT(options_.ttl.count(), 0);
+  CHECK_GT(options_.renewalInterval.count(), 0);
+}
+
+std::chrono::milliseconds LoadBasedLeaseSender::renewalInterval() const {
+  return options_.renewalInterval;
+}
+
+folly::Optional<Lease> LoadBasedLeaseSender::nextLease(size_t activeStreams) {
+  if (activeStreams >= options_.maxConcurrentStreams) {
+    return folly::none;
+  }
+
+  auto const available = std::min<size_t>(
+      options_.maxConcurrentStreams - activeStreams,
+      Frame_LEASE::kMaxNumRequests);
+  return Lease{options_.ttl, static_cast<uint32_t>(available)};
+}
+
+} // namespace rsocket
@@ -0,0 +1,82 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace rsocket {
+
+/// A lease granted by a responder: the requester may start up to
+/// `numberOfRequests` new requests within `ttl` of receiving it.
+struct Lease {
+  std::chrono::milliseconds ttl;
+  uint32_t numberOfRequests;
+};
+
+/// Server-side policy that decides which LEASE frames to send to a client that
+/// asked for leases in its SETUP frame.
+///
+/// The RSocketStateMachine asks for a new lease once when the connection is
+/// set up, and then every renewalInterval().  Each granted lease replaces the
+/// previous one.  Requests arriving without a valid lease are rejected with a
+/// REJECTED error.
+///
+/// A LeaseSender may be shared between connections, in which case it must be
+/// thread-safe.
+class LeaseSender {
+ public:
+  virtual ~LeaseSender() = default;
+
+  /// How often a fresh lease is requested from this policy.
+  virtual std::chrono::milliseconds renewalInterval() const = 0;
+
+  /// Returns the lease to grant next, given the number of streams the
+  /// requester currently has open on the connection.  Returning folly::none
+  /// skips this renewal and leaves the previous lease (if any) in place.
+  virtual folly::Optional<Lease> nextLease(size_t activeStreams) = 0;
+};
+
+/// Grants each connection as many new requests as it has free slots below a
+/// fixed concurrency limit, so a loaded connection gets smaller leases and a
+/// saturated one gets none.
+class LoadBasedLeaseSender : public LeaseSender {
+ public:
+  struct Options {
+    /// Maximum number of streams a single connection should have in flight.
+    size_t maxConcurrentStreams{1000};
+
+    /// How long each granted lease stays valid.
+    std::chrono::milliseconds ttl{std::chrono::seconds(5)};
+
+    /// How often a new lease is issued.  Should be shorter than the TTL so the
+    /// requester never runs dry while it is under the limit.
+    std::chrono::milliseconds renewalInterval{std::chrono::seconds(1)};
+  };
+
+  explicit LoadBasedLeaseSender(Options options);
+
+  std::chrono::milliseconds renewalInterval() const override;
+
+  folly::Optional<Lease> nextLease(size_t activeStreams) override;
+
+ private:
+  const Options options_;
+};
+
+} // namespace rsocket
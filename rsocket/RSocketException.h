@@ -33,4 +33,10 @@ class ResumptionException : public RSocketException {
 class ConnectionException : public RSocketException {
   using RSocketException::RSocketException;
 };
+
+// Delivered to a request's subscriber when the request's deadline passed
+// before it completed.  The request has been cancelled.
+class DeadlineExceededException : public RSocketException {
+  using RSocketException::RSocketException;
+};
 } // namespace rsocket
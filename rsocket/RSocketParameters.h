@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <folly/Optional.h>
+
 #include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,6 +27,8 @@
 
 namespace rsocket {
 
+class StreamStatePool;
+
 using OnRSocketResume =
     std::function<bool(std::vector<StreamId>, std::vector<StreamId>)>;
 
@@ -56,6 +61,27 @@ class SetupParameters : public RSocketParameters {
   std::string dataMimeType;
   Payload payload;
   ResumeIdentificationToken token;
+
+  /// Whether the requester honors leases, i.e. it will only send requests
+  /// permitted by LEASE frames from the responder.
+  bool lease{false};
+
+  /// Local setting, not sent in SETUP.  Largest payload fragment this client
+  /// writes, see StreamsWriterImpl::setMaxFragmentSize().
+  folly::Optional<size_t> maxFragmentSize;
+
+  /// Local setting, not sent in SETUP.  Budget for the frames held while the
+  /// connection is disconnected or resuming, see PendingOutputLimit.
+  PendingOutputLimit pendingOutputLimit;
+
+  /// Local setting, not sent in SETUP.  Makes the streams this side consumes
+  /// prefetch, see RequestNWatermarks.
+  RequestNWatermarks requestNWatermarks;
+
+  /// Local setting, not sent in SETUP.  Recycles the memory of stream state
+  /// machines, see StreamStatePool.  The connection gets a pool of its own
+  /// when this is not set.
+  std::shared_ptr<StreamStatePool> streamStatePool;
 };
 
 std::ostream& operator<<(std::ostream&, const SetupParameters&);
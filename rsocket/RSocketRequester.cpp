@@ -16,8 +16,10 @@
 
 #include <folly/ExceptionWrapper.h>
 
+#include "rsocket/internal/DeadlineSubscriber.h"
 #include "rsocket/internal/ScheduledSingleObserver.h"
 #include "rsocket/internal/ScheduledSubscriber.h"
+#include "rsocket/internal/SubmissionQueue.h"
 #include "yarpl/Flowable.h"
 #include "yarpl/single/SingleSubscriptions.h"
 
@@ -25,23 +27,12 @@ using namespace folly;
 
 namespace rsocket {
 
-namespace {
-
-template <class Fn>
-void runOnCorrectThread(folly::EventBase& evb, Fn fn) {
-  if (evb.isInEventBaseThread()) {
-    fn();
-  } else {
-    evb.runInEventBaseThread(std::move(fn));
-  }
-}
-
-} // namespace
-
 RSocketRequester::RSocketRequester(
     std::shared_ptr<RSocketStateMachine> srs,
     EventBase& eventBase)
-    : stateMachine_{std::move(srs)}, eventBase_{&eventBase} {}
+    : stateMachine_{std::move(srs)},
+      eventBase_{&eventBase},
+      submissions_{std::make_shared<SubmissionQueue>(eventBase)} {}
 
 RSocketRequester::~RSocketRequester() {
   VLOG(1) << "Destroying RSocketRequester";
@@ -58,7 +49,8 @@ std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
 RSocketRequester::requestChannel(
     std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
         requestStream) {
-  return requestChannel({}, false, std::move(requestStream));
+  return requestChannel(
+      {}, false, std::move(requestStream), StreamPriority());
 }
 
 std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
@@ -66,7 +58,17 @@ RSocketRequester::requestChannel(
     Payload request,
     std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
         requestStream) {
-  return requestChannel(std::move(request), true, std::move(requestStream));
+  return requestChannel(
+      std::move(request), true, std::move(requestStream), StreamPriority());
+}
+
+std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
+RSocketRequester::requestChannel(
+    Payload request,
+    std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requestStream,
+    StreamPriority priority) {
+  return requestChannel(
+      std::move(request), true, std::move(requestStream), priority);
 }
 
 std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
@@ -74,7 +76,8 @@ RSocketRequester::requestChannel(
     Payload request,
     bool hasInitialRequest,
     std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
-        requestStreamFlowable) {
+        requestStreamFlowable,
+    StreamPriority priority) {
   CHECK(stateMachine_);
 
   return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
@@ -82,19 +85,22 @@ RSocketRequester::requestChannel(
        req = std::move(request),
        hasInitialRequest,
        requestStream = std::move(requestStreamFlowable),
-       srs = stateMachine_](
+       srs = stateMachine_,
+       submissions = submissions_,
+       priority](
           std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
         auto lambda = [eb,
                        r = req.clone(),
                        hasInitialRequest,
                        requestStream,
                        srs,
+                       priority,
                        subs = std::move(subscriber)]() mutable {
           auto scheduled =
               std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
                   std::move(subs), *eb);
           auto responseSink = srs->requestChannel(
-              std::move(r), hasInitialRequest, std::move(scheduled));
+              std::move(r), hasInitialRequest, std::move(scheduled), priority);
           // responseSink is wrapped with thread scheduling
           // so all emissions happen on the right thread.
 
@@ -108,74 +114,143 @@ RSocketRequester::requestChannel(
             requestStream->subscribe(std::move(scheduledResponse));
           }
         };
-        runOnCorrectThread(*eb, std::move(lambda));
+        submissions->run(std::move(lambda));
       });
 }
 
 std::shared_ptr<yarpl::flowable::Flowable<Payload>>
 RSocketRequester::requestStream(Payload request) {
+  return requestStream(std::move(request), StreamPriority());
+}
+
+std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+RSocketRequester::requestStream(Payload request, StreamPriority priority) {
+  return requestStreamWithDeadline(
+      std::move(request), priority, std::chrono::milliseconds::zero());
+}
+
+std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+RSocketRequester::requestStreamWithDeadline(
+    Payload request,
+    StreamPriority priority,
+    std::chrono::milliseconds timeout) {
   CHECK(stateMachine_);
 
   return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
-      [eb = eventBase_, req = std::move(request), srs = stateMachine_](
+      [eb = eventBase_,
+       req = std::move(request),
+       srs = stateMachine_,
+       submissions = submissions_,
+       priority,
+       timeout](
           std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
-        auto lambda =
-            [eb, r = req.clone(), srs, subs = std::move(subscriber)]() mutable {
-              auto scheduled =
-                  std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
-                      std::move(subs), *eb);
-              srs->requestStream(std::move(r), std::move(scheduled));
-            };
-        runOnCorrectThread(*eb, std::move(lambda));
+        auto lambda = [eb,
+                       r = req.clone(),
+                       srs,
+                       priority,
+                       timeout,
+                       subs = std::move(subscriber)]() mutable {
+          std::shared_ptr<yarpl::flowable::Subscriber<Payload>> scheduled =
+              std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
+                  std::move(subs), *eb);
+          if (timeout > std::chrono::milliseconds::zero()) {
+            scheduled = std::make_shared<DeadlineSubscriber>(
+                std::move(scheduled), *eb, timeout);
+            srs->addRequestDeadline(r, timeout);
+          }
+          srs->requestStream(std::move(r), std::move(scheduled), priority);
+        };
+        submissions->run(std::move(lambda));
       });
 }
 
 std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
 RSocketRequester::requestResponse(Payload request) {
+  return requestResponse(std::move(request), StreamPriority());
+}
+
+std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
+RSocketRequester::requestResponse(Payload request, StreamPriority priority) {
+  return requestResponseWithDeadline(
+      std::move(request), priority, std::chrono::milliseconds::zero());
+}
+
+std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
+RSocketRequester::requestResponseWithDeadline(
+    Payload request,
+    StreamPriority priority,
+    std::chrono::milliseconds timeout) {
   CHECK(stateMachine_);
 
   return yarpl::single::Single<Payload>::create(
-      [eb = eventBase_, req = std::move(request), srs = stateMachine_](
+      [eb = eventBase_,
+       req = std::move(request),
+       srs = stateMachine_,
+       submissions = submissions_,
+       priority,
+       timeout](
           std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
         auto lambda = [eb,
                        r = req.clone(),
                        srs,
+                       priority,
+                       timeout,
                        obs = std::move(observer)]() mutable {
-          auto scheduled =
+          std::shared_ptr<yarpl::single::SingleObserver<Payload>> scheduled =
               std::make_shared<ScheduledSubscriptionSingleObserver<Payload>>(
                   std::move(obs), *eb);
-          srs->requestResponse(std::move(r), std::move(scheduled));
+          if (timeout > std::chrono::milliseconds::zero()) {
+            scheduled = std::make_shared<DeadlineSingleObserver>(
+                std::move(scheduled), *eb, timeout);
+            srs->addRequestDeadline(r, timeout);
+          }
+          srs->requestResponse(std::move(r), std::move(scheduled), priority);
         };
-        runOnCorrectThread(*eb, std::move(lambda));
+        submissions->run(std::move(lambda));
       });
 }
 
 std::shared_ptr<yarpl::single::Single<void>> RSocketRequester::fireAndForget(
     rsocket::Payload request) {
+  return fireAndForget(std::move(request), StreamPriority());
+}
+
+std::shared_ptr<yarpl::single::Single<void>> RSocketRequester::fireAndForget(
+    rsocket::Payload request,
+    StreamPriority priority) {
   CHECK(stateMachine_);
 
   return yarpl::single::Single<void>::create(
-      [eb = eventBase_, req = std::move(request), srs = stateMachine_](
+      [req = std::move(request),
+       srs = stateMachine_,
+       submissions = submissions_,
+       priority](
           std::shared_ptr<yarpl::single::SingleObserverBase<void>> subscriber) {
-        auto lambda =
-            [r = req.clone(), srs, subs = std::move(subscriber)]() mutable {
-              // TODO: Pass in SingleSubscriber for underlying layers to call
-              // onSuccess/onError once put on network.
-              srs->fireAndForget(std::move(r));
-              subs->onSubscribe(yarpl::single::SingleSubscriptions::empty());
-              subs->onSuccess();
-            };
-        runOnCorrectThread(*eb, std::move(lambda));
+        auto lambda = [r = req.clone(),
+                       srs,
+                       priority,
+                       subs = std::move(subscriber)]() mutable {
+          // TODO: Pass in SingleSubscriber for underlying layers to call
+          // onSuccess/onError once put on network.
+          srs->fireAndForget(std::move(r), priority);
+          subs->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+          subs->onSuccess();
+        };
+        submissions->run(std::move(lambda));
       });
 }
 
 void RSocketRequester::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
   CHECK(stateMachine_);
 
-  runOnCorrectThread(
-      *eventBase_, [srs = stateMachine_, meta = std::move(metadata)]() mutable {
+  submissions_->run(
+      [srs = stateMachine_, meta = std::move(metadata)]() mutable {
         srs->metadataPush(std::move(meta));
       });
 }
 
+RttStats RSocketRequester::getRttStats() const {
+  return stateMachine_ ? stateMachine_->getRttStats() : RttStats();
+}
+
 } // namespace rsocket
@@ -20,6 +20,7 @@
 #include "yarpl/Single.h"
 
 #include "rsocket/Payload.h"
+#include "rsocket/internal/SubmissionQueue.h"
 #include "rsocket/statemachine/RSocketStateMachine.h"
 
 namespace rsocket {
@@ -66,6 +67,27 @@ class RSocketRequester {
   virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
   requestStream(rsocket::Payload request);
 
+  /**
+   * As requestStream, with the priority of the stream's outgoing frames.
+   * @see StreamPriority
+   */
+  virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
+  requestStream(rsocket::Payload request, StreamPriority priority);
+
+  /**
+   * As requestStream, with a deadline for the whole stream.  If the stream
+   * has not completed `timeout` after it was subscribed to, it is cancelled
+   * and the subscriber gets a DeadlineExceededException.  If the connection's
+   * metadata is composite ("message/x.rsocket.composite-metadata.v0"), the
+   * responder is told the deadline and cancels the stream on its side too.
+   * A timeout that isn't positive means no deadline.
+   */
+  virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
+  requestStreamWithDeadline(
+      rsocket::Payload request,
+      StreamPriority priority,
+      std::chrono::milliseconds timeout);
+
   /**
    * Start a channel (streams in both directions).
    *
@@ -87,6 +109,16 @@ class RSocketRequester {
       Payload request,
       std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requests);
 
+  /**
+   * As requestChannel, with the priority of the stream's outgoing frames.
+   * @see StreamPriority
+   */
+  virtual std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>>
+  requestChannel(
+      Payload request,
+      std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requests,
+      StreamPriority priority);
+
   /**
    * Send a single request and get a single response.
    *
@@ -96,6 +128,27 @@ class RSocketRequester {
   virtual std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
   requestResponse(rsocket::Payload request);
 
+  /**
+   * As requestResponse, with the priority of the stream's outgoing frames.
+   * @see StreamPriority
+   */
+  virtual std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
+  requestResponse(rsocket::Payload request, StreamPriority priority);
+
+  /**
+   * As requestResponse, with a deadline for the response.  If no response
+   * arrived `timeout` after the request was subscribed to, it is cancelled
+   * and the observer gets a DeadlineExceededException.  If the connection's
+   * metadata is composite ("message/x.rsocket.composite-metadata.v0"), the
+   * responder is told the deadline and cancels the request on its side too.
+   * A timeout that isn't positive means no deadline.
+   */
+  virtual std::shared_ptr<yarpl::single::Single<rsocket::Payload>>
+  requestResponseWithDeadline(
+      rsocket::Payload request,
+      StreamPriority priority,
+      std::chrono::milliseconds timeout);
+
   /**
    * Send a single Payload with no response.
    *
@@ -111,11 +164,26 @@ class RSocketRequester {
   virtual std::shared_ptr<yarpl::single::Single<void>> fireAndForget(
       rsocket::Payload request);
 
+  /**
+   * As fireAndForget, with the priority of the request's frames.
+   * @see StreamPriority
+   */
+  virtual std::shared_ptr<yarpl::single::Single<void>> fireAndForget(
+      rsocket::Payload request,
+      StreamPriority priority);
+
   /**
    * Send metadata without response.
    */
   virtual void metadataPush(std::unique_ptr<folly::IOBuf> metadata);
 
+  /**
+   * Round trip times measured with the connection's keepalives.  Only clients
+   * send keepalives, so a server's requester has no samples.  May be called
+   * from any thread.
+   */
+  virtual RttStats getRttStats() const;
+
   virtual void closeSocket();
 
  protected:
@@ -123,9 +191,14 @@ class RSocketRequester {
   requestChannel(
       Payload request,
       bool hasInitialRequest,
-      std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requests);
+      std::shared_ptr<yarpl::flowable::Flowable<rsocket::Payload>> requests,
+      StreamPriority priority);
 
   std::shared_ptr<rsocket::RSocketStateMachine> stateMachine_;
   folly::EventBase* eventBase_;
+
+  /// Carries requests made off the EventBase thread over to it.  Shared with
+  /// the requests' lambdas, which may be subscribed after the requester died.
+  std::shared_ptr<SubmissionQueue> submissions_;
 };
 } // namespace rsocket
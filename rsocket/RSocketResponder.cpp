@@ -39,6 +39,23 @@ void RSocketResponderCore::handleRequestResponse(
       std::logic_error("handleRequestResponse not implemented"));
 }
 
+void RSocketResponderCore::handleRequestStreamWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::shared_ptr<Subscriber<Payload>> response,
+    std::chrono::steady_clock::time_point) noexcept {
+  handleRequestStream(std::move(request), streamId, std::move(response));
+}
+
+void RSocketResponderCore::handleRequestResponseWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::shared_ptr<SingleObserver<Payload>> responseObserver,
+    std::chrono::steady_clock::time_point) noexcept {
+  handleRequestResponse(
+      std::move(request), streamId, std::move(responseObserver));
+}
+
 void RSocketResponderCore::handleFireAndForget(Payload, StreamId) {
   // No default implementation, no error response to provide.
 }
@@ -65,6 +82,14 @@ std::shared_ptr<Single<Payload>> RSocketResponder::handleRequestResponse(
       std::logic_error("handleRequestResponse not implemented"));
 }
 
+std::shared_ptr<Single<Payload>>
+RSocketResponder::handleRequestResponseWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::chrono::steady_clock::time_point) {
+  return handleRequestResponse(std::move(request), streamId);
+}
+
 std::shared_ptr<Flowable<Payload>> RSocketResponder::handleRequestStream(
     Payload,
     StreamId) {
@@ -72,6 +97,14 @@ std::shared_ptr<Flowable<Payload>> RSocketResponder::handleRequestStream(
       std::logic_error("handleRequestStream not implemented"));
 }
 
+std::shared_ptr<Flowable<Payload>>
+RSocketResponder::handleRequestStreamWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::chrono::steady_clock::time_point) {
+  return handleRequestStream(std::move(request), streamId);
+}
+
 std::shared_ptr<Flowable<Payload>> RSocketResponder::handleRequestChannel(
     Payload,
     std::shared_ptr<Flowable<Payload>>,
@@ -177,6 +210,16 @@ void RSocketResponderAdapter::handleRequestStream(
   flowable->subscribe(std::move(response));
 }
 
+void RSocketResponderAdapter::handleRequestStreamWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::shared_ptr<Subscriber<Payload>> response,
+    std::chrono::steady_clock::time_point deadline) noexcept {
+  auto flowable = inner_->handleRequestStreamWithDeadline(
+      std::move(request), streamId, deadline);
+  flowable->subscribe(std::move(response));
+}
+
 /// Handles a new inbound RequestResponse requested by the other end.
 void RSocketResponderAdapter::handleRequestResponse(
     Payload request,
@@ -186,6 +229,16 @@ void RSocketResponderAdapter::handleRequestResponse(
   single->subscribe(std::move(responseObserver));
 }
 
+void RSocketResponderAdapter::handleRequestResponseWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::shared_ptr<SingleObserver<Payload>> responseObserver,
+    std::chrono::steady_clock::time_point deadline) noexcept {
+  auto single = inner_->handleRequestResponseWithDeadline(
+      std::move(request), streamId, deadline);
+  single->subscribe(std::move(responseObserver));
+}
+
 void RSocketResponderAdapter::handleFireAndForget(
     Payload request,
     StreamId streamId) {
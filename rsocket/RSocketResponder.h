@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "rsocket/Payload.h"
 #include "rsocket/framing/FrameHeader.h"
 #include "yarpl/Flowable.h"
@@ -40,11 +42,27 @@ class RSocketResponderCore {
       StreamId streamId,
       std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response) noexcept;
 
+  /// Called instead of handleRequestStream, for a request the requester gave
+  /// a deadline.  The stream is cancelled once the deadline passes.
+  virtual void handleRequestStreamWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response,
+      std::chrono::steady_clock::time_point deadline) noexcept;
+
   virtual void handleRequestResponse(
       Payload request,
       StreamId streamId,
       std::shared_ptr<yarpl::single::SingleObserver<Payload>>
           response) noexcept;
+
+  /// Called instead of handleRequestResponse, for a request the requester
+  /// gave a deadline.  The request is cancelled once the deadline passes.
+  virtual void handleRequestResponseWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::shared_ptr<yarpl::single::SingleObserver<Payload>> response,
+      std::chrono::steady_clock::time_point deadline) noexcept;
 };
 
 /**
@@ -79,6 +97,19 @@ class RSocketResponder {
       Payload request,
       StreamId streamId);
 
+  /**
+   * Called instead of the above when the requester gave the request a
+   * deadline.  The request is cancelled once the deadline passes, so work
+   * that can't finish in time is better not started.
+   *
+   * Calls the variant without the deadline by default.
+   */
+  virtual std::shared_ptr<yarpl::single::Single<Payload>>
+  handleRequestResponseWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::chrono::steady_clock::time_point deadline);
+
   /**
    * Called when a new `requestStream` occurs from an RSocketRequester.
    *
@@ -87,6 +118,18 @@ class RSocketResponder {
   virtual std::shared_ptr<yarpl::flowable::Flowable<Payload>>
   handleRequestStream(Payload request, StreamId streamId);
 
+  /**
+   * Called instead of the above when the requester gave the stream a
+   * deadline.  The stream is cancelled once the deadline passes.
+   *
+   * Calls the variant without the deadline by default.
+   */
+  virtual std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+  handleRequestStreamWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::chrono::steady_clock::time_point deadline);
+
   /**
    * Called when a new `requestChannel` occurs from an RSocketRequester.
    *
@@ -136,6 +179,11 @@ class RSocketResponderAdapter : public RSocketResponderCore {
       StreamId streamId,
       std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response) noexcept
       override;
+  void handleRequestStreamWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response,
+      std::chrono::steady_clock::time_point deadline) noexcept override;
 
   /// Internal method for handling request-response requests, not intended to be
   /// used by application code.
@@ -144,6 +192,11 @@ class RSocketResponderAdapter : public RSocketResponderCore {
       StreamId streamId,
       std::shared_ptr<yarpl::single::SingleObserver<Payload>> response) noexcept
       override;
+  void handleRequestResponseWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::shared_ptr<yarpl::single::SingleObserver<Payload>> response,
+      std::chrono::steady_clock::time_point deadline) noexcept override;
 
   void handleFireAndForget(Payload request, StreamId streamId) override;
   void handleMetadataPush(std::unique_ptr<folly::IOBuf> buf) override;
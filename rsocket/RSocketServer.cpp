@@ -170,6 +170,14 @@ void RSocketServer::onRSocketSetup(
                 "Received invalid Responder from server")));
     return;
   }
+  if (setupParams.lease && !connectionParams.leaseSender) {
+    VLOG(3) << "Terminating SETUP attempt from client.  Lease is not supported";
+    connection->send(
+        FrameSerializer::createFrameSerializer(setupParams.protocolVersion)
+            ->serializeOut(Frame_ERROR::unsupportedSetup(
+                "Server does not support leases")));
+    return;
+  }
   const auto rs = std::make_shared<RSocketStateMachine>(
       scheduledResponder
           ? std::make_shared<ScheduledRSocketResponder>(
@@ -193,6 +201,15 @@ void RSocketServer::onRSocketSetup(
     return;
   }
   rs->registerCloseCallback(connectionSet.get());
+  if (setupParams.lease) {
+    rs->setLeaseSender(std::move(connectionParams.leaseSender));
+  }
+  if (connectionParams.maxFragmentSize) {
+    rs->setMaxFragmentSize(*connectionParams.maxFragmentSize);
+  }
+  rs->setPendingOutputLimit(connectionParams.pendingOutputLimit);
+  rs->setRequestNWatermarks(connectionParams.requestNWatermarks);
+  rs->setStreamStatePool(std::move(connectionParams.streamStatePool));
 
   auto requester = std::make_shared<RSocketRequester>(rs, *eventBase);
   auto serverState = std::shared_ptr<RSocketServerState>(
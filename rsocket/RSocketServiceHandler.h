@@ -15,7 +15,9 @@
 #pragma once
 
 #include <folly/Expected.h>
+#include <folly/Optional.h>
 
+#include "rsocket/LeaseSender.h"
 #include "rsocket/RSocketConnectionEvents.h"
 #include "rsocket/RSocketException.h"
 #include "rsocket/RSocketParameters.h"
@@ -44,6 +46,20 @@ struct RSocketConnectionParams {
   std::shared_ptr<RSocketResponder> responder;
   std::shared_ptr<RSocketStats> stats;
   std::shared_ptr<RSocketConnectionEvents> connectionEvents;
+  // Policy for granting leases, used if the client asked for leases in its
+  // SETUP frame.  Such clients are rejected when this is not set.
+  std::shared_ptr<LeaseSender> leaseSender;
+  // Largest payload fragment written on the connection, see
+  // StreamsWriterImpl::setMaxFragmentSize().
+  folly::Optional<size_t> maxFragmentSize;
+  // Budget for the frames held while the connection is disconnected or
+  // resuming, see PendingOutputLimit.
+  PendingOutputLimit pendingOutputLimit;
+  // Makes the streams the server consumes prefetch, see RequestNWatermarks.
+  RequestNWatermarks requestNWatermarks;
+  // Recycles the memory of stream state machines, see StreamStatePool.  Each
+  // connection gets a pool of its own when this is not set.
+  std::shared_ptr<StreamStatePool> streamStatePool;
 };
 
 // This class has to be implemented by the application.  The methods can be
@@ -40,17 +40,26 @@ class NoopStats : public RSocketStats {
 
   void bytesWritten(size_t) override {}
   void bytesRead(size_t) override {}
+  void framesFlushed(size_t, size_t) override {}
+  void zeroCopyWrite(size_t) override {}
+  void zeroCopyUnavailable() override {}
   void frameWritten(FrameType) override {}
   void frameRead(FrameType) override {}
   void serverResume(folly::Optional<int64_t>, int64_t, int64_t, ResumeOutcome)
       override {}
   void resumeBufferChanged(int, int) override {}
   void streamBufferChanged(int64_t, int64_t) override {}
+  void pendingFramesDropped(size_t, size_t) override {}
 
   void resumeFailedNoState() override {}
 
   void keepaliveSent() override {}
   void keepaliveReceived() override {}
+  void rttMeasured(const RttStats&) override {}
+
+  void leaseSent(uint32_t) override {}
+  void leaseReceived(uint32_t) override {}
+  void requestRejectedWithoutLease() override {}
 
   static std::shared_ptr<NoopStats> instance() {
     static const auto singleton = std::make_shared<NoopStats>();
@@ -54,6 +54,14 @@ class RSocketStats {
       ResumeOutcome /* outcome */) {}
   virtual void bytesWritten(size_t /* bytes */) {}
   virtual void bytesRead(size_t /* bytes */) {}
+  /// A transport flushed `frames` serialized frames with a single write.
+  virtual void framesFlushed(size_t /* frames */, size_t /* bytes */) {}
+  /// A transport handed `bytes` to the kernel with MSG_ZEROCOPY.  Their
+  /// buffers stay pinned until the kernel reports the send complete.
+  virtual void zeroCopyWrite(size_t /* bytes */) {}
+  /// Zero-copy sends were requested but the socket doesn't support them, so
+  /// the transport copies instead.
+  virtual void zeroCopyUnavailable() {}
   virtual void frameWritten(FrameType /* frameType */) {}
   virtual void frameRead(FrameType /* frameType */) {}
   virtual void resumeBufferChanged(
@@ -62,9 +70,18 @@ class RSocketStats {
   virtual void streamBufferChanged(
       int64_t /* framesCountDelta */,
       int64_t /* dataSizeDelta */) {}
+  /// Frames held while the connection couldn't write them were dropped to
+  /// stay within the PendingOutputLimit.
+  virtual void pendingFramesDropped(size_t /* frames */, size_t /* bytes */) {}
   virtual void resumeFailedNoState() {}
   virtual void keepaliveSent() {}
   virtual void keepaliveReceived() {}
+  /// A keepalive response carried a new round trip time sample.
+  virtual void rttMeasured(const RttStats& /* stats */) {}
+  virtual void leaseSent(uint32_t /* numberOfRequests */) {}
+  virtual void leaseReceived(uint32_t /* numberOfRequests */) {}
+  /// A request was refused because the requester held no valid lease.
+  virtual void requestRejectedWithoutLease() {}
   virtual void unknownFrameReceived() {
   } // TODO(lehecka): add to all implementations
 };
@@ -0,0 +1,225 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/Exception.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <sys/socket.h>
+
+#include <limits>
+#include <string>
+
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+
+// Round trips between two threads over a shared memory channel, against the
+// same over a Unix domain socket pair.  Each benchmark iteration is one round
+// trip, so the reported time per iteration is the round trip latency.
+
+using namespace rsocket;
+
+namespace {
+
+/// Both ends of a connection, each driven by its own EventBase thread.
+struct Connections {
+  ~Connections() {
+    clientThread.getEventBase()->runInEventBaseThreadAndWait(
+        [this] { client.reset(); });
+    serverThread.getEventBase()->runInEventBaseThreadAndWait(
+        [this] { server.reset(); });
+  }
+
+  folly::ScopedEventBaseThread serverThread{"baseline-server"};
+  folly::ScopedEventBaseThread clientThread{"baseline-client"};
+  std::unique_ptr<DuplexConnection> server;
+  std::unique_ptr<DuplexConnection> client;
+};
+
+void makeShm(Connections& connections) {
+  auto endpoints = ShmDuplexConnection::createChannel();
+  connections.serverThread.getEventBase()->runInEventBaseThreadAndWait([&] {
+    connections.server = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.first),
+        *connections.serverThread.getEventBase());
+  });
+  connections.clientThread.getEventBase()->runInEventBaseThreadAndWait([&] {
+    connections.client = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.second),
+        *connections.clientThread.getEventBase());
+  });
+}
+
+void makeUnix(Connections& connections) {
+  int fds[2];
+  folly::checkUnixError(
+      ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), "socketpair() failed");
+  connections.serverThread.getEventBase()->runInEventBaseThreadAndWait([&] {
+    connections.server =
+        UnixConnectionFactory::createDuplexConnectionFromSocket(
+            folly::NetworkSocket::fromFd(fds[0]),
+            *connections.serverThread.getEventBase());
+  });
+  connections.clientThread.getEventBase()->runInEventBaseThreadAndWait([&] {
+    connections.client =
+        UnixConnectionFactory::createDuplexConnectionFromSocket(
+            folly::NetworkSocket::fromFd(fds[1]),
+            *connections.clientThread.getEventBase());
+  });
+}
+
+/// Echoes everything it receives back over the connection.
+class Echo : public DuplexConnection::Subscriber {
+ public:
+  explicit Echo(DuplexConnection& connection) : connection_(connection) {}
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> buf) override {
+    connection_.send(std::move(buf));
+  }
+
+  void onComplete() override {}
+  void onError(folly::exception_wrapper) override {}
+
+ private:
+  DuplexConnection& connection_;
+};
+
+/// Sends `total` messages, keeping `inFlight` of them outstanding, and posts
+/// `done` once every echo has come back.  Counts bytes rather than frames so
+/// it works over unframed connections too.
+class Pinger : public DuplexConnection::Subscriber {
+ public:
+  Pinger(
+      DuplexConnection& connection,
+      size_t total,
+      size_t messageLen,
+      size_t inFlight,
+      folly::Baton<>& done)
+      : connection_(connection),
+        total_(total),
+        inFlight_(inFlight),
+        done_(done),
+        message_(folly::IOBuf::copyBuffer(std::string(messageLen, 'a'))) {}
+
+  void start() {
+    while (sent_ < inFlight_ && sent_ < total_) {
+      sendOne();
+    }
+  }
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> buf) override {
+    received_ += buf->computeChainDataLength();
+    while (received_ >= message_->length()) {
+      received_ -= message_->length();
+      if (++completed_ == total_) {
+        done_.post();
+        return;
+      }
+      if (sent_ < total_) {
+        sendOne();
+      }
+    }
+  }
+
+  void onComplete() override {}
+  void onError(folly::exception_wrapper) override {}
+
+ private:
+  void sendOne() {
+    ++sent_;
+    connection_.send(message_->clone());
+  }
+
+  DuplexConnection& connection_;
+  const size_t total_;
+  const size_t inFlight_;
+  folly::Baton<>& done_;
+  const std::unique_ptr<folly::IOBuf> message_;
+
+  size_t sent_{0};
+  size_t completed_{0};
+  size_t received_{0};
+};
+
+void roundTrips(
+    size_t n,
+    size_t messageLen,
+    size_t inFlight,
+    void (*makeConnections)(Connections&)) {
+  std::unique_ptr<Connections> connections;
+  std::shared_ptr<Pinger> pinger;
+  folly::Baton<> done;
+
+  BENCHMARK_SUSPEND {
+    connections = std::make_unique<Connections>();
+    makeConnections(*connections);
+    connections->serverThread.getEventBase()->runInEventBaseThreadAndWait(
+        [&] {
+          auto& server = *connections->server;
+          server.setInput(std::make_shared<Echo>(server));
+        });
+    pinger = std::make_shared<Pinger>(
+        *connections->client, n, messageLen, inFlight, done);
+    connections->clientThread.getEventBase()->runInEventBaseThreadAndWait(
+        [&] { connections->client->setInput(pinger); });
+  }
+
+  connections->clientThread.getEventBase()->runInEventBaseThread(
+      [&] { pinger->start(); });
+  done.wait();
+
+  BENCHMARK_SUSPEND {
+    connections.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_Baseline_Unix_Latency_32B, n) {
+  roundTrips(n, 32, 1, makeUnix);
+}
+BENCHMARK_RELATIVE(BM_Baseline_Shm_Latency_32B, n) {
+  roundTrips(n, 32, 1, makeShm);
+}
+BENCHMARK(BM_Baseline_Unix_Latency_128B, n) {
+  roundTrips(n, 128, 1, makeUnix);
+}
+BENCHMARK_RELATIVE(BM_Baseline_Shm_Latency_128B, n) {
+  roundTrips(n, 128, 1, makeShm);
+}
+BENCHMARK(BM_Baseline_Unix_Latency_4kB, n) {
+  roundTrips(n, 4096, 1, makeUnix);
+}
+BENCHMARK_RELATIVE(BM_Baseline_Shm_Latency_4kB, n) {
+  roundTrips(n, 4096, 1, makeShm);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(BM_Baseline_Unix_Pipelined_16x32B, n) {
+  roundTrips(n, 32, 16, makeUnix);
+}
+BENCHMARK_RELATIVE(BM_Baseline_Shm_Pipelined_16x32B, n) {
+  roundTrips(n, 32, 16, makeShm);
+}
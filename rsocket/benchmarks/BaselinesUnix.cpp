@@ -0,0 +1,307 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+#include "yarpl/Single.h"
+
+// The raw socket benchmarks mirror the ones in BaselinesTcp.cpp, so the two
+// binaries' numbers compare directly.  The RSocket benchmarks then show what
+// is left of the difference once a full request/response goes over each
+// transport.
+
+#define MAX_MESSAGE_LENGTH (8 * 1024)
+
+using namespace rsocket;
+
+namespace {
+
+std::string socketPath() {
+  return folly::to<std::string>("/tmp/rsocket-baselines-", ::getpid(), ".sock");
+}
+
+sockaddr_un makeAddress(const std::string& path) {
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return addr;
+}
+
+} // namespace
+
+static void BM_Baseline_UNIX_SendReceive(
+    size_t loadSize,
+    size_t msgLength,
+    size_t recvLength) {
+  std::atomic<bool> accepting{false};
+  std::atomic<bool> accepted{false};
+  const auto path = socketPath();
+
+  std::thread t([&]() {
+    int serverSock = socket(AF_UNIX, SOCK_STREAM, 0);
+    int sock = -1;
+    auto addr = makeAddress(path);
+    std::array<char, MAX_MESSAGE_LENGTH> message = {};
+
+    if (serverSock < 0) {
+      perror("acceptor socket");
+      return;
+    }
+
+    unlink(path.c_str());
+    if (bind(
+            serverSock,
+            reinterpret_cast<struct sockaddr*>(&addr),
+            sizeof(addr)) < 0) {
+      perror("bind");
+      return;
+    }
+
+    if (listen(serverSock, 1) < 0) {
+      perror("listen");
+      return;
+    }
+
+    accepting.store(true);
+
+    if ((sock = accept(serverSock, nullptr, nullptr)) < 0) {
+      perror("accept");
+      return;
+    }
+
+    accepted.store(true);
+
+    size_t sentBytes = 0;
+    while (sentBytes < loadSize) {
+      if (send(sock, message.data(), msgLength, 0) !=
+          static_cast<ssize_t>(msgLength)) {
+        perror("send");
+        return;
+      }
+      sentBytes += msgLength;
+    }
+
+    close(sock);
+    close(serverSock);
+    unlink(path.c_str());
+  });
+
+  while (!accepting) {
+    std::this_thread::yield();
+  }
+
+  const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  const auto addr = makeAddress(path);
+  std::array<char, MAX_MESSAGE_LENGTH> message = {};
+
+  if (sock < 0) {
+    perror("connector socket");
+    return;
+  }
+
+  if (connect(
+          sock,
+          reinterpret_cast<const struct sockaddr*>(&addr),
+          sizeof(addr)) < 0) {
+    perror("connect");
+    return;
+  }
+
+  while (!accepted) {
+    std::this_thread::yield();
+  }
+
+  size_t receivedBytes = 0;
+  while (receivedBytes < loadSize) {
+    const ssize_t recved = recv(sock, message.data(), recvLength, 0);
+
+    if (recved < 0) {
+      perror("recv");
+      return;
+    }
+
+    receivedBytes += recved;
+  }
+
+  close(sock);
+  t.join();
+}
+
+BENCHMARK(BM_Baseline_UNIX_Throughput_100MB_s40B_r1024B, n) {
+  (void)n;
+  constexpr size_t loadSizeB = 100 * 1024 * 1024;
+  constexpr size_t sendSizeB = 40;
+  constexpr size_t receiveSizeB = 1024;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, sendSizeB, receiveSizeB);
+}
+BENCHMARK(BM_Baseline_UNIX_Throughput_100MB_s40B_r4096B, n) {
+  (void)n;
+  constexpr size_t loadSizeB = 100 * 1024 * 1024;
+  constexpr size_t sendSizeB = 40;
+  constexpr size_t receiveSizeB = 4096;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, sendSizeB, receiveSizeB);
+}
+BENCHMARK(BM_Baseline_UNIX_Throughput_100MB_s80B_r4096B, n) {
+  (void)n;
+  constexpr size_t loadSizeB = 100 * 1024 * 1024;
+  constexpr size_t sendSizeB = 80;
+  constexpr size_t receiveSizeB = 4096;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, sendSizeB, receiveSizeB);
+}
+BENCHMARK(BM_Baseline_UNIX_Throughput_100MB_s4096B_r4096B, n) {
+  (void)n;
+  constexpr size_t loadSizeB = 100 * 1024 * 1024;
+  constexpr size_t sendSizeB = 4096;
+  constexpr size_t receiveSizeB = 4096;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, sendSizeB, receiveSizeB);
+}
+
+BENCHMARK(BM_Baseline_UNIX_Latency_1M_msgs_32B, n) {
+  (void)n;
+  constexpr size_t messageSizeB = 32;
+  constexpr size_t loadSizeB = 1000000 * messageSizeB;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, messageSizeB, messageSizeB);
+}
+BENCHMARK(BM_Baseline_UNIX_Latency_1M_msgs_128B, n) {
+  (void)n;
+  constexpr size_t messageSizeB = 128;
+  constexpr size_t loadSizeB = 1000000 * messageSizeB;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, messageSizeB, messageSizeB);
+}
+BENCHMARK(BM_Baseline_UNIX_Latency_1M_msgs_4kB, n) {
+  (void)n;
+  constexpr size_t messageSizeB = 4096;
+  constexpr size_t loadSizeB = 1000000 * messageSizeB;
+  BM_Baseline_UNIX_SendReceive(loadSizeB, messageSizeB, messageSizeB);
+}
+
+BENCHMARK_DRAW_LINE();
+
+namespace {
+
+class Observer : public yarpl::single::SingleObserverBase<Payload> {
+ public:
+  explicit Observer(Latch& latch) : latch_{latch} {}
+
+  void onSuccess(Payload) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onSuccess({});
+  }
+
+  void onError(folly::exception_wrapper) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onError({});
+  }
+
+ private:
+  Latch& latch_;
+};
+
+using MakeFactory = folly::Function<std::unique_ptr<ConnectionFactory>(
+    folly::EventBase&,
+    const RSocketServer&)>;
+
+/// Sequential request/response round trips of `messageLen` bytes each way.
+void roundTrips(
+    size_t n,
+    size_t messageLen,
+    std::unique_ptr<ConnectionAcceptor> acceptor,
+    MakeFactory makeFactory) {
+  std::unique_ptr<RSocketServer> server;
+  folly::ScopedEventBaseThread worker;
+  std::shared_ptr<RSocketClient> client;
+  std::string message;
+
+  BENCHMARK_SUSPEND {
+    message.assign(messageLen, 'a');
+    server = RSocket::createServer(std::move(acceptor));
+    auto responder = std::make_shared<FixedResponder>(message);
+    server->start([responder](const SetupParameters&) { return responder; });
+    client = RSocket::createConnectedClient(
+                 makeFactory(*worker.getEventBase(), *server))
+                 .get();
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    Latch latch{1};
+    client->getRequester()
+        ->requestResponse(Payload(message))
+        ->subscribe(std::make_shared<Observer>(latch));
+    latch.wait();
+  }
+
+  BENCHMARK_SUSPEND {
+    client.reset();
+    server.reset();
+  }
+}
+
+void tcpRoundTrips(size_t n, size_t messageLen) {
+  TcpConnectionAcceptor::Options opts;
+  opts.address = folly::SocketAddress{"127.0.0.1", 0};
+  opts.threads = 1;
+  roundTrips(
+      n,
+      messageLen,
+      std::make_unique<TcpConnectionAcceptor>(std::move(opts)),
+      [](folly::EventBase& evb, const RSocketServer& server) {
+        return std::make_unique<TcpConnectionFactory>(
+            evb, folly::SocketAddress{"127.0.0.1", *server.listeningPort()});
+      });
+}
+
+void unixRoundTrips(size_t n, size_t messageLen) {
+  UnixConnectionAcceptor::Options opts;
+  opts.path = socketPath();
+  opts.threads = 1;
+  roundTrips(
+      n,
+      messageLen,
+      std::make_unique<UnixConnectionAcceptor>(std::move(opts)),
+      [](folly::EventBase& evb, const RSocketServer&) {
+        return std::make_unique<UnixConnectionFactory>(evb, socketPath());
+      });
+}
+
+} // namespace
+
+BENCHMARK(RSocket_TCP_RequestResponse_32B, n) {
+  tcpRoundTrips(n, 32);
+}
+BENCHMARK_RELATIVE(RSocket_UNIX_RequestResponse_32B, n) {
+  unixRoundTrips(n, 32);
+}
+BENCHMARK(RSocket_TCP_RequestResponse_4kB, n) {
+  tcpRoundTrips(n, 4096);
+}
+BENCHMARK_RELATIVE(RSocket_UNIX_RequestResponse_4kB, n) {
+  unixRoundTrips(n, 4096);
+}
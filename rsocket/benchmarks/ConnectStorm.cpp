@@ -0,0 +1,126 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Latch.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+
+// Simulates a reconnect storm: client threads open as many TCP connections
+// as they can against a TcpConnectionAcceptor, and the benchmark ends once
+// all of them have been accepted and wrapped in a DuplexConnection.  Compares
+// the single listener thread against one SO_REUSEPORT listener per worker.
+
+using namespace rsocket;
+
+DEFINE_int32(connections, 20000, "number of connections per run");
+DEFINE_int32(client_threads, 8, "number of threads opening connections");
+DEFINE_int32(acceptor_threads, 4, "number of acceptor worker threads");
+DEFINE_int32(backlog, 1024, "listen backlog");
+
+namespace {
+
+/// Connects to the loopback `port` and immediately resets the connection,
+/// so the client side doesn't leave sockets in TIME_WAIT behind.
+void connectAndReset(uint16_t port) {
+  int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) {
+    perror("socket");
+    return;
+  }
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (::connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    perror("connect");
+  }
+
+  linger noLinger = {1, 0};
+  ::setsockopt(sock, SOL_SOCKET, SO_LINGER, &noLinger, sizeof(noLinger));
+  ::close(sock);
+}
+
+void connectStorm(bool reusePort) {
+  std::unique_ptr<TcpConnectionAcceptor> acceptor;
+  Latch accepted{static_cast<size_t>(FLAGS_connections)};
+  uint16_t port{0};
+
+  BENCHMARK_SUSPEND {
+    TcpConnectionAcceptor::Options options;
+    options.address = folly::SocketAddress{"0.0.0.0", 0};
+    options.threads = FLAGS_acceptor_threads;
+    options.backlog = FLAGS_backlog;
+    options.reusePort = reusePort;
+
+    acceptor = std::make_unique<TcpConnectionAcceptor>(std::move(options));
+    acceptor->start(
+        [&accepted](std::unique_ptr<DuplexConnection>, folly::EventBase&) {
+          accepted.post();
+        });
+    port = *acceptor->listeningPort();
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+
+  std::atomic<int> remaining{FLAGS_connections};
+  std::vector<std::thread> clients;
+  for (int i = 0; i < FLAGS_client_threads; ++i) {
+    clients.emplace_back([&] {
+      while (remaining.fetch_sub(1) > 0) {
+        connectAndReset(port);
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  constexpr std::chrono::minutes timeout{1};
+  if (!accepted.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  BENCHMARK_SUSPEND {
+    LOG(INFO) << (reusePort ? "SO_REUSEPORT" : "Single listener") << ": "
+              << FLAGS_connections * 1000000.0 / elapsed.count()
+              << " connections/sec";
+    acceptor.reset();
+  }
+}
+
+} // namespace
+
+BENCHMARK(ConnectStormSingleListener, n) {
+  (void)n;
+  connectStorm(false);
+}
+
+BENCHMARK(ConnectStormReusePort, n) {
+  (void)n;
+  connectStorm(true);
+}
@@ -22,12 +22,37 @@ namespace rsocket {
 
 namespace {
 
+class FixtureServiceHandler : public RSocketServiceHandler {
+ public:
+  FixtureServiceHandler(
+      std::shared_ptr<RSocketResponder> responder,
+      std::shared_ptr<StreamStatePool> streamStatePool)
+      : responder_(std::move(responder)),
+        streamStatePool_(std::move(streamStatePool)) {}
+
+  folly::Expected<RSocketConnectionParams, RSocketException> onNewSetup(
+      const SetupParameters&) override {
+    RSocketConnectionParams params(responder_);
+    params.streamStatePool = streamStatePool_;
+    return params;
+  }
+
+ private:
+  const std::shared_ptr<RSocketResponder> responder_;
+  const std::shared_ptr<StreamStatePool> streamStatePool_;
+};
+
 std::shared_ptr<RSocketClient> makeClient(
     folly::EventBase* eventBase,
-    folly::SocketAddress address) {
-  auto factory =
-      std::make_unique<TcpConnectionFactory>(*eventBase, std::move(address));
-  return RSocket::createConnectedClient(std::move(factory)).get();
+    folly::SocketAddress address,
+    const Fixture::Options& options) {
+  auto factory = std::make_unique<TcpConnectionFactory>(
+      *eventBase, std::move(address), nullptr, options.connection);
+  SetupParameters setupParameters;
+  setupParameters.streamStatePool = options.streamStatePool;
+  return RSocket::createConnectedClient(
+             std::move(factory), std::move(setupParameters))
+      .get();
 }
 } // namespace
 
@@ -38,10 +63,12 @@ Fixture::Fixture(
   TcpConnectionAcceptor::Options opts;
   opts.address = folly::SocketAddress{"0.0.0.0", 0};
   opts.threads = options.serverThreads;
+  opts.connection = options.connection;
 
   auto acceptor = std::make_unique<TcpConnectionAcceptor>(std::move(opts));
   server = std::make_unique<RSocketServer>(std::move(acceptor));
-  server->start([responder](const SetupParameters&) { return responder; });
+  server->start(std::make_shared<FixtureServiceHandler>(
+      std::move(responder), options.streamStatePool));
 
   auto const numWorkers =
       options.clientThreads ? *options.clientThreads : options.clients;
@@ -55,7 +82,8 @@ Fixture::Fixture(
   for (size_t i = 0; i < options.clients; ++i) {
     auto worker = std::move(workers.front());
     workers.pop_front();
-    clients.push_back(makeClient(worker->getEventBase(), actual));
+    clients.push_back(
+        makeClient(worker->getEventBase(), actual, options));
     workers.push_back(std::move(worker));
   }
 }
@@ -16,6 +16,7 @@
 
 #include "rsocket/RSocketClient.h"
 #include "rsocket/RSocketServer.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 #include <folly/Optional.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
@@ -40,6 +41,14 @@ struct Fixture {
     /// Number of worker threads driving the clients.  A default value means to
     /// use one thread per client.
     folly::Optional<size_t> clientThreads;
+
+    /// Options for every TCP connection, on both the server and the clients.
+    TcpDuplexConnection::Options connection;
+
+    /// Recycles stream state machines on every connection, on both the
+    /// server and the clients.  Each connection has a pool of its own by
+    /// default.
+    std::shared_ptr<StreamStatePool> streamStatePool;
   };
 
   Fixture(Options, std::shared_ptr<RSocketResponder>);
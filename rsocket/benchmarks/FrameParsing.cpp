@@ -0,0 +1,145 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameParser_v1_0.h"
+#include "rsocket/framing/FrameSerializer.h"
+
+using namespace rsocket;
+
+namespace {
+
+constexpr size_t kFrames = 1024;
+
+std::unique_ptr<FrameSerializer> makeSerializer() {
+  return FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+}
+
+/// Build `kFrames` copies of a serialized frame up front; parsing consumes
+/// them, so each benchmark iteration takes the next one.
+template <typename MakeFrame>
+std::vector<std::unique_ptr<folly::IOBuf>> serializeFrames(
+    FrameSerializer& serializer,
+    MakeFrame&& makeFrame) {
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  auto const frame = serializer.serializeOut(makeFrame());
+  for (size_t i = 0; i < kFrames; ++i) {
+    frames.push_back(frame->clone());
+  }
+  return frames;
+}
+
+/// Parse one frame per iteration, through the serializer's virtual
+/// deserializeFrom() or through FrameParserV1_0.
+template <typename TFrame, typename MakeFrame>
+void parse(size_t iters, bool hot, MakeFrame&& makeFrame) {
+  std::unique_ptr<FrameSerializer> serializer;
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  BENCHMARK_SUSPEND {
+    serializer = makeSerializer();
+  }
+  size_t parsed = 0;
+  for (size_t i = 0; i < iters; ++i) {
+    if (i % kFrames == 0) {
+      BENCHMARK_SUSPEND {
+        frames = serializeFrames(*serializer, makeFrame);
+      }
+    }
+    TFrame frame;
+    auto& in = frames[i % kFrames];
+    parsed += hot ? deserializeHotFrame(frame, std::move(in), *serializer)
+                  : serializer->deserializeFrom(frame, std::move(in));
+    folly::doNotOptimizeAway(frame);
+  }
+  folly::doNotOptimizeAway(parsed);
+}
+
+Payload makePayload(size_t size) {
+  return Payload(std::string(size, 'x'), "metadata");
+}
+
+void payloadFrame(size_t iters, size_t size, bool hot) {
+  parse<Frame_PAYLOAD>(iters, hot, [&] {
+    return Frame_PAYLOAD(
+        1, FrameFlags::NEXT | FrameFlags::METADATA, makePayload(size));
+  });
+}
+
+void requestResponseFrame(size_t iters, size_t size, bool hot) {
+  parse<Frame_REQUEST_RESPONSE>(iters, hot, [&] {
+    return Frame_REQUEST_RESPONSE(1, FrameFlags::METADATA, makePayload(size));
+  });
+}
+
+void requestNFrame(size_t iters, bool hot) {
+  parse<Frame_REQUEST_N>(iters, hot, [] { return Frame_REQUEST_N(1, 10); });
+}
+
+void cancelFrame(size_t iters, bool hot) {
+  parse<Frame_CANCEL>(iters, hot, [] { return Frame_CANCEL(1); });
+}
+
+void payloadCursor(size_t iters, size_t size) {
+  payloadFrame(iters, size, false);
+}
+
+void payloadHot(size_t iters, size_t size) {
+  payloadFrame(iters, size, true);
+}
+
+void requestResponseCursor(size_t iters, size_t size) {
+  requestResponseFrame(iters, size, false);
+}
+
+void requestResponseHot(size_t iters, size_t size) {
+  requestResponseFrame(iters, size, true);
+}
+
+} // namespace
+
+BENCHMARK_PARAM(payloadCursor, 16)
+BENCHMARK_RELATIVE_PARAM(payloadHot, 16)
+BENCHMARK_PARAM(payloadCursor, 4096)
+BENCHMARK_RELATIVE_PARAM(payloadHot, 4096)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(requestResponseCursor, 16)
+BENCHMARK_RELATIVE_PARAM(requestResponseHot, 16)
+BENCHMARK_PARAM(requestResponseCursor, 4096)
+BENCHMARK_RELATIVE_PARAM(requestResponseHot, 4096)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(requestNCursor, iters) {
+  requestNFrame(iters, false);
+}
+
+BENCHMARK_RELATIVE(requestNHot, iters) {
+  requestNFrame(iters, true);
+}
+
+BENCHMARK(cancelCursor, iters) {
+  cancelFrame(iters, false);
+}
+
+BENCHMARK_RELATIVE(cancelHot, iters) {
+  cancelFrame(iters, true);
+}
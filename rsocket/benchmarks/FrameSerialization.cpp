@@ -0,0 +1,166 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+
+#include <cstring>
+#include <memory>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer.h"
+
+using namespace rsocket;
+
+namespace {
+
+/// Room left in front of large payloads so the serializer can write frame
+/// fields in place, the way a transport-provided buffer would.
+constexpr size_t kHeadroom = 64;
+
+std::unique_ptr<FrameSerializer> makeSerializer() {
+  auto serializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  serializer->preallocateFrameSizeField() = true;
+  return serializer;
+}
+
+std::unique_ptr<folly::IOBuf> makeBuffer(size_t size, bool headroom) {
+  auto const reserve = headroom ? kHeadroom : 0;
+  auto buf = folly::IOBuf::create(reserve + size);
+  buf->advance(reserve);
+  std::memset(buf->writableTail(), 'x', size);
+  buf->append(size);
+  return buf;
+}
+
+/// Serialize one frame per iteration, building a fresh `size`-byte payload
+/// each time since serialization consumes it.
+template <typename MakeFrame>
+void serialize(size_t iters, MakeFrame&& makeFrame) {
+  std::unique_ptr<FrameSerializer> serializer;
+  BENCHMARK_SUSPEND {
+    serializer = makeSerializer();
+  }
+  size_t bytes = 0;
+  for (size_t i = 0; i < iters; ++i) {
+    auto out = serializer->serializeOut(makeFrame());
+    bytes += out->computeChainDataLength();
+    folly::doNotOptimizeAway(out);
+  }
+  folly::doNotOptimizeAway(bytes);
+}
+
+void payloadFrame(size_t iters, size_t size, bool headroom) {
+  serialize(iters, [&] {
+    return Frame_PAYLOAD(
+        1,
+        FrameFlags::NEXT,
+        Payload(makeBuffer(size, headroom), makeBuffer(16, false)));
+  });
+}
+
+void payloadFrameCopied(size_t iters, size_t size) {
+  payloadFrame(iters, size, false);
+}
+
+void payloadFrameWithHeadroom(size_t iters, size_t size) {
+  payloadFrame(iters, size, true);
+}
+
+void requestResponseFrame(size_t iters, size_t size) {
+  serialize(iters, [&] {
+    return Frame_REQUEST_RESPONSE(
+        1, FrameFlags::EMPTY_, Payload(makeBuffer(size, true)));
+  });
+}
+
+void requestStreamFrame(size_t iters, size_t size) {
+  serialize(iters, [&] {
+    return Frame_REQUEST_STREAM(
+        1, FrameFlags::EMPTY_, 10, Payload(makeBuffer(size, true)));
+  });
+}
+
+void fireAndForgetFrame(size_t iters, size_t size) {
+  serialize(iters, [&] {
+    return Frame_REQUEST_FNF(
+        1, FrameFlags::EMPTY_, Payload(makeBuffer(size, true)));
+  });
+}
+
+void errorFrame(size_t iters, size_t size) {
+  serialize(iters, [&] {
+    return Frame_ERROR(
+        1, ErrorCode::APPLICATION_ERROR, Payload(makeBuffer(size, false)));
+  });
+}
+
+void metadataPushFrame(size_t iters, size_t size) {
+  serialize(
+      iters, [&] { return Frame_METADATA_PUSH(makeBuffer(size, false)); });
+}
+
+void requestNFrame(size_t iters, size_t) {
+  serialize(iters, [] { return Frame_REQUEST_N(1, 10); });
+}
+
+void cancelFrame(size_t iters, size_t) {
+  serialize(iters, [] { return Frame_CANCEL(1); });
+}
+
+void keepaliveFrame(size_t iters, size_t) {
+  serialize(iters, [] {
+    return Frame_KEEPALIVE(
+        FrameFlags::KEEPALIVE_RESPOND, 0, folly::IOBuf::create(0));
+  });
+}
+
+void leaseFrame(size_t iters, size_t) {
+  serialize(iters, [] { return Frame_LEASE(1000, 100); });
+}
+
+void resumeOkFrame(size_t iters, size_t) {
+  serialize(iters, [] { return Frame_RESUME_OK(0); });
+}
+
+} // namespace
+
+BENCHMARK_PARAM(payloadFrameCopied, 16)
+BENCHMARK_RELATIVE_PARAM(payloadFrameWithHeadroom, 16)
+BENCHMARK_PARAM(payloadFrameCopied, 512)
+BENCHMARK_RELATIVE_PARAM(payloadFrameWithHeadroom, 512)
+BENCHMARK_PARAM(payloadFrameCopied, 4096)
+BENCHMARK_RELATIVE_PARAM(payloadFrameWithHeadroom, 4096)
+BENCHMARK_PARAM(payloadFrameCopied, 65536)
+BENCHMARK_RELATIVE_PARAM(payloadFrameWithHeadroom, 65536)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(requestResponseFrame, 16)
+BENCHMARK_PARAM(requestResponseFrame, 4096)
+BENCHMARK_PARAM(requestStreamFrame, 16)
+BENCHMARK_PARAM(requestStreamFrame, 4096)
+BENCHMARK_PARAM(fireAndForgetFrame, 16)
+BENCHMARK_PARAM(fireAndForgetFrame, 4096)
+BENCHMARK_PARAM(errorFrame, 16)
+BENCHMARK_PARAM(metadataPushFrame, 16)
+BENCHMARK_PARAM(metadataPushFrame, 4096)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(requestNFrame, 0)
+BENCHMARK_PARAM(cancelFrame, 0)
+BENCHMARK_PARAM(keepaliveFrame, 0)
+BENCHMARK_PARAM(leaseFrame, 0)
+BENCHMARK_PARAM(resumeOkFrame, 0)
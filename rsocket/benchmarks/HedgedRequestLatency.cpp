@@ -0,0 +1,220 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "rsocket/HedgingRequester.h"
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/Single.h"
+
+// Latency percentiles of request/responses spread over several servers, one
+// of which is occasionally slow, sent directly versus through a
+// HedgingRequester.
+
+using namespace rsocket;
+
+DEFINE_int32(items, 20000, "number of requests to time");
+DEFINE_int32(in_flight, 8, "number of requests in flight at once");
+DEFINE_int32(servers, 3, "number of equivalent servers");
+DEFINE_double(
+    slow_fraction,
+    0.02,
+    "share of the first server's responses that are delayed");
+DEFINE_int32(slow_ms, 50, "delay of the slow responses");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Answers every request with a short response, delaying a share of them.
+class SlowResponder : public RSocketResponder {
+ public:
+  explicit SlowResponder(double slowFraction) : slowFraction_(slowFraction) {}
+
+  std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    auto const slow = folly::Random::randDouble01() < slowFraction_;
+    return yarpl::single::Single<Payload>::create([slow](auto observer) {
+      observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
+      if (!slow) {
+        observer->onSuccess(Payload("ok"));
+        return;
+      }
+      auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+      CHECK(evb);
+      evb->runAfterDelay(
+          [observer] { observer->onSuccess(Payload("ok")); },
+          static_cast<uint32_t>(FLAGS_slow_ms));
+    });
+  }
+
+ private:
+  const double slowFraction_;
+};
+
+/// Keeps `--in_flight` requests going until `--items` have completed, and
+/// records their latencies.
+class Load : public std::enable_shared_from_this<Load> {
+ public:
+  Load(HedgingRequester& requester, folly::Baton<>& done)
+      : requester_(requester), done_(done) {
+    latencies_.reserve(static_cast<size_t>(FLAGS_items));
+  }
+
+  void start() {
+    for (int i = 0; i < FLAGS_in_flight; ++i) {
+      send();
+    }
+  }
+
+  std::vector<Clock::duration>& latencies() {
+    return latencies_;
+  }
+
+ private:
+  void send() {
+    if (sent_ == static_cast<size_t>(FLAGS_items)) {
+      return;
+    }
+    ++sent_;
+    auto const start = Clock::now();
+    requester_.requestResponse(Payload("request"))
+        ->subscribe(
+            [self = shared_from_this(), start](Payload) {
+              self->onResponse(Clock::now() - start);
+            },
+            [self = shared_from_this()](folly::exception_wrapper ew) {
+              LOG(ERROR) << "Request failed: " << ew;
+              self->done_.post();
+            });
+  }
+
+  void onResponse(Clock::duration latency) {
+    latencies_.push_back(latency);
+    if (latencies_.size() == static_cast<size_t>(FLAGS_items)) {
+      done_.post();
+    } else {
+      send();
+    }
+  }
+
+  HedgingRequester& requester_;
+  folly::Baton<>& done_;
+  std::vector<Clock::duration> latencies_;
+  size_t sent_{0};
+};
+
+Clock::duration percentile(
+    const std::vector<Clock::duration>& sorted,
+    double p) {
+  auto const index = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void hedgedLoad(HedgingRequester::Options options) {
+  std::vector<std::unique_ptr<RSocketServer>> servers;
+  std::unique_ptr<folly::ScopedEventBaseThread> clientThread;
+  std::unique_ptr<HedgingRequester> requester;
+  std::shared_ptr<Load> load;
+  folly::Baton<> done;
+
+  BENCHMARK_SUSPEND {
+    clientThread = std::make_unique<folly::ScopedEventBaseThread>(
+        "rsocket-client-thread");
+    auto& evb = *clientThread->getEventBase();
+
+    std::vector<std::shared_ptr<RSocketClient>> clients;
+    for (int i = 0; i < std::max(FLAGS_servers, 1); ++i) {
+      TcpConnectionAcceptor::Options acceptorOptions;
+      acceptorOptions.address = folly::SocketAddress{"127.0.0.1", 0};
+      acceptorOptions.threads = 1;
+      auto server = std::make_unique<RSocketServer>(
+          std::make_unique<TcpConnectionAcceptor>(std::move(acceptorOptions)));
+      auto const slowFraction = i == 0 ? FLAGS_slow_fraction : 0;
+      server->start([slowFraction](const SetupParameters&) {
+        return std::make_shared<SlowResponder>(slowFraction);
+      });
+
+      clients.push_back(
+          RSocket::createConnectedClient(
+              std::make_unique<TcpConnectionFactory>(
+                  evb,
+                  folly::SocketAddress{"127.0.0.1",
+                                       *server->listeningPort()}))
+              .get());
+      servers.push_back(std::move(server));
+    }
+
+    requester = std::make_unique<HedgingRequester>(
+        std::move(clients), evb, std::move(options));
+    load = std::make_shared<Load>(*requester, done);
+  }
+
+  clientThread->getEventBase()->runInEventBaseThread([&] { load->start(); });
+  done.wait();
+
+  BENCHMARK_SUSPEND {
+    auto const counters = requester->counters();
+    clientThread->getEventBase()->runInEventBaseThreadAndWait(
+        [&] { requester.reset(); });
+    servers.clear();
+
+    auto& latencies = load->latencies();
+    if (latencies.empty()) {
+      LOG(ERROR) << "No requests completed";
+      return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto const micros = [&](double p) {
+      return std::chrono::duration<double, std::micro>(
+                 percentile(latencies, p))
+          .count();
+    };
+    LOG(INFO) << "  " << latencies.size() << " requests over "
+              << FLAGS_servers << " servers, " << FLAGS_slow_fraction * 100
+              << "% of the first server's responses delayed by "
+              << FLAGS_slow_ms << "ms";
+    LOG(INFO) << "  p50 " << micros(0.5) << "us, p99 " << micros(0.99)
+              << "us, p99.9 " << micros(0.999) << "us";
+    LOG(INFO) << "  " << counters.hedges << " hedges, " << counters.hedgeWins
+              << " won, " << counters.retries << " retries";
+  }
+}
+
+} // namespace
+
+BENCHMARK(Direct, n) {
+  (void)n;
+  HedgingRequester::Options options;
+  options.maxHedges = 0;
+  options.maxRetries = 0;
+  hedgedLoad(std::move(options));
+}
+
+BENCHMARK(HedgedAtP95, n) {
+  (void)n;
+  hedgedLoad(HedgingRequester::Options());
+}
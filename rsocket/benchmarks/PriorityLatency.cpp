@@ -0,0 +1,230 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/Single.h"
+
+using namespace rsocket;
+
+DEFINE_int32(items, 10000, "number of high priority requests to time");
+DEFINE_int32(bulk_len, 4 * 1024 * 1024, "length of each bulk request");
+DEFINE_int32(bulk_in_flight, 8, "number of bulk requests in flight at once");
+DEFINE_int32(fragment_size, 64 * 1024, "largest fragment of a payload");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Answers every request with a short response, whatever its size.
+class AckResponder : public RSocketResponder {
+ public:
+  std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
+      Payload,
+      StreamId) override {
+    return yarpl::single::Singles::fromGenerator<Payload>(
+        [] { return Payload("ok"); });
+  }
+};
+
+/// Keeps a number of bulk uploads in flight on a connection, and times small
+/// requests sent one after the other next to them.
+class MixedLoad : public std::enable_shared_from_this<MixedLoad> {
+ public:
+  MixedLoad(
+      RSocketRequester& requester,
+      StreamPriority control,
+      StreamPriority bulk,
+      folly::Baton<>& done)
+      : requester_(requester),
+        control_(control),
+        bulk_(bulk),
+        done_(done),
+        bulkPayload_(folly::IOBuf::copyBuffer(
+            std::string(static_cast<size_t>(FLAGS_bulk_len), 'b'))) {
+    latencies_.reserve(static_cast<size_t>(FLAGS_items));
+  }
+
+  void start() {
+    for (int i = 0; i < FLAGS_bulk_in_flight; ++i) {
+      sendBulk();
+    }
+    sendControl();
+  }
+
+  std::vector<Clock::duration>& latencies() {
+    return latencies_;
+  }
+
+  size_t bulkRequests() const {
+    return bulkRequests_;
+  }
+
+ private:
+  void sendBulk() {
+    if (finished_) {
+      return;
+    }
+    requester_.requestResponse(Payload(bulkPayload_->clone()), bulk_)
+        ->subscribe(
+            [self = shared_from_this()](Payload) {
+              ++self->bulkRequests_;
+              self->sendBulk();
+            },
+            [self = shared_from_this()](folly::exception_wrapper ew) {
+              // Bulk requests still in flight fail when the client goes away.
+              if (!self->finished_) {
+                LOG(ERROR) << "Bulk request failed: " << ew;
+                self->finish();
+              }
+            });
+  }
+
+  void sendControl() {
+    auto const start = Clock::now();
+    requester_.requestResponse(Payload("control"), control_)
+        ->subscribe(
+            [self = shared_from_this(), start](Payload) {
+              self->latencies_.push_back(Clock::now() - start);
+              if (self->latencies_.size() ==
+                  static_cast<size_t>(FLAGS_items)) {
+                self->finish();
+              } else {
+                self->sendControl();
+              }
+            },
+            [self = shared_from_this()](folly::exception_wrapper ew) {
+              LOG(ERROR) << "Control request failed: " << ew;
+              self->finish();
+            });
+  }
+
+  void finish() {
+    if (!finished_) {
+      finished_ = true;
+      done_.post();
+    }
+  }
+
+  RSocketRequester& requester_;
+  const StreamPriority control_;
+  const StreamPriority bulk_;
+  folly::Baton<>& done_;
+  const std::unique_ptr<folly::IOBuf> bulkPayload_;
+
+  std::vector<Clock::duration> latencies_;
+  size_t bulkRequests_{0};
+  bool finished_{false};
+};
+
+Clock::duration percentile(
+    const std::vector<Clock::duration>& sorted,
+    double p) {
+  auto const index = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void mixedLoad(StreamPriority control, StreamPriority bulk) {
+  std::unique_ptr<RSocketServer> server;
+  std::unique_ptr<folly::ScopedEventBaseThread> clientThread;
+  std::shared_ptr<RSocketClient> client;
+  std::shared_ptr<MixedLoad> load;
+  folly::Baton<> done;
+  Clock::time_point start;
+
+  BENCHMARK_SUSPEND {
+    TcpConnectionAcceptor::Options acceptorOptions;
+    acceptorOptions.address = folly::SocketAddress{"127.0.0.1", 0};
+    acceptorOptions.threads = 1;
+    server = std::make_unique<RSocketServer>(
+        std::make_unique<TcpConnectionAcceptor>(std::move(acceptorOptions)));
+    server->start([](const SetupParameters&) {
+      return std::make_shared<AckResponder>();
+    });
+
+    clientThread = std::make_unique<folly::ScopedEventBaseThread>(
+        "rsocket-client-thread");
+    auto& evb = *clientThread->getEventBase();
+    SetupParameters setupParameters;
+    setupParameters.maxFragmentSize =
+        static_cast<size_t>(FLAGS_fragment_size);
+    client = RSocket::createConnectedClient(
+                 std::make_unique<TcpConnectionFactory>(
+                     evb,
+                     folly::SocketAddress{"127.0.0.1",
+                                          *server->listeningPort()}),
+                 std::move(setupParameters))
+                 .get();
+
+    load = std::make_shared<MixedLoad>(
+        *client->getRequester(), control, bulk, done);
+    start = Clock::now();
+  }
+
+  clientThread->getEventBase()->runInEventBaseThread([&] { load->start(); });
+  done.wait();
+
+  BENCHMARK_SUSPEND {
+    auto const elapsed = Clock::now() - start;
+    clientThread->getEventBase()->runInEventBaseThreadAndWait(
+        [&] { client.reset(); });
+    server.reset();
+
+    auto& latencies = load->latencies();
+    if (latencies.empty()) {
+      LOG(ERROR) << "No control requests completed";
+      return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto const micros = [&](double p) {
+      return std::chrono::duration<double, std::micro>(
+                 percentile(latencies, p))
+          .count();
+    };
+    auto const seconds = std::chrono::duration<double>(elapsed).count();
+    LOG(INFO) << "  " << latencies.size() << " control requests next to "
+              << FLAGS_bulk_in_flight << " bulk requests of "
+              << FLAGS_bulk_len << " bytes in " << FLAGS_fragment_size
+              << " byte fragments";
+    LOG(INFO) << "  control p50 " << micros(0.5) << "us, p99 " << micros(0.99)
+              << "us, p99.9 " << micros(0.999) << "us";
+    auto const bulkBytes =
+        static_cast<double>(load->bulkRequests()) * FLAGS_bulk_len;
+    LOG(INFO) << "  bulk " << bulkBytes / (seconds * 1024 * 1024) << " MB/s";
+  }
+}
+
+} // namespace
+
+BENCHMARK(SamePriority, n) {
+  (void)n;
+  mixedLoad(StreamPriority(), StreamPriority());
+}
+
+BENCHMARK(UrgentControlBackgroundBulk, n) {
+  (void)n;
+  mixedLoad(
+      StreamPriority(StreamPriority::kMostUrgent),
+      StreamPriority(StreamPriority::kLeastUrgent));
+}
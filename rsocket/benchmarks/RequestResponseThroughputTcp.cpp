@@ -20,7 +20,13 @@
 #include <folly/init/Init.h>
 #include <folly/portability/GFlags.h>
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include "rsocket/RSocket.h"
+#include "rsocket/internal/StreamStatePool.h"
+#include "rsocket/internal/SubmissionQueue.h"
 #include "yarpl/Single.h"
 
 using namespace rsocket;
@@ -37,6 +43,19 @@ DEFINE_int32(
     items,
     1000000,
     "number of request-response requests to send, in total");
+DEFINE_bool(
+    pool_stream_state,
+    true,
+    "recycle stream state machine memory");
+DEFINE_int32(
+    submit_threads,
+    1,
+    "number of application threads sending the requests");
+DEFINE_bool(
+    batch_submissions,
+    true,
+    "hand requests to the client EventBases in batches, rather than posting "
+    "each one on its own");
 
 namespace {
 
@@ -74,10 +93,14 @@ BENCHMARK(RequestResponseThroughput, n) {
   Fixture::Options opts;
 
   BENCHMARK_SUSPEND {
+    rsocket::SubmissionQueue::setEnabled(FLAGS_batch_submissions);
+
     auto responder =
         std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
 
     opts.serverThreads = FLAGS_server_threads;
+    opts.streamStatePool =
+        std::make_shared<StreamStatePool>(FLAGS_pool_stream_state);
     opts.clients = FLAGS_clients;
     if (FLAGS_override_client_threads > 0) {
       opts.clientThreads = FLAGS_override_client_threads;
@@ -89,18 +112,40 @@ BENCHMARK(RequestResponseThroughput, n) {
     LOG(INFO) << "  Server with " << opts.serverThreads << " threads.";
     LOG(INFO) << "  " << opts.clients << " clients across "
               << fixture->workers.size() << " threads.";
-    LOG(INFO) << "  Running " << FLAGS_items << " requests in total";
+    LOG(INFO) << "  Running " << FLAGS_items << " requests in total, sent "
+              << "from " << FLAGS_submit_threads << " threads ("
+              << (FLAGS_batch_submissions ? "batched" : "one post each")
+              << ")";
   }
 
-  for (int i = 0; i < FLAGS_items; ++i) {
-    auto& client = fixture->clients[i % opts.clients];
-    client->getRequester()
-        ->requestResponse(Payload("RequestResponseTcp"))
-        ->subscribe(std::make_shared<Observer>(latch));
+  auto const submitThreads = std::max(FLAGS_submit_threads, 1);
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < submitThreads; ++t) {
+    submitters.emplace_back([&, t] {
+      for (int i = t; i < FLAGS_items; i += submitThreads) {
+        auto& client = fixture->clients[i % opts.clients];
+        client->getRequester()
+            ->requestResponse(Payload("RequestResponseTcp"))
+            ->subscribe(std::make_shared<Observer>(latch));
+      }
+    });
+  }
+  for (auto& submitter : submitters) {
+    submitter.join();
   }
 
   constexpr std::chrono::minutes timeout{5};
   if (!latch.timed_wait(timeout)) {
     LOG(ERROR) << "Timed out!";
   }
+
+  BENCHMARK_SUSPEND {
+    // Both the client and the server allocate a stream per request.
+    auto const stats = opts.streamStatePool->stats();
+    LOG(INFO) << "  " << static_cast<double>(stats.misses) / FLAGS_items
+              << " stream state allocations per request, "
+              << static_cast<double>(stats.hits) / FLAGS_items
+              << " recycled (stream state pooling "
+              << (FLAGS_pool_stream_state ? "on" : "off") << ")";
+  }
 }
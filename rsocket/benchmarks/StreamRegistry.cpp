@@ -0,0 +1,137 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <folly/Benchmark.h>
+
+#include <deque>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "rsocket/internal/StreamRegistry.h"
+
+using namespace rsocket;
+
+namespace {
+
+struct Stream {
+  size_t frames{0};
+};
+
+using StreamPtr = std::shared_ptr<Stream>;
+using StreamMap = std::unordered_map<StreamId, StreamPtr>;
+using Registry = StreamRegistry<Stream>;
+
+bool insert(StreamMap& map, StreamId id, StreamPtr stream) {
+  return map.emplace(id, std::move(stream)).second;
+}
+
+bool insert(Registry& registry, StreamId id, StreamPtr stream) {
+  return registry.insert(id, std::move(stream));
+}
+
+Stream* find(StreamMap& map, StreamId id) {
+  auto it = map.find(id);
+  return it != map.end() ? it->second.get() : nullptr;
+}
+
+Stream* find(Registry& registry, StreamId id) {
+  auto stream = registry.find(id);
+  return stream ? stream->get() : nullptr;
+}
+
+/// Open `n` client-allocated streams, returning their IDs oldest first.
+template <typename Table>
+std::deque<StreamId> populate(Table& table, size_t n) {
+  std::deque<StreamId> ids;
+  for (size_t i = 0; i < n; ++i) {
+    auto const id = static_cast<StreamId>(2 * i + 1);
+    insert(table, id, std::make_shared<Stream>());
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+/// Dispatch a frame to a random live stream per iteration, the way
+/// handleFrame() looks up a stream for every incoming frame.
+template <typename Table>
+void lookup(size_t iters, size_t streams) {
+  Table table;
+  std::vector<StreamId> order;
+  BENCHMARK_SUSPEND {
+    populate(table, streams);
+    std::mt19937 rng{static_cast<uint32_t>(streams)};
+    for (size_t i = 0; i < 4096; ++i) {
+      order.push_back(static_cast<StreamId>(2 * (rng() % streams) + 1));
+    }
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    ++find(table, order[i & 4095])->frames;
+  }
+  folly::doNotOptimizeAway(table);
+}
+
+/// Open a new stream and close the oldest one per iteration, keeping
+/// `streams` streams alive.
+template <typename Table>
+void churn(size_t iters, size_t streams) {
+  Table table;
+  std::deque<StreamId> ids;
+  BENCHMARK_SUSPEND {
+    ids = populate(table, streams);
+  }
+  auto next = ids.back() + 2;
+  for (size_t i = 0; i < iters; ++i) {
+    insert(table, next, std::make_shared<Stream>());
+    ids.push_back(next);
+    next += 2;
+    table.erase(ids.front());
+    ids.pop_front();
+  }
+  folly::doNotOptimizeAway(table);
+}
+
+void mapLookup(size_t iters, size_t streams) {
+  lookup<StreamMap>(iters, streams);
+}
+
+void registryLookup(size_t iters, size_t streams) {
+  lookup<Registry>(iters, streams);
+}
+
+void mapChurn(size_t iters, size_t streams) {
+  churn<StreamMap>(iters, streams);
+}
+
+void registryChurn(size_t iters, size_t streams) {
+  churn<Registry>(iters, streams);
+}
+
+} // namespace
+
+BENCHMARK_PARAM(mapLookup, 10)
+BENCHMARK_RELATIVE_PARAM(registryLookup, 10)
+BENCHMARK_PARAM(mapLookup, 1000)
+BENCHMARK_RELATIVE_PARAM(registryLookup, 1000)
+BENCHMARK_PARAM(mapLookup, 100000)
+BENCHMARK_RELATIVE_PARAM(registryLookup, 100000)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_PARAM(mapChurn, 10)
+BENCHMARK_RELATIVE_PARAM(registryChurn, 10)
+BENCHMARK_PARAM(mapChurn, 1000)
+BENCHMARK_RELATIVE_PARAM(registryChurn, 1000)
+BENCHMARK_PARAM(mapChurn, 100000)
+BENCHMARK_RELATIVE_PARAM(registryChurn, 100000)
@@ -0,0 +1,131 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Fixture.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include <algorithm>
+
+#include "rsocket/RSocket.h"
+
+using namespace rsocket;
+
+DEFINE_int32(server_threads, 2, "number of server threads to run");
+DEFINE_int32(clients, 2, "number of clients to run");
+DEFINE_int64(
+    bytes,
+    256 * 1024 * 1024,
+    "number of payload bytes to stream, per client");
+
+namespace {
+
+/// Stream FLAGS_bytes worth of `payloadLen`-sized payloads to every client.
+/// When `adaptive` is false the read buffer is pinned to the old fixed 4KB.
+/// With `zeroCopy` the server sends frames of 64KB or more with MSG_ZEROCOPY.
+void streamPayloads(size_t payloadLen, bool adaptive, bool zeroCopy = false) {
+  std::unique_ptr<Fixture> fixture;
+  Fixture::Options opts;
+  size_t items = 0;
+
+  BENCHMARK_SUSPEND {
+    auto responder =
+        std::make_shared<FixedResponder>(std::string(payloadLen, 'a'));
+
+    opts.serverThreads = FLAGS_server_threads;
+    opts.clients = FLAGS_clients;
+    if (!adaptive) {
+      opts.connection.minReadBufferSize = 4096;
+      opts.connection.maxReadBufferSize = 4096;
+    }
+    opts.connection.zeroCopy = zeroCopy;
+
+    fixture = std::make_unique<Fixture>(opts, std::move(responder));
+    items = std::max<size_t>(1, FLAGS_bytes / payloadLen);
+
+    LOG(INFO) << "Running " << fixture->clients.size() << " streams of "
+              << items << " items of " << payloadLen << " bytes each, "
+              << (adaptive ? "adaptive" : "fixed") << " read buffer"
+              << (zeroCopy ? ", zero-copy sends." : ".");
+  }
+
+  Latch latch{fixture->clients.size()};
+  for (auto& client : fixture->clients) {
+    client->getRequester()
+        ->requestStream(Payload("TcpStream"))
+        ->subscribe(std::make_shared<BoundedSubscriber>(latch, items));
+  }
+
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+} // namespace
+
+BENCHMARK(FixedReadBuffer_64B, n) {
+  (void)n;
+  streamPayloads(64, false);
+}
+
+BENCHMARK_RELATIVE(AdaptiveReadBuffer_64B, n) {
+  (void)n;
+  streamPayloads(64, true);
+}
+
+BENCHMARK(FixedReadBuffer_4KB, n) {
+  (void)n;
+  streamPayloads(4 * 1024, false);
+}
+
+BENCHMARK_RELATIVE(AdaptiveReadBuffer_4KB, n) {
+  (void)n;
+  streamPayloads(4 * 1024, true);
+}
+
+BENCHMARK(FixedReadBuffer_256KB, n) {
+  (void)n;
+  streamPayloads(256 * 1024, false);
+}
+
+BENCHMARK_RELATIVE(AdaptiveReadBuffer_256KB, n) {
+  (void)n;
+  streamPayloads(256 * 1024, true);
+}
+
+BENCHMARK_RELATIVE(ZeroCopy_256KB, n) {
+  (void)n;
+  streamPayloads(256 * 1024, true, true);
+}
+
+BENCHMARK(FixedReadBuffer_4MB, n) {
+  (void)n;
+  streamPayloads(4 * 1024 * 1024, false);
+}
+
+BENCHMARK_RELATIVE(AdaptiveReadBuffer_4MB, n) {
+  (void)n;
+  streamPayloads(4 * 1024 * 1024, true);
+}
+
+BENCHMARK_RELATIVE(ZeroCopy_4MB, n) {
+  (void)n;
+  streamPayloads(4 * 1024 * 1024, true, true);
+}
@@ -0,0 +1,213 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+#include "rsocket/AdaptiveSubscriber.h"
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/memory/MemoryDuplexConnection.h"
+#include "yarpl/Flowable.h"
+
+// Throughput of a single stream when the credit is requested in fixed batches
+// versus by an AdaptiveSubscriber, over a MemoryDuplexConnection pair with a
+// simulated round trip time.
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_int32(seconds, 2, "how long to run each stream for");
+DEFINE_int32(batch, 16, "credit requested at a time by the fixed subscriber");
+
+namespace {
+
+/// Delays the frames sent through a connection by a fixed time.  The frames
+/// keep their order, and are still delivered once the connection has been
+/// dropped.
+class DelayedConnection : public DuplexConnection {
+ public:
+  DelayedConnection(
+      std::unique_ptr<DuplexConnection> connection,
+      folly::EventBase& evb,
+      std::chrono::milliseconds delay)
+      : state_(std::make_shared<State>(std::move(connection))),
+        evb_(evb),
+        delay_(delay) {}
+
+  void send(std::unique_ptr<folly::IOBuf> frame) override {
+    state_->frames.push_back(std::move(frame));
+    // Every callback sends the oldest frame, so the order of the timers does
+    // not matter.
+    evb_.runAfterDelay(
+        [state = state_] {
+          state->connection->send(std::move(state->frames.front()));
+          state->frames.pop_front();
+        },
+        static_cast<uint32_t>(delay_.count()));
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> input) override {
+    state_->connection->setInput(std::move(input));
+  }
+
+  bool isFramed() const override {
+    return state_->connection->isFramed();
+  }
+
+ private:
+  struct State {
+    explicit State(std::unique_ptr<DuplexConnection> c)
+        : connection(std::move(c)) {}
+
+    const std::unique_ptr<DuplexConnection> connection;
+    std::deque<std::unique_ptr<folly::IOBuf>> frames;
+  };
+
+  const std::shared_ptr<State> state_;
+  folly::EventBase& evb_;
+  const std::chrono::milliseconds delay_;
+};
+
+/// A server and a client on their own EventBases, where everything the client
+/// sends is delayed by the round trip time.
+class DelayedFixture {
+ public:
+  explicit DelayedFixture(std::chrono::milliseconds rtt)
+      : serverEvb_(*serverThread_.getEventBase()),
+        clientEvb_(*clientThread_.getEventBase()) {
+    auto connections = MemoryDuplexConnection::makePair(serverEvb_, clientEvb_);
+
+    server_ = std::make_unique<RSocketServer>(nullptr);
+    server_->setSingleThreadedResponder();
+    serverEvb_.runInEventBaseThreadAndWait([&] {
+      server_->acceptConnection(
+          std::move(connections.first),
+          serverEvb_,
+          RSocketServiceHandler::create([](const SetupParameters&) {
+            return std::make_shared<FixedResponder>(
+                std::string(kMessageLen, 'a'));
+          }));
+    });
+    clientEvb_.runInEventBaseThreadAndWait([&] {
+      client_ = RSocket::createClientFromConnection(
+          std::make_unique<DelayedConnection>(
+              std::move(connections.second), clientEvb_, rtt),
+          clientEvb_);
+    });
+  }
+
+  ~DelayedFixture() {
+    clientEvb_.runInEventBaseThreadAndWait([this] { client_.reset(); });
+    server_.reset();
+  }
+
+  folly::EventBase& clientEvb() {
+    return clientEvb_;
+  }
+
+  RSocketRequester& requester() {
+    return *client_->getRequester();
+  }
+
+ private:
+  folly::ScopedEventBaseThread serverThread_{"rsocket-rtt-server"};
+  folly::ScopedEventBaseThread clientThread_{"rsocket-rtt-client"};
+  folly::EventBase& serverEvb_;
+  folly::EventBase& clientEvb_;
+
+  std::unique_ptr<RSocketServer> server_;
+  std::unique_ptr<RSocketClient> client_;
+};
+
+/// Runs a stream for --seconds with a simulated `rtt`, and logs how many items
+/// per second it delivered.
+void streamThroughput(std::chrono::milliseconds rtt, bool adaptive) {
+  std::unique_ptr<DelayedFixture> fixture;
+  std::atomic<size_t> received{0};
+  std::shared_ptr<AdaptiveSubscriber> adaptiveSubscriber;
+
+  BENCHMARK_SUSPEND {
+    fixture = std::make_unique<DelayedFixture>(rtt);
+  }
+
+  auto const counter = [&received](Payload) {
+    received.fetch_add(1, std::memory_order_relaxed);
+  };
+  fixture->clientEvb().runInEventBaseThreadAndWait([&] {
+    auto stream = fixture->requester().requestStream(Payload("RttStream"));
+    if (adaptive) {
+      adaptiveSubscriber = AdaptiveSubscriber::create(
+          yarpl::flowable::Subscriber<Payload>::create(counter));
+      stream->subscribe(adaptiveSubscriber);
+    } else {
+      stream->subscribe(
+          yarpl::flowable::Subscriber<Payload>::create(counter, FLAGS_batch));
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::seconds(FLAGS_seconds));
+  auto const items = received.load();
+
+  BENCHMARK_SUSPEND {
+    size_t window = 0;
+    if (adaptiveSubscriber) {
+      fixture->clientEvb().runInEventBaseThreadAndWait(
+          [&] { window = adaptiveSubscriber->window().window(); });
+    }
+    fixture.reset();
+
+    LOG(INFO) << "  " << rtt.count() << "ms RTT: "
+              << static_cast<double>(items) / FLAGS_seconds << " items/s";
+    if (adaptive) {
+      LOG(INFO) << "  final window " << window;
+    }
+  }
+}
+
+} // namespace
+
+BENCHMARK(FixedBatch1msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{1}, false);
+}
+BENCHMARK(Adaptive1msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{1}, true);
+}
+
+BENCHMARK(FixedBatch10msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{10}, false);
+}
+BENCHMARK(Adaptive10msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{10}, true);
+}
+
+BENCHMARK(FixedBatch100msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{100}, false);
+}
+BENCHMARK(Adaptive100msRtt, n) {
+  (void)n;
+  streamThroughput(std::chrono::milliseconds{100}, true);
+}
@@ -23,8 +23,6 @@
 
 using namespace rsocket;
 
-constexpr size_t kMessageLen = 32;
-
 DEFINE_int32(server_threads, 8, "number of server threads to run");
 DEFINE_int32(
     override_client_threads,
@@ -33,6 +31,10 @@ DEFINE_int32(
 DEFINE_int32(clients, 10, "number of clients to run");
 DEFINE_int32(items, 1000000, "number of items in stream, per client");
 DEFINE_int32(streams, 1, "number of streams, per client");
+DEFINE_int32(
+    message_len,
+    32,
+    "payload size of each item; small payloads pack many frames per read");
 
 BENCHMARK(StreamThroughput, n) {
   (void)n;
@@ -44,7 +46,7 @@ BENCHMARK(StreamThroughput, n) {
 
   BENCHMARK_SUSPEND {
     auto responder =
-        std::make_shared<FixedResponder>(std::string(kMessageLen, 'a'));
+        std::make_shared<FixedResponder>(std::string(FLAGS_message_len, 'a'));
 
     opts.serverThreads = FLAGS_server_threads;
     opts.clients = FLAGS_clients;
@@ -59,7 +61,7 @@ BENCHMARK(StreamThroughput, n) {
     LOG(INFO) << "  " << opts.clients << " clients across "
               << fixture->workers.size() << " threads.";
     LOG(INFO) << "  Running " << FLAGS_streams << " streams of " << FLAGS_items
-              << " items each.";
+              << " items of " << FLAGS_message_len << " bytes each.";
   }
 
   for (size_t i = 0; i < FLAGS_streams; ++i) {
@@ -0,0 +1,235 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/benchmarks/Latch.h"
+#include "rsocket/benchmarks/Throughput.h"
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include "rsocket/RSocket.h"
+#include "rsocket/transports/memory/MemoryDuplexConnection.h"
+#include "yarpl/Flowable.h"
+#include "yarpl/Single.h"
+
+// Throughput of each interaction model between a client and a server that
+// talk over a MemoryDuplexConnection pair.  Without a kernel in the way, what
+// is measured is the cost of RSocket itself: frame serialization and the
+// state machines.
+
+using namespace rsocket;
+
+constexpr size_t kMessageLen = 32;
+
+DEFINE_int32(items, 1000000, "number of items to send, for each benchmark");
+
+namespace {
+
+/// Responds with a fixed message, echoes channels, and counts
+/// fire-and-forgets.
+class Responder : public FixedResponder {
+ public:
+  explicit Responder(Latch& fireAndForgets)
+      : FixedResponder(std::string(kMessageLen, 'a')),
+        fireAndForgets_(fireAndForgets) {}
+
+  void handleFireAndForget(Payload, StreamId) override {
+    fireAndForgets_.post();
+  }
+
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestChannel(
+      Payload,
+      std::shared_ptr<yarpl::flowable::Flowable<Payload>> requests,
+      StreamId) override {
+    return requests;
+  }
+
+ private:
+  Latch& fireAndForgets_;
+};
+
+/// A server and a client talking over a MemoryDuplexConnection pair, either
+/// both on one EventBase or each on its own.
+class MemoryFixture {
+ public:
+  MemoryFixture(std::shared_ptr<RSocketResponder> responder, bool crossEvb)
+      : serverEvb_(*serverThread_.getEventBase()),
+        clientEvb_(crossEvb ? *clientThread_.getEventBase() : serverEvb_) {
+    auto connections = MemoryDuplexConnection::makePair(serverEvb_, clientEvb_);
+
+    server_ = std::make_unique<RSocketServer>(nullptr);
+    server_->setSingleThreadedResponder();
+    serverEvb_.runInEventBaseThreadAndWait([&] {
+      server_->acceptConnection(
+          std::move(connections.first),
+          serverEvb_,
+          RSocketServiceHandler::create(
+              [responder](const SetupParameters&) { return responder; }));
+    });
+    clientEvb_.runInEventBaseThreadAndWait([&] {
+      client_ = RSocket::createClientFromConnection(
+          std::move(connections.second), clientEvb_);
+    });
+  }
+
+  ~MemoryFixture() {
+    clientEvb_.runInEventBaseThreadAndWait([this] { client_.reset(); });
+    server_.reset();
+  }
+
+  RSocketRequester& requester() {
+    return *client_->getRequester();
+  }
+
+ private:
+  folly::ScopedEventBaseThread serverThread_{"rsocket-mem-server"};
+  folly::ScopedEventBaseThread clientThread_{"rsocket-mem-client"};
+  folly::EventBase& serverEvb_;
+  folly::EventBase& clientEvb_;
+
+  std::unique_ptr<RSocketServer> server_;
+  std::unique_ptr<RSocketClient> client_;
+};
+
+class Observer : public yarpl::single::SingleObserverBase<Payload> {
+ public:
+  explicit Observer(Latch& latch) : latch_{latch} {}
+
+  void onSuccess(Payload) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onSuccess({});
+  }
+
+  void onError(folly::exception_wrapper) override {
+    latch_.post();
+    yarpl::single::SingleObserverBase<Payload>::onError({});
+  }
+
+ private:
+  Latch& latch_;
+};
+
+std::shared_ptr<yarpl::flowable::Flowable<Payload>> infinitePayloads() {
+  return yarpl::flowable::Flowable<Payload>::fromGenerator(
+      [msg = folly::IOBuf::copyBuffer(std::string(kMessageLen, 'a'))] {
+        return Payload(msg->clone());
+      });
+}
+
+void await(Latch& latch) {
+  constexpr std::chrono::minutes timeout{5};
+  if (!latch.timed_wait(timeout)) {
+    LOG(ERROR) << "Timed out!";
+  }
+}
+
+/// Run `body` against a fresh fixture, which is set up and torn down outside
+/// of the measurement.
+template <typename Body>
+void run(Latch& fireAndForgets, bool crossEvb, Body&& body) {
+  std::unique_ptr<MemoryFixture> fixture;
+  BENCHMARK_SUSPEND {
+    fixture = std::make_unique<MemoryFixture>(
+        std::make_shared<Responder>(fireAndForgets), crossEvb);
+  }
+
+  body(fixture->requester());
+
+  BENCHMARK_SUSPEND {
+    fixture.reset();
+  }
+}
+
+void fireAndForget(bool crossEvb) {
+  Latch latch{static_cast<size_t>(FLAGS_items)};
+  run(latch, crossEvb, [&](RSocketRequester& requester) {
+    for (int i = 0; i < FLAGS_items; ++i) {
+      requester.fireAndForget(Payload("InMemoryFireAndForget"))
+          ->subscribe(
+              std::make_shared<yarpl::single::SingleObserverBase<void>>());
+    }
+    await(latch);
+  });
+}
+
+void requestResponse(bool crossEvb) {
+  Latch unused{0};
+  run(unused, crossEvb, [&](RSocketRequester& requester) {
+    Latch latch{static_cast<size_t>(FLAGS_items)};
+    for (int i = 0; i < FLAGS_items; ++i) {
+      requester.requestResponse(Payload("InMemoryRequestResponse"))
+          ->subscribe(std::make_shared<Observer>(latch));
+    }
+    await(latch);
+  });
+}
+
+void requestStream(bool crossEvb) {
+  Latch unused{0};
+  run(unused, crossEvb, [&](RSocketRequester& requester) {
+    Latch latch{1};
+    requester.requestStream(Payload("InMemoryStream"))
+        ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+    await(latch);
+  });
+}
+
+void requestChannel(bool crossEvb) {
+  Latch unused{0};
+  run(unused, crossEvb, [&](RSocketRequester& requester) {
+    Latch latch{1};
+    requester.requestChannel(Payload("InMemoryChannel"), infinitePayloads())
+        ->subscribe(std::make_shared<BoundedSubscriber>(latch, FLAGS_items));
+    await(latch);
+  });
+}
+
+} // namespace
+
+BENCHMARK(FireAndForget, n) {
+  (void)n;
+  fireAndForget(false);
+}
+BENCHMARK(FireAndForgetCrossEventBase, n) {
+  (void)n;
+  fireAndForget(true);
+}
+
+BENCHMARK(RequestResponse, n) {
+  (void)n;
+  requestResponse(false);
+}
+BENCHMARK(RequestResponseCrossEventBase, n) {
+  (void)n;
+  requestResponse(true);
+}
+
+BENCHMARK(RequestStream, n) {
+  (void)n;
+  requestStream(false);
+}
+BENCHMARK(RequestStreamCrossEventBase, n) {
+  (void)n;
+  requestStream(true);
+}
+
+BENCHMARK(RequestChannel, n) {
+  (void)n;
+  requestChannel(false);
+}
+BENCHMARK(RequestChannelCrossEventBase, n) {
+  (void)n;
+  requestChannel(true);
+}
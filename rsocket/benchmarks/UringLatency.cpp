@@ -0,0 +1,317 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Benchmark.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/Baton.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "rsocket/RSocketStats.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "rsocket/transports/uring/UringConnectionAcceptor.h"
+#include "rsocket/transports/uring/UringConnectionFactory.h"
+#include "rsocket/transports/uring/UringRing.h"
+
+using namespace rsocket;
+
+DEFINE_int32(items, 100000, "number of messages to bounce off the server");
+DEFINE_int32(message_len, 64, "length of each message, in bytes");
+DEFINE_int32(in_flight, 1, "number of messages in flight at once");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Echoes everything it receives back over the connection.
+class Echo : public DuplexConnection::Subscriber {
+ public:
+  explicit Echo(DuplexConnection& connection) : connection_(connection) {}
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> buf) override {
+    connection_.send(std::move(buf));
+  }
+
+  void onComplete() override {}
+  void onError(folly::exception_wrapper) override {}
+
+ private:
+  DuplexConnection& connection_;
+};
+
+/// Sends fixed-size messages, keeping `inFlight` of them outstanding, and
+/// times each one until its echo has fully come back.
+class PingPong : public DuplexConnection::Subscriber {
+ public:
+  PingPong(DuplexConnection& connection, folly::Baton<>& done)
+      : connection_(connection),
+        done_(done),
+        message_(folly::IOBuf::copyBuffer(
+            std::string(static_cast<size_t>(FLAGS_message_len), 'a'))) {
+    latencies_.reserve(static_cast<size_t>(FLAGS_items));
+  }
+
+  void start() {
+    for (int i = 0; i < FLAGS_in_flight && sent_ < FLAGS_items; ++i) {
+      sendOne();
+    }
+  }
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> buf) override {
+    received_ += buf->computeChainDataLength();
+    auto const messageLen = static_cast<size_t>(FLAGS_message_len);
+    while (received_ >= messageLen && !sendTimes_.empty()) {
+      received_ -= messageLen;
+      latencies_.push_back(Clock::now() - sendTimes_.front());
+      sendTimes_.pop_front();
+      if (sent_ < FLAGS_items) {
+        sendOne();
+      }
+    }
+    if (latencies_.size() == static_cast<size_t>(FLAGS_items)) {
+      finish();
+    }
+  }
+
+  void onComplete() override {
+    finish();
+  }
+
+  void onError(folly::exception_wrapper ew) override {
+    LOG(ERROR) << "Connection failed: " << ew;
+    finish();
+  }
+
+  std::vector<Clock::duration>& latencies() {
+    return latencies_;
+  }
+
+ private:
+  void sendOne() {
+    ++sent_;
+    sendTimes_.push_back(Clock::now());
+    connection_.send(message_->clone());
+  }
+
+  void finish() {
+    if (!finished_) {
+      finished_ = true;
+      done_.post();
+    }
+  }
+
+  DuplexConnection& connection_;
+  folly::Baton<>& done_;
+  const std::unique_ptr<folly::IOBuf> message_;
+
+  int sent_{0};
+  size_t received_{0};
+  std::deque<Clock::time_point> sendTimes_;
+  std::vector<Clock::duration> latencies_;
+  bool finished_{false};
+};
+
+/// Counts a TCP connection's reads and writes, one syscall each.
+class SyscallCounter : public RSocketStats {
+ public:
+  void bytesRead(size_t) override {
+    ++calls;
+  }
+
+  void bytesWritten(size_t) override {
+    ++calls;
+  }
+
+  std::atomic<size_t> calls{0};
+};
+
+class Transport {
+ public:
+  virtual ~Transport() = default;
+
+  virtual std::unique_ptr<ConnectionAcceptor> makeAcceptor() = 0;
+
+  /// Connect a client driven by `evb`.  Called off the `evb` thread.
+  virtual std::unique_ptr<DuplexConnection> connect(
+      folly::EventBase& evb,
+      const folly::SocketAddress& address) = 0;
+
+  /// Syscalls the client side has made so far, not counting the wait for
+  /// events.  Called on the `evb` thread.
+  virtual size_t syscalls(folly::EventBase& evb) = 0;
+};
+
+class TcpTransport : public Transport {
+ public:
+  std::unique_ptr<ConnectionAcceptor> makeAcceptor() override {
+    TcpConnectionAcceptor::Options options;
+    options.address = folly::SocketAddress{"127.0.0.1", 0};
+    options.threads = 1;
+    return std::make_unique<TcpConnectionAcceptor>(std::move(options));
+  }
+
+  std::unique_ptr<DuplexConnection> connect(
+      folly::EventBase& evb,
+      const folly::SocketAddress& address) override {
+    std::unique_ptr<DuplexConnection> connection;
+    evb.runInEventBaseThreadAndWait([&] {
+      connection = TcpConnectionFactory::createDuplexConnectionFromSocket(
+          folly::AsyncSocket::newSocket(&evb, address), counter_);
+    });
+    return connection;
+  }
+
+  size_t syscalls(folly::EventBase&) override {
+    return counter_->calls.load();
+  }
+
+ private:
+  const std::shared_ptr<SyscallCounter> counter_{
+      std::make_shared<SyscallCounter>()};
+};
+
+class UringTransport : public Transport {
+ public:
+  std::unique_ptr<ConnectionAcceptor> makeAcceptor() override {
+    UringConnectionAcceptor::Options options;
+    options.address = folly::SocketAddress{"127.0.0.1", 0};
+    options.threads = 1;
+    return std::make_unique<UringConnectionAcceptor>(std::move(options));
+  }
+
+  std::unique_ptr<DuplexConnection> connect(
+      folly::EventBase& evb,
+      const folly::SocketAddress& address) override {
+    UringConnectionFactory factory{evb, address};
+    return factory.connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+        .get()
+        .connection;
+  }
+
+  size_t syscalls(folly::EventBase& evb) override {
+    auto const& stats = UringRing::get(evb).stats();
+    return stats.submits + stats.wakeups;
+  }
+};
+
+Clock::duration percentile(
+    const std::vector<Clock::duration>& sorted,
+    double p) {
+  auto const index = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+void pingPong(Transport& transport) {
+  folly::ScopedEventBaseThread clientThread{"rsocket-client-thread"};
+  auto& evb = *clientThread.getEventBase();
+
+  std::unique_ptr<ConnectionAcceptor> acceptor;
+  std::mutex mutex;
+  std::vector<std::pair<folly::EventBase*, std::unique_ptr<DuplexConnection>>>
+      serverConnections;
+  folly::Baton<> accepted;
+  std::unique_ptr<DuplexConnection> client;
+  std::shared_ptr<PingPong> pingPong;
+  folly::Baton<> done;
+  size_t syscallsBefore = 0;
+
+  BENCHMARK_SUSPEND {
+    acceptor = transport.makeAcceptor();
+    acceptor->start([&](
+                        std::unique_ptr<DuplexConnection> connection,
+                        folly::EventBase& serverEvb) {
+      connection->setInput(std::make_shared<Echo>(*connection));
+      std::lock_guard<std::mutex> lock(mutex);
+      serverConnections.emplace_back(&serverEvb, std::move(connection));
+      accepted.post();
+    });
+
+    client = transport.connect(
+        evb, folly::SocketAddress{"127.0.0.1", *acceptor->listeningPort()});
+    pingPong = std::make_shared<PingPong>(*client, done);
+    evb.runInEventBaseThreadAndWait([&] {
+      client->setInput(pingPong);
+      syscallsBefore = transport.syscalls(evb);
+    });
+  }
+
+  evb.runInEventBaseThread([&] { pingPong->start(); });
+  done.wait();
+
+  BENCHMARK_SUSPEND {
+    size_t syscalls = 0;
+    evb.runInEventBaseThreadAndWait([&] {
+      syscalls = transport.syscalls(evb) - syscallsBefore;
+      client.reset();
+    });
+    accepted.wait();
+    for (auto& serverConnection : serverConnections) {
+      serverConnection.first->runInEventBaseThreadAndWait(
+          [connection = std::move(serverConnection.second)] {});
+    }
+    acceptor->stop();
+
+    auto& latencies = pingPong->latencies();
+    if (latencies.empty()) {
+      LOG(ERROR) << "No messages made it back";
+      return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto const micros = [&](double p) {
+      return std::chrono::duration<double, std::micro>(
+                 percentile(latencies, p))
+          .count();
+    };
+    LOG(INFO) << "  " << latencies.size() << " messages of "
+              << FLAGS_message_len << " bytes, " << FLAGS_in_flight
+              << " in flight";
+    LOG(INFO) << "  p50 " << micros(0.5) << "us, p99 " << micros(0.99)
+              << "us, p99.9 " << micros(0.999) << "us";
+    LOG(INFO) << "  "
+              << static_cast<double>(syscalls) / (2 * latencies.size())
+              << " client syscalls per frame sent or received";
+  }
+}
+
+} // namespace
+
+BENCHMARK(TcpPingPong, n) {
+  (void)n;
+  TcpTransport transport;
+  pingPong(transport);
+}
+
+BENCHMARK(UringPingPong, n) {
+  (void)n;
+  UringTransport transport;
+  pingPong(transport);
+}
@@ -0,0 +1,173 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+
+#include <memory>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer_v1_0.h"
+
+namespace rsocket {
+
+/// Non-virtual parsers for the frame types that make up the bulk of the
+/// steady-state traffic of a 1.0 connection.  Each specialization provides
+///
+///   static bool parse(TFrame&, std::unique_ptr<folly::IOBuf>);
+///
+/// which is only ever handed a single, unchained buffer holding at least a
+/// frame header.  Fields are decoded with direct loads after explicit length
+/// checks, and payloads are carved out of the input buffer in place, so no
+/// cursor is built and malformed frames do not throw.
+///
+/// Use deserializeHotFrame() rather than calling parse() directly.
+template <typename TFrame>
+struct FrameParserV1_0;
+
+namespace detail {
+
+constexpr size_t kHotMetadataLengthSize = 3; // bytes
+
+/// Decodes the header at the start of `data`, which must hold at least
+/// FrameSerializerV1_0::kFrameHeaderSize bytes.  Fails on a negative stream
+/// ID, or on a frame that is not of `type`.
+inline bool
+parseHeader(const uint8_t* data, FrameType type, FrameHeader& header) {
+  auto const streamId = folly::Endian::big(folly::loadUnaligned<int32_t>(data));
+  if (streamId < 0) {
+    return false;
+  }
+  // |Frame Type (6)|I|M|Flags (8)|
+  auto const typeAndFlags =
+      folly::Endian::big(folly::loadUnaligned<uint16_t>(data + 4));
+  if ((typeAndFlags >> 10) != static_cast<uint8_t>(type)) {
+    return false;
+  }
+  header.type = type;
+  header.flags = static_cast<FrameFlags>(typeAndFlags & 0x3FF);
+  header.streamId = static_cast<StreamId>(streamId);
+  return true;
+}
+
+/// Splits everything in `in` past the first `offset` bytes into metadata (if
+/// the METADATA flag is set) and data.  Metadata shares the input buffer, and
+/// data reuses it.
+inline bool parsePayload(
+    std::unique_ptr<folly::IOBuf> in,
+    size_t offset,
+    FrameFlags flags,
+    Payload& payload) {
+  std::unique_ptr<folly::IOBuf> metadata;
+  if (!!(flags & FrameFlags::METADATA)) {
+    if (in->length() < offset + kHotMetadataLengthSize) {
+      return false;
+    }
+    auto const field = in->data() + offset;
+    auto const metadataLength = (static_cast<uint32_t>(field[0]) << 16) |
+        (static_cast<uint32_t>(field[1]) << 8) | field[2];
+    offset += kHotMetadataLengthSize;
+    if (in->length() - offset < metadataLength) {
+      return false;
+    }
+    metadata = in->cloneOne();
+    metadata->trimStart(offset);
+    metadata->trimEnd(metadata->length() - metadataLength);
+    offset += metadataLength;
+  }
+
+  in->trimStart(offset);
+  if (in->empty()) {
+    in.reset();
+  }
+  payload = Payload(std::move(in), std::move(metadata));
+  return true;
+}
+
+} // namespace detail
+
+template <>
+struct FrameParserV1_0<Frame_PAYLOAD> {
+  static bool parse(Frame_PAYLOAD& frame, std::unique_ptr<folly::IOBuf> in) {
+    if (!detail::parseHeader(in->data(), FrameType::PAYLOAD, frame.header_)) {
+      return false;
+    }
+    return detail::parsePayload(
+        std::move(in),
+        FrameSerializerV1_0::kFrameHeaderSize,
+        frame.header_.flags,
+        frame.payload_);
+  }
+};
+
+template <>
+struct FrameParserV1_0<Frame_REQUEST_RESPONSE> {
+  static bool parse(
+      Frame_REQUEST_RESPONSE& frame,
+      std::unique_ptr<folly::IOBuf> in) {
+    if (!detail::parseHeader(
+            in->data(), FrameType::REQUEST_RESPONSE, frame.header_)) {
+      return false;
+    }
+    return detail::parsePayload(
+        std::move(in),
+        FrameSerializerV1_0::kFrameHeaderSize,
+        frame.header_.flags,
+        frame.payload_);
+  }
+};
+
+template <>
+struct FrameParserV1_0<Frame_REQUEST_N> {
+  static bool parse(Frame_REQUEST_N& frame, std::unique_ptr<folly::IOBuf> in) {
+    constexpr auto kSize = FrameSerializerV1_0::kFrameHeaderSize + 4;
+    if (in->length() < kSize ||
+        !detail::parseHeader(in->data(), FrameType::REQUEST_N, frame.header_)) {
+      return false;
+    }
+    auto const requestN = folly::Endian::big(folly::loadUnaligned<int32_t>(
+        in->data() + FrameSerializerV1_0::kFrameHeaderSize));
+    if (requestN <= 0) {
+      return false;
+    }
+    frame.requestN_ = static_cast<uint32_t>(requestN);
+    return true;
+  }
+};
+
+template <>
+struct FrameParserV1_0<Frame_CANCEL> {
+  static bool parse(Frame_CANCEL& frame, std::unique_ptr<folly::IOBuf> in) {
+    return detail::parseHeader(in->data(), FrameType::CANCEL, frame.header_);
+  }
+};
+
+/// Deserializes one of the frame types FrameParserV1_0 is specialized for.
+/// Frames spread over a chain of buffers, or too short to hold a header, go
+/// through `fallback`, which must be a 1.0 serializer.
+template <typename TFrame>
+bool deserializeHotFrame(
+    TFrame& frame,
+    std::unique_ptr<folly::IOBuf> in,
+    const FrameSerializer& fallback) {
+  if (in->isChained() ||
+      in->length() < FrameSerializerV1_0::kFrameHeaderSize) {
+    return fallback.deserializeFrom(frame, std::move(in));
+  }
+  return FrameParserV1_0<TFrame>::parse(frame, std::move(in));
+}
+
+} // namespace rsocket
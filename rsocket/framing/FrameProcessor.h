@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <folly/ExceptionWrapper.h>
 #include <folly/io/IOBuf.h>
 
@@ -24,6 +26,17 @@ class FrameProcessor {
   virtual ~FrameProcessor() = default;
 
   virtual void processFrame(std::unique_ptr<folly::IOBuf>) = 0;
+
+  /// Process all the complete frames parsed out of a single read, in order.
+  /// Processors which can amortize per-frame work across the batch override
+  /// this, by default the frames are processed one by one.
+  virtual void processFrames(
+      std::vector<std::unique_ptr<folly::IOBuf>> frames) {
+    for (auto& frame : frames) {
+      processFrame(std::move(frame));
+    }
+  }
+
   virtual void onTerminal(folly::exception_wrapper) = 0;
 };
 
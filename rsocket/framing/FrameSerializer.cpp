@@ -40,8 +40,7 @@ bool& FrameSerializer::preallocateFrameSizeField() {
 }
 
 folly::IOBufQueue FrameSerializer::createBufferQueue(size_t bufferSize) const {
-  const auto prependSize =
-      preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
+  const auto prependSize = frameSizeFieldReserve();
   auto buf = folly::IOBuf::createCombined(bufferSize + prependSize);
   buf->advance(prependSize);
   folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
@@ -108,6 +108,12 @@ class FrameSerializer {
  protected:
   folly::IOBufQueue createBufferQueue(size_t bufferSize) const;
 
+  /// Number of bytes to leave in front of every serialized frame, so the frame
+  /// length field can later be written in place.
+  size_t frameSizeFieldReserve() const {
+    return preallocateFrameSizeField_ ? frameLengthFieldSize() : 0;
+  }
+
  private:
   bool preallocateFrameSizeField_{false};
 };
@@ -25,6 +25,10 @@ constexpr const size_t FrameSerializerV1_0::kMinBytesNeededForAutodetection;
 namespace {
 constexpr const uint32_t kMedatadaLengthSize = 3u; // bytes
 constexpr const uint32_t kMaxMetadataLength = 0xFFFFFFu; // 24bit max value
+
+// Payloads up to this size are copied right behind the frame header, so that
+// the serialized frame is a single contiguous buffer.
+constexpr const size_t kMaxInlinePayloadSize = 512; // bytes
 } // namespace
 
 ProtocolVersion FrameSerializerV1_0::protocolVersion() const {
@@ -39,10 +43,9 @@ static FrameType deserializeFrameType(uint16_t frameType) {
   return static_cast<FrameType>(frameType);
 }
 
-static void serializeHeaderInto(
-    folly::io::QueueAppender& appender,
-    const FrameHeader& header) {
-  appender.writeBE<int32_t>(static_cast<int32_t>(header.streamId));
+template <typename Writer>
+static void serializeHeaderInto(Writer& appender, const FrameHeader& header) {
+  appender.template writeBE<int32_t>(static_cast<int32_t>(header.streamId));
 
   auto type = static_cast<uint8_t>(header.type); // 6 bit
   auto flags = static_cast<uint16_t>(header.flags); // 10 bit
@@ -62,24 +65,33 @@ static void deserializeHeaderFrom(folly::io::Cursor& cur, FrameHeader& header) {
       static_cast<FrameFlags>(((type & 0x3) << 8) | cur.readBE<uint8_t>());
 }
 
-static void serializeMetadataInto(
-    folly::io::QueueAppender& appender,
-    std::unique_ptr<folly::IOBuf> metadata) {
-  if (metadata == nullptr) {
-    return;
-  }
+template <typename Writer>
+static void serializeMetadataLengthInto(
+    Writer& appender,
+    uint32_t metadataLength) {
+  appender.write(static_cast<uint8_t>(metadataLength >> 16)); // first byte
+  appender.write(
+      static_cast<uint8_t>((metadataLength >> 8) & 0xFF)); // second byte
+  appender.write(static_cast<uint8_t>(metadataLength & 0xFF)); // third byte
+}
 
+static uint32_t checkedMetadataLength(const folly::IOBuf& metadata) {
   // metadata length field not included in the medatadata length
   uint32_t metadataLength =
-      static_cast<uint32_t>(metadata->computeChainDataLength());
+      static_cast<uint32_t>(metadata.computeChainDataLength());
   CHECK_LT(metadataLength, kMaxMetadataLength)
       << "Metadata is too big to serialize";
+  return metadataLength;
+}
 
-  appender.write(static_cast<uint8_t>(metadataLength >> 16)); // first byte
-  appender.write(
-      static_cast<uint8_t>((metadataLength >> 8) & 0xFF)); // second byte
-  appender.write(static_cast<uint8_t>(metadataLength & 0xFF)); // third byte
+static void serializeMetadataInto(
+    folly::io::QueueAppender& appender,
+    std::unique_ptr<folly::IOBuf> metadata) {
+  if (metadata == nullptr) {
+    return;
+  }
 
+  serializeMetadataLengthInto(appender, checkedMetadataLength(*metadata));
   appender.insert(std::move(metadata));
 }
 
@@ -135,18 +147,85 @@ static uint32_t payloadFramingSize(const Payload& payload) {
   return (payload.metadata != nullptr ? kMedatadaLengthSize : 0);
 }
 
-std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
-    Frame_REQUEST_Base&& frame) const {
-  auto queue = createBufferQueue(
-      FrameSerializerV1_0::kFrameHeaderSize + sizeof(uint32_t) +
-      payloadFramingSize(frame.payload_));
+/// Serializes a frame made of `fieldsSize` bytes of header and fixed fields,
+/// written by `writeFields`, then the metadata with its length field (if
+/// there is metadata), then the data.  `reserve` bytes are left in front of
+/// the frame for the frame length field.
+///
+/// Small payloads are copied next to the fields, producing one contiguous
+/// buffer from one allocation.  Larger payloads are not copied: the fields go
+/// into the headroom of the first payload buffer when it is big enough and not
+/// shared, or else into a small buffer chained in front.
+template <typename WriteFields>
+static std::unique_ptr<folly::IOBuf> serializeFrame(
+    size_t reserve,
+    size_t fieldsSize,
+    std::unique_ptr<folly::IOBuf> metadata,
+    std::unique_ptr<folly::IOBuf> data,
+    WriteFields&& writeFields) {
+  const bool hasMetadata = metadata != nullptr;
+  const auto metadataLength =
+      hasMetadata ? checkedMetadataLength(*metadata) : 0;
+  const auto dataLength = data ? data->computeChainDataLength() : 0;
+  const auto prefixSize = fieldsSize + (hasMetadata ? kMedatadaLengthSize : 0);
+
+  auto writePrefix = [&](auto& writer) {
+    writeFields(writer);
+    if (hasMetadata) {
+      serializeMetadataLengthInto(writer, metadataLength);
+    }
+  };
+
+  if (metadataLength + dataLength <= kMaxInlinePayloadSize) {
+    auto buf = folly::IOBuf::createCombined(
+        reserve + prefixSize + metadataLength + dataLength);
+    buf->advance(reserve);
+    folly::io::Appender appender(buf.get(), /* do not grow */ 0);
+    writePrefix(appender);
+    for (const auto* part : {metadata.get(), data.get()}) {
+      if (part) {
+        for (const auto range : *part) {
+          appender.push(range.data(), range.size());
+        }
+      }
+    }
+    return buf;
+  }
 
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
+  auto payload = std::move(metadata);
+  if (!payload) {
+    payload = std::move(data);
+  } else if (data) {
+    payload->prependChain(std::move(data));
+  }
 
-  appender.writeBE<int32_t>(static_cast<int32_t>(frame.requestN_));
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  if (!payload->isSharedOne() && payload->headroom() >= reserve + prefixSize) {
+    payload->prepend(prefixSize);
+    folly::io::RWPrivateCursor cursor(payload.get());
+    writePrefix(cursor);
+    return payload;
+  }
+
+  auto buf = folly::IOBuf::createCombined(reserve + prefixSize);
+  buf->advance(reserve);
+  folly::io::Appender appender(buf.get(), /* do not grow */ 0);
+  writePrefix(appender);
+  buf->prependChain(std::move(payload));
+  return buf;
+}
+
+std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOutInternal(
+    Frame_REQUEST_Base&& frame) const {
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(uint32_t),
+      std::move(frame.payload_.metadata),
+      std::move(frame.payload_.data),
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.template writeBE<int32_t>(
+            static_cast<int32_t>(frame.requestN_));
+      });
 }
 
 static bool deserializeFromInternal(
@@ -218,83 +297,93 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_RESPONSE&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize,
+      std::move(frame.payload_.metadata),
+      std::move(frame.payload_.data),
+      [&](auto& appender) { serializeHeaderInto(appender, frame.header_); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_FNF&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize,
+      std::move(frame.payload_.metadata),
+      std::move(frame.payload_.data),
+      [&](auto& appender) { serializeHeaderInto(appender, frame.header_); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_REQUEST_N&& frame) const {
-  auto queue = createBufferQueue(kFrameHeaderSize + sizeof(uint32_t));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE<int32_t>(static_cast<int32_t>(frame.requestN_));
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(uint32_t),
+      nullptr,
+      nullptr,
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.template writeBE<int32_t>(
+            static_cast<int32_t>(frame.requestN_));
+      });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_METADATA_PUSH&& frame) const {
-  auto queue = createBufferQueue(kFrameHeaderSize);
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  if (frame.metadata_) {
-    appender.insert(std::move(frame.metadata_));
-  }
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize,
+      nullptr,
+      std::move(frame.metadata_),
+      [&](auto& appender) { serializeHeaderInto(appender, frame.header_); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_CANCEL&& frame) const {
-  auto queue = createBufferQueue(kFrameHeaderSize);
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize,
+      nullptr,
+      nullptr,
+      [&](auto& appender) { serializeHeaderInto(appender, frame.header_); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_PAYLOAD&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize,
+      std::move(frame.payload_.metadata),
+      std::move(frame.payload_.data),
+      [&](auto& appender) { serializeHeaderInto(appender, frame.header_); });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_ERROR&& frame) const {
-  auto queue = createBufferQueue(
-      kFrameHeaderSize + sizeof(uint32_t) + payloadFramingSize(frame.payload_));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE(static_cast<uint32_t>(frame.errorCode_));
-  serializePayloadInto(appender, std::move(frame.payload_));
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(uint32_t),
+      std::move(frame.payload_.metadata),
+      std::move(frame.payload_.data),
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.writeBE(static_cast<uint32_t>(frame.errorCode_));
+      });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_KEEPALIVE&& frame) const {
-  auto queue = createBufferQueue(kFrameHeaderSize + sizeof(int64_t));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE<int64_t>(static_cast<int64_t>(frame.position_));
-  if (frame.data_) {
-    appender.insert(std::move(frame.data_));
-  }
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(int64_t),
+      nullptr,
+      std::move(frame.data_),
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.template writeBE<int64_t>(
+            static_cast<int64_t>(frame.position_));
+      });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
@@ -341,16 +430,16 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_LEASE&& frame) const {
-  auto queue =
-      createBufferQueue(kFrameHeaderSize + sizeof(int32_t) + sizeof(int32_t));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE(static_cast<int32_t>(frame.ttl_));
-  appender.writeBE(static_cast<int32_t>(frame.numberOfRequests_));
-  if (frame.metadata_) {
-    appender.insert(std::move(frame.metadata_));
-  }
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(int32_t) + sizeof(int32_t),
+      nullptr,
+      std::move(frame.metadata_),
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.writeBE(static_cast<int32_t>(frame.ttl_));
+        appender.writeBE(static_cast<int32_t>(frame.numberOfRequests_));
+      });
 }
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
@@ -378,11 +467,15 @@ std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
 
 std::unique_ptr<folly::IOBuf> FrameSerializerV1_0::serializeOut(
     Frame_RESUME_OK&& frame) const {
-  auto queue = createBufferQueue(kFrameHeaderSize + sizeof(int64_t));
-  folly::io::QueueAppender appender(&queue, /* do not grow */ 0);
-  serializeHeaderInto(appender, frame.header_);
-  appender.writeBE<int64_t>(frame.position_);
-  return queue.move();
+  return serializeFrame(
+      frameSizeFieldReserve(),
+      kFrameHeaderSize + sizeof(int64_t),
+      nullptr,
+      nullptr,
+      [&](auto& appender) {
+        serializeHeaderInto(appender, frame.header_);
+        appender.template writeBE<int64_t>(frame.position_);
+      });
 }
 
 bool FrameSerializerV1_0::deserializeFrom(
@@ -34,5 +34,17 @@ class FrameTransport {
   virtual DuplexConnection* getConnection() = 0;
 
   virtual bool isConnectionFramed() const = 0;
+
+  /// See DuplexConnection::getQueuedWriteBytes().
+  virtual size_t getQueuedWriteBytes() const {
+    return 0;
+  }
+
+  /// See DuplexConnection::setWriteDrainedCallback().
+  virtual void setWriteDrainedCallback(
+      size_t /* threshold */,
+      folly::Function<void()> callback) {
+    callback();
+  }
 };
 } // namespace rsocket
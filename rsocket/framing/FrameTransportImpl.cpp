@@ -94,6 +94,14 @@ void FrameTransportImpl::onNext(std::unique_ptr<folly::IOBuf> frame) {
   }
 }
 
+void FrameTransportImpl::onNextBatch(
+    std::vector<std::unique_ptr<folly::IOBuf>> frames) {
+  // Copy in case frame processing calls through to close().
+  if (auto const processor = frameProcessor_) {
+    processor->processFrames(std::move(frames));
+  }
+}
+
 void FrameTransportImpl::terminateProcessor(folly::exception_wrapper ex) {
   // This method can be executed multiple times while terminating.
 
@@ -133,4 +141,16 @@ bool FrameTransportImpl::isConnectionFramed() const {
   return connection_->isFramed();
 }
 
+size_t FrameTransportImpl::getQueuedWriteBytes() const {
+  return connection_ ? connection_->getQueuedWriteBytes() : 0;
+}
+
+void FrameTransportImpl::setWriteDrainedCallback(
+    size_t threshold,
+    folly::Function<void()> callback) {
+  if (connection_) {
+    connection_->setWriteDrainedCallback(threshold, std::move(callback));
+  }
+}
+
 } // namespace rsocket
@@ -28,7 +28,7 @@ class FrameProcessor;
 class FrameTransportImpl
     : public FrameTransport,
       /// Registered as an input in the DuplexConnection.
-      public DuplexConnection::Subscriber,
+      public DuplexConnection::BatchSubscriber,
       public std::enable_shared_from_this<FrameTransportImpl> {
  public:
   explicit FrameTransportImpl(std::unique_ptr<DuplexConnection> connection);
@@ -53,10 +53,14 @@ class FrameTransportImpl
 
   bool isConnectionFramed() const override;
 
+  size_t getQueuedWriteBytes() const override;
+  void setWriteDrainedCallback(size_t, folly::Function<void()>) override;
+
   // Subscriber.
 
   void onSubscribe(std::shared_ptr<yarpl::flowable::Subscription>) override;
   void onNext(std::unique_ptr<folly::IOBuf>) override;
+  void onNextBatch(std::vector<std::unique_ptr<folly::IOBuf>>) override;
   void onComplete() override;
   void onError(folly::exception_wrapper) override;
 
@@ -38,6 +38,17 @@ class FramedDuplexConnection : public virtual DuplexConnection {
     return true;
   }
 
+  size_t getQueuedWriteBytes() const override {
+    return inner_ ? inner_->getQueuedWriteBytes() : 0;
+  }
+
+  void setWriteDrainedCallback(size_t threshold, folly::Function<void()> cb)
+      override {
+    if (inner_) {
+      inner_->setWriteDrainedCallback(threshold, std::move(cb));
+    }
+  }
+
   DuplexConnection* getConnection() {
     return inner_.get();
   }
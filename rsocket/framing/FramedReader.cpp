@@ -96,6 +96,10 @@ void FramedReader::parseFrames() {
 
   dispatchingFrames_ = true;
 
+  // Frames parsed out of the buffered bytes, if the inner subscriber takes
+  // them in batches.
+  std::vector<std::unique_ptr<folly::IOBuf>> batch;
+
   while (allowance_.canConsume(1) && inner_) {
     if (!ensureOrAutodetectProtocolVersion()) {
       // At this point we dont have enough bytes on the wire or we errored out.
@@ -110,6 +114,8 @@ void FramedReader::parseFrames() {
 
     auto const nextFrameSize = readFrameLength();
     if (nextFrameSize < minimalFrameLength(*version_)) {
+      // Frames before the invalid one are still valid.
+      deliverBatch(batch);
       error("Invalid frame - Frame size smaller than minimum");
       break;
     }
@@ -132,12 +138,36 @@ void FramedReader::parseFrames() {
 
     VLOG(4) << "parsed frame length=" << nextFrame->length() << '\n'
             << hexDump(nextFrame->clone()->moveToFbString());
-    inner_->onNext(std::move(nextFrame));
+    if (innerTakesBatches_) {
+      batch.push_back(std::move(nextFrame));
+    } else {
+      inner_->onNext(std::move(nextFrame));
+    }
   }
 
+  deliverBatch(batch);
   dispatchingFrames_ = false;
 }
 
+void FramedReader::deliverBatch(
+    std::vector<std::unique_ptr<folly::IOBuf>>& batch) {
+  if (batch.empty()) {
+    return;
+  }
+  auto const inner = inner_;
+  if (!inner) {
+    batch.clear();
+    return;
+  }
+  if (batch.size() == 1) {
+    inner->onNext(std::move(batch.front()));
+  } else {
+    static_cast<DuplexConnection::BatchSubscriber&>(*inner).onNextBatch(
+        std::move(batch));
+  }
+  batch.clear();
+}
+
 void FramedReader::onComplete() {
   payloadQueue_.move();
   auto subscription = std::move(subscription_);
@@ -171,6 +201,8 @@ void FramedReader::setInput(
   CHECK(!inner_)
       << "Must cancel original input to FramedReader before setting a new one";
   inner_ = std::move(inner);
+  innerTakesBatches_ =
+      dynamic_cast<DuplexConnection::BatchSubscriber*>(inner_.get()) != nullptr;
   inner_->onSubscribe(shared_from_this());
 }
 
@@ -52,11 +52,17 @@ class FramedReader : public DuplexConnection::Subscriber,
   void parseFrames();
   bool ensureOrAutodetectProtocolVersion();
 
+  /// Hand the frames collected so far to the inner subscriber.
+  void deliverBatch(std::vector<std::unique_ptr<folly::IOBuf>>&);
+
   size_t readFrameLength() const;
 
   std::shared_ptr<yarpl::flowable::Subscription> subscription_;
   std::shared_ptr<DuplexConnection::Subscriber> inner_;
 
+  /// Whether inner_ is a DuplexConnection::BatchSubscriber.
+  bool innerTakesBatches_{false};
+
   Allowance allowance_;
   bool dispatchingFrames_{false};
 
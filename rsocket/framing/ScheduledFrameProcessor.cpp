@@ -33,6 +33,16 @@ void ScheduledFrameProcessor::processFrame(
       });
 }
 
+void ScheduledFrameProcessor::processFrames(
+    std::vector<std::unique_ptr<folly::IOBuf>> frames) {
+  CHECK(processor_) << "Calling processFrames() after onTerminal()";
+
+  evb_->runInEventBaseThread(
+      [processor = processor_, frames = std::move(frames)]() mutable {
+        processor->processFrames(std::move(frames));
+      });
+}
+
 void ScheduledFrameProcessor::onTerminal(folly::exception_wrapper ew) {
   evb_->runInEventBaseThread(
       [e = std::move(ew), processor = std::move(processor_)]() mutable {
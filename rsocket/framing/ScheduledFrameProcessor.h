@@ -34,6 +34,7 @@ class ScheduledFrameProcessor : public FrameProcessor {
   ~ScheduledFrameProcessor();
 
   void processFrame(std::unique_ptr<folly::IOBuf>) override;
+  void processFrames(std::vector<std::unique_ptr<folly::IOBuf>>) override;
   void onTerminal(folly::exception_wrapper) override;
 
  private:
@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/AdaptiveRequestWindow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+constexpr std::chrono::milliseconds AdaptiveRequestWindow::kMinRound;
+
+AdaptiveRequestWindow::AdaptiveRequestWindow(Options options)
+    : options_(std::move(options)) {
+  CHECK_GT(options_.minWindow, 0u);
+  CHECK_LE(options_.minWindow, options_.maxWindow);
+  CHECK_LE(options_.maxWindow, static_cast<size_t>(kMaxRequestN));
+  window_ = std::min(
+      std::max(options_.initialWindow, options_.minWindow),
+      options_.maxWindow);
+}
+
+size_t AdaptiveRequestWindow::start(Clock::time_point now) {
+  started_ = now;
+  outstanding_ = window_;
+  return window_;
+}
+
+size_t AdaptiveRequestWindow::onDelivered(Clock::time_point now) {
+  if (outstanding_ > 0) {
+    --outstanding_;
+  }
+
+  if (!delivered_) {
+    delivered_ = true;
+    firstItemDelay_ = std::max(
+        std::chrono::microseconds{1},
+        std::chrono::duration_cast<std::chrono::microseconds>(now - started_));
+    roundStart_ = now;
+  } else {
+    ++roundDelivered_;
+    if (now - roundStart_ >= std::max<Clock::duration>(rtt(), kMinRound)) {
+      endRound(now);
+    }
+  }
+
+  if (outstanding_ > window_ / 2) {
+    return 0;
+  }
+  auto const credit = window_ - outstanding_;
+  outstanding_ = window_;
+  return credit;
+}
+
+std::chrono::microseconds AdaptiveRequestWindow::rtt() const {
+  if (options_.rtt) {
+    auto const rtt = options_.rtt();
+    if (rtt.count() > 0) {
+      return rtt;
+    }
+  }
+  return firstItemDelay_;
+}
+
+void AdaptiveRequestWindow::endRound(Clock::time_point now) {
+  auto const elapsed = std::chrono::duration<double>(now - roundStart_);
+  auto const rtt = std::chrono::duration<double>(this->rtt());
+  auto const perRtt = roundDelivered_ * (rtt.count() / elapsed.count());
+  auto const target = static_cast<size_t>(std::min(
+      std::ceil(2 * perRtt), static_cast<double>(options_.maxWindow)));
+
+  if (target > window_) {
+    window_ = std::min(target, window_ * 2);
+  } else if (target < window_ / 2) {
+    window_ = std::max(target, window_ / 2);
+  }
+  window_ = std::min(std::max(window_, options_.minWindow), options_.maxWindow);
+
+  roundStart_ = now;
+  roundDelivered_ = 0;
+}
+
+} // namespace rsocket
@@ -0,0 +1,93 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace rsocket {
+
+/// Sizes the credit a consumer keeps outstanding on a stream, the way TCP
+/// receive window auto-tuning sizes its window.
+///
+/// The window is kept at twice the number of items delivered per round trip,
+/// so the credit requested when half of it has been used arrives before the
+/// other half runs out.  While the window is what limits the stream, the
+/// delivery rate grows with it and the window keeps growing, at most doubling
+/// every round trip.  Once the producer, the link or the application is the
+/// limit, the window settles, and shrinks again if the rate drops.
+///
+/// The round trip time comes from Options::rtt when it is set, and is
+/// otherwise estimated from the delay of the first item.
+///
+/// Not thread safe.
+class AdaptiveRequestWindow {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    /// Credit requested when the stream starts.
+    size_t initialWindow{32};
+
+    /// Bounds of the window.
+    size_t minWindow{8};
+    size_t maxWindow{64 * 1024};
+
+    /// Current round trip time of the connection, e.g. one measured with
+    /// keepalives.  Returning zero falls back to the estimate.
+    std::function<std::chrono::microseconds()> rtt;
+  };
+
+  explicit AdaptiveRequestWindow(Options options);
+
+  /// Starts the stream.  Returns the credit to request.
+  size_t start(Clock::time_point now);
+
+  /// Accounts for an item delivered at `now`.  Returns the credit to request,
+  /// which is zero most of the time.
+  size_t onDelivered(Clock::time_point now);
+
+  size_t window() const {
+    return window_;
+  }
+
+  /// Credit requested but not delivered yet.
+  size_t outstanding() const {
+    return outstanding_;
+  }
+
+  std::chrono::microseconds rtt() const;
+
+ private:
+  /// Shortest period to measure the delivery rate over.
+  static constexpr std::chrono::milliseconds kMinRound{1};
+
+  void endRound(Clock::time_point now);
+
+  const Options options_;
+
+  size_t window_;
+  size_t outstanding_{0};
+
+  Clock::time_point started_;
+  bool delivered_{false};
+  std::chrono::microseconds firstItemDelay_{0};
+
+  Clock::time_point roundStart_;
+  size_t roundDelivered_{0};
+};
+
+} // namespace rsocket
@@ -51,6 +51,12 @@ static const char* getTerminatingSignalErrorMessage(int terminatingSignal) {
   }
 }
 
+constexpr uint8_t StreamPriority::kMostUrgent;
+constexpr uint8_t StreamPriority::kDefaultUrgency;
+constexpr uint8_t StreamPriority::kLeastUrgent;
+
+constexpr size_t RttStats::kHistogramBuckets;
+
 folly::StringPiece toString(StreamType t) {
   switch (t) {
     case StreamType::REQUEST_RESPONSE:
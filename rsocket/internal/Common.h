@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -76,6 +78,111 @@ enum class StreamType {
 folly::StringPiece toString(StreamType);
 std::ostream& operator<<(std::ostream&, StreamType);
 
+/// Scheduling priority of a stream's outgoing frames.
+///
+/// While a connection's output is congested, the frames that streams write
+/// wait in per-stream queues.  Streams of a more urgent class are always
+/// served first.  Streams of the same class take turns, writing up to
+/// `weight` frames each per turn.  REQUEST_N, CANCEL and connection level
+/// frames never wait.
+///
+/// Priorities are local to a connection's side and are not sent to the peer.
+struct StreamPriority {
+  static constexpr uint8_t kMostUrgent = 0;
+  static constexpr uint8_t kDefaultUrgency = 3;
+  static constexpr uint8_t kLeastUrgent = 7;
+
+  StreamPriority() = default;
+  explicit StreamPriority(uint8_t urgency_, uint16_t weight_ = 1)
+      : urgency{urgency_}, weight{weight_} {}
+
+  /// Between kMostUrgent and kLeastUrgent, larger values are clamped.
+  uint8_t urgency{kDefaultUrgency};
+
+  /// Share of the output within the urgency class, at least 1.
+  uint16_t weight{1};
+};
+
+/// What a connection does when the frames it holds because it can't write
+/// them, e.g. while it is disconnected and waiting to resume, outgrow their
+/// budget.  Only request and PAYLOAD frames count against the budget's
+/// policy; REQUEST_N, CANCEL, ERROR and connection level frames are always
+/// held.
+enum class PendingOutputPolicy : uint8_t {
+  /// Stop granting the peer's credit to local publishers until the frames
+  /// have been written, but keep holding everything they produce.  A
+  /// publisher may still use up the credit it was granted before, see
+  /// PendingOutputLimit::publisherWindow.
+  BLOCK,
+  /// As BLOCK, and fail each stream whose frame doesn't fit, on both sides.
+  FAIL_STREAMS,
+  /// As BLOCK, and drop the oldest held fire-and-forget requests to make
+  /// room.
+  DROP_OLDEST_FNF,
+};
+
+struct PendingOutputLimit {
+  /// Budget for the frames held, unlimited by default.
+  size_t maxBytes{std::numeric_limits<size_t>::max()};
+  PendingOutputPolicy policy{PendingOutputPolicy::BLOCK};
+
+  /// With a budget, local publishers are granted at most this many items of
+  /// the peer's credit at a time, which bounds what each produces once the
+  /// budget is used up.
+  uint32_t publisherWindow{64};
+
+  bool isLimited() const {
+    return maxBytes != std::numeric_limits<size_t>::max();
+  }
+};
+
+/// Credit a consumer keeps granted to its peer, when it prefetches.
+///
+/// By default a consumer sends a REQUEST_N as soon as the application
+/// requests more, so an application requesting one item per item received
+/// sends one REQUEST_N per PAYLOAD.  With watermarks, the consumer grants its
+/// peer `high` items up front, whatever the application requested, and tops
+/// the credit back up to `high` only once the items granted but not yet
+/// handed to the application have dropped to `low`.  Items that arrive
+/// before the application requests them are held, never more than `high`.
+///
+/// Completion is delivered once the held items have been; errors and
+/// cancellation drop them.
+struct RequestNWatermarks {
+  RequestNWatermarks() = default;
+  RequestNWatermarks(uint32_t low_, uint32_t high_) : low{low_}, high{high_} {}
+
+  bool enabled() const {
+    return high > 0;
+  }
+
+  uint32_t low{0};
+  /// Zero disables prefetching.
+  uint32_t high{0};
+};
+
+/// Round trip time of a connection, measured by the client with the
+/// timestamps its keepalives carry.  Servers don't send keepalives, so they
+/// have no samples.
+struct RttStats {
+  /// Samples below 128us land in bucket 0; each following bucket covers
+  /// twice the range of the previous one, and the last is unbounded.
+  static constexpr size_t kHistogramBuckets = 20;
+
+  /// Upper bound of a histogram bucket, except for the last one.
+  static std::chrono::microseconds bucketLimit(size_t bucket) {
+    return std::chrono::microseconds{128} * (int64_t{1} << bucket);
+  }
+
+  size_t samples{0};
+  std::chrono::microseconds latest{0};
+  std::chrono::microseconds min{0};
+  /// Smoothed RTT and RTT variance, as TCP computes them (RFC 6298).
+  std::chrono::microseconds smoothed{0};
+  std::chrono::microseconds variance{0};
+  std::array<uint64_t, kHistogramBuckets> histogram{};
+};
+
 enum class RequestOriginator {
   LOCAL,
   REMOTE,
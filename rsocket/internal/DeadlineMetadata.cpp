@@ -0,0 +1,97 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/DeadlineMetadata.h"
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace rsocket {
+
+namespace {
+
+/// Set in the entry's flags when the request had no metadata.
+constexpr uint8_t kNoMetadata = 0x01;
+
+/// Flags and milliseconds.
+constexpr size_t kDeadlineEntrySize = sizeof(uint8_t) + sizeof(uint32_t);
+
+/// MIME type length, MIME type and the entry's uint24 length.
+constexpr size_t kEntryHeaderSize =
+    sizeof(uint8_t) + kDeadlineMimeType.size() + 3;
+
+} // namespace
+
+void encodeDeadline(Payload& payload, std::chrono::milliseconds budget) {
+  auto const millis = std::min<int64_t>(
+      std::max<int64_t>(budget.count(), 1),
+      std::numeric_limits<uint32_t>::max());
+
+  auto entry = folly::IOBuf::create(kEntryHeaderSize + kDeadlineEntrySize);
+  folly::io::Appender appender(entry.get(), 0);
+  appender.write(static_cast<uint8_t>(kDeadlineMimeType.size() - 1));
+  appender.push(
+      reinterpret_cast<const uint8_t*>(kDeadlineMimeType.data()),
+      kDeadlineMimeType.size());
+  appender.write<uint8_t>(0);
+  appender.writeBE(static_cast<uint16_t>(kDeadlineEntrySize));
+  appender.write(payload.metadata ? uint8_t{0} : kNoMetadata);
+  appender.writeBE<uint32_t>(static_cast<uint32_t>(millis));
+
+  if (payload.metadata) {
+    entry->prependChain(std::move(payload.metadata));
+  }
+  payload.metadata = std::move(entry);
+}
+
+folly::Optional<std::chrono::milliseconds> decodeDeadline(Payload& payload) {
+  if (!payload.metadata ||
+      payload.metadata->computeChainDataLength() <
+          kEntryHeaderSize + kDeadlineEntrySize) {
+    return folly::none;
+  }
+
+  folly::io::Cursor cursor(payload.metadata.get());
+  // Entries with a well-known MIME type id set the high bit instead.
+  if (cursor.read<uint8_t>() != kDeadlineMimeType.size() - 1 ||
+      cursor.readFixedString(kDeadlineMimeType.size()) !=
+          kDeadlineMimeType.str()) {
+    return folly::none;
+  }
+  auto const length = (size_t{cursor.read<uint8_t>()} << 16) |
+      cursor.readBE<uint16_t>();
+  if (length != kDeadlineEntrySize) {
+    return folly::none;
+  }
+  auto const flags = cursor.read<uint8_t>();
+  auto const millis = cursor.readBE<uint32_t>();
+
+  if (flags & kNoMetadata) {
+    payload.metadata.reset();
+  } else {
+    folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+    queue.append(std::move(payload.metadata));
+    queue.trimStart(kEntryHeaderSize + kDeadlineEntrySize);
+    payload.metadata = queue.move();
+    if (!payload.metadata) {
+      payload.metadata = folly::IOBuf::create(0);
+    }
+  }
+  return std::chrono::milliseconds{millis};
+}
+
+} // namespace rsocket
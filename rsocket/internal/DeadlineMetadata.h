@@ -0,0 +1,58 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <chrono>
+
+#include "rsocket/Payload.h"
+
+namespace rsocket {
+
+/// Metadata MIME type of connections whose metadata is composite metadata, a
+/// sequence of entries that each carry their own MIME type:
+///
+///   | MIME type length - 1 (uint8) | MIME type | length (uint24, big endian) |
+///   | entry metadata |
+///
+/// Deadlines are only sent on such connections, where an entry of their own
+/// can't be confused with the application's metadata.
+constexpr folly::StringPiece kCompositeMetadataMimeType =
+    "message/x.rsocket.composite-metadata.v0";
+
+/// MIME type of the composite metadata entry carrying a request's deadline,
+/// as the time left until it:
+///
+///   | flags (uint8) | milliseconds left (uint32, big endian) |
+///
+/// Sending a budget rather than a point in time spares the two sides from
+/// agreeing on the time.  The only flag tells whether the request had no
+/// metadata at all, so the responder can hand the application the metadata
+/// it sent, be it null or empty.
+constexpr folly::StringPiece kDeadlineMimeType =
+    "message/x.rsocket.request-deadline.v0";
+
+/// Puts an entry with `budget`, clamped to at least a millisecond, in front
+/// of the composite metadata of `payload`.
+void encodeDeadline(Payload& payload, std::chrono::milliseconds budget);
+
+/// Strips an entry added by encodeDeadline from the composite metadata of
+/// `payload`, and returns the budget it carried.  Leaves other metadata
+/// alone.
+folly::Optional<std::chrono::milliseconds> decodeDeadline(Payload& payload);
+
+} // namespace rsocket
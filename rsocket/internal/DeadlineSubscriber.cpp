@@ -0,0 +1,145 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/DeadlineSubscriber.h"
+
+#include <string>
+
+#include "rsocket/RSocketException.h"
+
+namespace rsocket {
+
+namespace {
+
+folly::exception_wrapper deadlineExceeded(std::chrono::milliseconds timeout) {
+  return DeadlineExceededException(
+      "request deadline of " + std::to_string(timeout.count()) +
+      "ms exceeded");
+}
+
+} // namespace
+
+DeadlineSubscriber::DeadlineSubscriber(
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> inner,
+    folly::EventBase& eventBase,
+    std::chrono::milliseconds timeout)
+    : inner_(std::move(inner)), eventBase_(eventBase), timeout_(timeout) {}
+
+void DeadlineSubscriber::onSubscribe(
+    std::shared_ptr<yarpl::flowable::Subscription> subscription) {
+  subscription_ = std::move(subscription);
+  eventBase_.timer().scheduleTimeout(this, timeout_);
+  inner_->onSubscribe(shared_from_this());
+}
+
+void DeadlineSubscriber::onNext(Payload payload) {
+  if (inner_) {
+    inner_->onNext(std::move(payload));
+  }
+}
+
+void DeadlineSubscriber::onComplete() {
+  cancelTimeout();
+  subscription_ = nullptr;
+  if (auto inner = std::move(inner_)) {
+    inner->onComplete();
+  }
+}
+
+void DeadlineSubscriber::onError(folly::exception_wrapper ew) {
+  cancelTimeout();
+  subscription_ = nullptr;
+  if (auto inner = std::move(inner_)) {
+    inner->onError(std::move(ew));
+  }
+}
+
+void DeadlineSubscriber::request(int64_t n) {
+  if (subscription_) {
+    subscription_->request(n);
+  }
+}
+
+void DeadlineSubscriber::cancel() {
+  cancelTimeout();
+  inner_ = nullptr;
+  if (auto subscription = std::move(subscription_)) {
+    subscription->cancel();
+  }
+}
+
+void DeadlineSubscriber::timeoutExpired() noexcept {
+  // The error may drop the last reference to this.
+  auto self = shared_from_this();
+  auto inner = std::move(inner_);
+  if (!inner) {
+    return;
+  }
+  if (auto subscription = std::move(subscription_)) {
+    subscription->cancel();
+  }
+  inner->onError(deadlineExceeded(timeout_));
+}
+
+DeadlineSingleObserver::DeadlineSingleObserver(
+    std::shared_ptr<yarpl::single::SingleObserver<Payload>> inner,
+    folly::EventBase& eventBase,
+    std::chrono::milliseconds timeout)
+    : inner_(std::move(inner)), eventBase_(eventBase), timeout_(timeout) {}
+
+void DeadlineSingleObserver::onSubscribe(
+    std::shared_ptr<yarpl::single::SingleSubscription> subscription) {
+  subscription_ = std::move(subscription);
+  eventBase_.timer().scheduleTimeout(this, timeout_);
+  inner_->onSubscribe(shared_from_this());
+}
+
+void DeadlineSingleObserver::onSuccess(Payload payload) {
+  cancelTimeout();
+  subscription_ = nullptr;
+  if (auto inner = std::move(inner_)) {
+    inner->onSuccess(std::move(payload));
+  }
+}
+
+void DeadlineSingleObserver::onError(folly::exception_wrapper ew) {
+  cancelTimeout();
+  subscription_ = nullptr;
+  if (auto inner = std::move(inner_)) {
+    inner->onError(std::move(ew));
+  }
+}
+
+void DeadlineSingleObserver::cancel() {
+  cancelTimeout();
+  inner_ = nullptr;
+  if (auto subscription = std::move(subscription_)) {
+    subscription->cancel();
+  }
+}
+
+void DeadlineSingleObserver::timeoutExpired() noexcept {
+  // The error may drop the last reference to this.
+  auto self = shared_from_this();
+  auto inner = std::move(inner_);
+  if (!inner) {
+    return;
+  }
+  if (auto subscription = std::move(subscription_)) {
+    subscription->cancel();
+  }
+  inner->onError(deadlineExceeded(timeout_));
+}
+
+} // namespace rsocket
@@ -0,0 +1,95 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+
+#include <chrono>
+#include <memory>
+
+#include "rsocket/Payload.h"
+#include "yarpl/flowable/Subscriber.h"
+#include "yarpl/flowable/Subscription.h"
+#include "yarpl/single/SingleObserver.h"
+#include "yarpl/single/SingleSubscription.h"
+
+namespace rsocket {
+
+//
+// Decorators that give a request a deadline.  If the request has not
+// completed `timeout` after it was subscribed to, they cancel it and deliver
+// a DeadlineExceededException instead.
+//
+// They sit between the stream state machine and the Scheduled* decorators,
+// so every call on them happens on the connection's EventBase.  The timer is
+// cancelled as soon as the request terminates either way.
+//
+
+class DeadlineSubscriber
+    : public yarpl::flowable::Subscriber<Payload>,
+      public yarpl::flowable::Subscription,
+      public folly::HHWheelTimer::Callback,
+      public std::enable_shared_from_this<DeadlineSubscriber> {
+ public:
+  DeadlineSubscriber(
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> inner,
+      folly::EventBase& eventBase,
+      std::chrono::milliseconds timeout);
+
+  void onSubscribe(std::shared_ptr<yarpl::flowable::Subscription>) override;
+  void onNext(Payload) override;
+  void onComplete() override;
+  void onError(folly::exception_wrapper) override;
+
+  void request(int64_t n) override;
+  void cancel() override;
+
+ private:
+  void timeoutExpired() noexcept override;
+
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>> inner_;
+  std::shared_ptr<yarpl::flowable::Subscription> subscription_;
+  folly::EventBase& eventBase_;
+  const std::chrono::milliseconds timeout_;
+};
+
+class DeadlineSingleObserver
+    : public yarpl::single::SingleObserver<Payload>,
+      public yarpl::single::SingleSubscription,
+      public folly::HHWheelTimer::Callback,
+      public std::enable_shared_from_this<DeadlineSingleObserver> {
+ public:
+  DeadlineSingleObserver(
+      std::shared_ptr<yarpl::single::SingleObserver<Payload>> inner,
+      folly::EventBase& eventBase,
+      std::chrono::milliseconds timeout);
+
+  void onSubscribe(std::shared_ptr<yarpl::single::SingleSubscription>) override;
+  void onSuccess(Payload) override;
+  void onError(folly::exception_wrapper) override;
+
+  void cancel() override;
+
+ private:
+  void timeoutExpired() noexcept override;
+
+  std::shared_ptr<yarpl::single::SingleObserver<Payload>> inner_;
+  std::shared_ptr<yarpl::single::SingleSubscription> subscription_;
+  folly::EventBase& eventBase_;
+  const std::chrono::milliseconds timeout_;
+};
+
+} // namespace rsocket
@@ -14,8 +14,25 @@
 
 #include "rsocket/internal/KeepaliveTimer.h"
 
+#include <folly/io/Cursor.h>
+
 namespace rsocket {
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::unique_ptr<folly::IOBuf> makeTimestamp() {
+  auto const now = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now().time_since_epoch());
+  auto buf = folly::IOBuf::create(sizeof(uint64_t));
+  folly::io::Appender appender(buf.get(), 0);
+  appender.writeBE<uint64_t>(static_cast<uint64_t>(now.count()));
+  return buf;
+}
+
+} // namespace
+
 KeepaliveTimer::KeepaliveTimer(
     std::chrono::milliseconds period,
     folly::EventBase& eventBase)
@@ -60,7 +77,7 @@ void KeepaliveTimer::sendKeepalive(FrameSink& sink) {
     // this must happen before sendKeepalive as it can potentially result in
     // stop() being called
     pending_ = true;
-    sink.sendKeepalive();
+    sink.sendKeepalive(makeTimestamp());
     schedule();
   }
 }
@@ -84,4 +101,20 @@ void KeepaliveTimer::start(const std::shared_ptr<FrameSink>& connection) {
 void KeepaliveTimer::keepaliveReceived() {
   pending_ = false;
 }
+
+folly::Optional<std::chrono::microseconds> KeepaliveTimer::roundTripTime(
+    const folly::IOBuf* data) {
+  if (!data || data->computeChainDataLength() != sizeof(uint64_t)) {
+    return folly::none;
+  }
+  folly::io::Cursor cursor(data);
+  auto const sent = std::chrono::microseconds{
+      static_cast<int64_t>(cursor.readBE<uint64_t>())};
+  auto const now = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now().time_since_epoch());
+  if (sent > now) {
+    return folly::none;
+  }
+  return now - sent;
+}
 } // namespace rsocket
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/io/async/EventBase.h>
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
@@ -38,6 +39,12 @@ class KeepaliveTimer {
 
   void keepaliveReceived();
 
+  /// Round trip time of the keepalive that the peer answered with `data`.
+  /// Keepalives carry the time they were sent, which the peer echoes back.
+  /// None if `data` doesn't hold such a timestamp.
+  static folly::Optional<std::chrono::microseconds> roundTripTime(
+      const folly::IOBuf* data);
+
  private:
   std::shared_ptr<FrameSink> connection_;
   folly::EventBase& eventBase_;
@@ -0,0 +1,53 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace rsocket {
+
+/// Tracks the remaining requests and the expiry of the most recent lease, on
+/// either the sending or the receiving side of a connection.
+class LeaseWindow {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Replace the current lease with a new one, starting now.
+  void grant(std::chrono::milliseconds ttl, uint32_t numberOfRequests) {
+    expiry_ = Clock::now() + ttl;
+    remaining_ = numberOfRequests;
+  }
+
+  /// Consume one request from the current lease.  Returns false if the lease
+  /// has expired or has been used up.
+  bool tryConsume() {
+    if (remaining_ == 0 || Clock::now() >= expiry_) {
+      return false;
+    }
+    --remaining_;
+    return true;
+  }
+
+  uint32_t remaining() const {
+    return Clock::now() < expiry_ ? remaining_ : 0;
+  }
+
+ private:
+  Clock::time_point expiry_;
+  uint32_t remaining_{0};
+};
+
+} // namespace rsocket
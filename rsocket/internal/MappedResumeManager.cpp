@@ -0,0 +1,673 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/MappedResumeManager.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <folly/Exception.h>
+#include <folly/Format.h>
+#include <folly/io/IOBuf.h>
+
+#include "rsocket/framing/FrameTransport.h"
+
+namespace rsocket {
+
+namespace {
+constexpr uint64_t kMagic = 0x5253525345554d45; // "RSRSEUME"
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderSize = 4096;
+
+// The stream journal follows the header page, in two halves.  The header's
+// `journalState` holds the active half in its top bit and the bytes used in
+// it in the others, so switching halves is a single store.
+constexpr size_t kJournalHalfSize = 512 * 1024;
+constexpr size_t kJournalSize = 2 * kJournalHalfSize;
+constexpr uint64_t kJournalHalfBit = uint64_t{1} << 63;
+// The stream table outgrew a journal half and is not persisted.
+constexpr uint64_t kJournalLost = ~uint64_t{0};
+
+// Each cached frame is preceded by its position and length.
+struct RecordHeader {
+  int64_t position;
+  uint32_t length;
+} __attribute__((__packed__));
+constexpr size_t kRecordHeaderSize = sizeof(RecordHeader);
+
+// Stream journal records.  A stream is added by OPEN (followed by its token),
+// removed by CLOSE, and ALLOWANCE replaces its allowances.
+enum class JournalOp : uint8_t {
+  OPEN = 1,
+  CLOSE = 2,
+  ALLOWANCE = 3,
+};
+
+struct JournalOpen {
+  JournalOp op;
+  uint32_t streamId;
+  uint8_t streamType;
+  uint8_t requester;
+  uint32_t tokenLength;
+} __attribute__((__packed__));
+
+struct JournalClose {
+  JournalOp op;
+  uint32_t streamId;
+} __attribute__((__packed__));
+
+struct JournalAllowance {
+  JournalOp op;
+  uint32_t streamId;
+  uint64_t producerAllowance;
+  uint64_t consumerAllowance;
+} __attribute__((__packed__));
+
+template <typename Record>
+void appendRecord(std::string& out, const Record& record) {
+  out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+void appendOpen(
+    std::string& out,
+    StreamId streamId,
+    const StreamResumeInfo& info) {
+  JournalOpen record;
+  record.op = JournalOp::OPEN;
+  record.streamId = streamId;
+  record.streamType = static_cast<uint8_t>(info.streamType);
+  record.requester = static_cast<uint8_t>(info.requester);
+  record.tokenLength = static_cast<uint32_t>(info.streamToken.size());
+  appendRecord(out, record);
+  out.append(info.streamToken);
+}
+
+void appendAllowance(
+    std::string& out,
+    StreamId streamId,
+    const StreamResumeInfo& info) {
+  JournalAllowance record;
+  record.op = JournalOp::ALLOWANCE;
+  record.streamId = streamId;
+  record.producerAllowance = info.producerAllowance;
+  record.consumerAllowance = info.consumerAllowance;
+  appendRecord(out, record);
+}
+
+template <typename Record>
+void readRecord(
+    const uint8_t* data,
+    size_t length,
+    size_t& offset,
+    Record& record) {
+  if (length - offset < sizeof(record)) {
+    throw std::runtime_error("Truncated journal record");
+  }
+  std::memcpy(&record, data + offset, sizeof(record));
+  offset += sizeof(record);
+}
+} // namespace
+
+// Lives at the start of the mapped file.  `head` and `tail` are the commit
+// points: frame bytes are written before `tail` moves past them, so a process
+// dying mid-append leaves the previous ring intact.
+struct MappedResumeManager::FileHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t capacity;
+  uint64_t head;
+  uint64_t tail;
+  int64_t lastSentPosition;
+  int64_t impliedPosition;
+  uint32_t largestUsedStreamId;
+  uint64_t journalState;
+};
+
+// Owns the file descriptor and the mapping.  Shared with every IOBuf handed
+// out by sendFramesFromPosition() so the pages outlive the manager if needed.
+struct MappedResumeManager::Mapping {
+  Mapping(int fd_, void* addr_, size_t length_)
+      : fd(fd_), addr(addr_), length(length_) {}
+
+  ~Mapping() {
+    ::munmap(addr, length);
+    ::close(fd);
+  }
+
+  const int fd;
+  void* const addr;
+  const size_t length;
+
+  // Number of outstanding IOBufs pointing into the ring.
+  std::atomic<size_t> pins{0};
+};
+
+MappedResumeManager::MappedResumeManager(
+    std::shared_ptr<RSocketStats> stats,
+    std::string path,
+    size_t capacity)
+    : stats_(std::move(stats)), path_(std::move(path)) {
+  static_assert(
+      sizeof(FileHeader) <= kHeaderSize, "Header must fit in the header page");
+  CHECK_GT(capacity, kRecordHeaderSize);
+
+  const int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  folly::checkUnixError(fd, "Failed to open resume file ", path_);
+
+  try {
+    // Two managers sharing a ring would corrupt it.
+    folly::checkUnixError(
+        ::flock(fd, LOCK_EX | LOCK_NB), "Resume file is in use ", path_);
+
+    struct stat st;
+    folly::checkUnixError(::fstat(fd, &st), "Failed to stat ", path_);
+
+    const bool fresh = st.st_size == 0;
+    size_t length = kHeaderSize + kJournalSize + capacity;
+    if (fresh) {
+      folly::checkUnixError(
+          ::ftruncate(fd, static_cast<off_t>(length)),
+          "Failed to size resume file ",
+          path_);
+    } else {
+      if (static_cast<size_t>(st.st_size) <= kHeaderSize + kJournalSize) {
+        throw std::runtime_error("Resume file is truncated");
+      }
+      length = static_cast<size_t>(st.st_size);
+    }
+
+    void* addr =
+        ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      folly::throwSystemError("Failed to map resume file ", path_);
+    }
+    mapping_ = std::make_shared<Mapping>(fd, addr, length);
+  } catch (...) {
+    if (!mapping_) {
+      ::close(fd);
+    }
+    throw;
+  }
+
+  header_ = static_cast<FileHeader*>(mapping_->addr);
+  journal_ = static_cast<uint8_t*>(mapping_->addr) + kHeaderSize;
+  ring_ = journal_ + kJournalSize;
+  capacity_ = mapping_->length - kHeaderSize - kJournalSize;
+
+  if (header_->magic == 0) {
+    std::memset(header_, 0, sizeof(FileHeader));
+    header_->version = kVersion;
+    header_->headerSize = kHeaderSize;
+    header_->capacity = capacity_;
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kMagic;
+    return;
+  }
+
+  try {
+    load();
+    loadJournal();
+  } catch (const std::exception& ex) {
+    throw std::runtime_error(folly::sformat(
+        "Failed loading resume file {}. {}", path_, ex.what()));
+  }
+
+  if (capacity_ != capacity) {
+    VLOG(1) << "Reusing resume file " << path_ << " with capacity "
+            << capacity_ << " instead of " << capacity;
+  }
+}
+
+MappedResumeManager::~MappedResumeManager() {
+  if (!frames_.empty()) {
+    stats_->resumeBufferChanged(
+        -static_cast<int>(frames_.size()), -static_cast<int>(size()));
+  }
+}
+
+void MappedResumeManager::load() {
+  if (header_->magic != kMagic || header_->version != kVersion ||
+      header_->headerSize != kHeaderSize || header_->capacity != capacity_) {
+    throw std::runtime_error("Invalid header");
+  }
+  if (header_->head > header_->tail ||
+      header_->tail - header_->head > capacity_) {
+    throw std::runtime_error("Invalid ring cursors");
+  }
+
+  head_ = header_->head;
+  tail_ = header_->tail;
+  impliedPosition_ = header_->impliedPosition;
+  largestUsedStreamId_ = header_->largestUsedStreamId;
+
+  ResumePosition position = header_->lastSentPosition;
+  for (auto cursor = head_; cursor != tail_;) {
+    if (tail_ - cursor < kRecordHeaderSize) {
+      throw std::runtime_error("Truncated frame record");
+    }
+    RecordHeader record;
+    copyOut(cursor, &record, kRecordHeaderSize);
+    if (record.length > tail_ - cursor - kRecordHeaderSize) {
+      throw std::runtime_error("Truncated frame record");
+    }
+    if (!frames_.empty() && record.position != position) {
+      throw std::runtime_error("Frame positions are not contiguous");
+    }
+    frames_.emplace_back(record.position, cursor);
+    position = record.position + record.length;
+    cursor += kRecordHeaderSize + record.length;
+  }
+
+  // The ring is authoritative; the header positions only matter when it is
+  // empty.
+  if (frames_.empty()) {
+    firstSentPosition_ = lastSentPosition_ = header_->lastSentPosition;
+  } else {
+    firstSentPosition_ = frames_.front().first;
+    lastSentPosition_ = position;
+    header_->lastSentPosition = lastSentPosition_;
+    stats_->resumeBufferChanged(
+        static_cast<int>(frames_.size()), static_cast<int>(size()));
+  }
+}
+
+void MappedResumeManager::loadJournal() {
+  const auto state = header_->journalState;
+  if (state == kJournalLost) {
+    LOG(WARNING) << "Streams of resume file " << path_ << " were not persisted";
+    return;
+  }
+  const auto length = state & ~kJournalHalfBit;
+  if (length > kJournalHalfSize) {
+    throw std::runtime_error("Invalid journal length");
+  }
+
+  const auto data = journalHalf(state);
+  size_t offset = 0;
+  while (offset < length) {
+    switch (static_cast<JournalOp>(data[offset])) {
+      case JournalOp::OPEN: {
+        JournalOpen record;
+        readRecord(data, length, offset, record);
+        if (record.tokenLength > length - offset) {
+          throw std::runtime_error("Truncated journal record");
+        }
+        StreamResumeInfo info(
+            static_cast<StreamType>(record.streamType),
+            static_cast<RequestOriginator>(record.requester),
+            std::string(
+                reinterpret_cast<const char*>(data + offset),
+                record.tokenLength));
+        offset += record.tokenLength;
+        if (!streamResumeInfos_.emplace(record.streamId, std::move(info))
+                 .second) {
+          throw std::runtime_error("Stream opened twice");
+        }
+        break;
+      }
+      case JournalOp::CLOSE: {
+        JournalClose record;
+        readRecord(data, length, offset, record);
+        streamResumeInfos_.erase(record.streamId);
+        break;
+      }
+      case JournalOp::ALLOWANCE: {
+        JournalAllowance record;
+        readRecord(data, length, offset, record);
+        auto it = streamResumeInfos_.find(record.streamId);
+        if (it == streamResumeInfos_.end()) {
+          throw std::runtime_error("Allowance of an unknown stream");
+        }
+        it->second.producerAllowance = record.producerAllowance;
+        it->second.consumerAllowance = record.consumerAllowance;
+        break;
+      }
+      default:
+        throw std::runtime_error("Invalid journal record");
+    }
+  }
+}
+
+void MappedResumeManager::journalOpen(
+    StreamId streamId,
+    const StreamResumeInfo& info) {
+  std::string record;
+  appendOpen(record, streamId, info);
+  appendJournal(record);
+}
+
+void MappedResumeManager::journalClose(StreamId streamId) {
+  JournalClose close;
+  close.op = JournalOp::CLOSE;
+  close.streamId = streamId;
+  std::string record;
+  appendRecord(record, close);
+  appendJournal(record);
+}
+
+void MappedResumeManager::journalAllowance(
+    StreamId streamId,
+    const StreamResumeInfo& info) {
+  std::string record;
+  appendAllowance(record, streamId, info);
+  appendJournal(record);
+}
+
+void MappedResumeManager::appendJournal(const std::string& record) {
+  const auto state = header_->journalState;
+  if (state == kJournalLost) {
+    return;
+  }
+  const auto length = state & ~kJournalHalfBit;
+  if (length + record.size() > kJournalHalfSize) {
+    // The in-memory table already has the change, so the snapshot holds it.
+    compactJournal();
+    return;
+  }
+  std::memcpy(journalHalf(state) + length, record.data(), record.size());
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->journalState = state + record.size();
+}
+
+void MappedResumeManager::compactJournal() {
+  std::string snapshot;
+  for (const auto& entry : streamResumeInfos_) {
+    appendOpen(snapshot, entry.first, entry.second);
+    appendAllowance(snapshot, entry.first, entry.second);
+  }
+  if (snapshot.size() > kJournalHalfSize) {
+    if (header_->journalState != kJournalLost) {
+      LOG(ERROR) << "Too many streams to persist in resume file " << path_;
+      header_->journalState = kJournalLost;
+    }
+    return;
+  }
+
+  const auto state = header_->journalState;
+  const auto next = state == kJournalLost
+      ? 0
+      : (state & kJournalHalfBit) ^ kJournalHalfBit;
+  std::memcpy(journalHalf(next), snapshot.data(), snapshot.size());
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->journalState = next | snapshot.size();
+}
+
+uint8_t* MappedResumeManager::journalHalf(uint64_t journalState) const {
+  return journal_ + ((journalState & kJournalHalfBit) ? kJournalHalfSize : 0);
+}
+
+void MappedResumeManager::sync() {
+  folly::checkUnixError(
+      ::msync(mapping_->addr, mapping_->length, MS_SYNC),
+      "Failed to sync resume file ",
+      path_);
+}
+
+void MappedResumeManager::trackReceivedFrame(
+    size_t frameLength,
+    FrameType frameType,
+    StreamId streamId,
+    size_t consumerAllowance) {
+  if (!shouldTrackFrame(frameType)) {
+    return;
+  }
+  VLOG(6) << "Track received frame " << frameType << " StreamId: " << streamId
+          << " Allowance: " << consumerAllowance;
+  // The stream may already be gone if this frame terminated it.
+  auto it = streamResumeInfos_.find(streamId);
+  if (it != streamResumeInfos_.end() &&
+      it->second.consumerAllowance != consumerAllowance) {
+    it->second.consumerAllowance = consumerAllowance;
+    journalAllowance(streamId, it->second);
+  }
+  impliedPosition_ += frameLength;
+  header_->impliedPosition = impliedPosition_;
+}
+
+void MappedResumeManager::trackSentFrame(
+    const folly::IOBuf& serializedFrame,
+    FrameType frameType,
+    StreamId streamId,
+    size_t consumerAllowance) {
+  if (!shouldTrackFrame(frameType)) {
+    return;
+  }
+  VLOG(6) << "Track sent frame " << frameType
+          << " Allowance: " << consumerAllowance;
+
+  auto it = streamResumeInfos_.find(streamId);
+  if (it != streamResumeInfos_.end() &&
+      it->second.consumerAllowance != consumerAllowance) {
+    it->second.consumerAllowance = consumerAllowance;
+    journalAllowance(streamId, it->second);
+  }
+
+  const auto frameDataLength = serializedFrame.computeChainDataLength();
+  const auto recordSize = kRecordHeaderSize + frameDataLength;
+
+  // A frame which doesn't fit, or which would overwrite pages still being
+  // written out by a resumption, isn't cached.  Empty the entire cache
+  // instead, same as WarmResumeManager.
+  if (recordSize > capacity_ || overlapsPinned(tail_ + recordSize)) {
+    resetUpToPosition(lastSentPosition_);
+    lastSentPosition_ += frameDataLength;
+    firstSentPosition_ = lastSentPosition_;
+    header_->lastSentPosition = lastSentPosition_;
+    return;
+  }
+
+  while (tail_ - head_ + recordSize > capacity_) {
+    evictFrame();
+  }
+
+  RecordHeader record;
+  record.position = lastSentPosition_;
+  record.length = static_cast<uint32_t>(frameDataLength);
+  copyIn(tail_, &record, kRecordHeaderSize);
+  auto cursor = tail_ + kRecordHeaderSize;
+  for (const auto range : serializedFrame) {
+    copyIn(cursor, range.data(), range.size());
+    cursor += range.size();
+  }
+
+  frames_.emplace_back(lastSentPosition_, tail_);
+  tail_ = cursor;
+  lastSentPosition_ += frameDataLength;
+
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->tail = tail_;
+  header_->lastSentPosition = lastSentPosition_;
+
+  stats_->resumeBufferChanged(1, static_cast<int>(frameDataLength));
+}
+
+void MappedResumeManager::resetUpToPosition(ResumePosition position) {
+  if (position <= firstSentPosition_) {
+    return;
+  }
+
+  if (position > lastSentPosition_) {
+    position = lastSentPosition_;
+  }
+
+  auto end = findFrame(position);
+  if (position < lastSentPosition_ &&
+      (end == frames_.end() || end->first != position)) {
+    // A position inside a frame keeps that whole frame.
+    if (end == frames_.begin()) {
+      return;
+    }
+    --end;
+    position = end->first;
+    if (position <= firstSentPosition_) {
+      return;
+    }
+  }
+  const auto pos = end == frames_.end() ? position : end->first;
+  const auto frames = std::distance(frames_.cbegin(), end);
+  if (frames > 0) {
+    stats_->resumeBufferChanged(
+        -static_cast<int>(frames),
+        -static_cast<int>(pos - firstSentPosition_));
+  }
+
+  head_ = end == frames_.end() ? tail_ : end->second;
+  frames_.erase(frames_.cbegin(), end);
+  header_->head = head_;
+
+  firstSentPosition_ = position;
+  DCHECK(frames_.empty() || frames_.front().first == firstSentPosition_);
+}
+
+void MappedResumeManager::evictFrame() {
+  DCHECK(!frames_.empty());
+
+  const auto position = frames_.size() > 1 ? std::next(frames_.begin())->first
+                                           : lastSentPosition_;
+  resetUpToPosition(position);
+}
+
+bool MappedResumeManager::isPositionAvailable(ResumePosition position) const {
+  if (position == lastSentPosition_) {
+    return true;
+  }
+  const auto it = findFrame(position);
+  return it != frames_.end() && it->first == position;
+}
+
+void MappedResumeManager::sendFramesFromPosition(
+    ResumePosition position,
+    FrameTransport& transport) const {
+  DCHECK(isPositionAvailable(position));
+
+  if (position == lastSentPosition_) {
+    // idle resumption
+    return;
+  }
+
+  auto it = findFrame(position);
+  DCHECK(it != frames_.end());
+  DCHECK(it->first == position);
+
+  if (mapping_->pins.load() == 0 || it->second < pinnedFrom_) {
+    pinnedFrom_ = it->second;
+  }
+
+  for (; it != frames_.end(); ++it) {
+    RecordHeader record;
+    copyOut(it->second, &record, kRecordHeaderSize);
+    transport.outputFrameOrDrop(
+        wrapRing(it->second + kRecordHeaderSize, record.length));
+  }
+}
+
+void MappedResumeManager::onStreamOpen(
+    StreamId streamId,
+    RequestOriginator requester,
+    std::string streamToken,
+    StreamType streamType) {
+  CHECK(streamType != StreamType::FNF);
+  CHECK(streamResumeInfos_.find(streamId) == streamResumeInfos_.end());
+  if (requester == RequestOriginator::LOCAL &&
+      streamId > largestUsedStreamId_) {
+    largestUsedStreamId_ = streamId;
+    header_->largestUsedStreamId = largestUsedStreamId_;
+  }
+  auto const result = streamResumeInfos_.emplace(
+      streamId,
+      StreamResumeInfo(streamType, requester, std::move(streamToken)));
+  journalOpen(streamId, result.first->second);
+}
+
+void MappedResumeManager::onStreamClosed(StreamId streamId) {
+  if (!streamResumeInfos_.erase(streamId)) {
+    return;
+  }
+  if (header_->journalState == kJournalLost) {
+    // The table may fit again.
+    compactJournal();
+  } else {
+    journalClose(streamId);
+  }
+}
+
+bool MappedResumeManager::overlapsPinned(uint64_t end) const {
+  // Writing up to cursor `end` reuses the bytes of cursors below
+  // `end - capacity_`.
+  return mapping_->pins.load() > 0 && end > pinnedFrom_ + capacity_;
+}
+
+void MappedResumeManager::copyIn(
+    uint64_t cursor,
+    const void* src,
+    size_t length) {
+  const auto offset = cursor % capacity_;
+  const auto first = std::min(length, capacity_ - offset);
+  std::memcpy(ring_ + offset, src, first);
+  std::memcpy(ring_, static_cast<const uint8_t*>(src) + first, length - first);
+}
+
+void MappedResumeManager::copyOut(uint64_t cursor, void* dst, size_t length)
+    const {
+  const auto offset = cursor % capacity_;
+  const auto first = std::min(length, capacity_ - offset);
+  std::memcpy(dst, ring_ + offset, first);
+  std::memcpy(static_cast<uint8_t*>(dst) + first, ring_, length - first);
+}
+
+std::unique_ptr<folly::IOBuf> MappedResumeManager::wrapRing(
+    uint64_t cursor,
+    size_t length) const {
+  auto pin = [this](uint8_t* data, size_t size) {
+    auto holder = new std::shared_ptr<Mapping>(mapping_);
+    ++(*holder)->pins;
+    return folly::IOBuf::takeOwnership(
+        data,
+        size,
+        [](void*, void* userData) {
+          auto mapping = static_cast<std::shared_ptr<Mapping>*>(userData);
+          --(*mapping)->pins;
+          delete mapping;
+        },
+        holder);
+  };
+
+  const auto offset = cursor % capacity_;
+  const auto first = std::min(length, capacity_ - offset);
+  auto buf = pin(ring_ + offset, first);
+  if (first < length) {
+    buf->prependChain(pin(ring_, length - first));
+  }
+  return buf;
+}
+
+std::deque<std::pair<ResumePosition, uint64_t>>::const_iterator
+MappedResumeManager::findFrame(ResumePosition position) const {
+  return std::lower_bound(
+      frames_.cbegin(),
+      frames_.cend(),
+      position,
+      [](const std::pair<ResumePosition, uint64_t>& frame,
+         ResumePosition pos) { return frame.first < pos; });
+}
+
+} // namespace rsocket
@@ -0,0 +1,184 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "rsocket/RSocketStats.h"
+#include "rsocket/ResumeManager.h"
+
+namespace folly {
+class IOBuf;
+}
+
+namespace rsocket {
+
+class FrameTransport;
+
+/// ResumeManager which keeps the send buffer in a memory-mapped ring file, so
+/// that resumption state survives a process restart and doesn't live on the
+/// heap.
+///
+/// The file starts with a fixed header page holding the ring cursors and
+/// positions, followed by the stream journal and `capacity` bytes of ring.
+/// Every cached frame is stored as a small record header followed by the
+/// serialized frame bytes.
+/// resetUpToPosition() only advances the head cursor, and
+/// sendFramesFromPosition() hands the transport IOBufs pointing straight into
+/// the mapped pages.  Ring space that still backs such an IOBuf is never
+/// overwritten; frames that would need it are not cached.
+///
+/// Stream resume infos are kept in memory, and every change to them is
+/// appended to a journal in the same mapping as the ring, so after a crash
+/// the ring and the stream table agree.  The journal has two halves; when the
+/// active one fills up, a snapshot of the table is written to the other one
+/// and the header switches over to it.
+///
+/// Not thread-safe, all methods must be called from the connection's
+/// EventBase thread.
+class MappedResumeManager : public ResumeManager {
+ public:
+  /// Opens (or creates) the ring file at `path`.  An existing file keeps its
+  /// own capacity and state, otherwise a new ring of `capacity` bytes is
+  /// created.  Throws if the file can't be opened, mapped or locked, or if
+  /// its content is corrupt.
+  MappedResumeManager(
+      std::shared_ptr<RSocketStats> stats,
+      std::string path,
+      size_t capacity = DEFAULT_CAPACITY);
+  ~MappedResumeManager();
+
+  MappedResumeManager(const MappedResumeManager&) = delete;
+  MappedResumeManager& operator=(const MappedResumeManager&) = delete;
+
+  void trackReceivedFrame(
+      size_t frameLength,
+      FrameType frameType,
+      StreamId streamId,
+      size_t consumerAllowance) override;
+
+  void trackSentFrame(
+      const folly::IOBuf& serializedFrame,
+      FrameType frameType,
+      StreamId streamId,
+      size_t consumerAllowance) override;
+
+  void resetUpToPosition(ResumePosition position) override;
+
+  bool isPositionAvailable(ResumePosition position) const override;
+
+  void sendFramesFromPosition(
+      ResumePosition position,
+      FrameTransport& transport) const override;
+
+  ResumePosition firstSentPosition() const override {
+    return firstSentPosition_;
+  }
+
+  ResumePosition lastSentPosition() const override {
+    return lastSentPosition_;
+  }
+
+  ResumePosition impliedPosition() const override {
+    return impliedPosition_;
+  }
+
+  void onStreamOpen(
+      StreamId,
+      RequestOriginator,
+      std::string streamToken,
+      StreamType) override;
+
+  void onStreamClosed(StreamId streamId) override;
+
+  const StreamResumeInfos& getStreamResumeInfos() const override {
+    return streamResumeInfos_;
+  }
+
+  StreamId getLargestUsedStreamId() const override {
+    return largestUsedStreamId_;
+  }
+
+  /// Flushes the mapped file to disk.  Only needed for durability across
+  /// machine crashes; a process restart sees the ring and the stream table
+  /// through the page cache regardless.
+  void sync();
+
+  /// Number of frame bytes currently cached.
+  size_t size() const {
+    return static_cast<size_t>(lastSentPosition_ - firstSentPosition_);
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  constexpr static size_t DEFAULT_CAPACITY = 16 * 1024 * 1024; // 16MB
+
+ private:
+  struct FileHeader;
+  struct Mapping;
+
+  void load();
+  void loadJournal();
+
+  void journalOpen(StreamId streamId, const StreamResumeInfo& info);
+  void journalClose(StreamId streamId);
+  void journalAllowance(StreamId streamId, const StreamResumeInfo& info);
+  void appendJournal(const std::string& record);
+  void compactJournal();
+  uint8_t* journalHalf(uint64_t journalState) const;
+
+  void evictFrame();
+  bool overlapsPinned(uint64_t end) const;
+
+  void copyIn(uint64_t cursor, const void* src, size_t length);
+  void copyOut(uint64_t cursor, void* dst, size_t length) const;
+  std::unique_ptr<folly::IOBuf> wrapRing(uint64_t cursor, size_t length) const;
+
+  std::deque<std::pair<ResumePosition, uint64_t>>::const_iterator findFrame(
+      ResumePosition position) const;
+
+  const std::shared_ptr<RSocketStats> stats_;
+  const std::string path_;
+
+  std::shared_ptr<Mapping> mapping_;
+  FileHeader* header_{nullptr};
+  uint8_t* journal_{nullptr};
+  uint8_t* ring_{nullptr};
+  size_t capacity_{0};
+
+  // Monotonic ring cursors; the byte offset in the ring is cursor % capacity_.
+  uint64_t head_{0};
+  uint64_t tail_{0};
+
+  // Lowest ring cursor which may still be referenced by an IOBuf handed out
+  // by sendFramesFromPosition().  Only meaningful while such buffers exist.
+  mutable uint64_t pinnedFrom_{0};
+
+  // (position, ring cursor) of every cached frame, oldest first.  Rebuilt
+  // from the ring on load.
+  std::deque<std::pair<ResumePosition, uint64_t>> frames_;
+
+  ResumePosition firstSentPosition_{0};
+  ResumePosition lastSentPosition_{0};
+  ResumePosition impliedPosition_{0};
+
+  StreamResumeInfos streamResumeInfos_;
+  StreamId largestUsedStreamId_{0};
+};
+} // namespace rsocket
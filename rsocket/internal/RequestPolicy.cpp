@@ -0,0 +1,77 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/RequestPolicy.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace rsocket {
+
+RetryBudget::RetryBudget(double ratio, double maxBalance)
+    : ratio_(ratio), maxBalance_(maxBalance), balance_(maxBalance) {}
+
+void RetryBudget::deposit() {
+  balance_ = std::min(balance_ + ratio_, maxBalance_);
+}
+
+bool RetryBudget::tryWithdraw() {
+  if (balance_ < 1) {
+    return false;
+  }
+  balance_ -= 1;
+  return true;
+}
+
+constexpr size_t LatencyWindow::kMinSamples;
+
+LatencyWindow::LatencyWindow(size_t capacity)
+    : capacity_(std::max(capacity, kMinSamples)) {
+  samples_.reserve(capacity_);
+}
+
+void LatencyWindow::add(std::chrono::microseconds latency) {
+  if (samples_.size() < capacity_) {
+    samples_.push_back(latency);
+  } else {
+    samples_[next_] = latency;
+    next_ = (next_ + 1) % capacity_;
+  }
+  ++addedSinceCached_;
+}
+
+folly::Optional<std::chrono::microseconds> LatencyWindow::percentile(
+    double percentile) {
+  DCHECK(percentile >= 0 && percentile <= 1);
+  if (samples_.size() < kMinSamples) {
+    return folly::none;
+  }
+  if (percentile == cachedPercentile_ &&
+      addedSinceCached_ < std::max<size_t>(capacity_ / 16, 1)) {
+    return cachedValue_;
+  }
+
+  auto sorted = samples_;
+  auto const rank = std::min(
+      static_cast<size_t>(percentile * sorted.size()), sorted.size() - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+  cachedPercentile_ = percentile;
+  cachedValue_ = sorted[rank];
+  addedSinceCached_ = 0;
+  return cachedValue_;
+}
+
+} // namespace rsocket
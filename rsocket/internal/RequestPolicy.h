@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace rsocket {
+
+/// Limits the extra attempts, i.e. hedges and retries, to a share of the
+/// requests, so a struggling server doesn't get its load multiplied.
+///
+/// Every request deposits `ratio` into the budget, up to `maxBalance`, and
+/// every extra attempt withdraws one.  The budget starts full, so a burst of
+/// up to `maxBalance` extra attempts is allowed at any time.
+///
+/// Not thread safe.
+class RetryBudget {
+ public:
+  RetryBudget(double ratio, double maxBalance);
+
+  void deposit();
+  bool tryWithdraw();
+
+  double balance() const {
+    return balance_;
+  }
+
+ private:
+  const double ratio_;
+  const double maxBalance_;
+  double balance_;
+};
+
+/// The last `capacity` response times, and their percentiles.
+///
+/// Percentiles are recomputed once a sixteenth of the window was replaced,
+/// rather than for every query.
+///
+/// Not thread safe.
+class LatencyWindow {
+ public:
+  /// Percentiles are unknown until this many samples were added.
+  static constexpr size_t kMinSamples = 20;
+
+  explicit LatencyWindow(size_t capacity);
+
+  void add(std::chrono::microseconds latency);
+
+  /// `percentile` is in [0, 1].
+  folly::Optional<std::chrono::microseconds> percentile(double percentile);
+
+  size_t size() const {
+    return samples_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  std::vector<std::chrono::microseconds> samples_;
+  /// Where the next sample goes once the window is full.
+  size_t next_{0};
+
+  double cachedPercentile_{-1};
+  std::chrono::microseconds cachedValue_{0};
+  size_t addedSinceCached_{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,154 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace rsocket {
+
+/// FIFO with random access, backed by a power-of-two array of slots that is
+/// reused as elements are pushed to the back and popped from the front.
+/// Popping a prefix never moves the remaining elements.
+template <typename T>
+class RingBuffer {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator(const RingBuffer* ring, size_t index)
+        : ring_(ring), index_(index) {}
+
+    reference operator*() const {
+      return (*ring_)[index_];
+    }
+    pointer operator->() const {
+      return &(*ring_)[index_];
+    }
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      auto copy = *this;
+      ++index_;
+      return copy;
+    }
+    bool operator==(const const_iterator& other) const {
+      return ring_ == other.ring_ && index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    const RingBuffer* ring_;
+    size_t index_;
+  };
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  T& operator[](size_t index) {
+    DCHECK_LT(index, size_);
+    return slots_[(head_ + index) & (slots_.size() - 1)];
+  }
+
+  const T& operator[](size_t index) const {
+    DCHECK_LT(index, size_);
+    return slots_[(head_ + index) & (slots_.size() - 1)];
+  }
+
+  T& front() {
+    return (*this)[0];
+  }
+  const T& front() const {
+    return (*this)[0];
+  }
+  T& back() {
+    return (*this)[size_ - 1];
+  }
+  const T& back() const {
+    return (*this)[size_ - 1];
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+  const_iterator end() const {
+    return const_iterator(this, size_);
+  }
+
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    if (size_ == slots_.size()) {
+      grow();
+    }
+    slots_[(head_ + size_) & (slots_.size() - 1)] =
+        T(std::forward<Args>(args)...);
+    ++size_;
+  }
+
+  /// Drops the first `count` elements.  Their slots are reset to a
+  /// default-constructed T so any resources they hold are released now.
+  void pop_front(size_t count = 1) {
+    DCHECK_LE(count, size_);
+    const auto mask = slots_.size() - 1;
+    for (size_t i = 0; i < count; ++i) {
+      slots_[(head_ + i) & mask] = T();
+    }
+    head_ = (head_ + count) & mask;
+    size_ -= count;
+    if (size_ == 0) {
+      head_ = 0;
+    }
+  }
+
+  void clear() {
+    pop_front(size_);
+  }
+
+ private:
+  void grow() {
+    std::vector<T> slots(slots_.empty() ? kInitialSlots : slots_.size() * 2);
+    for (size_t i = 0; i < size_; ++i) {
+      slots[i] = std::move((*this)[i]);
+    }
+    slots_ = std::move(slots);
+    head_ = 0;
+  }
+
+  static constexpr size_t kInitialSlots = 16;
+
+  std::vector<T> slots_;
+  size_t head_{0};
+  size_t size_{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,48 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/RttEstimator.h"
+
+#include <algorithm>
+
+namespace rsocket {
+
+void RttEstimator::addSample(std::chrono::microseconds rtt) {
+  rtt = std::max(rtt, std::chrono::microseconds{0});
+
+  if (stats_.samples == 0) {
+    stats_.min = rtt;
+    stats_.smoothed = rtt;
+    stats_.variance = rtt / 2;
+  } else {
+    // RFC 6298: RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R|, then
+    // SRTT <- 7/8 SRTT + 1/8 R.
+    auto const deviation = stats_.smoothed > rtt ? stats_.smoothed - rtt
+                                                 : rtt - stats_.smoothed;
+    stats_.variance = (stats_.variance * 3 + deviation) / 4;
+    stats_.smoothed = (stats_.smoothed * 7 + rtt) / 8;
+    stats_.min = std::min(stats_.min, rtt);
+  }
+  stats_.latest = rtt;
+  ++stats_.samples;
+
+  size_t bucket = 0;
+  while (bucket + 1 < RttStats::kHistogramBuckets &&
+         rtt >= RttStats::bucketLimit(bucket)) {
+    ++bucket;
+  }
+  ++stats_.histogram[bucket];
+}
+
+} // namespace rsocket
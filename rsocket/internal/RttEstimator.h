@@ -0,0 +1,36 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Accumulates round trip time samples into RttStats.
+class RttEstimator {
+ public:
+  void addSample(std::chrono::microseconds rtt);
+
+  const RttStats& stats() const {
+    return stats_;
+  }
+
+ private:
+  RttStats stats_;
+};
+
+} // namespace rsocket
@@ -30,29 +30,34 @@ std::shared_ptr<yarpl::single::Single<Payload>>
 ScheduledRSocketResponder::handleRequestResponse(
     Payload request,
     StreamId streamId) {
-  auto innerFlowable =
-      inner_->handleRequestResponse(std::move(request), streamId);
-  return yarpl::single::Singles::create<Payload>(
-      [innerFlowable = std::move(innerFlowable), eventBase = &eventBase_](
-          std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
-        innerFlowable->subscribe(
-            std::make_shared<ScheduledSingleObserver<Payload>>(
-                std::move(observer), *eventBase));
-      });
+  return scheduleSingle(
+      inner_->handleRequestResponse(std::move(request), streamId));
+}
+
+std::shared_ptr<yarpl::single::Single<Payload>>
+ScheduledRSocketResponder::handleRequestResponseWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::chrono::steady_clock::time_point deadline) {
+  return scheduleSingle(inner_->handleRequestResponseWithDeadline(
+      std::move(request), streamId, deadline));
 }
 
 std::shared_ptr<yarpl::flowable::Flowable<Payload>>
 ScheduledRSocketResponder::handleRequestStream(
     Payload request,
     StreamId streamId) {
-  auto innerFlowable =
-      inner_->handleRequestStream(std::move(request), streamId);
-  return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
-      [innerFlowable = std::move(innerFlowable), eventBase = &eventBase_](
-          std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
-        innerFlowable->subscribe(std::make_shared<ScheduledSubscriber<Payload>>(
-            std::move(subscriber), *eventBase));
-      });
+  return scheduleFlowable(
+      inner_->handleRequestStream(std::move(request), streamId));
+}
+
+std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+ScheduledRSocketResponder::handleRequestStreamWithDeadline(
+    Payload request,
+    StreamId streamId,
+    std::chrono::steady_clock::time_point deadline) {
+  return scheduleFlowable(inner_->handleRequestStreamWithDeadline(
+      std::move(request), streamId, deadline));
 }
 
 std::shared_ptr<yarpl::flowable::Flowable<Payload>>
@@ -69,14 +74,8 @@ ScheduledRSocketResponder::handleRequestChannel(
                 std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
                     std::move(subscriber), *eventBase));
           });
-  auto innerFlowable = inner_->handleRequestChannel(
-      std::move(request), std::move(requestStreamFlowable), streamId);
-  return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
-      [innerFlowable = std::move(innerFlowable), eventBase = &eventBase_](
-          std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
-        innerFlowable->subscribe(std::make_shared<ScheduledSubscriber<Payload>>(
-            std::move(subscriber), *eventBase));
-      });
+  return scheduleFlowable(inner_->handleRequestChannel(
+      std::move(request), std::move(requestStreamFlowable), streamId));
 }
 
 void ScheduledRSocketResponder::handleFireAndForget(
@@ -85,4 +84,26 @@ void ScheduledRSocketResponder::handleFireAndForget(
   inner_->handleFireAndForget(std::move(request), streamId);
 }
 
+std::shared_ptr<yarpl::single::Single<Payload>>
+ScheduledRSocketResponder::scheduleSingle(
+    std::shared_ptr<yarpl::single::Single<Payload>> inner) {
+  return yarpl::single::Singles::create<Payload>(
+      [inner = std::move(inner), eventBase = &eventBase_](
+          std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
+        inner->subscribe(std::make_shared<ScheduledSingleObserver<Payload>>(
+            std::move(observer), *eventBase));
+      });
+}
+
+std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+ScheduledRSocketResponder::scheduleFlowable(
+    std::shared_ptr<yarpl::flowable::Flowable<Payload>> inner) {
+  return yarpl::flowable::internal::flowableFromSubscriber<Payload>(
+      [inner = std::move(inner), eventBase = &eventBase_](
+          std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
+        inner->subscribe(std::make_shared<ScheduledSubscriber<Payload>>(
+            std::move(subscriber), *eventBase));
+      });
+}
+
 } // namespace rsocket
@@ -35,10 +35,20 @@ class ScheduledRSocketResponder : public RSocketResponder {
   std::shared_ptr<yarpl::single::Single<Payload>> handleRequestResponse(
       Payload request,
       StreamId streamId) override;
+  std::shared_ptr<yarpl::single::Single<Payload>>
+  handleRequestResponseWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::chrono::steady_clock::time_point deadline) override;
 
   std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestStream(
       Payload request,
       StreamId streamId) override;
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>>
+  handleRequestStreamWithDeadline(
+      Payload request,
+      StreamId streamId,
+      std::chrono::steady_clock::time_point deadline) override;
 
   std::shared_ptr<yarpl::flowable::Flowable<Payload>> handleRequestChannel(
       Payload request,
@@ -48,6 +58,11 @@ class ScheduledRSocketResponder : public RSocketResponder {
   void handleFireAndForget(Payload request, StreamId streamId) override;
 
  private:
+  std::shared_ptr<yarpl::single::Single<Payload>> scheduleSingle(
+      std::shared_ptr<yarpl::single::Single<Payload>> inner);
+  std::shared_ptr<yarpl::flowable::Flowable<Payload>> scheduleFlowable(
+      std::shared_ptr<yarpl::flowable::Flowable<Payload>> inner);
+
   const std::shared_ptr<RSocketResponder> inner_;
   folly::EventBase& eventBase_;
 };
@@ -0,0 +1,324 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rsocket/internal/Common.h"
+
+namespace rsocket {
+
+/// Table of live streams on a connection, keyed by StreamId.
+///
+/// Stream IDs are allocated monotonically, odd ones by the client and even
+/// ones by the server, so the live IDs of each parity cluster in a narrow
+/// range just behind the most recently allocated one.  Each parity is stored
+/// in a dense ring of slots indexed by `streamId >> 1`, which slides forward
+/// as the oldest streams close.  Lookups are an unsigned range check and an
+/// array index.
+///
+/// If a long-lived stream would stretch a ring past `maxWindow` slots, the
+/// oldest entries are moved to a side hash map so memory stays bounded.  IDs
+/// older than the ring (e.g. streams restored by cold resumption) go to the
+/// side map directly.  A ring that is mostly empty after a burst is shrunk
+/// again.
+template <typename T>
+class StreamRegistry {
+ public:
+  using Value = std::shared_ptr<T>;
+
+  static constexpr size_t kDefaultMaxWindow = size_t{1} << 12;
+
+  explicit StreamRegistry(size_t maxWindow = kDefaultMaxWindow)
+      : maxWindow_(maxWindow) {
+    CHECK_GT(maxWindow_, 0u);
+  }
+
+  /// Adds a stream.  Returns false, leaving the registry unchanged, if the ID
+  /// is already present.
+  bool insert(StreamId streamId, Value value) {
+    DCHECK(value);
+    if (!window(streamId).insert(streamId >> 1, std::move(value))) {
+      return false;
+    }
+    ++sizes_[streamId & 1];
+    return true;
+  }
+
+  /// Returns the stream with the given ID, or nullptr if there is none.
+  const Value* find(StreamId streamId) const {
+    return window(streamId).find(streamId >> 1);
+  }
+
+  /// Like find(), but throws std::out_of_range if the stream does not exist.
+  const Value& at(StreamId streamId) const {
+    if (auto value = find(streamId)) {
+      return *value;
+    }
+    throw std::out_of_range{"StreamRegistry::at"};
+  }
+
+  size_t count(StreamId streamId) const {
+    return find(streamId) ? 1 : 0;
+  }
+
+  /// Removes a stream.  Returns whether it was present.
+  bool erase(StreamId streamId) {
+    if (!window(streamId).erase(streamId >> 1)) {
+      return false;
+    }
+    --sizes_[streamId & 1];
+    return true;
+  }
+
+  /// Removes and returns an arbitrary stream.  Must not be called when empty.
+  Value extractAny() {
+    DCHECK(!empty());
+    auto const parity = windows_[0].empty() ? 1 : 0;
+    --sizes_[parity];
+    return windows_[parity].extractAny();
+  }
+
+  /// Calls `fn` with every stream, in no particular order.  `fn` must not
+  /// insert or erase streams.
+  template <typename F>
+  void forEach(F&& fn) const {
+    windows_[0].forEach(fn);
+    windows_[1].forEach(fn);
+  }
+
+  size_t size() const {
+    return sizes_[0] + sizes_[1];
+  }
+
+  /// Number of streams opened by the given side: clients allocate odd IDs
+  /// and servers even ones.
+  size_t size(RSocketMode opener) const {
+    return sizes_[opener == RSocketMode::CLIENT ? 1 : 0];
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /// Number of ring slots allocated, over both parities.
+  size_t capacity() const {
+    return windows_[0].capacity() + windows_[1].capacity();
+  }
+
+ private:
+  /// Streams of one parity.  Slots outside [head_, head_ + span_) are always
+  /// empty, and the slots at both ends of that range are always occupied.
+  class Window {
+   public:
+    explicit Window(size_t maxWindow) : maxWindow_(maxWindow) {}
+
+    bool empty() const {
+      return span_ == 0 && overflow_.empty();
+    }
+
+    size_t capacity() const {
+      return slots_.size();
+    }
+
+    const Value* find(uint32_t index) const {
+      // Indexes below base_ wrap around and fail the range check.
+      auto const offset = index - base_;
+      if (offset < span_) {
+        auto& slot = slots_[(head_ + offset) & mask()];
+        if (slot) {
+          return &slot;
+        }
+      }
+      if (overflow_.empty()) {
+        return nullptr;
+      }
+      auto it = overflow_.find(index);
+      return it != overflow_.end() ? &it->second : nullptr;
+    }
+
+    bool insert(uint32_t index, Value value) {
+      if (!overflow_.empty() && overflow_.count(index)) {
+        return false;
+      }
+
+      if (span_ == 0) {
+        base_ = index;
+      } else if (index < base_) {
+        return overflow_.emplace(index, std::move(value)).second;
+      }
+
+      // Rather than grow a ring that is mostly empty, e.g. one held open by a
+      // few long-lived streams, move its oldest entries to the side map.
+      while (index - base_ >= maxWindow_ ||
+             (index - base_ >= slots_.size() &&
+              occupied_ * 4 < slots_.size())) {
+        spillFront();
+        if (span_ == 0) {
+          base_ = index;
+        }
+      }
+
+      auto const offset = index - base_;
+      if (offset >= slots_.size()) {
+        size_t capacity = slots_.empty() ? kInitialCapacity : slots_.size();
+        while (capacity <= offset) {
+          capacity *= 2;
+        }
+        resize(capacity);
+      }
+
+      auto& slot = slots_[(head_ + offset) & mask()];
+      if (slot) {
+        return false;
+      }
+      slot = std::move(value);
+      ++occupied_;
+      span_ = std::max<size_t>(span_, offset + 1);
+      return true;
+    }
+
+    bool erase(uint32_t index) {
+      auto const offset = index - base_;
+      if (offset < span_) {
+        auto& slot = slots_[(head_ + offset) & mask()];
+        if (slot) {
+          slot.reset();
+          --occupied_;
+          trim();
+          return true;
+        }
+      }
+      return !overflow_.empty() && overflow_.erase(index) > 0;
+    }
+
+    template <typename F>
+    void forEach(F& fn) const {
+      for (size_t i = 0; i < span_; ++i) {
+        if (auto& slot = slots_[(head_ + i) & mask()]) {
+          fn(slot);
+        }
+      }
+      for (auto& entry : overflow_) {
+        fn(entry.second);
+      }
+    }
+
+    Value extractAny() {
+      if (!overflow_.empty()) {
+        auto it = overflow_.begin();
+        auto value = std::move(it->second);
+        overflow_.erase(it);
+        return value;
+      }
+      DCHECK_GT(span_, 0u);
+      // The front slot is always occupied.
+      auto value = std::move(slots_[head_]);
+      --occupied_;
+      trim();
+      return value;
+    }
+
+   private:
+    size_t mask() const {
+      return slots_.size() - 1;
+    }
+
+    /// Move the oldest slot into the overflow map and advance the window.
+    void spillFront() {
+      DCHECK_GT(span_, 0u);
+      auto& slot = slots_[head_];
+      if (slot) {
+        overflow_.emplace(base_, std::move(slot));
+        slot.reset();
+        --occupied_;
+      }
+      advance();
+      trim();
+    }
+
+    void advance() {
+      head_ = (head_ + 1) & mask();
+      ++base_;
+      --span_;
+    }
+
+    /// Drop empty slots from both ends of the window, and halve the ring for
+    /// as long as it would be no more than a quarter used.
+    void trim() {
+      while (span_ > 0 && !slots_[head_]) {
+        advance();
+      }
+      while (span_ > 0 && !slots_[(head_ + span_ - 1) & mask()]) {
+        --span_;
+      }
+      auto capacity = slots_.size();
+      while (capacity > kInitialCapacity && span_ * 4 <= capacity) {
+        capacity /= 2;
+      }
+      if (capacity != slots_.size()) {
+        resize(capacity);
+      }
+    }
+
+    /// Move the window into a ring of `capacity` slots, a power of two.
+    void resize(size_t capacity) {
+      DCHECK_GE(capacity, span_);
+      std::vector<Value> slots(capacity);
+      for (size_t i = 0; i < span_; ++i) {
+        slots[i] = std::move(slots_[(head_ + i) & mask()]);
+      }
+      slots_ = std::move(slots);
+      head_ = 0;
+    }
+
+    static constexpr size_t kInitialCapacity = 16;
+
+    const size_t maxWindow_;
+    std::vector<Value> slots_;
+    size_t head_{0};
+    size_t span_{0};
+    /// Occupied slots within the window.
+    size_t occupied_{0};
+    uint32_t base_{0};
+    std::unordered_map<uint32_t, Value> overflow_;
+  };
+
+  Window& window(StreamId streamId) {
+    return windows_[streamId & 1];
+  }
+
+  const Window& window(StreamId streamId) const {
+    return windows_[streamId & 1];
+  }
+
+  const size_t maxWindow_;
+  std::array<Window, 2> windows_{{Window{maxWindow_}, Window{maxWindow_}}};
+  std::array<size_t, 2> sizes_{{0, 0}};
+};
+
+template <typename T>
+constexpr size_t StreamRegistry<T>::kDefaultMaxWindow;
+
+} // namespace rsocket
@@ -0,0 +1,116 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamStatePool.h"
+
+#include <new>
+#include <vector>
+
+namespace rsocket {
+
+constexpr size_t StreamStatePool::kBlockAlignment;
+constexpr size_t StreamStatePool::kMaxBlockSize;
+constexpr size_t StreamStatePool::kMaxCachedBlocks;
+
+namespace {
+
+/// Set once the calling thread's free lists have been destroyed, so blocks
+/// freed later in thread teardown go straight back to the heap.
+thread_local bool threadCacheDestroyed{false};
+
+struct ThreadCache {
+  ~ThreadCache() {
+    release();
+    threadCacheDestroyed = true;
+  }
+
+  void release() {
+    for (auto& blocks : freeBlocks) {
+      for (auto block : blocks) {
+        ::operator delete(block);
+      }
+      blocks.clear();
+    }
+  }
+
+  std::array<
+      std::vector<void*>,
+      StreamStatePool::kMaxBlockSize / StreamStatePool::kBlockAlignment>
+      freeBlocks;
+};
+
+ThreadCache* threadCache() {
+  if (threadCacheDestroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+} // namespace
+
+StreamStatePool::StreamStatePool(bool enabled) : enabled_(enabled) {}
+
+void* StreamStatePool::allocate(size_t size) {
+  if (size == 0 || size > kMaxBlockSize) {
+    return ::operator new(size);
+  }
+  if (!enabled_) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+  }
+
+  auto const cls = sizeClass(size);
+  if (auto cache = threadCache()) {
+    auto& blocks = cache->freeBlocks[cls];
+    if (!blocks.empty()) {
+      auto block = blocks.back();
+      blocks.pop_back();
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return block;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  // Always allocate the full size class, so any block of the class can be
+  // reused for any request of the class.
+  return ::operator new((cls + 1) * kBlockAlignment);
+}
+
+void StreamStatePool::deallocate(void* block, size_t size) {
+  if (enabled_ && size != 0 && size <= kMaxBlockSize) {
+    if (auto cache = threadCache()) {
+      auto& blocks = cache->freeBlocks[sizeClass(size)];
+      if (blocks.size() < kMaxCachedBlocks) {
+        blocks.push_back(block);
+        return;
+      }
+    }
+  }
+  ::operator delete(block);
+}
+
+StreamStatePool::Stats StreamStatePool::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void StreamStatePool::releaseThreadCache() {
+  if (auto cache = threadCache()) {
+    cache->release();
+  }
+}
+
+} // namespace rsocket
@@ -0,0 +1,132 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace rsocket {
+
+/// Cache of memory blocks for stream state machines.
+///
+/// Short requests allocate and free a stream state machine (together with its
+/// shared_ptr control block) for every request.  Freed blocks are kept on free
+/// lists per size class and handed to the next stream of the same type, so a
+/// connection in steady state stops hitting malloc for them.
+///
+/// The free lists are per thread and shared by all pools, so neither
+/// allocation nor deallocation takes a lock.  A connection's streams are
+/// created and usually destroyed on its EventBase thread, and get their own
+/// blocks back.  Blocks freed on another thread go to that thread's lists.
+///
+/// A pool decides whether the streams allocated through it are recycled at
+/// all, and counts how often that saved an allocation.
+class StreamStatePool {
+ public:
+  /// Granularity of size classes, and the alignment of every block.
+  static constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+
+  /// Larger requests bypass the pool.
+  static constexpr size_t kMaxBlockSize = 1024;
+
+  /// Free blocks each thread keeps per size class; the rest go back to the
+  /// heap.
+  static constexpr size_t kMaxCachedBlocks = 256;
+
+  struct Stats {
+    /// Allocations served from a free list.
+    uint64_t hits{0};
+    /// Allocations small enough for the pool that went to the heap.
+    uint64_t misses{0};
+  };
+
+  /// A disabled pool sends all allocations straight to the heap, which is
+  /// useful for A/B benchmarks and for memory checkers that would otherwise
+  /// miss use-after-free of recycled blocks.
+  explicit StreamStatePool(bool enabled = true);
+
+  StreamStatePool(const StreamStatePool&) = delete;
+  StreamStatePool& operator=(const StreamStatePool&) = delete;
+
+  void* allocate(size_t size);
+  void deallocate(void* block, size_t size);
+
+  bool enabled() const {
+    return enabled_;
+  }
+
+  /// May be called from any thread.
+  Stats stats() const;
+
+  /// Frees the blocks cached by the calling thread.
+  static void releaseThreadCache();
+
+ private:
+  static size_t sizeClass(size_t size) {
+    return (size + kBlockAlignment - 1) / kBlockAlignment - 1;
+  }
+
+  const bool enabled_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+/// Standard allocator handing out blocks of a StreamStatePool, for use with
+/// std::allocate_shared.  Keeps the pool alive for as long as any block
+/// allocated from it is.
+template <typename T>
+class StreamStateAllocator {
+ public:
+  using value_type = T;
+
+  explicit StreamStateAllocator(std::shared_ptr<StreamStatePool> pool)
+      : pool_(std::move(pool)) {}
+
+  template <typename U>
+  StreamStateAllocator(const StreamStateAllocator<U>& other)
+      : pool_(other.pool_) {}
+
+  T* allocate(size_t n) {
+    static_assert(
+        alignof(T) <= StreamStatePool::kBlockAlignment,
+        "Over-aligned types are not supported");
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    pool_->deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const StreamStateAllocator<U>& other) const {
+    return pool_ == other.pool_;
+  }
+
+  template <typename U>
+  bool operator!=(const StreamStateAllocator<U>& other) const {
+    return pool_ != other.pool_;
+  }
+
+ private:
+  template <typename U>
+  friend class StreamStateAllocator;
+
+  std::shared_ptr<StreamStatePool> pool_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,55 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/SubmissionQueue.h"
+
+#include <atomic>
+
+namespace rsocket {
+
+namespace {
+std::atomic<bool> batchingEnabled{true};
+} // namespace
+
+SubmissionQueue::SubmissionQueue(folly::EventBase& evb) : evb_(evb) {}
+
+void SubmissionQueue::run(folly::Function<void()> fn) {
+  if (evb_.isInEventBaseThread()) {
+    fn();
+    return;
+  }
+  if (!isEnabled()) {
+    evb_.runInEventBaseThread(std::move(fn));
+    return;
+  }
+  // Only the submission that finds the list empty schedules a drain; every
+  // other one rides along with it.
+  if (tasks_.insertHead(std::move(fn))) {
+    evb_.runInEventBaseThread([self = shared_from_this()] { self->drain(); });
+  }
+}
+
+void SubmissionQueue::drain() {
+  tasks_.sweep([](folly::Function<void()>&& fn) { fn(); });
+}
+
+void SubmissionQueue::setEnabled(bool enabled) {
+  batchingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool SubmissionQueue::isEnabled() {
+  return batchingEnabled.load(std::memory_order_relaxed);
+}
+
+} // namespace rsocket
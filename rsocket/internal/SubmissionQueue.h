@@ -0,0 +1,56 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/AtomicLinkedList.h>
+#include <folly/Function.h>
+#include <folly/io/async/EventBase.h>
+
+#include <memory>
+
+namespace rsocket {
+
+/// Hands work from any thread to an EventBase, in batches.
+///
+/// Posting to an EventBase from another thread costs a locked queue push and
+/// an eventfd write per callback.  Work submitted here goes on a lock-free
+/// multi-producer list instead, and only the submission that finds the list
+/// empty wakes the EventBase up.  The EventBase then runs everything queued
+/// by the time it gets there, oldest first, in a single callback.
+///
+/// Work submitted by one thread runs in the order it was submitted.  Work
+/// submitted on the EventBase thread runs inline.
+class SubmissionQueue : public std::enable_shared_from_this<SubmissionQueue> {
+ public:
+  explicit SubmissionQueue(folly::EventBase& evb);
+
+  SubmissionQueue(const SubmissionQueue&) = delete;
+  SubmissionQueue& operator=(const SubmissionQueue&) = delete;
+
+  void run(folly::Function<void()> fn);
+
+  /// Process-wide switch, on by default.  Turning it off posts every piece of
+  /// work to the EventBase on its own, for A/B benchmarks.
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+
+ private:
+  void drain();
+
+  folly::EventBase& evb_;
+  folly::AtomicLinkedList<folly::Function<void()>> tasks_;
+};
+
+} // namespace rsocket
@@ -14,8 +14,6 @@
 
 #include "rsocket/internal/WarmResumeManager.h"
 
-#include <algorithm>
-
 namespace rsocket {
 
 WarmResumeManager::~WarmResumeManager() {
@@ -77,36 +75,35 @@ void WarmResumeManager::resetUpToPosition(ResumePosition position) {
 }
 
 bool WarmResumeManager::isPositionAvailable(ResumePosition position) const {
-  return (lastSentPosition_ == position) ||
-      std::binary_search(
-             frames_.begin(),
-             frames_.end(),
-             std::make_pair(position, std::unique_ptr<folly::IOBuf>()),
-             [](decltype(frames_.back()) pairA,
-                decltype(frames_.back()) pairB) {
-               return pairA.first < pairB.first;
-             });
+  if (lastSentPosition_ == position) {
+    return true;
+  }
+  const auto index = lowerBound(position);
+  return index < frames_.size() && frames_[index].first == position;
 }
 
 void WarmResumeManager::addFrame(
     const folly::IOBuf& frame,
     size_t frameDataLength) {
   size_ += frameDataLength;
-  while (size_ > capacity_) {
-    evictFrame();
+  if (size_ > capacity_) {
+    // Find the first frame boundary which leaves enough room and evict
+    // everything before it in one go.
+    size_t evicted = 0;
+    auto position = firstSentPosition_;
+    while (size_ - static_cast<size_t>(position - firstSentPosition_) >
+           capacity_) {
+      DCHECK_LT(evicted, frames_.size());
+      ++evicted;
+      position = evicted < frames_.size() ? frames_[evicted].first
+                                          : lastSentPosition_;
+    }
+    resetUpToPosition(position);
   }
-  frames_.emplace_back(lastSentPosition_, frame.clone());
+  frames_.emplace_back(lastSentPosition_, frame.cloneAsValue());
   stats_->resumeBufferChanged(1, static_cast<int>(frameDataLength));
 }
 
-void WarmResumeManager::evictFrame() {
-  DCHECK(!frames_.empty());
-
-  const auto position = frames_.size() > 1 ? std::next(frames_.begin())->first
-                                           : lastSentPosition_;
-  resetUpToPosition(position);
-}
-
 void WarmResumeManager::clearFrames(ResumePosition position) {
   if (frames_.empty()) {
     return;
@@ -114,23 +111,30 @@ void WarmResumeManager::clearFrames(ResumePosition position) {
   DCHECK(position <= lastSentPosition_);
   DCHECK(position >= firstSentPosition_);
 
-  const auto end = std::lower_bound(
-      frames_.begin(),
-      frames_.end(),
-      position,
-      [](decltype(frames_.back()) pair, ResumePosition pos) {
-        return pair.first < pos;
-      });
-  DCHECK(end == frames_.end() || end->first >= firstSentPosition_);
-  const auto pos = end == frames_.end() ? position : end->first;
+  const auto end = lowerBound(position);
+  DCHECK(end == frames_.size() || frames_[end].first >= firstSentPosition_);
+  const auto pos = end == frames_.size() ? position : frames_[end].first;
   stats_->resumeBufferChanged(
-      -static_cast<int>(std::distance(frames_.begin(), end)),
-      -static_cast<int>(pos - firstSentPosition_));
+      -static_cast<int>(end), -static_cast<int>(pos - firstSentPosition_));
 
-  frames_.erase(frames_.begin(), end);
+  frames_.pop_front(end);
   size_ -= static_cast<decltype(size_)>(pos - firstSentPosition_);
 }
 
+size_t WarmResumeManager::lowerBound(ResumePosition position) const {
+  size_t low = 0;
+  size_t high = frames_.size();
+  while (low < high) {
+    const auto mid = low + (high - low) / 2;
+    if (frames_[mid].first < position) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
 void WarmResumeManager::sendFramesFromPosition(
     ResumePosition position,
     FrameTransport& frameTransport) const {
@@ -141,20 +145,13 @@ void WarmResumeManager::sendFramesFromPosition(
     return;
   }
 
-  auto found = std::lower_bound(
-      frames_.begin(),
-      frames_.end(),
-      position,
-      [](decltype(frames_.back()) pair, ResumePosition pos) {
-        return pair.first < pos;
-      });
+  auto index = lowerBound(position);
 
-  DCHECK(found != frames_.end());
-  DCHECK(found->first == position);
+  DCHECK(index < frames_.size());
+  DCHECK(frames_[index].first == position);
 
-  while (found != frames_.end()) {
-    frameTransport.outputFrameOrDrop(found->second->clone());
-    found++;
+  for (; index < frames_.size(); ++index) {
+    frameTransport.outputFrameOrDrop(frames_[index].second.clone());
   }
 }
 
@@ -14,16 +14,12 @@
 
 #pragma once
 
-#include <deque>
-
+#include <folly/io/IOBuf.h>
 #include <folly/lang/Assume.h>
 
 #include "rsocket/RSocketStats.h"
 #include "rsocket/ResumeManager.h"
-
-namespace folly {
-class IOBuf;
-}
+#include "rsocket/internal/RingBuffer.h"
 
 namespace rsocket {
 
@@ -93,11 +89,14 @@ class WarmResumeManager : public ResumeManager {
 
  protected:
   void addFrame(const folly::IOBuf&, size_t);
-  void evictFrame();
 
-  // Called before clearing cached frames to update stats.
+  // Drops all cached frames starting before position and updates stats once
+  // for the whole batch.
   void clearFrames(ResumePosition position);
 
+  // Index of the first cached frame at or after position.
+  size_t lowerBound(ResumePosition position) const;
+
   const std::shared_ptr<RSocketStats> stats_;
 
   // Start position of the send buffer queue
@@ -107,7 +106,9 @@ class WarmResumeManager : public ResumeManager {
   // Inferred position of the rcvd frames
   ResumePosition impliedPosition_{0};
 
-  std::deque<std::pair<ResumePosition, std::unique_ptr<folly::IOBuf>>> frames_;
+  // Cached frames share the serialized buffers with the transport; nothing
+  // is copied.
+  RingBuffer<std::pair<ResumePosition, folly::IOBuf>> frames_;
 
   constexpr static size_t DEFAULT_CAPACITY = 1024 * 1024; // 1MB
   const size_t capacity_;
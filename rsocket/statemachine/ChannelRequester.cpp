@@ -29,12 +29,10 @@ void ChannelRequester::onSubscribe(
 void ChannelRequester::onNext(Payload request) {
   if (!requested_) {
     initStream(std::move(request));
-    return;
-  }
-
-  if (!publisherClosed()) {
+  } else if (!publisherClosed()) {
     writePayload(std::move(request));
   }
+  publisherNext();
 }
 
 // TODO: consolidate code in onCompleteImpl, onErrorImpl, cancelImpl
@@ -83,8 +81,11 @@ void ChannelRequester::cancel() {
     removeFromWriter();
     return;
   }
+  auto const peerCompleted = consumerDraining();
   cancelConsumer();
-  writeCancel();
+  if (!peerCompleted) {
+    writeCancel();
+  }
   tryCompleteChannel();
 }
 
@@ -128,21 +129,19 @@ void ChannelRequester::endStream(StreamCompletionSignal signal) {
 void ChannelRequester::initStream(Payload&& request) {
   requested_ = true;
 
-  const size_t initialN = initialResponseAllowance_.consumeUpTo(kMaxRequestN);
-  const size_t remainingN = initialResponseAllowance_.consumeAll();
-
-  // Send as much as possible with the initial request.
-  CHECK_GE(static_cast<size_t>(kMaxRequestN), initialN);
-  newStream(
-      StreamType::CHANNEL, static_cast<uint32_t>(initialN), std::move(request));
-  // We must inform ConsumerBase about an implicit allowance we have
-  // requested from the remote end.
-  ConsumerBase::addImplicitAllowance(initialN);
+  // Send as much as possible with the initial request.  We must inform
+  // ConsumerBase about an implicit allowance we have requested from the
+  // remote end.
+  auto const initialN = ConsumerBase::addInitialAllowance(
+      initialResponseAllowance_.consumeAll());
+  newStream(StreamType::CHANNEL, initialN, std::move(request));
   // Pump the remaining allowance into the ConsumerBase _after_ sending the
   // initial request.
-  if (remainingN) {
-    ConsumerBase::generateRequest(remainingN);
-  }
+  ConsumerBase::sendRequests();
+}
+
+void ChannelRequester::onConsumerDrained() {
+  tryCompleteChannel();
 }
 
 void ChannelRequester::tryCompleteChannel() {
@@ -56,9 +56,14 @@ class ChannelRequester : public ConsumerBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void setPublisherPaused(bool paused) override {
+    PublisherBase::setPublisherPaused(paused);
+  }
+
   void endStream(StreamCompletionSignal) override;
 
  private:
+  void onConsumerDrained() override;
   void initStream(Payload&&);
   void tryCompleteChannel();
 
@@ -24,6 +24,7 @@ void ChannelResponder::onSubscribe(
 void ChannelResponder::onNext(Payload response) {
   if (!publisherClosed()) {
     writePayload(std::move(response));
+    publisherNext();
   }
 }
 
@@ -53,8 +54,11 @@ void ChannelResponder::request(int64_t n) {
 }
 
 void ChannelResponder::cancel() {
+  auto const peerCompleted = consumerDraining();
   cancelConsumer();
-  writeCancel();
+  if (!peerCompleted) {
+    writeCancel();
+  }
   tryCompleteChannel();
 }
 
@@ -112,6 +116,10 @@ void ChannelResponder::endStream(StreamCompletionSignal signal) {
   ConsumerBase::endStream(signal);
 }
 
+void ChannelResponder::onConsumerDrained() {
+  tryCompleteChannel();
+}
+
 void ChannelResponder::tryCompleteChannel() {
   if (publisherClosed() && consumerClosed()) {
     endStream(StreamCompletionSignal::COMPLETE);
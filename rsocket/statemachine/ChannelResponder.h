@@ -50,9 +50,14 @@ class ChannelResponder : public ConsumerBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void setPublisherPaused(bool paused) override {
+    PublisherBase::setPublisherPaused(paused);
+  }
+
   void endStream(StreamCompletionSignal) override;
 
  private:
+  void onConsumerDrained() override;
   void tryCompleteChannel();
 
   bool newStream_{true};
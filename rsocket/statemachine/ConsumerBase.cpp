@@ -37,6 +37,8 @@ void ConsumerBase::cancelConsumer() {
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::cancelConsumer()";
   consumingSubscriber_ = nullptr;
+  prefetched_.clear();
+  completeWhenDrained_ = false;
 }
 
 void ConsumerBase::addImplicitAllowance(size_t n) {
@@ -44,15 +46,41 @@ void ConsumerBase::addImplicitAllowance(size_t n) {
   activeRequests_.add(n);
 }
 
+uint32_t ConsumerBase::addInitialAllowance(size_t n) {
+  if (watermarks_.enabled()) {
+    allowance_.add(n);
+    activeRequests_.add(watermarks_.high);
+    return watermarks_.high;
+  }
+
+  auto const initial = std::min<size_t>(n, kMaxRequestN);
+  addImplicitAllowance(initial);
+  allowance_.add(n - initial);
+  pendingAllowance_.add(n - initial);
+  return static_cast<uint32_t>(initial);
+}
+
 void ConsumerBase::generateRequest(size_t n) {
   allowance_.add(n);
+  if (watermarks_.enabled()) {
+    deliverPrefetched();
+    return;
+  }
   pendingAllowance_.add(n);
   sendRequests();
 }
 
+void ConsumerBase::setRequestNWatermarks(RequestNWatermarks watermarks) {
+  CHECK_LT(watermarks.low, watermarks.high);
+  CHECK_LE(watermarks.high, static_cast<uint32_t>(kMaxRequestN));
+  watermarks_ = watermarks;
+}
+
 void ConsumerBase::endStream(StreamCompletionSignal signal) {
   VLOG(5) << "ConsumerBase::endStream(" << signal << ")";
   state_ = State::CLOSED;
+  prefetched_.clear();
+  completeWhenDrained_ = false;
   if (auto subscriber = std::move(consumingSubscriber_)) {
     if (signal == StreamCompletionSignal::COMPLETE ||
         signal == StreamCompletionSignal::CANCEL) { // TODO: remove CANCEL
@@ -74,6 +102,18 @@ void ConsumerBase::processPayload(Payload&& payload, bool onNext) {
     return;
   }
 
+  if (watermarks_.enabled()) {
+    if (!activeRequests_.tryConsume(1)) {
+      handleFlowControlError();
+      return;
+    }
+    // Hold the payload until the application requests it, behind any held
+    // before it.
+    prefetched_.push_back(std::move(payload));
+    deliverPrefetched();
+    return;
+  }
+
   // Frames carrying application-level payloads are taken into account when
   // figuring out flow control allowance.
   if (!allowance_.tryConsume(1) || !activeRequests_.tryConsume(1)) {
@@ -112,6 +152,10 @@ bool ConsumerBase::processFragmentedPayload(
 }
 
 void ConsumerBase::completeConsumer() {
+  if (!prefetched_.empty()) {
+    completeWhenDrained_ = true;
+    return;
+  }
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::completeConsumer()";
   if (auto subscriber = std::move(consumingSubscriber_)) {
@@ -122,12 +166,19 @@ void ConsumerBase::completeConsumer() {
 void ConsumerBase::errorConsumer(folly::exception_wrapper ew) {
   state_ = State::CLOSED;
   VLOG(5) << "ConsumerBase::errorConsumer()";
+  prefetched_.clear();
+  completeWhenDrained_ = false;
   if (auto subscriber = std::move(consumingSubscriber_)) {
     subscriber->onError(std::move(ew));
   }
 }
 
 void ConsumerBase::sendRequests() {
+  if (watermarks_.enabled()) {
+    sendWatermarkRequests();
+    return;
+  }
+
   auto toSync = std::min<size_t>(pendingAllowance_.get(), kMaxRequestN);
   auto actives = activeRequests_.get();
   if (actives <= toSync) {
@@ -139,6 +190,46 @@ void ConsumerBase::sendRequests() {
   }
 }
 
+void ConsumerBase::sendWatermarkRequests() {
+  if (state_ == State::CLOSED || completeWhenDrained_) {
+    return;
+  }
+  // Held payloads count as outstanding, which bounds them to the high
+  // watermark.
+  auto const outstanding = activeRequests_.get() + prefetched_.size();
+  if (outstanding <= watermarks_.low) {
+    auto const toSync = watermarks_.high - outstanding;
+    writeRequestN(static_cast<uint32_t>(toSync));
+    activeRequests_.add(toSync);
+  }
+}
+
+void ConsumerBase::deliverPrefetched() {
+  // The application may request more, or cancel, from onNext().
+  if (delivering_) {
+    return;
+  }
+  auto const self = shared_from_this();
+  delivering_ = true;
+  while (!prefetched_.empty() && allowance_.tryConsume(1)) {
+    auto payload = std::move(prefetched_.front());
+    prefetched_.pop_front();
+    sendRequests();
+    if (consumingSubscriber_) {
+      consumingSubscriber_->onNext(std::move(payload));
+    }
+  }
+  delivering_ = false;
+
+  if (prefetched_.empty() && completeWhenDrained_) {
+    completeWhenDrained_ = false;
+    completeConsumer();
+    onConsumerDrained();
+  } else {
+    sendRequests();
+  }
+}
+
 void ConsumerBase::handleFlowControlError() {
   if (auto subscriber = std::move(consumingSubscriber_)) {
     subscriber->onError(std::runtime_error("Surplus response"));
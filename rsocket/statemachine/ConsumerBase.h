@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "rsocket/Payload.h"
 #include "rsocket/internal/Allowance.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
@@ -37,8 +39,18 @@ class ConsumerBase : public StreamStateMachineBase,
   /// count towards the limit of allowance the remote PublisherBase may use.
   void addImplicitAllowance(size_t);
 
+  /// Accounts for the application's requests of `n` items made before the
+  /// stream started.  Returns the allowance to send with the frame that
+  /// starts the stream; call sendRequests() once that frame is out to sync
+  /// the rest.
+  uint32_t addInitialAllowance(size_t n);
+
   void generateRequest(size_t);
 
+  /// Makes the consumer prefetch between `watermarks`, see
+  /// RequestNWatermarks.  Must be called before the stream starts.
+  void setRequestNWatermarks(RequestNWatermarks watermarks);
+
   bool consumerClosed() const {
     return state_ == State::CLOSED;
   }
@@ -53,17 +65,30 @@ class ConsumerBase : public StreamStateMachineBase,
   bool
   processFragmentedPayload(Payload&&, bool next, bool complete, bool follows);
 
+  void sendRequests();
+
   void cancelConsumer();
   void completeConsumer();
   void errorConsumer(folly::exception_wrapper);
 
+  /// Whether the peer has completed the stream, but the completion waits
+  /// for the application to request the items prefetched before it.
+  bool consumerDraining() const {
+    return completeWhenDrained_;
+  }
+
+  /// Called when a completion that waited for prefetched items to be
+  /// requested has been delivered.
+  virtual void onConsumerDrained() {}
+
  private:
   enum class State : uint8_t {
     RESPONDING,
     CLOSED,
   };
 
-  void sendRequests();
+  void sendWatermarkRequests();
+  void deliverPrefetched();
 
   void handleFlowControlError();
 
@@ -81,6 +106,16 @@ class ConsumerBase : public StreamStateMachineBase,
   /// calls.
   Allowance activeRequests_;
 
+  /// Watermarks to prefetch between, disabled by default.
+  RequestNWatermarks watermarks_;
+  /// While prefetching, payloads received before the application requested
+  /// them.
+  std::deque<Payload> prefetched_;
+  /// Whether prefetched payloads are being handed to the subscriber.
+  bool delivering_{false};
+  /// See consumerDraining().
+  bool completeWhenDrained_{false};
+
   State state_{State::RESPONDING};
 };
 
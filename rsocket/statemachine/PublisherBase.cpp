@@ -16,10 +16,12 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace rsocket {
 
 PublisherBase::PublisherBase(uint32_t initialRequestN)
-    : initialRequestN_(initialRequestN) {}
+    : pendingRequestN_(initialRequestN) {}
 
 void PublisherBase::publisherSubscribe(
     std::shared_ptr<yarpl::flowable::Subscription> subscription) {
@@ -29,9 +31,7 @@ void PublisherBase::publisherSubscribe(
   }
   DCHECK(!producingSubscription_);
   producingSubscription_ = std::move(subscription);
-  if (initialRequestN_) {
-    producingSubscription_->request(initialRequestN_.consumeAll());
-  }
+  grantRequestN();
 }
 
 void PublisherBase::publisherComplete() {
@@ -50,11 +50,8 @@ void PublisherBase::processRequestN(uint32_t requestN) {
 
   // We might not have the subscription set yet as there can be REQUEST_N frames
   // scheduled on the executor before onSubscribe method.
-  if (producingSubscription_) {
-    producingSubscription_->request(requestN);
-  } else {
-    initialRequestN_.add(requestN);
-  }
+  pendingRequestN_.add(requestN);
+  grantRequestN();
 }
 
 void PublisherBase::terminatePublisher() {
@@ -64,4 +61,51 @@ void PublisherBase::terminatePublisher() {
   }
 }
 
+void PublisherBase::setPublisherWindow(size_t window) {
+  window_ = std::max<size_t>(window, 1);
+}
+
+void PublisherBase::setPublisherPaused(bool paused) {
+  paused_ = paused;
+  grantRequestN();
+}
+
+void PublisherBase::publisherNext() {
+  if (window_ == Allowance::max() || grantedRequestN_ == 0) {
+    return;
+  }
+  --grantedRequestN_;
+  grantRequestN();
+}
+
+void PublisherBase::grantRequestN() {
+  if (granting_) {
+    return;
+  }
+  granting_ = true;
+  while (!paused_ && state_ != State::CLOSED) {
+    // Completing or cancelling from within request() drops the subscription.
+    auto const subscription = producingSubscription_;
+    if (!subscription) {
+      break;
+    }
+
+    size_t requestN;
+    if (window_ == Allowance::max()) {
+      requestN = pendingRequestN_.consumeAll();
+    } else if (grantedRequestN_ <= window_ / 2) {
+      // Top the window up in batches, rather than one item at a time.
+      requestN = pendingRequestN_.consumeUpTo(window_ - grantedRequestN_);
+      grantedRequestN_ += requestN;
+    } else {
+      break;
+    }
+    if (requestN == 0) {
+      break;
+    }
+    subscription->request(requestN);
+  }
+  granting_ = false;
+}
+
 } // namespace rsocket
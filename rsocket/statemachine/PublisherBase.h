@@ -32,15 +32,38 @@ class PublisherBase {
   bool publisherClosed() const;
   void terminatePublisher();
 
+  /// Grant the producer at most `window` items of the peer's credit at a
+  /// time, topping it up as it produces them, so that it stops soon after
+  /// being paused.  Unlimited by default.
+  void setPublisherWindow(size_t window);
+
+  /// While paused, the peer's credit is held back from the producer.
+  void setPublisherPaused(bool paused);
+
+ protected:
+  /// To be called after each item the producer emits.
+  void publisherNext();
+
  private:
   enum class State : uint8_t {
     RESPONDING,
     CLOSED,
   };
 
+  void grantRequestN();
+
   std::shared_ptr<yarpl::flowable::Subscription> producingSubscription_;
-  Allowance initialRequestN_;
+  /// The peer's credit not granted to the producer yet.
+  Allowance pendingRequestN_;
+  /// Credit granted to the producer and not used yet.  Only tracked with a
+  /// window.
+  size_t grantedRequestN_{0};
+  size_t window_{Allowance::max()};
   State state_{State::RESPONDING};
+  bool paused_{false};
+  /// Whether grantRequestN() is on the stack, as the producer may emit items
+  /// from within Subscription::request().
+  bool granting_{false};
 };
 
 } // namespace rsocket
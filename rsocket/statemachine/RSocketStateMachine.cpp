@@ -19,8 +19,11 @@
 #include <folly/Optional.h>
 #include <folly/String.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/HHWheelTimer.h>
 #include <folly/lang/Assume.h>
 
+#include <algorithm>
+
 #include "rsocket/DuplexConnection.h"
 #include "rsocket/RSocketConnectionEvents.h"
 #include "rsocket/RSocketParameters.h"
@@ -28,8 +31,10 @@
 #include "rsocket/RSocketStats.h"
 #include "rsocket/framing/Frame.h"
 #include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/framing/FrameSerializer_v1_0.h"
 #include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/ClientResumeStatusCallback.h"
+#include "rsocket/internal/DeadlineMetadata.h"
 #include "rsocket/internal/ScheduledSubscriber.h"
 #include "rsocket/internal/WarmResumeManager.h"
 #include "rsocket/statemachine/ChannelRequester.h"
@@ -48,23 +53,51 @@ namespace rsocket {
 
 namespace {
 
-void disconnectError(
-    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber) {
-  std::runtime_error exn{"RSocket connection is disconnected or closed"};
+constexpr auto kDisconnectedMessage =
+    "RSocket connection is disconnected or closed";
+constexpr auto kNoLeaseMessage = "No lease available for the request";
+
+/// Stream frames queue up while the transport buffers more than this.
+constexpr size_t kCongestedWriteBytes = 256 * 1024;
+
+/// Most bytes of queued stream frames written per EventBase loop iteration.
+constexpr size_t kQueuedBytesPerLoop = 1024 * 1024;
+
+void rejectRequest(
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber,
+    const char* message) {
+  std::runtime_error exn{message};
   subscriber->onSubscribe(yarpl::flowable::Subscription::create());
   subscriber->onError(std::move(exn));
 }
 
-void disconnectError(
-    std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer) {
-  auto exn = folly::make_exception_wrapper<std::runtime_error>(
-      "RSocket connection is disconnected or closed");
+void rejectRequest(
+    std::shared_ptr<yarpl::single::SingleObserver<Payload>> observer,
+    const char* message) {
+  auto exn = folly::make_exception_wrapper<std::runtime_error>(message);
   observer->onSubscribe(yarpl::single::SingleSubscriptions::empty());
   observer->onError(std::move(exn));
 }
 
 } // namespace
 
+class RSocketStateMachine::StreamDeadline
+    : public folly::HHWheelTimer::Callback {
+ public:
+  StreamDeadline(RSocketStateMachine& stateMachine, StreamId streamId)
+      : stateMachine_(stateMachine), streamId_(streamId) {}
+
+  void timeoutExpired() noexcept override {
+    stateMachine_.onStreamDeadline(streamId_);
+  }
+
+  void callbackCanceled() noexcept override {}
+
+ private:
+  RSocketStateMachine& stateMachine_;
+  const StreamId streamId_;
+};
+
 RSocketStateMachine::RSocketStateMachine(
     std::shared_ptr<RSocketResponder> requestResponder,
     std::unique_ptr<KeepaliveTimer> keepaliveTimer,
@@ -137,9 +170,14 @@ void RSocketStateMachine::connectServer(
     std::shared_ptr<FrameTransport> frameTransport,
     const SetupParameters& setupParams) {
   setResumable(setupParams.resumable);
+  compositeMetadata_ =
+      setupParams.metadataMimeType == kCompositeMetadataMimeType;
   setProtocolVersionOrThrow(setupParams.protocolVersion, frameTransport);
   connect(std::move(frameTransport));
   sendPendingFrames();
+  if (leaseSender_) {
+    startLeases();
+  }
 }
 
 bool RSocketStateMachine::resumeServer(
@@ -186,9 +224,18 @@ void RSocketStateMachine::connectClient(
 
   setProtocolVersionOrThrow(version, transport);
   setResumable(params.resumable);
+  requireLease_ = params.lease;
+  compositeMetadata_ = params.metadataMimeType == kCompositeMetadataMimeType;
+  if (params.maxFragmentSize) {
+    setMaxFragmentSize(*params.maxFragmentSize);
+  }
+  setPendingOutputLimit(params.pendingOutputLimit);
+  setRequestNWatermarks(params.requestNWatermarks);
+  setStreamStatePool(std::move(params.streamStatePool));
 
   Frame_SETUP frame(
       (params.resumable ? FrameFlags::RESUME_ENABLE : FrameFlags::EMPTY_) |
+          (params.lease ? FrameFlags::LEASE : FrameFlags::EMPTY_) |
           (params.payload.metadata ? FrameFlags::METADATA : FrameFlags::EMPTY_),
       version.major,
       version.minor,
@@ -314,6 +361,7 @@ void RSocketStateMachine::close(
   }
 
   closeStreams(signal);
+  dropQueuedFrames();
   closeFrameTransport(ex);
 
   if (auto connectionEvents = std::move(connectionEvents_)) {
@@ -335,6 +383,9 @@ void RSocketStateMachine::closeFrameTransport(folly::exception_wrapper ex) {
   if (keepaliveTimer_) {
     keepaliveTimer_->stop();
   }
+  ++leaseGeneration_;
+  // A drained callback set on the old transport is never going to run.
+  queuedWriteScheduled_ = false;
 
   if (auto resumeCallback = std::move(resumeCallback_)) {
     resumeCallback->onResumeError(ConnectionException(
@@ -414,17 +465,26 @@ void RSocketStateMachine::reconnect(
 
 void RSocketStateMachine::requestStream(
     Payload request,
-    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink,
+    StreamPriority priority) {
   if (isDisconnected()) {
-    disconnectError(std::move(responseSink));
+    rejectRequest(std::move(responseSink), kDisconnectedMessage);
+    return;
+  }
+  if (!acquireLease()) {
+    rejectRequest(std::move(responseSink), kNoLeaseMessage);
     return;
   }
 
   auto const streamId = getNextStreamId();
-  auto stateMachine = std::make_shared<StreamRequester>(
+  setStreamPriority(streamId, priority);
+  auto stateMachine = makeStream<StreamRequester>(
       shared_from_this(), streamId, std::move(request));
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  if (requestNWatermarks_.enabled()) {
+    stateMachine->setRequestNWatermarks(requestNWatermarks_);
+  }
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result);
   stateMachine->subscribe(std::move(responseSink));
 }
 
@@ -432,48 +492,62 @@ std::shared_ptr<yarpl::flowable::Subscriber<Payload>>
 RSocketStateMachine::requestChannel(
     Payload request,
     bool hasInitialRequest,
-    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink) {
+    std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink,
+    StreamPriority priority) {
   if (isDisconnected()) {
-    disconnectError(std::move(responseSink));
+    rejectRequest(std::move(responseSink), kDisconnectedMessage);
+    return nullptr;
+  }
+  if (!acquireLease()) {
+    rejectRequest(std::move(responseSink), kNoLeaseMessage);
     return nullptr;
   }
 
   auto const streamId = getNextStreamId();
+  setStreamPriority(streamId, priority);
   std::shared_ptr<ChannelRequester> stateMachine;
   if (hasInitialRequest) {
-    stateMachine = std::make_shared<ChannelRequester>(
+    stateMachine = makeStream<ChannelRequester>(
         std::move(request), shared_from_this(), streamId);
   } else {
-    stateMachine =
-        std::make_shared<ChannelRequester>(shared_from_this(), streamId);
+    stateMachine = makeStream<ChannelRequester>(shared_from_this(), streamId);
+  }
+  if (requestNWatermarks_.enabled()) {
+    stateMachine->setRequestNWatermarks(requestNWatermarks_);
   }
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  configurePublisher(*stateMachine);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result);
   stateMachine->subscribe(std::move(responseSink));
   return stateMachine;
 }
 
 void RSocketStateMachine::requestResponse(
     Payload request,
-    std::shared_ptr<yarpl::single::SingleObserver<Payload>> responseSink) {
+    std::shared_ptr<yarpl::single::SingleObserver<Payload>> responseSink,
+    StreamPriority priority) {
   if (isDisconnected()) {
-    disconnectError(std::move(responseSink));
+    rejectRequest(std::move(responseSink), kDisconnectedMessage);
+    return;
+  }
+  if (!acquireLease()) {
+    rejectRequest(std::move(responseSink), kNoLeaseMessage);
     return;
   }
 
   auto const streamId = getNextStreamId();
-  auto stateMachine = std::make_shared<RequestResponseRequester>(
+  setStreamPriority(streamId, priority);
+  auto stateMachine = makeStream<RequestResponseRequester>(
       shared_from_this(), streamId, std::move(request));
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result);
   stateMachine->subscribe(std::move(responseSink));
 }
 
 void RSocketStateMachine::closeStreams(StreamCompletionSignal signal) {
+  streamDeadlines_.clear();
   while (!streams_.empty()) {
-    auto it = streams_.begin();
-    auto streamStateMachine = std::move(it->second);
-    streams_.erase(it);
+    auto streamStateMachine = streams_.extractAny();
     streamStateMachine->endStream(signal);
   }
 }
@@ -500,13 +574,37 @@ void RSocketStateMachine::processFrame(std::unique_ptr<folly::IOBuf> frame) {
     return;
   }
 
-  const auto frameLength = frame->computeChainDataLength();
   const auto streamId = *optStreamId;
+  if (!isResumable_) {
+    handleFrame(streamId, frameType, std::move(frame));
+    return;
+  }
+
+  const auto frameLength = frame->computeChainDataLength();
   handleFrame(streamId, frameType, std::move(frame));
   resumeManager_->trackReceivedFrame(
       frameLength, frameType, streamId, getConsumerAllowance(streamId));
 }
 
+void RSocketStateMachine::processFrames(
+    std::vector<std::unique_ptr<folly::IOBuf>> frames) {
+  // Frames in the batch were all read from this transport.  If one of them
+  // tears it down, the rest are dropped like they would have been had they
+  // arrived one by one.
+  auto const transport = frameTransport_;
+
+  processingBatch_ = true;
+  for (auto& frame : frames) {
+    if (frameTransport_ != transport) {
+      break;
+    }
+    processFrame(std::move(frame));
+  }
+  processingBatch_ = false;
+
+  flushRequestN();
+}
+
 void RSocketStateMachine::onTerminal(folly::exception_wrapper ex) {
   if (isResumable_) {
     disconnect(std::move(ex));
@@ -534,6 +632,13 @@ void RSocketStateMachine::onKeepAliveFrame(
           "client received keepalive with respond flag"));
     } else if (keepaliveTimer_) {
       keepaliveTimer_->keepaliveReceived();
+      if (auto const rtt = KeepaliveTimer::roundTripTime(data.get())) {
+        auto const rttStats = rttEstimator_.withWLock([&](RttEstimator& rtts) {
+          rtts.addSample(*rtt);
+          return rtts.stats();
+        });
+        stats_->rttMeasured(rttStats);
+      }
     }
     stats_->keepaliveReceived();
   }
@@ -569,12 +674,12 @@ void RSocketStateMachine::onResumeOkFrame(ResumePosition resumePosition) {
         auto subscriber = coldResumeHandler_->handleRequesterResumeStream(
             streamResumeInfo.streamToken, streamResumeInfo.consumerAllowance);
 
-        auto stateMachine = std::make_shared<StreamRequester>(
+        auto stateMachine = makeStream<StreamRequester>(
             shared_from_this(), streamId, Payload());
         // Set requested to true (since cold resumption)
         stateMachine->setRequested(streamResumeInfo.consumerAllowance);
-        const auto result = streams_.emplace(streamId, stateMachine);
-        DCHECK(result.second);
+        const auto result = streams_.insert(streamId, stateMachine);
+        DCHECK(result);
         stateMachine->subscribe(
             std::make_shared<ScheduledSubscriptionSubscriber<Payload>>(
                 std::move(subscriber),
@@ -639,8 +744,16 @@ void RSocketStateMachine::onReservedFrame() {
   onUnexpectedFrame(0);
 }
 
-void RSocketStateMachine::onLeaseFrame() {
-  onUnexpectedFrame(0);
+void RSocketStateMachine::onLeaseFrame(
+    uint32_t ttl,
+    uint32_t numberOfRequests) {
+  if (!requireLease_) {
+    // Leases were not negotiated in the SETUP frame.
+    onUnexpectedFrame(0);
+    return;
+  }
+  receivedLease_.grant(std::chrono::milliseconds(ttl), numberOfRequests);
+  stats_->leaseReceived(numberOfRequests);
 }
 
 void RSocketStateMachine::onExtFrame() {
@@ -705,12 +818,18 @@ void RSocketStateMachine::handleFrame(
     case FrameType::RESERVED:
       onReservedFrame();
       return;
-    case FrameType::LEASE:
-      onLeaseFrame();
+    case FrameType::LEASE: {
+      Frame_LEASE frame;
+      if (!deserializeFrameOrError(frame, std::move(payload))) {
+        return;
+      }
+      VLOG(3) << mode_ << " In: " << frame;
+      onLeaseFrame(frame.ttl_, frame.numberOfRequests_);
       return;
+    }
     case FrameType::REQUEST_N: {
       Frame_REQUEST_N frameRequestN;
-      if (!deserializeFrameOrError(frameRequestN, std::move(payload))) {
+      if (!deserializeHotFrameOrError(frameRequestN, std::move(payload))) {
         return;
       }
       VLOG(3) << mode_ << " In: " << frameRequestN;
@@ -718,13 +837,17 @@ void RSocketStateMachine::handleFrame(
       break;
     }
     case FrameType::CANCEL: {
-      VLOG(3) << mode_ << " In: " << Frame_CANCEL(streamId);
+      Frame_CANCEL frame;
+      if (!deserializeHotFrameOrError(frame, std::move(payload))) {
+        return;
+      }
+      VLOG(3) << mode_ << " In: " << frame;
       onCancelFrame(streamId);
       break;
     }
     case FrameType::PAYLOAD: {
       Frame_PAYLOAD framePayload;
-      if (!deserializeFrameOrError(framePayload, std::move(payload))) {
+      if (!deserializeHotFrameOrError(framePayload, std::move(payload))) {
         return;
       }
       VLOG(3) << mode_ << " In: " << framePayload;
@@ -766,7 +889,7 @@ void RSocketStateMachine::handleFrame(
     }
     case FrameType::REQUEST_RESPONSE: {
       Frame_REQUEST_RESPONSE frame;
-      if (!deserializeFrameOrError(frame, std::move(payload))) {
+      if (!deserializeHotFrameOrError(frame, std::move(payload))) {
         return;
       }
       VLOG(3) << mode_ << " In: " << frame;
@@ -798,14 +921,14 @@ void RSocketStateMachine::handleFrame(
 
 std::shared_ptr<StreamStateMachineBase>
 RSocketStateMachine::getStreamStateMachine(StreamId streamId) {
-  const auto&& it = streams_.find(streamId);
-  if (it == streams_.end()) {
+  const auto stateMachine = streams_.find(streamId);
+  if (!stateMachine) {
     return nullptr;
   }
   // we are purposely making a copy of the reference here to avoid problems with
   // lifetime of the stateMachine when a terminating signal is delivered which
   // will cause the stateMachine to be destroyed while in one of its methods
-  return it->second;
+  return *stateMachine;
 }
 
 bool RSocketStateMachine::ensureNotInResumption() {
@@ -838,6 +961,9 @@ void RSocketStateMachine::onCancelFrame(StreamId streamId) {
   if (!ensureNotInResumption()) {
     return;
   }
+  // The peer doesn't want the frames still queued for the stream, even if the
+  // stream already completed on our side.
+  dropQueuedFrames(streamId);
   // we ignore  messages for streams which don't exist
   if (auto stateMachine = getStreamStateMachine(streamId)) {
     stateMachine->handleCancel();
@@ -865,13 +991,15 @@ void RSocketStateMachine::onRequestStreamFrame(
     uint32_t requestN,
     Payload payload,
     bool flagsFollows) {
-  if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
+  if (!ensureNotInResumption() || !isNewStreamId(streamId) ||
+      !admitPeerRequest(streamId, StreamType::STREAM)) {
     return;
   }
   auto stateMachine =
-      std::make_shared<StreamResponder>(shared_from_this(), streamId, requestN);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+      makeStream<StreamResponder>(shared_from_this(), streamId, requestN);
+  configurePublisher(*stateMachine);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -882,13 +1010,18 @@ void RSocketStateMachine::onRequestChannelFrame(
     bool flagsComplete,
     bool flagsNext,
     bool flagsFollows) {
-  if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
+  if (!ensureNotInResumption() || !isNewStreamId(streamId) ||
+      !admitPeerRequest(streamId, StreamType::CHANNEL)) {
     return;
   }
-  auto stateMachine = std::make_shared<ChannelResponder>(
+  auto stateMachine = makeStream<ChannelResponder>(
       shared_from_this(), streamId, requestN);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+  if (requestNWatermarks_.enabled()) {
+    stateMachine->setRequestNWatermarks(requestNWatermarks_);
+  }
+  configurePublisher(*stateMachine);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result); // ensured by calling isNewStreamId
   stateMachine->handlePayload(
       std::move(payload), flagsComplete, flagsNext, flagsFollows);
 }
@@ -897,13 +1030,14 @@ void RSocketStateMachine::onRequestResponseFrame(
     StreamId streamId,
     Payload payload,
     bool flagsFollows) {
-  if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
+  if (!ensureNotInResumption() || !isNewStreamId(streamId) ||
+      !admitPeerRequest(streamId, StreamType::REQUEST_RESPONSE)) {
     return;
   }
   auto stateMachine =
-      std::make_shared<RequestResponseResponder>(shared_from_this(), streamId);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+      makeStream<RequestResponseResponder>(shared_from_this(), streamId);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -911,13 +1045,14 @@ void RSocketStateMachine::onFireAndForgetFrame(
     StreamId streamId,
     Payload payload,
     bool flagsFollows) {
-  if (!ensureNotInResumption() || !isNewStreamId(streamId)) {
+  if (!ensureNotInResumption() || !isNewStreamId(streamId) ||
+      !admitPeerRequest(streamId, StreamType::FNF)) {
     return;
   }
   auto stateMachine =
-      std::make_shared<FireAndForgetResponder>(shared_from_this(), streamId);
-  const auto result = streams_.emplace(streamId, stateMachine);
-  DCHECK(result.second); // ensured by calling isNewStreamId
+      makeStream<FireAndForgetResponder>(shared_from_this(), streamId);
+  const auto result = streams_.insert(streamId, stateMachine);
+  DCHECK(result); // ensured by calling isNewStreamId
   stateMachine->handlePayload(std::move(payload), false, false, flagsFollows);
 }
 
@@ -935,6 +1070,11 @@ RSocketStateMachine::onNewStreamReady(
     StreamType streamType,
     Payload payload,
     std::shared_ptr<yarpl::flowable::Subscriber<Payload>> response) {
+  // Requesters only give deadlines to streams and request-responses.
+  auto const deadline = streamType == StreamType::STREAM
+      ? takeStreamDeadline(streamId, payload)
+      : folly::none;
+
   if (coldResumeHandler_ && streamType != StreamType::FNF) {
     auto streamToken =
         coldResumeHandler_->generateStreamToken(payload, streamId, streamType);
@@ -948,8 +1088,13 @@ RSocketStateMachine::onNewStreamReady(
           std::move(payload), streamId, std::move(response));
 
     case StreamType::STREAM:
-      requestResponder_->handleRequestStream(
-          std::move(payload), streamId, std::move(response));
+      if (deadline) {
+        requestResponder_->handleRequestStreamWithDeadline(
+            std::move(payload), streamId, std::move(response), *deadline);
+      } else {
+        requestResponder_->handleRequestStream(
+            std::move(payload), streamId, std::move(response));
+      }
       return nullptr;
 
     case StreamType::REQUEST_RESPONSE:
@@ -974,14 +1119,65 @@ void RSocketStateMachine::onNewStreamReady(
     std::shared_ptr<yarpl::single::SingleObserver<Payload>> response) {
   CHECK(streamType == StreamType::REQUEST_RESPONSE);
 
+  auto const deadline = takeStreamDeadline(streamId, payload);
+
   if (coldResumeHandler_) {
     auto streamToken =
         coldResumeHandler_->generateStreamToken(payload, streamId, streamType);
     resumeManager_->onStreamOpen(
         streamId, RequestOriginator::REMOTE, streamToken, streamType);
   }
-  requestResponder_->handleRequestResponse(
-      std::move(payload), streamId, std::move(response));
+  if (deadline) {
+    requestResponder_->handleRequestResponseWithDeadline(
+        std::move(payload), streamId, std::move(response), *deadline);
+  } else {
+    requestResponder_->handleRequestResponse(
+        std::move(payload), streamId, std::move(response));
+  }
+}
+
+void RSocketStateMachine::addRequestDeadline(
+    Payload& request,
+    std::chrono::milliseconds budget) {
+  if (compositeMetadata_) {
+    encodeDeadline(request, budget);
+  }
+}
+
+folly::Optional<std::chrono::steady_clock::time_point>
+RSocketStateMachine::takeStreamDeadline(StreamId streamId, Payload& payload) {
+  if (!compositeMetadata_) {
+    return folly::none;
+  }
+  auto const budget = decodeDeadline(payload);
+  if (!budget) {
+    return folly::none;
+  }
+
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  CHECK(evb);
+  auto& deadline = streamDeadlines_[streamId];
+  deadline = std::make_unique<StreamDeadline>(*this, streamId);
+  evb->timer().scheduleTimeout(deadline.get(), *budget);
+  return std::chrono::steady_clock::now() + *budget;
+}
+
+void RSocketStateMachine::onStreamDeadline(StreamId streamId) {
+  auto const it = streamDeadlines_.find(streamId);
+  if (it == streamDeadlines_.end()) {
+    return;
+  }
+  // Called from the timer itself, which is fine to destroy now.
+  auto const deadline = std::move(it->second);
+  streamDeadlines_.erase(it);
+
+  // As if the requester had cancelled the stream, which it has by now.
+  if (auto stateMachine = getStreamStateMachine(streamId)) {
+    VLOG(3) << mode_ << " Deadline of stream " << streamId
+            << " passed, cancelling it";
+    dropQueuedFrames(streamId);
+    stateMachine->handleCancel();
+  }
 }
 
 void RSocketStateMachine::sendKeepalive(std::unique_ptr<folly::IOBuf> data) {
@@ -998,6 +1194,86 @@ void RSocketStateMachine::sendKeepalive(
   stats_->keepaliveSent();
 }
 
+void RSocketStateMachine::setLeaseSender(
+    std::shared_ptr<LeaseSender> leaseSender) {
+  DCHECK(isDisconnected());
+  leaseSender_ = std::move(leaseSender);
+}
+
+void RSocketStateMachine::startLeases() {
+  DCHECK(leaseSender_);
+  ++leaseGeneration_;
+  sendLease();
+}
+
+void RSocketStateMachine::sendLease() {
+  if (isDisconnected()) {
+    return;
+  }
+
+  // Only the streams the peer opened count as load; the ones we opened are
+  // served by the peer.
+  auto const peer =
+      mode_ == RSocketMode::CLIENT ? RSocketMode::SERVER : RSocketMode::CLIENT;
+  if (auto lease = leaseSender_->nextLease(streams_.size(peer))) {
+    auto const ttl = std::min<int64_t>(
+        std::max<int64_t>(lease->ttl.count(), 1), Frame_LEASE::kMaxTtl);
+    auto const numberOfRequests =
+        std::min(lease->numberOfRequests, Frame_LEASE::kMaxNumRequests);
+    if (numberOfRequests > 0) {
+      Frame_LEASE frame{static_cast<uint32_t>(ttl), numberOfRequests};
+      VLOG(3) << mode_ << " Out: " << frame;
+      grantedLease_.grant(std::chrono::milliseconds(ttl), numberOfRequests);
+      outputFrameOrEnqueue(frameSerializer_->serializeOut(std::move(frame)));
+      stats_->leaseSent(numberOfRequests);
+    }
+  }
+
+  // Sending the frame can fail and disconnect us.
+  if (!isDisconnected()) {
+    scheduleLeaseRenewal();
+  }
+}
+
+void RSocketStateMachine::scheduleLeaseRenewal() {
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  CHECK(evb);
+  evb->runAfterDelay(
+      [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this()),
+       generation = leaseGeneration_] {
+        auto self = weak.lock();
+        if (self && self->leaseGeneration_ == generation) {
+          self->sendLease();
+        }
+      },
+      static_cast<uint32_t>(leaseSender_->renewalInterval().count()));
+}
+
+bool RSocketStateMachine::acquireLease() {
+  if (!requireLease_ || receivedLease_.tryConsume()) {
+    return true;
+  }
+  VLOG(3) << mode_ << " Rejecting request, no lease from the responder";
+  stats_->requestRejectedWithoutLease();
+  return false;
+}
+
+bool RSocketStateMachine::admitPeerRequest(
+    StreamId streamId,
+    StreamType streamType) {
+  if (!leaseSender_ || grantedLease_.tryConsume()) {
+    return true;
+  }
+  VLOG(3) << mode_ << " Rejecting stream " << streamId << ", no lease granted";
+  stats_->requestRejectedWithoutLease();
+  // Fire-and-forget requests have nobody to report the rejection to.
+  if (streamType != StreamType::FNF) {
+    outputFrameOrEnqueue(frameSerializer_->serializeOut(
+        Frame_ERROR::rejected(streamId, "No lease granted")));
+  }
+  return false;
+}
+
 bool RSocketStateMachine::isPositionAvailable(ResumePosition position) const {
   return resumeManager_->isPositionAvailable(position);
 }
@@ -1044,15 +1320,14 @@ void RSocketStateMachine::resumeFromPosition(ResumePosition position) {
     connectionEvents_->onStreamsResumed();
   }
   resumeManager_->sendFramesFromPosition(position, *frameTransport_);
-
-  auto frames = consumePendingOutputFrames();
-  for (auto& frame : frames) {
-    outputFrameOrEnqueue(std::move(frame));
-  }
+  outputPendingFrames();
 
   if (!isDisconnected() && keepaliveTimer_) {
     keepaliveTimer_->start(shared_from_this());
   }
+  if (!isDisconnected() && leaseSender_) {
+    startLeases();
+  }
 }
 
 bool RSocketStateMachine::shouldQueue() {
@@ -1060,10 +1335,17 @@ bool RSocketStateMachine::shouldQueue() {
   return isDisconnected() || resumeCallback_;
 }
 
-void RSocketStateMachine::fireAndForget(Payload request) {
+void RSocketStateMachine::fireAndForget(
+    Payload request,
+    StreamPriority priority) {
+  if (!acquireLease()) {
+    return;
+  }
   auto const streamId = getNextStreamId();
-  Frame_REQUEST_FNF frame{streamId, FrameFlags::EMPTY_, std::move(request)};
-  outputFrameOrEnqueue(frameSerializer_->serializeOut(std::move(frame)));
+  // There is no stream to close, its queued frames keep the priority.
+  setStreamPriority(streamId, priority);
+  writeNewStream(streamId, StreamType::FNF, 0, std::move(request));
+  clearStreamPriority(streamId);
 }
 
 void RSocketStateMachine::metadataPush(std::unique_ptr<folly::IOBuf> metadata) {
@@ -1087,6 +1369,10 @@ void RSocketStateMachine::outputFrame(std::unique_ptr<folly::IOBuf> frame) {
   frameTransport_->outputFrameOrDrop(std::move(frame));
 }
 
+RttStats RSocketStateMachine::getRttStats() const {
+  return rttEstimator_.rlock()->stats();
+}
+
 uint32_t RSocketStateMachine::getKeepaliveTime() const {
   return keepaliveTimer_
       ? static_cast<uint32_t>(keepaliveTimer_->keepaliveTime().count())
@@ -1117,8 +1403,146 @@ void RSocketStateMachine::writeNewStream(
       streamId, streamType, initialRequestN, std::move(payload));
 }
 
+void RSocketStateMachine::writeRequestN(Frame_REQUEST_N&& frame) {
+  if (!processingBatch_) {
+    StreamsWriterImpl::writeRequestN(std::move(frame));
+    return;
+  }
+
+  const auto streamId = frame.header_.streamId;
+  auto& pending = pendingRequestN_[streamId];
+  if (pending + static_cast<int64_t>(frame.requestN_) >
+      Frame_REQUEST_N::kMaxRequestN) {
+    StreamsWriterImpl::writeRequestN(Frame_REQUEST_N(streamId, pending));
+    pending = 0;
+  }
+  pending += frame.requestN_;
+}
+
+void RSocketStateMachine::flushRequestN() {
+  if (pendingRequestN_.empty()) {
+    return;
+  }
+  auto pending = std::move(pendingRequestN_);
+  pendingRequestN_.clear();
+  for (const auto& entry : pending) {
+    // Streams which terminated later in the batch don't need more allowance.
+    if (streams_.count(entry.first)) {
+      StreamsWriterImpl::writeRequestN(
+          Frame_REQUEST_N(entry.first, entry.second));
+    }
+  }
+}
+
+void RSocketStateMachine::scheduleQueuedFrames() {
+  if (queuedWriteScheduled_ || isDisconnected()) {
+    // sendPendingFrames() schedules them again after reconnecting.
+    return;
+  }
+  queuedWriteScheduled_ = true;
+
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  CHECK(evb);
+  evb->runInLoop(
+      [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this())] {
+        if (auto self = weak.lock()) {
+          self->writeQueuedFramesInLoop();
+        }
+      });
+}
+
+bool RSocketStateMachine::isOutputCongested() {
+  return frameTransport_ &&
+      frameTransport_->getQueuedWriteBytes() > kCongestedWriteBytes;
+}
+
+void RSocketStateMachine::writeQueuedFramesInLoop() {
+  queuedWriteScheduled_ = false;
+  if (!writeQueuedFrames(kQueuedBytesPerLoop) || isDisconnected()) {
+    return;
+  }
+  if (!isOutputCongested()) {
+    // Out of budget, let the rest of the loop run first.
+    scheduleQueuedFrames();
+    return;
+  }
+  queuedWriteScheduled_ = true;
+  frameTransport_->setWriteDrainedCallback(
+      kCongestedWriteBytes,
+      [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this())] {
+        if (auto self = weak.lock()) {
+          self->queuedWriteScheduled_ = false;
+          self->scheduleQueuedFrames();
+        }
+      });
+}
+
+void RSocketStateMachine::onPendingOutputFull() {
+  VLOG(2) << "Pending output exceeds its budget, pausing local publishers";
+  setPublishersPaused(true);
+}
+
+void RSocketStateMachine::onPendingOutputDrained() {
+  VLOG(2) << "Pending output drained, resuming local publishers";
+  setPublishersPaused(false);
+}
+
+void RSocketStateMachine::setPublishersPaused(bool paused) {
+  // Resumed publishers may produce and complete right away, closing streams.
+  std::vector<std::shared_ptr<StreamStateMachineBase>> streams;
+  streams.reserve(streams_.size());
+  streams_.forEach(
+      [&](const std::shared_ptr<StreamStateMachineBase>& stateMachine) {
+        streams.push_back(stateMachine);
+      });
+  for (auto& stateMachine : streams) {
+    stateMachine->setPublisherPaused(paused);
+  }
+}
+
+void RSocketStateMachine::configurePublisher(PublisherBase& publisher) {
+  auto const& limit = getPendingOutputLimit();
+  if (limit.isLimited()) {
+    publisher.setPublisherWindow(limit.publisherWindow);
+  }
+  if (isPendingOutputFull()) {
+    publisher.setPublisherPaused(true);
+  }
+}
+
+void RSocketStateMachine::scheduleOverflowedStreams() {
+  auto const evb = folly::EventBaseManager::get()->getExistingEventBase();
+  CHECK(evb);
+  evb->runInLoop(
+      [weak = std::weak_ptr<RSocketStateMachine>(shared_from_this())] {
+        if (auto self = weak.lock()) {
+          self->failOverflowedStreams();
+        }
+      });
+}
+
+void RSocketStateMachine::onPendingOutputOverflow(StreamId streamId) {
+  constexpr auto kOverflowMessage = "Pending output limit exceeded";
+
+  auto const stateMachine = getStreamStateMachine(streamId);
+  if (!stateMachine) {
+    // It ended in the meantime.
+    return;
+  }
+  // Stream responders tell the peer and close themselves in endStream().
+  stateMachine->endStream(StreamCompletionSignal::ERROR);
+  if (!getStreamStateMachine(streamId)) {
+    return;
+  }
+  outputFrameOrEnqueue(frameSerializer_->serializeOut(
+      Frame_ERROR::applicationError(streamId, kOverflowMessage)));
+  onStreamClosed(streamId);
+}
+
 void RSocketStateMachine::onStreamClosed(StreamId streamId) {
   streams_.erase(streamId);
+  streamDeadlines_.erase(streamId);
+  clearStreamPriority(streamId);
   resumeManager_->onStreamClosed(streamId);
 }
 
@@ -1145,13 +1569,15 @@ bool RSocketStateMachine::ensureOrAutodetectFrameSerializer(
   frameSerializer_ = std::move(serializer);
   frameSerializer_->preallocateFrameSizeField() =
       frameTransport_ && frameTransport_->isConnectionFramed();
+  hotFrameParser_ =
+      frameSerializer_->protocolVersion() == FrameSerializerV1_0::Version;
 
   return true;
 }
 
 size_t RSocketStateMachine::getConsumerAllowance(StreamId streamId) const {
-  auto const it = streams_.find(streamId);
-  return it != streams_.end() ? it->second->getConsumerAllowance() : 0;
+  auto const stateMachine = streams_.find(streamId);
+  return stateMachine ? (*stateMachine)->getConsumerAllowance() : 0;
 }
 
 void RSocketStateMachine::registerCloseCallback(
@@ -1188,6 +1614,7 @@ void RSocketStateMachine::setProtocolVersionOrThrow(
     frameSerializer_ = std::move(frameSerializer);
     frameSerializer_->preallocateFrameSizeField() =
         frameTransport_ && frameTransport_->isConnectionFramed();
+    hotFrameParser_ = version == FrameSerializerV1_0::Version;
   }
 
   transportGuard.dismiss();
@@ -14,18 +14,29 @@
 
 #pragma once
 
+#include <folly/Optional.h>
+#include <folly/Synchronized.h>
+
 #include <deque>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "rsocket/ColdResumeHandler.h"
 #include "rsocket/DuplexConnection.h"
+#include "rsocket/LeaseSender.h"
 #include "rsocket/Payload.h"
 #include "rsocket/RSocketParameters.h"
 #include "rsocket/ResumeManager.h"
+#include "rsocket/framing/FrameParser_v1_0.h"
 #include "rsocket/framing/FrameProcessor.h"
 #include "rsocket/framing/FrameSerializer.h"
 #include "rsocket/internal/Common.h"
 #include "rsocket/internal/KeepaliveTimer.h"
+#include "rsocket/internal/LeaseWindow.h"
+#include "rsocket/internal/RttEstimator.h"
+#include "rsocket/internal/StreamRegistry.h"
+#include "rsocket/internal/StreamStatePool.h"
 #include "rsocket/statemachine/StreamFragmentAccumulator.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/statemachine/StreamsWriter.h"
@@ -40,6 +51,7 @@ class DuplexConnection;
 class FrameTransport;
 class Frame_ERROR;
 class KeepaliveTimer;
+class PublisherBase;
 class RSocketConnectionEvents;
 class RSocketParameters;
 class RSocketResponder;
@@ -132,19 +144,27 @@ class RSocketStateMachine final
 
   void requestStream(
       Payload request,
-      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink);
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink,
+      StreamPriority priority = StreamPriority());
 
   std::shared_ptr<yarpl::flowable::Subscriber<Payload>> requestChannel(
       Payload request,
       bool hasInitialRequest,
-      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink);
+      std::shared_ptr<yarpl::flowable::Subscriber<Payload>> responseSink,
+      StreamPriority priority = StreamPriority());
 
   void requestResponse(
       Payload payload,
-      std::shared_ptr<yarpl::single::SingleObserver<Payload>> responseSink);
+      std::shared_ptr<yarpl::single::SingleObserver<Payload>> responseSink,
+      StreamPriority priority = StreamPriority());
 
   /// Send a REQUEST_FNF frame.
-  void fireAndForget(Payload);
+  void fireAndForget(Payload, StreamPriority priority = StreamPriority());
+
+  /// Tell the responder the deadline of a request, in its metadata.  Only
+  /// done when the connection's metadata is composite metadata, elsewhere the
+  /// requester alone enforces the deadline.
+  void addRequestDeadline(Payload& request, std::chrono::milliseconds budget);
 
   /// Send a METADATA_PUSH frame.
   void metadataPush(std::unique_ptr<folly::IOBuf>);
@@ -152,6 +172,26 @@ class RSocketStateMachine final
   /// Send a KEEPALIVE frame, with the RESPOND flag set.
   void sendKeepalive(std::unique_ptr<folly::IOBuf>) override;
 
+  /// Grant leases to the peer according to the given policy, and reject its
+  /// requests that arrive without a valid lease.  Must be called before
+  /// connectServer().
+  void setLeaseSender(std::shared_ptr<LeaseSender>);
+
+  /// Make the streams this side consumes prefetch between `watermarks`, see
+  /// RequestNWatermarks.  Applies to the streams started afterwards.
+  void setRequestNWatermarks(RequestNWatermarks watermarks) {
+    requestNWatermarks_ = watermarks;
+  }
+
+  /// Recycle the memory of stream state machines through `pool`, which may be
+  /// shared with other connections.  Applies to the streams started
+  /// afterwards.
+  void setStreamStatePool(std::shared_ptr<StreamStatePool> pool) {
+    if (pool) {
+      streamStatePool_ = std::move(pool);
+    }
+  }
+
   class CloseCallback {
    public:
     virtual ~CloseCallback() = default;
@@ -168,6 +208,9 @@ class RSocketStateMachine final
   // Has active requests?
   bool hasStreams() const;
 
+  /// Round trip times measured with keepalives so far.  Thread-safe.
+  RttStats getRttStats() const;
+
  private:
   // connection scope signals
   void onKeepAliveFrame(
@@ -207,13 +250,20 @@ class RSocketStateMachine final
   void onSetupFrame();
   void onResumeFrame();
   void onReservedFrame();
-  void onLeaseFrame();
+  void onLeaseFrame(uint32_t ttl, uint32_t numberOfRequests);
   void onExtFrame();
   void onUnexpectedFrame(StreamId streamId);
 
   std::shared_ptr<StreamStateMachineBase> getStreamStateMachine(
       StreamId streamId);
 
+  /// Create a stream state machine in memory recycled from closed streams.
+  template <typename T, typename... Args>
+  std::shared_ptr<T> makeStream(Args&&... args) {
+    return std::allocate_shared<T>(
+        StreamStateAllocator<T>(streamStatePool_), std::forward<Args>(args)...);
+  }
+
   void connect(std::shared_ptr<FrameTransport>);
 
   /// Terminate underlying connection and connect new connection
@@ -258,8 +308,25 @@ class RSocketStateMachine final
     return false;
   }
 
+  /// Like deserializeFrameOrError(), for the frame types FrameParserV1_0
+  /// handles.  Skips the virtual serializer call on 1.0 connections.
+  template <typename TFrame>
+  bool deserializeHotFrameOrError(
+      TFrame& frame,
+      std::unique_ptr<folly::IOBuf> buf) {
+    if (!hotFrameParser_) {
+      return deserializeFrameOrError(frame, std::move(buf));
+    }
+    if (deserializeHotFrame(frame, std::move(buf), *frameSerializer_)) {
+      return true;
+    }
+    closeWithError(Frame_ERROR::connectionError("Invalid frame"));
+    return false;
+  }
+
   // FrameProcessor.
   void processFrame(std::unique_ptr<folly::IOBuf>) override;
+  void processFrames(std::vector<std::unique_ptr<folly::IOBuf>>) override;
   void onTerminal(folly::exception_wrapper) override;
 
   void handleFrame(StreamId, FrameType, std::unique_ptr<folly::IOBuf>);
@@ -269,6 +336,18 @@ class RSocketStateMachine final
 
   void sendKeepalive(FrameFlags, std::unique_ptr<folly::IOBuf>);
 
+  /// Send a fresh lease to the peer, and schedule the next renewal.
+  void sendLease();
+  void scheduleLeaseRenewal();
+  void startLeases();
+
+  /// Whether a new local request may be sent under the peer's lease.
+  bool acquireLease();
+
+  /// Whether a new request from the peer is covered by the lease we granted.
+  /// Rejects the stream otherwise.
+  bool admitPeerRequest(StreamId, StreamType);
+
   void resumeFromPosition(ResumePosition);
   void outputFrame(std::unique_ptr<folly::IOBuf>) override;
 
@@ -290,8 +369,45 @@ class RSocketStateMachine final
       std::shared_ptr<yarpl::single::SingleObserver<Payload>> response)
       override;
 
+  /// Strips the deadline the requester put in a new stream's request, and
+  /// schedules the stream's cancellation for when it passes.
+  folly::Optional<std::chrono::steady_clock::time_point> takeStreamDeadline(
+      StreamId streamId,
+      Payload& payload);
+
+  /// Cancels a stream whose requester's deadline passed.
+  void onStreamDeadline(StreamId streamId);
+
   void onStreamClosed(StreamId) override;
 
+  /// Queued stream frames are written from a loop callback, a bounded amount
+  /// per EventBase loop iteration, and only while the transport has little
+  /// data buffered.  When it has too much, writing resumes once it drains.
+  void scheduleQueuedFrames() override;
+  bool isOutputCongested() override;
+  void writeQueuedFramesInLoop();
+
+  /// While the pending output exceeds its budget, the local publishers of all
+  /// streams are paused: the peer's credit still accumulates, but they are
+  /// granted none of it until the pending frames have been written.  With
+  /// FAIL_STREAMS, streams that overflow it are failed from a loop callback,
+  /// and end with a single ERROR frame to the peer.
+  void onPendingOutputFull() override;
+  void onPendingOutputDrained() override;
+  void onPendingOutputOverflow(StreamId) override;
+  void scheduleOverflowedStreams() override;
+
+  /// Pause or resume the local publishers of all streams.
+  void setPublishersPaused(bool paused);
+
+  /// Apply the pending output limit to a new stream's local publisher.
+  void configurePublisher(PublisherBase&);
+
+  /// While a batch of frames is being processed, REQUEST_N frames are merged
+  /// per stream and only written once the batch is done.
+  void writeRequestN(Frame_REQUEST_N&&) override;
+  void flushRequestN();
+
   bool ensureOrAutodetectFrameSerializer(const folly::IOBuf& firstFrame);
   bool ensureNotInResumption();
 
@@ -313,17 +429,64 @@ class RSocketStateMachine final
   /// Whether the connection was initialized as resumable.
   bool isResumable_{false};
 
+  /// Whether the SETUP frame declared composite metadata, which request
+  /// deadlines are carried in.
+  bool compositeMetadata_{false};
+
   /// Whether the connection has closed.
   bool isClosed_{false};
 
   /// Whether a cold resume is currently in progress.
   bool coldResumeInProgress_{false};
 
+  /// Whether processFrames() is dispatching a batch of frames.
+  bool processingBatch_{false};
+
+  /// Whether writeQueuedFramesInLoop() is scheduled or awaits the transport
+  /// draining.
+  bool queuedWriteScheduled_{false};
+
+  /// REQUEST_N allowance generated by streams during the current batch.
+  std::unordered_map<StreamId, uint32_t> pendingRequestN_;
+
+  /// Watermarks the streams this side consumes prefetch between.
+  RequestNWatermarks requestNWatermarks_;
+
+  /// Whether this side asked for leases in its SETUP frame, and so may only
+  /// send requests covered by a lease received from the peer.
+  bool requireLease_{false};
+
+  /// Most recent lease received from the peer.
+  LeaseWindow receivedLease_;
+
+  /// Policy for leases granted to the peer.  Null if leases are not in use.
+  std::shared_ptr<LeaseSender> leaseSender_;
+
+  /// Most recent lease granted to the peer.
+  LeaseWindow grantedLease_;
+
+  /// Bumped to invalidate scheduled lease renewals.
+  uint32_t leaseGeneration_{0};
+
   std::shared_ptr<RSocketStats> stats_;
 
-  /// Map of all individual stream state machines.
-  std::unordered_map<StreamId, std::shared_ptr<StreamStateMachineBase>>
-      streams_;
+  /// Written on the EventBase, but read from any thread.
+  folly::Synchronized<RttEstimator> rttEstimator_;
+
+  /// All individual stream state machines.
+  StreamRegistry<StreamStateMachineBase> streams_;
+
+  class StreamDeadline;
+
+  /// Timers of the streams the peer gave a deadline, dropped (and so
+  /// cancelled) when the stream closes.
+  std::unordered_map<StreamId, std::unique_ptr<StreamDeadline>>
+      streamDeadlines_;
+
+  /// Memory for stream state machines, shared with the streams themselves so
+  /// that it outlives all of them.
+  std::shared_ptr<StreamStatePool> streamStatePool_{
+      std::make_shared<StreamStatePool>()};
   StreamId nextStreamId_;
   StreamId lastPeerStreamId_{0};
 
@@ -333,6 +496,8 @@ class RSocketStateMachine final
   const std::shared_ptr<RSocketResponderCore> requestResponder_;
   std::shared_ptr<FrameTransport> frameTransport_;
   std::unique_ptr<FrameSerializer> frameSerializer_;
+  /// Whether frameSerializer_ speaks 1.0, so FrameParserV1_0 can be used.
+  bool hotFrameParser_{false};
 
   const std::unique_ptr<KeepaliveTimer> keepaliveTimer_;
 
@@ -77,6 +77,9 @@ void RequestResponseResponder::handleCancel() {
   switch (state_) {
     case State::RESPONDING:
       state_ = State::CLOSED;
+      if (auto subscription = std::move(producingSubscription_)) {
+        subscription->cancel();
+      }
       removeFromWriter();
       break;
     case State::NEW:
@@ -38,15 +38,12 @@ void StreamRequester::request(int64_t signedN) {
 
   // We must inform ConsumerBase about an implicit allowance we have requested
   // from the remote end.
-  auto const initial = std::min<uint32_t>(n, kMaxRequestN);
-  addImplicitAllowance(initial);
+  auto const initial = addInitialAllowance(n);
   newStream(StreamType::STREAM, initial, std::move(initialPayload_));
 
   // Pump the remaining allowance into the ConsumerBase _after_ sending the
   // initial request.
-  if (n > initial) {
-    generateRequest(n - initial);
-  }
+  sendRequests();
 }
 
 void StreamRequester::cancel() {
@@ -54,8 +51,11 @@ void StreamRequester::cancel() {
   if (consumerClosed()) {
     return;
   }
+  // The peer is done with a stream whose completion only waits for the
+  // application to take the prefetched payloads.
+  auto const peerCompleted = consumerDraining();
   cancelConsumer();
-  if (requested_) {
+  if (requested_ && !peerCompleted) {
     writeCancel();
   }
   removeFromWriter();
@@ -26,6 +26,7 @@ void StreamResponder::onNext(Payload response) {
     return;
   }
   writePayload(std::move(response));
+  publisherNext();
 }
 
 void StreamResponder::onComplete() {
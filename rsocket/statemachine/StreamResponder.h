@@ -47,6 +47,10 @@ class StreamResponder : public StreamStateMachineBase,
   void handleError(folly::exception_wrapper) override;
   void handleCancel() override;
 
+  void setPublisherPaused(bool paused) override {
+    PublisherBase::setPublisherPaused(paused);
+  }
+
   void endStream(StreamCompletionSignal) override;
 
  private:
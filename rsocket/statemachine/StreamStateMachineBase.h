@@ -54,6 +54,10 @@ class StreamStateMachineBase {
 
   virtual size_t getConsumerAllowance() const;
 
+  /// Stop or resume granting the peer's credit to the stream's local
+  /// publisher, if it has one.
+  virtual void setPublisherPaused(bool) {}
+
   /// Indicates a terminal signal from the connection.
   ///
   /// This signal corresponds to Subscriber::{onComplete,onError} and
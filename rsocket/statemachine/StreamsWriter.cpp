@@ -14,11 +14,56 @@
 
 #include "rsocket/statemachine/StreamsWriter.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "rsocket/RSocketStats.h"
 #include "rsocket/framing/FrameSerializer.h"
 
 namespace rsocket {
 
+constexpr size_t StreamsWriterImpl::kMaxFragmentSize;
+
+void StreamsWriterImpl::setMaxFragmentSize(size_t size) {
+  CHECK_GT(size, 0u);
+  maxFragmentSize_ = std::min(size, kMaxFragmentSize);
+}
+
+void StreamsWriterImpl::setStreamPriority(
+    StreamId streamId,
+    StreamPriority priority) {
+  priority.urgency = std::min(priority.urgency, StreamPriority::kLeastUrgent);
+  priority.weight = std::max<uint16_t>(priority.weight, 1);
+  if (priority.urgency == StreamPriority::kDefaultUrgency &&
+      priority.weight == 1) {
+    priorities_.erase(streamId);
+  } else {
+    priorities_[streamId] = priority;
+  }
+
+  auto it = streamQueues_.find(streamId);
+  if (it == streamQueues_.end()) {
+    return;
+  }
+  auto& queue = it->second;
+  if (queue.priority.urgency != priority.urgency) {
+    auto& ready = readyStreams_[queue.priority.urgency];
+    ready.erase(std::find(ready.begin(), ready.end(), streamId));
+    readyStreams_[priority.urgency].push_back(streamId);
+    queue.turnFrames = 0;
+  }
+  queue.priority = priority;
+}
+
+StreamPriority StreamsWriterImpl::getStreamPriority(StreamId streamId) const {
+  auto it = priorities_.find(streamId);
+  return it != priorities_.end() ? it->second : StreamPriority();
+}
+
+void StreamsWriterImpl::clearStreamPriority(StreamId streamId) {
+  priorities_.erase(streamId);
+}
+
 void StreamsWriterImpl::outputFrameOrEnqueue(
     std::unique_ptr<folly::IOBuf> frame) {
   if (shouldQueue()) {
@@ -29,17 +74,43 @@ void StreamsWriterImpl::outputFrameOrEnqueue(
 }
 
 void StreamsWriterImpl::sendPendingFrames() {
+  outputPendingFrames();
+}
+
+void StreamsWriterImpl::outputPendingFrames() {
   // We are free to try to send frames again.  Not all frames might be sent if
   // the connection breaks, the rest of them will queue up again.
   auto frames = consumePendingOutputFrames();
   for (auto& frame : frames) {
     outputFrameOrEnqueue(std::move(frame));
   }
+  if (pendingOutputFull_ && pendingOutputFrames_.empty()) {
+    pendingOutputFull_ = false;
+    onPendingOutputDrained();
+  }
+  if (hasQueuedFrames()) {
+    scheduleQueuedFrames();
+  }
 }
 
 void StreamsWriterImpl::enqueuePendingOutputFrame(
     std::unique_ptr<folly::IOBuf> frame) {
   auto const length = frame->computeChainDataLength();
+  if (isOverflowedStreamFrame(*frame)) {
+    stats().pendingFramesDropped(1, length);
+    return;
+  }
+  if (pendingSize_ > pendingOutputLimit_.maxBytes ||
+      length > pendingOutputLimit_.maxBytes - pendingSize_) {
+    if (!pendingOutputFull_) {
+      pendingOutputFull_ = true;
+      onPendingOutputFull();
+    }
+    if (!makeRoomForPendingFrame(*frame, length)) {
+      stats().pendingFramesDropped(1, length);
+      return;
+    }
+  }
   stats().streamBufferChanged(1, static_cast<int64_t>(length));
   pendingSize_ += length;
   pendingOutputFrames_.push_back(std::move(frame));
@@ -55,6 +126,101 @@ StreamsWriterImpl::consumePendingOutputFrames() {
   return std::move(pendingOutputFrames_);
 }
 
+bool StreamsWriterImpl::makeRoomForPendingFrame(
+    const folly::IOBuf& frame,
+    size_t length) {
+  switch (serializer().peekFrameType(frame)) {
+    case FrameType::REQUEST_RESPONSE:
+    case FrameType::REQUEST_FNF:
+    case FrameType::REQUEST_STREAM:
+    case FrameType::REQUEST_CHANNEL:
+    case FrameType::PAYLOAD:
+      break;
+    default:
+      return true;
+  }
+
+  switch (pendingOutputLimit_.policy) {
+    case PendingOutputPolicy::BLOCK:
+      return true;
+    case PendingOutputPolicy::FAIL_STREAMS: {
+      auto const streamId = serializer().peekStreamId(frame, false);
+      CHECK(streamId) << "Error in serialized frame.";
+      dropQueuedFrames(*streamId);
+      // The stream is still writing, fail it once it is done.
+      overflowedStreams_.push_back(*streamId);
+      if (overflowedStreams_.size() == 1) {
+        scheduleOverflowedStreams();
+      }
+      return false;
+    }
+    case PendingOutputPolicy::DROP_OLDEST_FNF:
+      while (pendingSize_ + length > pendingOutputLimit_.maxBytes &&
+             dropOldestPendingFireAndForget()) {
+      }
+      return true;
+  }
+  return true;
+}
+
+bool StreamsWriterImpl::isOverflowedStreamFrame(const folly::IOBuf& frame) {
+  if (overflowedStreams_.empty()) {
+    return false;
+  }
+  auto const streamId = serializer().peekStreamId(frame, false);
+  return streamId &&
+      std::find(
+          overflowedStreams_.begin(), overflowedStreams_.end(), *streamId) !=
+      overflowedStreams_.end();
+}
+
+void StreamsWriterImpl::scheduleOverflowedStreams() {
+  failOverflowedStreams();
+}
+
+void StreamsWriterImpl::failOverflowedStreams() {
+  auto const streams = std::move(overflowedStreams_);
+  overflowedStreams_.clear();
+  for (auto const streamId : streams) {
+    onPendingOutputOverflow(streamId);
+  }
+}
+
+bool StreamsWriterImpl::dropOldestPendingFireAndForget() {
+  auto it = std::find_if(
+      pendingOutputFrames_.begin(),
+      pendingOutputFrames_.end(),
+      [this](const std::unique_ptr<folly::IOBuf>& frame) {
+        return serializer().peekFrameType(*frame) == FrameType::REQUEST_FNF;
+      });
+  if (it == pendingOutputFrames_.end()) {
+    return false;
+  }
+  auto const streamId = serializer().peekStreamId(**it, false);
+  CHECK(streamId) << "Error in serialized frame.";
+  dropQueuedFrames(*streamId);
+
+  // The request's fragments can only follow it.
+  size_t frames = 0;
+  size_t bytes = 0;
+  auto const remaining = std::remove_if(
+      it, pendingOutputFrames_.end(), [&](std::unique_ptr<folly::IOBuf>& f) {
+        if (*serializer().peekStreamId(*f, false) != *streamId) {
+          return false;
+        }
+        ++frames;
+        bytes += f->computeChainDataLength();
+        return true;
+      });
+  pendingOutputFrames_.erase(remaining, pendingOutputFrames_.end());
+
+  pendingSize_ -= bytes;
+  stats().streamBufferChanged(
+      -static_cast<int64_t>(frames), -static_cast<int64_t>(bytes));
+  stats().pendingFramesDropped(frames, bytes);
+  return true;
+}
+
 void StreamsWriterImpl::writeNewStream(
     StreamId streamId,
     StreamType streamType,
@@ -65,24 +231,20 @@ void StreamsWriterImpl::writeNewStream(
       [&](Payload p, FrameFlags flags) {
         switch (streamType) {
           case StreamType::CHANNEL:
-            outputFrameOrEnqueue(
-                serializer().serializeOut(Frame_REQUEST_CHANNEL(
-                    streamId, flags, initialRequestN, std::move(p))));
-            break;
+            return serializer().serializeOut(Frame_REQUEST_CHANNEL(
+                streamId, flags, initialRequestN, std::move(p)));
           case StreamType::STREAM:
-            outputFrameOrEnqueue(serializer().serializeOut(Frame_REQUEST_STREAM(
-                streamId, flags, initialRequestN, std::move(p))));
-            break;
+            return serializer().serializeOut(Frame_REQUEST_STREAM(
+                streamId, flags, initialRequestN, std::move(p)));
           case StreamType::REQUEST_RESPONSE:
-            outputFrameOrEnqueue(serializer().serializeOut(
-                Frame_REQUEST_RESPONSE(streamId, flags, std::move(p))));
-            break;
+            return serializer().serializeOut(
+                Frame_REQUEST_RESPONSE(streamId, flags, std::move(p)));
           case StreamType::FNF:
-            outputFrameOrEnqueue(serializer().serializeOut(
-                Frame_REQUEST_FNF(streamId, flags, std::move(p))));
-            break;
+            return serializer().serializeOut(
+                Frame_REQUEST_FNF(streamId, flags, std::move(p)));
           default:
             CHECK(false) << "invalid stream type " << toString(streamType);
+            return std::unique_ptr<folly::IOBuf>();
         }
       },
       streamId,
@@ -91,11 +253,26 @@ void StreamsWriterImpl::writeNewStream(
 }
 
 void StreamsWriterImpl::writeRequestN(Frame_REQUEST_N&& frame) {
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
+  auto const streamId = frame.header_.streamId;
+  outputControlFrame(streamId, serializer().serializeOut(std::move(frame)));
 }
 
 void StreamsWriterImpl::writeCancel(Frame_CANCEL&& frame) {
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
+  auto const streamId = frame.header_.streamId;
+  auto it = streamQueues_.find(streamId);
+  if (it != streamQueues_.end()) {
+    switch (serializer().peekFrameType(*it->second.frames.front())) {
+      case FrameType::REQUEST_RESPONSE:
+      case FrameType::REQUEST_STREAM:
+        // The request itself is still queued, so the peer doesn't know about
+        // the stream and needs neither the request nor the CANCEL.
+        dropQueuedFrames(streamId);
+        return;
+      default:
+        break;
+    }
+  }
+  outputControlFrame(streamId, serializer().serializeOut(std::move(frame)));
 }
 
 void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
@@ -105,8 +282,8 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
 
   writeFragmented(
       [this, streamId](Payload p, FrameFlags flags) {
-        outputFrameOrEnqueue(serializer().serializeOut(
-            Frame_PAYLOAD(streamId, flags, std::move(p))));
+        return serializer().serializeOut(
+            Frame_PAYLOAD(streamId, flags, std::move(p)));
       },
       streamId,
       initialFlags,
@@ -115,36 +292,145 @@ void StreamsWriterImpl::writePayload(Frame_PAYLOAD&& f) {
 
 void StreamsWriterImpl::writeError(Frame_ERROR&& frame) {
   // TODO: implement fragmentation for writeError as well
-  outputFrameOrEnqueue(serializer().serializeOut(std::move(frame)));
-}
-
-// The max amount of user data transmitted per frame - eg the size
-// of the data and metadata combined, plus the size of the frame header.
-// This assumes that the frame header will never be more than 512 bytes in
-// size. A CHECK in FrameTransportImpl enforces this. The idea is that
-// 16M is so much larger than the ~500 bytes possibly wasted that it won't
-// be noticeable (0.003% wasted at most)
-constexpr size_t GENEROUS_MAX_FRAME_SIZE = 0xFFFFFF - 512;
-
-// writeFragmented takes a `payload` and splits it up into chunks which
-// are sent as fragmented requests. The first fragmented payload is
-// given to writeInitialFrame, which is expected to write the initial
-// "REQUEST_" or "PAYLOAD" frame of a stream or response. writeFragmented
-// then writes the rest of the frames as payloads.
+  auto const streamId = frame.header_.streamId;
+  outputStreamFrame(streamId, serializer().serializeOut(std::move(frame)));
+}
+
+void StreamsWriterImpl::scheduleQueuedFrames() {
+  writeQueuedFrames(std::numeric_limits<size_t>::max());
+}
+
+bool StreamsWriterImpl::writeQueuedFrames(size_t budget) {
+  size_t written = 0;
+  while (!streamQueues_.empty() && written < budget && !shouldQueue() &&
+         !isOutputCongested()) {
+    size_t urgency = 0;
+    while (readyStreams_[urgency].empty()) {
+      ++urgency;
+      DCHECK_LT(urgency, readyStreams_.size());
+    }
+    auto& ready = readyStreams_[urgency];
+    auto const streamId = ready.front();
+
+    auto it = streamQueues_.find(streamId);
+    DCHECK(it != streamQueues_.end());
+    auto& queue = it->second;
+    if (queue.turnFrames == 0) {
+      queue.turnFrames = queue.priority.weight;
+    }
+    auto frame = std::move(queue.frames.front());
+    queue.frames.pop_front();
+    --queue.turnFrames;
+
+    if (queue.frames.empty()) {
+      streamQueues_.erase(it);
+      ready.pop_front();
+    } else if (queue.turnFrames == 0) {
+      ready.pop_front();
+      ready.push_back(streamId);
+    }
+
+    written += frame->computeChainDataLength();
+    outputFrameOrEnqueue(std::move(frame));
+  }
+  return hasQueuedFrames();
+}
+
+void StreamsWriterImpl::dropQueuedFrames(StreamId streamId) {
+  auto it = streamQueues_.find(streamId);
+  if (it == streamQueues_.end()) {
+    return;
+  }
+  auto& ready = readyStreams_[it->second.priority.urgency];
+  ready.erase(std::find(ready.begin(), ready.end(), streamId));
+  streamQueues_.erase(it);
+}
+
+void StreamsWriterImpl::dropQueuedFrames() {
+  streamQueues_.clear();
+  for (auto& ready : readyStreams_) {
+    ready.clear();
+  }
+}
+
+void StreamsWriterImpl::outputStreamFrame(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  auto it = streamQueues_.find(streamId);
+  if (it != streamQueues_.end()) {
+    // Don't cut in front of the stream's own frames.
+    it->second.frames.push_back(std::move(frame));
+    return;
+  }
+  if (!isOutputCongested() &&
+      !hasQueuedFramesMoreUrgentThan(getStreamPriority(streamId).urgency)) {
+    outputFrameOrEnqueue(std::move(frame));
+    return;
+  }
+  queueStreamFrame(streamId, std::move(frame));
+  scheduleQueuedFrames();
+}
+
+void StreamsWriterImpl::outputControlFrame(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  auto it = streamQueues_.find(streamId);
+  if (it != streamQueues_.end()) {
+    // The peer must see the rest of a fragmented payload first.
+    it->second.frames.push_back(std::move(frame));
+    return;
+  }
+  // Control frames are small and don't wait behind other streams.
+  outputFrameOrEnqueue(std::move(frame));
+}
+
+void StreamsWriterImpl::queueStreamFrame(
+    StreamId streamId,
+    std::unique_ptr<folly::IOBuf> frame) {
+  auto& queue = streamQueues_[streamId];
+  if (queue.frames.empty()) {
+    queue.priority = getStreamPriority(streamId);
+    readyStreams_[queue.priority.urgency].push_back(streamId);
+  }
+  queue.frames.push_back(std::move(frame));
+}
+
+bool StreamsWriterImpl::hasQueuedFramesMoreUrgentThan(uint8_t urgency) const {
+  if (streamQueues_.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < urgency; ++i) {
+    if (!readyStreams_[i].empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// writeFragmented takes a `payload` and splits it up into chunks of at most
+// maxFragmentSize_ bytes which are sent as fragmented requests. The first
+// fragmented payload is given to serializeInitialFrame, which is expected to
+// serialize the initial "REQUEST_" or "PAYLOAD" frame of a stream or
+// response. writeFragmented then serializes the rest of the frames as
+// payloads.
+//
+// The first frame is written like any other frame of the stream, see
+// outputStreamFrame().  The rest are queued, to be written in turns with the
+// frames of other streams.
 //
-// writeInitialFrame
+// serializeInitialFrame
 //  - called with the payload of the first frame to send, and any additional
 //    flags (eg, addFlags with FOLLOWS, if there are more frames to write)
 // streamId
 //  - The stream ID to write additional fragments with
 // addFlags
-//  - All flags that writeInitialFrame wants to write the first frame with,
+//  - All flags that serializeInitialFrame wants to write the first frame with,
 //    and all flags that subsequent fragmented payloads will be sent with
 // payload
 //  - The unsplit payload to send, possibly in multiple fragments
-template <typename WriteInitialFrame>
+template <typename SerializeInitialFrame>
 void StreamsWriterImpl::writeFragmented(
-    WriteInitialFrame writeInitialFrame,
+    SerializeInitialFrame serializeInitialFrame,
     StreamId const streamId,
     FrameFlags const addFlags,
     Payload payload) {
@@ -166,12 +452,11 @@ void StreamsWriterImpl::writeFragmented(
     // chew off some metadata (splitAtMost will never return a null pointer,
     // safe to compute length on it always)
     if (haveNonNullMeta) {
-      sendme.metadata = metaQueue.splitAtMost(GENEROUS_MAX_FRAME_SIZE);
-      DCHECK_GE(
-          GENEROUS_MAX_FRAME_SIZE, sendme.metadata->computeChainDataLength());
+      sendme.metadata = metaQueue.splitAtMost(maxFragmentSize_);
+      DCHECK_GE(maxFragmentSize_, sendme.metadata->computeChainDataLength());
     }
     sendme.data = dataQueue.splitAtMost(
-        GENEROUS_MAX_FRAME_SIZE -
+        maxFragmentSize_ -
         (haveNonNullMeta ? sendme.metadata->computeChainDataLength() : 0));
 
     auto const metaLeft = metaQueue.chainLength();
@@ -182,16 +467,23 @@ void StreamsWriterImpl::writeFragmented(
 
     if (isFirstFrame) {
       isFirstFrame = false;
-      writeInitialFrame(std::move(sendme), flags);
+      outputStreamFrame(
+          streamId, serializeInitialFrame(std::move(sendme), flags));
     } else {
-      outputFrameOrEnqueue(serializer().serializeOut(
-          Frame_PAYLOAD(streamId, flags, std::move(sendme))));
+      queueStreamFrame(
+          streamId,
+          serializer().serializeOut(
+              Frame_PAYLOAD(streamId, flags, std::move(sendme))));
     }
 
     if (!moreFragments) {
       break;
     }
   }
+
+  if (hasQueuedFrames()) {
+    scheduleQueuedFrames();
+  }
 }
 
 } // namespace rsocket
@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <array>
 #include <deque>
+#include <unordered_map>
+#include <vector>
 
 #include <yarpl/Flowable.h>
 #include <yarpl/Single.h>
@@ -62,6 +65,42 @@ class StreamsWriter {
 
 class StreamsWriterImpl : public StreamsWriter {
  public:
+  /// The most payload data and metadata a single frame may carry.  This
+  /// assumes that the frame header will never be more than 512 bytes in size,
+  /// and leaves room for it below the 24-bit frame length limit.
+  static constexpr size_t kMaxFragmentSize = 0xFFFFFF - 512;
+
+  /// Payloads larger than this many bytes of data and metadata are split into
+  /// fragments.  Only the first fragment of a payload is written right away,
+  /// the rest are queued and written in turns with the frames of other
+  /// streams.  A small fragment size keeps bulk transfers from delaying small
+  /// requests on the same connection.  Values above kMaxFragmentSize are
+  /// clamped to it.
+  void setMaxFragmentSize(size_t);
+  size_t getMaxFragmentSize() const {
+    return maxFragmentSize_;
+  }
+
+  /// Set the priority of a stream's frames.  Frames the stream already has
+  /// queued move along with it.
+  void setStreamPriority(StreamId, StreamPriority);
+  StreamPriority getStreamPriority(StreamId) const;
+
+  /// Budget for the frames held while shouldQueue(), and what to do once it
+  /// is used up.  See PendingOutputLimit.
+  void setPendingOutputLimit(PendingOutputLimit limit) {
+    pendingOutputLimit_ = limit;
+  }
+  const PendingOutputLimit& getPendingOutputLimit() const {
+    return pendingOutputLimit_;
+  }
+
+  /// Whether the pending frames exceed their budget, between
+  /// onPendingOutputFull() and onPendingOutputDrained().
+  bool isPendingOutputFull() const {
+    return pendingOutputFull_;
+  }
+
   void writeNewStream(
       StreamId streamId,
       StreamType streamType,
@@ -83,25 +122,129 @@ class StreamsWriterImpl : public StreamsWriter {
   virtual RSocketStats& stats() = 0;
   virtual bool shouldQueue() = 0;
 
-  template <typename WriteInitialFrame>
+  template <typename SerializeInitialFrame>
   void writeFragmented(
-      WriteInitialFrame,
+      SerializeInitialFrame,
       StreamId const,
       FrameFlags const,
       Payload payload);
 
+  /// Forget the priority of a stream.  Frames it already has queued keep
+  /// theirs.
+  void clearStreamPriority(StreamId);
+
+  /// Arrange for writeQueuedFrames() to be called.  By default the queued
+  /// frames are written right away.
+  virtual void scheduleQueuedFrames();
+
+  /// Whether the output already holds enough data that stream frames should
+  /// wait, to be written in priority order.
+  virtual bool isOutputCongested() {
+    return false;
+  }
+
+  /// Write queued stream frames in priority order until `budget` bytes have
+  /// been written, the output is congested or should queue, or nothing is
+  /// left.  Returns whether frames are still queued.
+  bool writeQueuedFrames(size_t budget);
+
+  bool hasQueuedFrames() const {
+    return !streamQueues_.empty();
+  }
+
+  /// Drop the frames queued for a stream, e.g. when the peer cancels it.
+  void dropQueuedFrames(StreamId);
+
+  /// Drop all queued stream frames, when the connection closes.
+  void dropQueuedFrames();
+
   /// Send a frame to the output, or queue it if shouldQueue()
   virtual void sendPendingFrames();
   void outputFrameOrEnqueue(std::unique_ptr<folly::IOBuf>);
   void enqueuePendingOutputFrame(std::unique_ptr<folly::IOBuf> frame);
   std::deque<std::unique_ptr<folly::IOBuf>> consumePendingOutputFrames();
 
+  /// Try to send the pending frames and the queued stream frames again.
+  void outputPendingFrames();
+
+  /// Called once the pending frames exceed their budget, and once they have
+  /// been written after that.  Local publishers should not be granted more
+  /// of the peer's credit in between.
+  virtual void onPendingOutputFull() {}
+  virtual void onPendingOutputDrained() {}
+
+  /// Called with the policy FAIL_STREAMS, when a frame of the stream didn't
+  /// fit in the budget and has been dropped.  Called from
+  /// failOverflowedStreams(), never from within the write that overflowed.
+  virtual void onPendingOutputOverflow(StreamId) {}
+
+  /// Arrange for failOverflowedStreams() to be called, once the write that
+  /// overflowed has returned.  By default the streams are failed right away.
+  virtual void scheduleOverflowedStreams();
+
+  /// Call onPendingOutputOverflow() for the streams whose frames were dropped.
+  /// Until then, any other frame they write is dropped too.
+  void failOverflowedStreams();
+
  private:
+  /// Frames of a stream waiting for its turn.
+  struct StreamQueue {
+    StreamPriority priority;
+    std::deque<std::unique_ptr<folly::IOBuf>> frames;
+    /// Frames the stream may still write in its current turn.
+    uint16_t turnFrames{0};
+  };
+
+  /// Write a frame of a stream, or queue it if the stream already has frames
+  /// queued, the output is congested, or more urgent streams are waiting.
+  void outputStreamFrame(StreamId, std::unique_ptr<folly::IOBuf>);
+  /// Write a REQUEST_N or CANCEL frame of a stream.  It goes ahead of other
+  /// streams' frames, but queues behind the stream's own.
+  void outputControlFrame(StreamId, std::unique_ptr<folly::IOBuf>);
+  void queueStreamFrame(StreamId, std::unique_ptr<folly::IOBuf>);
+  /// Whether streams of a class more urgent than `urgency` have frames queued.
+  bool hasQueuedFramesMoreUrgentThan(uint8_t urgency) const;
+
+  /// Apply the pending output policy to a frame that doesn't fit in the
+  /// budget.  Returns whether the frame should still be held.
+  bool makeRoomForPendingFrame(const folly::IOBuf& frame, size_t length);
+
+  /// Drop the oldest pending REQUEST_FNF frame along with its fragments.
+  /// Returns false if there is none.
+  bool dropOldestPendingFireAndForget();
+
+  /// Whether the frame belongs to a stream awaiting failOverflowedStreams().
+  bool isOverflowedStreamFrame(const folly::IOBuf& frame);
+
   /// A queue of frames that are slated to be sent out.
   std::deque<std::unique_ptr<folly::IOBuf>> pendingOutputFrames_;
 
   /// The byte size of all pending output frames.
   size_t pendingSize_{0};
+
+  PendingOutputLimit pendingOutputLimit_;
+
+  /// Streams that overflowed the pending output budget, to be failed.
+  std::vector<StreamId> overflowedStreams_;
+
+  /// Whether the pending output frames have exceeded their budget since they
+  /// were last written.
+  bool pendingOutputFull_{false};
+
+  size_t maxFragmentSize_{kMaxFragmentSize};
+
+  /// Priorities of streams which don't use the default one.
+  std::unordered_map<StreamId, StreamPriority> priorities_;
+
+  /// Serialized frames of streams which have to wait for their turn.  Any
+  /// frame a stream writes while it has queued frames goes to the back of its
+  /// queue, to keep the stream's frames in order.
+  std::unordered_map<StreamId, StreamQueue> streamQueues_;
+
+  /// Streams with queued frames per urgency class, in the order they get
+  /// their next turn.
+  std::array<std::deque<StreamId>, StreamPriority::kLeastUrgent + 1>
+      readyStreams_;
 };
 
 } // namespace rsocket
@@ -0,0 +1,148 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include "RSocketTests.h"
+#include "rsocket/HedgingRequester.h"
+#include "rsocket/test/test_utils/GenericRequestResponseHandler.h"
+#include "yarpl/Single.h"
+#include "yarpl/single/SingleTestObserver.h"
+
+using namespace yarpl::single;
+using namespace rsocket;
+using namespace rsocket::tests;
+using namespace rsocket::tests::client_server;
+
+namespace {
+
+/// Never responds, and posts `onCancel` once the request is cancelled.
+class StuckHandler : public rsocket::RSocketResponder {
+ public:
+  explicit StuckHandler(std::shared_ptr<folly::Baton<>> onCancel)
+      : onCancel_(std::move(onCancel)) {}
+
+  std::shared_ptr<Single<Payload>> handleRequestResponse(Payload, StreamId)
+      override {
+    return Single<Payload>::create([onCancel = onCancel_](auto subscriber) {
+      subscriber->onSubscribe(
+          SingleSubscriptions::create([onCancel] { onCancel->post(); }));
+    });
+  }
+
+ private:
+  std::shared_ptr<folly::Baton<>> onCancel_;
+};
+
+std::shared_ptr<RSocketResponder> helloHandler() {
+  return std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const& request) {
+        return payload_response("Hello, " + request.first + "!", "");
+      });
+}
+
+std::shared_ptr<SingleTestObserver<std::string>> send(
+    HedgingRequester& requester,
+    std::string name) {
+  auto to = SingleTestObserver<std::string>::create();
+  requester.requestResponse(Payload(std::move(name)))
+      ->map([](auto p) { return p.moveDataToString(); })
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  return to;
+}
+
+} // namespace
+
+TEST(HedgingRequesterTest, HedgesAroundSlowServer) {
+  folly::ScopedEventBaseThread worker;
+  auto onCancel = std::make_shared<folly::Baton<>>();
+  auto slowServer = makeServer(std::make_shared<StuckHandler>(onCancel));
+  auto fastServer = makeServer(helloHandler());
+
+  HedgingRequester::Options options;
+  options.initialHedgeDelay = std::chrono::milliseconds(20);
+  HedgingRequester requester(
+      {makeClient(worker.getEventBase(), *slowServer->listeningPort()),
+       makeClient(worker.getEventBase(), *fastServer->listeningPort())},
+      *worker.getEventBase(),
+      options);
+
+  send(requester, "Jane")->assertOnSuccessValue("Hello, Jane!");
+
+  // The copy stuck on the slow server was cancelled.
+  EXPECT_TRUE(onCancel->try_wait_for(std::chrono::seconds(5)));
+  auto const counters = requester.counters();
+  EXPECT_EQ(1u, counters.requests);
+  EXPECT_EQ(1u, counters.hedges);
+  EXPECT_EQ(1u, counters.hedgeWins);
+  EXPECT_EQ(0u, counters.retries);
+}
+
+TEST(HedgingRequesterTest, RetriesThroughNextClient) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(helloHandler());
+
+  HedgingRequester::Options options;
+  options.maxHedges = 0;
+  HedgingRequester requester(
+      {makeDisconnectedClient(worker.getEventBase()),
+       makeClient(worker.getEventBase(), *server->listeningPort())},
+      *worker.getEventBase(),
+      options);
+
+  send(requester, "Jane")->assertOnSuccessValue("Hello, Jane!");
+  EXPECT_EQ(1u, requester.counters().retries);
+}
+
+TEST(HedgingRequesterTest, RetriesAreBudgeted) {
+  folly::ScopedEventBaseThread worker;
+
+  HedgingRequester::Options options;
+  options.maxHedges = 0;
+  options.maxRetries = 5;
+  options.budgetRatio = 0;
+  options.maxBudget = 2;
+  HedgingRequester requester(
+      {makeDisconnectedClient(worker.getEventBase())},
+      *worker.getEventBase(),
+      options);
+
+  EXPECT_TRUE(send(requester, "Jane")->getError());
+  EXPECT_TRUE(send(requester, "Joe")->getError());
+  EXPECT_EQ(2u, requester.counters().retries);
+}
+
+TEST(HedgingRequesterTest, DoesNotRetryApplicationErrors) {
+  folly::ScopedEventBaseThread worker;
+  auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const&) {
+        return error_response(std::runtime_error("whew!"));
+      }));
+
+  HedgingRequester::Options options;
+  options.maxHedges = 0;
+  HedgingRequester requester(
+      {makeClient(worker.getEventBase(), *server->listeningPort())},
+      *worker.getEventBase(),
+      options);
+
+  auto to = send(requester, "Jane");
+  EXPECT_TRUE(to->getException().with_exception([](ErrorWithPayload& err) {
+    EXPECT_STREQ("whew!", err.payload.moveDataToString().c_str());
+  }));
+  EXPECT_EQ(0u, requester.counters().retries);
+}
@@ -0,0 +1,121 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include "RSocketTests.h"
+#include "rsocket/LeaseSender.h"
+#include "rsocket/test/test_utils/GenericRequestResponseHandler.h"
+#include "yarpl/Single.h"
+#include "yarpl/single/SingleTestObserver.h"
+
+using namespace yarpl::single;
+using namespace rsocket;
+using namespace rsocket::tests;
+using namespace rsocket::tests::client_server;
+
+namespace {
+
+class LeaseServiceHandler : public RSocketServiceHandler {
+ public:
+  LeaseServiceHandler(
+      std::shared_ptr<RSocketResponder> responder,
+      std::shared_ptr<LeaseSender> leaseSender)
+      : responder_(std::move(responder)),
+        leaseSender_(std::move(leaseSender)) {}
+
+  folly::Expected<RSocketConnectionParams, RSocketException> onNewSetup(
+      const SetupParameters&) override {
+    RSocketConnectionParams params(responder_);
+    params.leaseSender = leaseSender_;
+    return params;
+  }
+
+ private:
+  std::shared_ptr<RSocketResponder> responder_;
+  std::shared_ptr<LeaseSender> leaseSender_;
+};
+
+class LeaseStats : public RSocketStats {
+ public:
+  void leaseReceived(uint32_t numberOfRequests) override {
+    received = numberOfRequests;
+    leaseBaton.post();
+  }
+
+  void requestRejectedWithoutLease() override {
+    ++rejected;
+  }
+
+  folly::Baton<> leaseBaton;
+  std::atomic<uint32_t> received{0};
+  std::atomic<int> rejected{0};
+};
+
+std::shared_ptr<RSocketResponder> makeHelloResponder() {
+  return std::make_shared<GenericRequestResponseHandler>(
+      [](StringPair const& request) {
+        return payload_response("Hello, " + request.first + "!", ":)");
+      });
+}
+
+} // namespace
+
+TEST(LeaseTest, RequestsBeyondLeaseAreRejected) {
+  folly::ScopedEventBaseThread worker;
+
+  LoadBasedLeaseSender::Options leaseOptions;
+  leaseOptions.maxConcurrentStreams = 2;
+  leaseOptions.ttl = std::chrono::minutes(1);
+  leaseOptions.renewalInterval = std::chrono::minutes(1);
+  auto server = makeResumableServer(std::make_shared<LeaseServiceHandler>(
+      makeHelloResponder(),
+      std::make_shared<LoadBasedLeaseSender>(leaseOptions)));
+
+  SetupParameters setupParameters;
+  setupParameters.lease = true;
+  auto stats = std::make_shared<LeaseStats>();
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(
+                        worker.getEventBase(), *server->listeningPort()),
+                    std::move(setupParameters),
+                    std::make_shared<RSocketResponder>(),
+                    kDefaultKeepaliveInterval,
+                    stats)
+                    .get();
+
+  ASSERT_TRUE(stats->leaseBaton.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ(2u, stats->received);
+
+  auto requester = client->getRequester();
+  for (int i = 0; i < 2; ++i) {
+    auto to = SingleTestObserver<StringPair>::create();
+    requester->requestResponse(Payload("Jane"))
+        ->map(payload_to_stringpair)
+        ->subscribe(to);
+    to->awaitTerminalEvent();
+    to->assertOnSuccessValue({"Hello, Jane!", ":)"});
+  }
+
+  auto to = SingleTestObserver<StringPair>::create();
+  requester->requestResponse(Payload("Jane"))
+      ->map(payload_to_stringpair)
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  to->assertOnErrorMessage("No lease available for the request");
+  EXPECT_EQ(1, stats->rejected);
+}
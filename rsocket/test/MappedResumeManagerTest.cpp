@@ -0,0 +1,275 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/IOBuf.h>
+#include <gmock/gmock.h>
+
+#include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameSerializer.h"
+#include "rsocket/framing/FrameTransportImpl.h"
+#include "rsocket/internal/MappedResumeManager.h"
+#include "rsocket/test/test_utils/MockDuplexConnection.h"
+
+using namespace ::testing;
+using namespace ::rsocket;
+
+namespace {
+
+class FrameTransportMock : public FrameTransportImpl {
+ public:
+  FrameTransportMock()
+      : FrameTransportImpl(std::make_unique<MockDuplexConnection>()) {}
+
+  MOCK_METHOD1(outputFrameOrDrop_, void(std::unique_ptr<folly::IOBuf>&));
+
+  void outputFrameOrDrop(std::unique_ptr<folly::IOBuf> frame) override {
+    outputFrameOrDrop_(frame);
+  }
+};
+
+} // namespace
+
+class MappedResumeManagerTest : public Test {
+ protected:
+  std::string path() const {
+    return (dir_.path() / "resume").string();
+  }
+
+  folly::test::TemporaryDirectory dir_;
+  std::unique_ptr<FrameSerializer> frameSerializer_{
+      FrameSerializer::createFrameSerializer(ProtocolVersion(1, 0))};
+};
+
+TEST_F(MappedResumeManagerTest, TwoFrames) {
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  FrameTransportMock transport;
+
+  auto frame1 = frameSerializer_->serializeOut(Frame_CANCEL(0));
+  const auto frame1Size = frame1->computeChainDataLength();
+
+  auto frame2 = frameSerializer_->serializeOut(Frame_REQUEST_N(0, 2));
+  const auto frame2Size = frame2->computeChainDataLength();
+
+  EXPECT_TRUE(cache.isPositionAvailable(0));
+  EXPECT_FALSE(cache.isPositionAvailable(1));
+
+  cache.trackSentFrame(*frame1, FrameType::CANCEL, 1, 0);
+  cache.trackSentFrame(*frame2, FrameType::REQUEST_N, 1, 0);
+
+  EXPECT_EQ(0, cache.firstSentPosition());
+  EXPECT_EQ(
+      (ResumePosition)(frame1Size + frame2Size), cache.lastSentPosition());
+  EXPECT_TRUE(cache.isPositionAvailable(0));
+  EXPECT_TRUE(cache.isPositionAvailable(frame1Size));
+  EXPECT_TRUE(cache.isPositionAvailable(frame1Size + frame2Size));
+  EXPECT_FALSE(cache.isPositionAvailable(frame1Size - 1)); // misaligned
+
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .WillOnce(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_TRUE(folly::IOBufEqualTo()(*frame1, *buf));
+      }))
+      .WillOnce(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_TRUE(folly::IOBufEqualTo()(*frame2, *buf));
+      }));
+
+  cache.sendFramesFromPosition(0, transport);
+
+  cache.resetUpToPosition(frame1Size);
+
+  EXPECT_EQ((ResumePosition)frame1Size, cache.firstSentPosition());
+  EXPECT_FALSE(cache.isPositionAvailable(0));
+  EXPECT_TRUE(cache.isPositionAvailable(frame1Size));
+  EXPECT_EQ(frame2Size, cache.size());
+}
+
+TEST_F(MappedResumeManagerTest, SurvivesReopen) {
+  auto frame1 = frameSerializer_->serializeOut(Frame_CANCEL(1));
+  const auto frame1Size = frame1->computeChainDataLength();
+  auto frame2 = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 7));
+  const auto frame2Size = frame2->computeChainDataLength();
+
+  {
+    MappedResumeManager cache(RSocketStats::noop(), path());
+    cache.onStreamOpen(
+        1, RequestOriginator::LOCAL, "token", StreamType::STREAM);
+    cache.trackSentFrame(*frame1, FrameType::CANCEL, 1, 0);
+    cache.trackSentFrame(*frame2, FrameType::REQUEST_N, 1, 7);
+    cache.trackReceivedFrame(42, FrameType::PAYLOAD, 1, 6);
+    cache.resetUpToPosition(frame1Size);
+  }
+
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  FrameTransportMock transport;
+
+  EXPECT_EQ((ResumePosition)frame1Size, cache.firstSentPosition());
+  EXPECT_EQ(
+      (ResumePosition)(frame1Size + frame2Size), cache.lastSentPosition());
+  EXPECT_EQ(42, cache.impliedPosition());
+  EXPECT_EQ(1u, cache.getLargestUsedStreamId());
+
+  const auto& infos = cache.getStreamResumeInfos();
+  ASSERT_EQ(1u, infos.size());
+  EXPECT_EQ("token", infos.at(1).streamToken);
+  EXPECT_EQ(StreamType::STREAM, infos.at(1).streamType);
+  EXPECT_EQ(6u, infos.at(1).consumerAllowance);
+
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .WillOnce(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_TRUE(folly::IOBufEqualTo()(*frame2, *buf));
+      }));
+  cache.sendFramesFromPosition(frame1Size, transport);
+}
+
+TEST_F(MappedResumeManagerTest, StreamTableSurvivesCrash) {
+  auto frame = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 5));
+  const auto frameSize = frame->computeChainDataLength();
+
+  // Die without running any destructor.
+  EXPECT_EXIT(
+      {
+        auto cache = new MappedResumeManager(RSocketStats::noop(), path());
+        cache->onStreamOpen(
+            1, RequestOriginator::LOCAL, "one", StreamType::STREAM);
+        cache->onStreamOpen(
+            3, RequestOriginator::LOCAL, "three", StreamType::CHANNEL);
+        cache->trackSentFrame(*frame, FrameType::REQUEST_N, 1, 5);
+        cache->onStreamClosed(3);
+        std::_Exit(0);
+      },
+      ExitedWithCode(0),
+      "");
+
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  EXPECT_EQ((ResumePosition)frameSize, cache.lastSentPosition());
+  const auto& infos = cache.getStreamResumeInfos();
+  ASSERT_EQ(1u, infos.size());
+  EXPECT_EQ("one", infos.at(1).streamToken);
+  EXPECT_EQ(5u, infos.at(1).consumerAllowance);
+}
+
+TEST_F(MappedResumeManagerTest, StreamJournalIsCompacted) {
+  {
+    MappedResumeManager cache(RSocketStats::noop(), path());
+    for (StreamId id = 1; id <= 5; id += 2) {
+      cache.onStreamOpen(
+          id, RequestOriginator::REMOTE, "long-lived", StreamType::STREAM);
+    }
+    // Far more churn than a journal half holds.
+    for (StreamId id = 7; id < 100000; id += 2) {
+      cache.onStreamOpen(
+          id, RequestOriginator::LOCAL, "short", StreamType::STREAM);
+      cache.trackReceivedFrame(10, FrameType::PAYLOAD, id, 1);
+      cache.onStreamClosed(id);
+    }
+    cache.trackReceivedFrame(10, FrameType::PAYLOAD, 3, 9);
+  }
+
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  const auto& infos = cache.getStreamResumeInfos();
+  ASSERT_EQ(3u, infos.size());
+  EXPECT_EQ("long-lived", infos.at(5).streamToken);
+  EXPECT_EQ(9u, infos.at(3).consumerAllowance);
+  EXPECT_EQ(99999u, cache.getLargestUsedStreamId());
+}
+
+TEST_F(MappedResumeManagerTest, ResetInsideFrameKeepsIt) {
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  auto frame1 = frameSerializer_->serializeOut(Frame_CANCEL(1));
+  const auto frame1Size = frame1->computeChainDataLength();
+  auto frame2 = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 2));
+  const auto frame2Size = frame2->computeChainDataLength();
+  cache.trackSentFrame(*frame1, FrameType::CANCEL, 1, 0);
+  cache.trackSentFrame(*frame2, FrameType::REQUEST_N, 1, 0);
+
+  cache.resetUpToPosition(frame1Size - 1);
+  EXPECT_EQ(0, cache.firstSentPosition());
+  EXPECT_EQ(frame1Size + frame2Size, cache.size());
+
+  cache.resetUpToPosition(frame1Size + 1);
+  EXPECT_EQ((ResumePosition)frame1Size, cache.firstSentPosition());
+  EXPECT_TRUE(cache.isPositionAvailable(frame1Size));
+  EXPECT_EQ(frame2Size, cache.size());
+}
+
+TEST_F(MappedResumeManagerTest, EvictAndWrapAround) {
+  auto frame = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 3));
+  const auto frameSize = frame->computeChainDataLength();
+
+  // Room for two and a half records, so every other record wraps.
+  const size_t capacity = (frameSize + 12) * 5 / 2;
+  MappedResumeManager cache(RSocketStats::noop(), path(), capacity);
+  FrameTransportMock transport;
+
+  for (size_t i = 0; i < 10; ++i) {
+    cache.trackSentFrame(*frame, FrameType::REQUEST_N, 1, 0);
+    EXPECT_LE(cache.size(), 2 * frameSize);
+    EXPECT_TRUE(cache.isPositionAvailable((i + 1) * frameSize));
+    EXPECT_TRUE(cache.isPositionAvailable(i * frameSize));
+    if (i >= 2) {
+      EXPECT_FALSE(cache.isPositionAvailable((i - 2) * frameSize));
+    }
+  }
+
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        EXPECT_TRUE(folly::IOBufEqualTo()(*frame, *buf));
+      }));
+  cache.sendFramesFromPosition(8 * frameSize, transport);
+}
+
+TEST_F(MappedResumeManagerTest, OutstandingBuffersAreNotOverwritten) {
+  auto frame = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 3));
+  const auto frameSize = frame->computeChainDataLength();
+
+  const size_t capacity = (frameSize + 12) * 2;
+  MappedResumeManager cache(RSocketStats::noop(), path(), capacity);
+  FrameTransportMock transport;
+
+  cache.trackSentFrame(*frame, FrameType::REQUEST_N, 1, 0);
+  cache.trackSentFrame(*frame, FrameType::REQUEST_N, 1, 0);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> sent;
+  EXPECT_CALL(transport, outputFrameOrDrop_(_))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](std::unique_ptr<folly::IOBuf>& buf) {
+        sent.push_back(std::move(buf));
+      }));
+  cache.sendFramesFromPosition(0, transport);
+
+  // The ring is full and its pages are still referenced, so the next frame
+  // can't be cached.
+  auto other = frameSerializer_->serializeOut(Frame_REQUEST_N(1, 9));
+  cache.trackSentFrame(*other, FrameType::REQUEST_N, 1, 0);
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ((ResumePosition)(3 * frameSize), cache.firstSentPosition());
+  for (const auto& buf : sent) {
+    EXPECT_TRUE(folly::IOBufEqualTo()(*frame, *buf));
+  }
+
+  // Once the buffers are released the ring is reusable.
+  sent.clear();
+  cache.trackSentFrame(*other, FrameType::REQUEST_N, 1, 0);
+  EXPECT_EQ(frameSize, cache.size());
+  EXPECT_TRUE(cache.isPositionAvailable(3 * frameSize));
+}
+
+TEST_F(MappedResumeManagerTest, RejectsSecondOpener) {
+  MappedResumeManager cache(RSocketStats::noop(), path());
+  EXPECT_THROW(
+      MappedResumeManager(RSocketStats::noop(), path()), std::system_error);
+}
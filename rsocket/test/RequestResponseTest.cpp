@@ -18,7 +18,10 @@
 #include <thread>
 
 #include "RSocketTests.h"
+#include "rsocket/RSocketException.h"
+#include "rsocket/internal/DeadlineMetadata.h"
 #include "rsocket/test/test_utils/GenericRequestResponseHandler.h"
+#include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "yarpl/Single.h"
 #include "yarpl/single/SingleTestObserver.h"
 
@@ -74,6 +77,33 @@ class TestHandlerCancel : public rsocket::RSocketResponder {
   std::shared_ptr<folly::Baton<>> onCancel_;
   std::shared_ptr<folly::Baton<>> onSubscribe_;
 };
+
+/// Never responds, and posts `onCancel` once the request is cancelled.
+class TestHandlerDeadline : public rsocket::RSocketResponder {
+ public:
+  explicit TestHandlerDeadline(std::shared_ptr<folly::Baton<>> onCancel)
+      : onCancel_(std::move(onCancel)) {}
+
+  std::shared_ptr<Single<Payload>> handleRequestResponseWithDeadline(
+      Payload request,
+      StreamId,
+      std::chrono::steady_clock::time_point deadline) override {
+    metadata_ = request.moveMetadataToString();
+    timeLeft_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    return Single<Payload>::create([onCancel = onCancel_](auto subscriber) {
+      subscriber->onSubscribe(
+          SingleSubscriptions::create([onCancel] { onCancel->post(); }));
+    });
+  }
+
+  // Only read once the request was cancelled.
+  std::string metadata_;
+  std::chrono::milliseconds timeLeft_{0};
+
+ private:
+  std::shared_ptr<folly::Baton<>> onCancel_;
+};
 } // namespace
 
 TEST(RequestResponseTest, Cancel) {
@@ -100,6 +130,40 @@ TEST(RequestResponseTest, Cancel) {
   to->assertNoTerminalEvent();
 }
 
+TEST(RequestResponseTest, Deadline) {
+  folly::ScopedEventBaseThread worker;
+  auto onCancel = std::make_shared<folly::Baton<>>();
+  auto handler = std::make_shared<TestHandlerDeadline>(onCancel);
+  auto server = makeServer(handler);
+  // The responder is only told deadlines on connections with composite
+  // metadata.
+  SetupParameters setupParameters(kCompositeMetadataMimeType.str());
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(
+                        worker.getEventBase(), *server->listeningPort()),
+                    std::move(setupParameters))
+                    .get();
+  auto requester = client->getRequester();
+
+  auto to = SingleTestObserver<std::string>::create();
+  requester
+      ->requestResponseWithDeadline(
+          Payload("Jane", "Doe"),
+          StreamPriority(),
+          std::chrono::milliseconds(200))
+      ->map([](auto p) { return p.moveDataToString(); })
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  EXPECT_TRUE(to->getException().with_exception(
+      [](DeadlineExceededException&) {}));
+
+  // The responder's work is cancelled too.
+  ASSERT_TRUE(onCancel->try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ("Doe", handler->metadata_);
+  EXPECT_GT(handler->timeLeft_.count(), 0);
+  EXPECT_LE(handler->timeLeft_.count(), 200);
+}
+
 // response creation usage
 TEST(RequestResponseTest, CanCtorTypes) {
   Response r1 = payload_response("foo", "bar");
@@ -277,6 +341,62 @@ TEST(RequestResponseTest, TestLargePayload) {
       {100, 10 * 1024 * 1024, 100}, {100, 10 * 1024 * 1024, 100});
 }
 
+TEST(RequestResponseTest, LargePayloadInSmallFragments) {
+  static constexpr size_t kFragmentSize = 64 * 1024;
+
+  struct ServiceHandler : public RSocketServiceHandler {
+    explicit ServiceHandler(std::shared_ptr<RSocketResponder> responder)
+        : responder_(std::move(responder)) {}
+
+    folly::Expected<RSocketConnectionParams, RSocketException> onNewSetup(
+        const SetupParameters&) override {
+      RSocketConnectionParams params(responder_);
+      params.maxFragmentSize = kFragmentSize;
+      return params;
+    }
+
+    std::shared_ptr<RSocketResponder> responder_;
+  };
+
+  std::string niceLongData = RSocketPayloadUtils::makeLongString(
+      RSocketPayloadUtils::LargeRequestSize, "ABCDEFGH");
+  std::string niceLongMeta = RSocketPayloadUtils::makeLongString(
+      RSocketPayloadUtils::LargeRequestSize, "12345678");
+
+  TcpConnectionAcceptor::Options opts;
+  opts.address = folly::SocketAddress("0.0.0.0", 0);
+  auto server = RSocket::createServer(
+      std::make_unique<TcpConnectionAcceptor>(std::move(opts)));
+  server->start(std::make_shared<ServiceHandler>(
+      std::make_shared<LargePayloadReqRespHandler>(
+          niceLongData, niceLongMeta)));
+
+  folly::ScopedEventBaseThread worker;
+  SetupParameters setupParams;
+  setupParams.maxFragmentSize = kFragmentSize;
+  auto client = RSocket::createConnectedClient(
+                    getConnFactory(
+                        worker.getEventBase(), *server->listeningPort()),
+                    std::move(setupParams))
+                    .get();
+
+  auto to = SingleTestObserver<int>::create();
+  client->getRequester()
+      ->requestResponse(Payload(
+          folly::IOBuf::copyBuffer(niceLongData),
+          folly::IOBuf::copyBuffer(niceLongMeta)))
+      ->map([&](Payload p) {
+        RSocketPayloadUtils::checkSameStrings(
+            p.data, niceLongData, "data (received on client)");
+        RSocketPayloadUtils::checkSameStrings(
+            p.metadata, niceLongMeta, "metadata (received on client)");
+        return 0;
+      })
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  to->assertSuccess();
+}
+
 TEST(RequestResponseTest, MultiSubscribe) {
   folly::ScopedEventBaseThread worker;
   auto server = makeServer(std::make_shared<GenericRequestResponseHandler>(
@@ -18,6 +18,7 @@
 #include <gmock/gmock.h>
 
 #include "rsocket/framing/Frame.h"
+#include "rsocket/framing/FrameParser_v1_0.h"
 #include "rsocket/framing/FrameSerializer.h"
 
 using namespace ::rsocket;
@@ -302,3 +303,147 @@ TEST(FrameTest, Frame_PreallocatedFrameLengthField) {
 
   EXPECT_LT(0, serializedFrame->headroom());
 }
+
+TEST(FrameTest, Frame_PAYLOAD_SmallPayloadIsOneBuffer) {
+  auto metadata = folly::IOBuf::copyBuffer("meta");
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  frameSerializer->preallocateFrameSizeField() = true;
+
+  auto serializedFrame = frameSerializer->serializeOut(Frame_PAYLOAD(
+      42,
+      FrameFlags::METADATA,
+      Payload(data->clone(), metadata->clone())));
+
+  EXPECT_FALSE(serializedFrame->isChained());
+  EXPECT_LE(
+      frameSerializer->frameLengthFieldSize(), serializedFrame->headroom());
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *frame.payload_.metadata));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *frame.payload_.data));
+}
+
+TEST(FrameTest, Frame_PAYLOAD_LargePayloadUsesHeadroom) {
+  const std::string content(4096, 'x');
+  auto data = folly::IOBuf::copyBuffer(content, /* headroom */ 64);
+  const auto dataPtr = data->data();
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  auto serializedFrame = frameSerializer->serializeOut(
+      Frame_PAYLOAD(42, FrameFlags::EMPTY_, Payload(std::move(data))));
+
+  // The header went in front of the payload bytes, in the same buffer.
+  EXPECT_FALSE(serializedFrame->isChained());
+  EXPECT_EQ(dataPtr - 6, serializedFrame->data());
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(
+      frameSerializer->deserializeFrom(frame, std::move(serializedFrame)));
+  EXPECT_EQ(content, frame.payload_.data->moveToFbString().toStdString());
+}
+
+TEST(FrameTest, FrameParser_PAYLOAD) {
+  auto metadata = folly::IOBuf::copyBuffer("i'm so meta even this acronym");
+  auto data = folly::IOBuf::copyBuffer("424242");
+  auto flags = FrameFlags::METADATA | FrameFlags::NEXT;
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto serializedFrame = frameSerializer->serializeOut(
+      Frame_PAYLOAD(42, flags, Payload(data->clone(), metadata->clone())));
+  ASSERT_FALSE(serializedFrame->isChained());
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(deserializeHotFrame(
+      frame, std::move(serializedFrame), *frameSerializer));
+  expectHeader(FrameType::PAYLOAD, flags, 42, frame);
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *frame.payload_.metadata));
+  EXPECT_TRUE(folly::IOBufEqualTo()(*data, *frame.payload_.data));
+}
+
+TEST(FrameTest, FrameParser_REQUEST_RESPONSE_EmptyData) {
+  auto metadata = folly::IOBuf::copyBuffer("meta");
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto serializedFrame = frameSerializer->serializeOut(Frame_REQUEST_RESPONSE(
+      7, FrameFlags::METADATA, Payload(nullptr, metadata->clone())));
+
+  Frame_REQUEST_RESPONSE frame;
+  EXPECT_TRUE(deserializeHotFrame(
+      frame, std::move(serializedFrame), *frameSerializer));
+  expectHeader(FrameType::REQUEST_RESPONSE, FrameFlags::METADATA, 7, frame);
+  EXPECT_TRUE(folly::IOBufEqualTo()(*metadata, *frame.payload_.metadata));
+  EXPECT_EQ(nullptr, frame.payload_.data);
+}
+
+TEST(FrameTest, FrameParser_REQUEST_N_And_CANCEL) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  Frame_REQUEST_N requestN;
+  EXPECT_TRUE(deserializeHotFrame(
+      requestN,
+      frameSerializer->serializeOut(Frame_REQUEST_N(42, 24)),
+      *frameSerializer));
+  expectHeader(FrameType::REQUEST_N, FrameFlags::EMPTY_, 42, requestN);
+  EXPECT_EQ(24u, requestN.requestN_);
+
+  Frame_CANCEL cancel;
+  EXPECT_TRUE(deserializeHotFrame(
+      cancel,
+      frameSerializer->serializeOut(Frame_CANCEL(42)),
+      *frameSerializer));
+  expectHeader(FrameType::CANCEL, FrameFlags::EMPTY_, 42, cancel);
+}
+
+TEST(FrameTest, FrameParser_ChainedFallsBack) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+  auto serializedFrame = frameSerializer->serializeOut(
+      Frame_PAYLOAD(42, FrameFlags::NEXT, Payload("424242")));
+
+  // Split the header across two buffers.
+  auto tail = serializedFrame->cloneOne();
+  serializedFrame->trimEnd(serializedFrame->length() - 3);
+  tail->trimStart(3);
+  serializedFrame->prependChain(std::move(tail));
+
+  Frame_PAYLOAD frame;
+  EXPECT_TRUE(deserializeHotFrame(
+      frame, std::move(serializedFrame), *frameSerializer));
+  expectHeader(FrameType::PAYLOAD, FrameFlags::NEXT, 42, frame);
+  EXPECT_EQ("424242", frame.payload_.moveDataToString());
+}
+
+TEST(FrameTest, FrameParser_RejectsMalformedFrames) {
+  auto frameSerializer =
+      FrameSerializer::createFrameSerializer(ProtocolVersion::Latest);
+
+  // Metadata length runs past the end of the frame.
+  auto truncated = frameSerializer->serializeOut(Frame_PAYLOAD(
+      42,
+      FrameFlags::METADATA,
+      Payload(nullptr, folly::IOBuf::copyBuffer("metadata"))));
+  truncated->trimEnd(2);
+  Frame_PAYLOAD payload;
+  EXPECT_FALSE(
+      deserializeHotFrame(payload, std::move(truncated), *frameSerializer));
+
+  // REQUEST_N must be positive.
+  auto zero = frameSerializer->serializeOut(Frame_REQUEST_N(42, 1));
+  zero->writableData()[zero->length() - 1] = 0;
+  Frame_REQUEST_N requestN;
+  EXPECT_FALSE(
+      deserializeHotFrame(requestN, std::move(zero), *frameSerializer));
+
+  // A frame of another type.
+  Frame_CANCEL cancel;
+  EXPECT_FALSE(deserializeHotFrame(
+      cancel,
+      frameSerializer->serializeOut(Frame_REQUEST_N(42, 1)),
+      *frameSerializer));
+}
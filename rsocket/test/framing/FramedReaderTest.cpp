@@ -111,3 +111,51 @@ TEST(FramedReader, SubscriberErrorAfterError) {
   reader->error("Oops");
   reader->onError(std::runtime_error{"Not oops"});
 }
+
+namespace {
+
+/// Records how frames were delivered: one entry per onNext() or
+/// onNextBatch() call, holding the number of frames delivered.
+class RecordingBatchSubscriber : public DuplexConnection::BatchSubscriber {
+ public:
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription->request(std::numeric_limits<int64_t>::max());
+  }
+  void onNext(std::unique_ptr<folly::IOBuf>) override {
+    deliveries.push_back(1);
+  }
+  void onNextBatch(std::vector<std::unique_ptr<folly::IOBuf>> frames) override {
+    deliveries.push_back(frames.size());
+  }
+  void onComplete() override {}
+  void onError(folly::exception_wrapper) override {}
+
+  std::vector<size_t> deliveries;
+};
+
+/// A minimal (length-prefixed) frame: 3 byte length and a 6 byte header.
+std::string makeFrame() {
+  return std::string("\x00\x00\x06\x00\x00\x00\x01\x28\x00", 9);
+}
+
+} // namespace
+
+TEST(FramedReader, BatchesFramesFromOneRead) {
+  auto version = std::make_shared<ProtocolVersion>(ProtocolVersion::Latest);
+  auto reader = std::make_shared<FramedReader>(version);
+  reader->onSubscribe(yarpl::flowable::Subscription::create());
+
+  auto subscriber = std::make_shared<RecordingBatchSubscriber>();
+  reader->setInput(subscriber);
+
+  // Three complete frames and the first half of a fourth.
+  const auto frame = makeFrame();
+  reader->onNext(folly::IOBuf::copyBuffer(
+      frame + frame + frame + frame.substr(0, 4)));
+  // The rest of the fourth frame.
+  reader->onNext(folly::IOBuf::copyBuffer(frame.substr(4)));
+
+  EXPECT_EQ((std::vector<size_t>{3, 1}), subscriber->deliveries);
+  reader->onComplete();
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/AdaptiveRequestWindow.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using namespace ::rsocket;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = AdaptiveRequestWindow::Clock;
+
+AdaptiveRequestWindow::Options options(
+    size_t initial,
+    size_t min,
+    size_t max,
+    std::chrono::microseconds rtt) {
+  AdaptiveRequestWindow::Options options;
+  options.initialWindow = initial;
+  options.minWindow = min;
+  options.maxWindow = max;
+  options.rtt = [rtt] { return rtt; };
+  return options;
+}
+
+} // namespace
+
+TEST(AdaptiveRequestWindowTest, InitialWindowIsClamped) {
+  EXPECT_EQ(8u, AdaptiveRequestWindow(options(1, 8, 64, 0us)).window());
+  EXPECT_EQ(64u, AdaptiveRequestWindow(options(100, 8, 64, 0us)).window());
+
+  AdaptiveRequestWindow window(options(32, 8, 64, 0us));
+  EXPECT_EQ(32u, window.start(Clock::now()));
+  EXPECT_EQ(32u, window.outstanding());
+}
+
+TEST(AdaptiveRequestWindowTest, TopsUpOnceHalfTheWindowIsUsed) {
+  AdaptiveRequestWindow window(options(32, 8, 64, 10ms));
+  auto const now = Clock::now();
+  window.start(now);
+
+  for (int i = 0; i < 15; ++i) {
+    EXPECT_EQ(0u, window.onDelivered(now));
+  }
+  EXPECT_EQ(16u, window.onDelivered(now));
+  EXPECT_EQ(32u, window.outstanding());
+}
+
+TEST(AdaptiveRequestWindowTest, EstimatesRttFromTheFirstItem) {
+  auto const now = Clock::now();
+
+  AdaptiveRequestWindow estimated(options(32, 8, 64, 0us));
+  estimated.start(now);
+  estimated.onDelivered(now + 5ms);
+  EXPECT_EQ(5000us, estimated.rtt());
+
+  AdaptiveRequestWindow given(options(32, 8, 64, 7ms));
+  given.start(now);
+  given.onDelivered(now + 5ms);
+  EXPECT_EQ(7000us, given.rtt());
+}
+
+TEST(AdaptiveRequestWindowTest, GrowsWhileTheWindowIsTheLimit) {
+  constexpr std::chrono::microseconds kRtt = 10ms;
+  AdaptiveRequestWindow window(options(16, 8, 4096, kRtt));
+  auto now = Clock::now();
+
+  // The producer sends what it was granted one round trip earlier, spread
+  // over the round trip.
+  size_t available = window.start(now);
+  size_t previous = window.window();
+  for (int rtt = 0; rtt < 20; ++rtt) {
+    size_t granted = 0;
+    auto const spacing = kRtt / static_cast<int64_t>(available);
+    for (size_t i = 0; i < available; ++i) {
+      granted += window.onDelivered(now + spacing * static_cast<int64_t>(i));
+    }
+    available = granted;
+    now += kRtt;
+
+    EXPECT_LE(window.window(), previous * 2);
+    previous = window.window();
+  }
+  EXPECT_EQ(4096u, window.window());
+}
+
+TEST(AdaptiveRequestWindowTest, SettlesAtTheDeliveryRate) {
+  constexpr auto kRtt = 10ms;
+  AdaptiveRequestWindow window(options(1024, 8, 4096, kRtt));
+  auto now = Clock::now();
+  window.start(now);
+
+  // Ten items per round trip, whatever the credit.
+  for (int rtt = 0; rtt < 30; ++rtt) {
+    for (int i = 0; i < 10; ++i) {
+      window.onDelivered(now + 1ms * i);
+    }
+    now += kRtt;
+  }
+  EXPECT_GE(window.window(), 20u);
+  EXPECT_LT(window.window(), 40u);
+}
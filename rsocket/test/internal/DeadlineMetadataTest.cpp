@@ -0,0 +1,89 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/DeadlineMetadata.h"
+#include <folly/io/Cursor.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+
+using namespace ::rsocket;
+using namespace std::chrono_literals;
+
+TEST(DeadlineMetadataTest, RoundTrip) {
+  Payload payload("data", "metadata");
+  encodeDeadline(payload, 1500ms);
+  EXPECT_LT(8u, payload.metadata->computeChainDataLength());
+
+  auto const budget = decodeDeadline(payload);
+  ASSERT_TRUE(budget.hasValue());
+  EXPECT_EQ(1500ms, *budget);
+  EXPECT_EQ("metadata", payload.moveMetadataToString());
+  EXPECT_EQ("data", payload.moveDataToString());
+}
+
+TEST(DeadlineMetadataTest, NoMetadata) {
+  Payload payload("data");
+  encodeDeadline(payload, 10ms);
+
+  EXPECT_EQ(10ms, *decodeDeadline(payload));
+  EXPECT_FALSE(payload.metadata);
+}
+
+TEST(DeadlineMetadataTest, EmptyMetadataStaysEmpty) {
+  Payload payload("data");
+  payload.metadata = folly::IOBuf::create(0);
+  encodeDeadline(payload, 10ms);
+
+  EXPECT_EQ(10ms, *decodeDeadline(payload));
+  ASSERT_TRUE(payload.metadata);
+  EXPECT_EQ(0u, payload.metadata->computeChainDataLength());
+}
+
+TEST(DeadlineMetadataTest, IsACompositeMetadataEntry) {
+  Payload payload("data");
+  encodeDeadline(payload, 10ms);
+
+  folly::io::Cursor cursor(payload.metadata.get());
+  EXPECT_EQ(kDeadlineMimeType.size() - 1, cursor.read<uint8_t>());
+  EXPECT_EQ(
+      kDeadlineMimeType.str(),
+      cursor.readFixedString(kDeadlineMimeType.size()));
+  EXPECT_EQ(0u, cursor.read<uint8_t>());
+  EXPECT_EQ(5u, cursor.readBE<uint16_t>());
+  EXPECT_EQ(5u, cursor.totalLength());
+}
+
+TEST(DeadlineMetadataTest, BudgetIsClamped) {
+  Payload small("data");
+  encodeDeadline(small, 0ms);
+  EXPECT_EQ(1ms, *decodeDeadline(small));
+
+  Payload large("data");
+  encodeDeadline(large, std::chrono::hours(24 * 365 * 1000));
+  EXPECT_EQ(
+      std::chrono::milliseconds(std::numeric_limits<uint32_t>::max()),
+      *decodeDeadline(large));
+}
+
+TEST(DeadlineMetadataTest, OtherMetadataIsLeftAlone) {
+  Payload none("data");
+  EXPECT_FALSE(decodeDeadline(none).hasValue());
+
+  auto const metadata =
+      "some application metadata, long enough to be parsed as an entry";
+  Payload other("data", metadata);
+  EXPECT_FALSE(decodeDeadline(other).hasValue());
+  EXPECT_EQ(metadata, other.moveMetadataToString());
+}
@@ -83,3 +83,27 @@ TEST(FollyKeepaliveTimerTest, NoResponse) {
 
   timer.stop();
 }
+
+TEST(FollyKeepaliveTimerTest, KeepaliveCarriesTimestamp) {
+  auto connectionAutomaton =
+      std::make_shared<NiceMock<MockConnectionAutomaton>>();
+
+  std::unique_ptr<folly::IOBuf> data;
+  EXPECT_CALL(*connectionAutomaton, sendKeepalive_(_))
+      .WillOnce(Invoke(
+          [&](std::unique_ptr<folly::IOBuf>& buf) { data = std::move(buf); }));
+
+  folly::EventBase eventBase;
+  KeepaliveTimer timer(std::chrono::milliseconds(100), eventBase);
+  timer.start(connectionAutomaton);
+  timer.sendKeepalive(*connectionAutomaton);
+  timer.stop();
+
+  auto const rtt = KeepaliveTimer::roundTripTime(data.get());
+  ASSERT_TRUE(rtt.hasValue());
+  EXPECT_GE(rtt->count(), 0);
+
+  EXPECT_FALSE(KeepaliveTimer::roundTripTime(nullptr).hasValue());
+  auto const other = folly::IOBuf::copyBuffer("not a timestamp");
+  EXPECT_FALSE(KeepaliveTimer::roundTripTime(other.get()).hasValue());
+}
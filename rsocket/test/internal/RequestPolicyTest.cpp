@@ -0,0 +1,83 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/RequestPolicy.h"
+#include <gtest/gtest.h>
+
+using namespace ::rsocket;
+using namespace std::chrono_literals;
+
+TEST(RetryBudgetTest, StartsFull) {
+  RetryBudget budget(0.1, 2);
+  EXPECT_TRUE(budget.tryWithdraw());
+  EXPECT_TRUE(budget.tryWithdraw());
+  EXPECT_FALSE(budget.tryWithdraw());
+}
+
+TEST(RetryBudgetTest, RequestsPayForRetries) {
+  RetryBudget budget(0.25, 10);
+  while (budget.tryWithdraw()) {
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    budget.deposit();
+  }
+  EXPECT_FALSE(budget.tryWithdraw());
+  budget.deposit();
+  EXPECT_TRUE(budget.tryWithdraw());
+  EXPECT_FALSE(budget.tryWithdraw());
+}
+
+TEST(RetryBudgetTest, BalanceIsCapped) {
+  RetryBudget budget(1, 3);
+  for (int i = 0; i < 100; ++i) {
+    budget.deposit();
+  }
+  EXPECT_EQ(3, budget.balance());
+}
+
+TEST(LatencyWindowTest, NeedsEnoughSamples) {
+  LatencyWindow window(100);
+  for (size_t i = 1; i < LatencyWindow::kMinSamples; ++i) {
+    window.add(1ms);
+  }
+  EXPECT_FALSE(window.percentile(0.5).hasValue());
+  window.add(1ms);
+  EXPECT_EQ(1000us, *window.percentile(0.5));
+}
+
+TEST(LatencyWindowTest, Percentiles) {
+  LatencyWindow window(100);
+  for (int i = 1; i <= 100; ++i) {
+    window.add(std::chrono::microseconds(i));
+  }
+  EXPECT_EQ(51us, *window.percentile(0.5));
+  EXPECT_EQ(96us, *window.percentile(0.95));
+  EXPECT_EQ(100us, *window.percentile(1));
+  EXPECT_EQ(1us, *window.percentile(0));
+}
+
+TEST(LatencyWindowTest, OldSamplesAgeOut) {
+  LatencyWindow window(100);
+  for (int i = 0; i < 100; ++i) {
+    window.add(1ms);
+  }
+  EXPECT_EQ(1000us, *window.percentile(0.5));
+
+  for (int i = 0; i < 100; ++i) {
+    window.add(2ms);
+  }
+  EXPECT_EQ(100u, window.size());
+  EXPECT_EQ(2000us, *window.percentile(0.5));
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "rsocket/internal/RingBuffer.h"
+
+using namespace rsocket;
+
+TEST(RingBufferTest, PushPopWrapAround) {
+  RingBuffer<int> ring;
+  EXPECT_TRUE(ring.empty());
+
+  int next = 0;
+  int expectedFront = 0;
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 7; ++i) {
+      ring.emplace_back(next++);
+    }
+    ring.pop_front(5);
+    expectedFront += 5;
+    ASSERT_EQ(static_cast<size_t>(next - expectedFront), ring.size());
+    EXPECT_EQ(expectedFront, ring.front());
+    EXPECT_EQ(next - 1, ring.back());
+    for (size_t i = 0; i < ring.size(); ++i) {
+      EXPECT_EQ(expectedFront + static_cast<int>(i), ring[i]);
+    }
+  }
+
+  int expected = expectedFront;
+  for (auto value : ring) {
+    EXPECT_EQ(expected++, value);
+  }
+  EXPECT_EQ(next, expected);
+
+  ring.clear();
+  EXPECT_TRUE(ring.empty());
+  EXPECT_EQ(ring.begin(), ring.end());
+}
+
+TEST(RingBufferTest, PopReleasesElements) {
+  auto shared = std::make_shared<std::string>("frame");
+  RingBuffer<std::shared_ptr<std::string>> ring;
+
+  ring.emplace_back(shared);
+  ring.emplace_back(shared);
+  EXPECT_EQ(3, shared.use_count());
+
+  ring.pop_front();
+  EXPECT_EQ(2, shared.use_count());
+
+  ring.clear();
+  EXPECT_EQ(1, shared.use_count());
+}
@@ -0,0 +1,70 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/RttEstimator.h"
+#include <gtest/gtest.h>
+
+using namespace ::rsocket;
+using namespace std::chrono_literals;
+
+TEST(RttEstimatorTest, FirstSample) {
+  RttEstimator estimator;
+  EXPECT_EQ(0u, estimator.stats().samples);
+
+  estimator.addSample(800us);
+  auto const& stats = estimator.stats();
+  EXPECT_EQ(1u, stats.samples);
+  EXPECT_EQ(800us, stats.latest);
+  EXPECT_EQ(800us, stats.min);
+  EXPECT_EQ(800us, stats.smoothed);
+  EXPECT_EQ(400us, stats.variance);
+}
+
+TEST(RttEstimatorTest, Smoothing) {
+  RttEstimator estimator;
+  estimator.addSample(800us);
+  estimator.addSample(1600us);
+
+  auto const& stats = estimator.stats();
+  EXPECT_EQ(2u, stats.samples);
+  EXPECT_EQ(1600us, stats.latest);
+  EXPECT_EQ(800us, stats.min);
+  // (7 * 800 + 1600) / 8
+  EXPECT_EQ(900us, stats.smoothed);
+  // (3 * 400 + 800) / 4
+  EXPECT_EQ(500us, stats.variance);
+
+  for (int i = 0; i < 100; ++i) {
+    estimator.addSample(1000us);
+  }
+  // Integer arithmetic settles within 8us of a steady RTT.
+  EXPECT_NEAR(1000, stats.smoothed.count(), 8);
+  EXPECT_LE(stats.variance.count(), 8);
+}
+
+TEST(RttEstimatorTest, Histogram) {
+  RttEstimator estimator;
+  estimator.addSample(0us);
+  estimator.addSample(127us);
+  estimator.addSample(128us);
+  estimator.addSample(255us);
+  estimator.addSample(256us);
+  estimator.addSample(1h);
+
+  auto const& histogram = estimator.stats().histogram;
+  EXPECT_EQ(2u, histogram[0]);
+  EXPECT_EQ(2u, histogram[1]);
+  EXPECT_EQ(1u, histogram[2]);
+  EXPECT_EQ(1u, histogram[RttStats::kHistogramBuckets - 1]);
+}
@@ -0,0 +1,187 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "rsocket/internal/StreamRegistry.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace ::rsocket;
+
+namespace {
+using Registry = StreamRegistry<int>;
+
+std::shared_ptr<int> value(StreamId streamId) {
+  return std::make_shared<int>(static_cast<int>(streamId));
+}
+} // namespace
+
+TEST(StreamRegistryTest, InsertFindErase) {
+  Registry registry;
+  ASSERT_TRUE(registry.empty());
+  ASSERT_EQ(nullptr, registry.find(1));
+
+  ASSERT_TRUE(registry.insert(1, value(1)));
+  ASSERT_TRUE(registry.insert(2, value(2)));
+  ASSERT_TRUE(registry.insert(5, value(5)));
+  ASSERT_FALSE(registry.insert(5, value(5)));
+  ASSERT_EQ(3U, registry.size());
+  ASSERT_EQ(2U, registry.size(RSocketMode::CLIENT));
+  ASSERT_EQ(1U, registry.size(RSocketMode::SERVER));
+
+  ASSERT_EQ(1, *registry.at(1));
+  ASSERT_EQ(2, *registry.at(2));
+  ASSERT_EQ(5, *registry.at(5));
+  ASSERT_EQ(nullptr, registry.find(3));
+  ASSERT_EQ(nullptr, registry.find(4));
+  ASSERT_THROW(registry.at(3), std::out_of_range);
+
+  ASSERT_TRUE(registry.erase(1));
+  ASSERT_FALSE(registry.erase(1));
+  ASSERT_EQ(0U, registry.count(1));
+  ASSERT_EQ(1U, registry.count(5));
+  ASSERT_EQ(2U, registry.size());
+  ASSERT_EQ(1U, registry.size(RSocketMode::CLIENT));
+}
+
+TEST(StreamRegistryTest, OlderIdsAfterWindowMovedOn) {
+  Registry registry;
+  ASSERT_TRUE(registry.insert(101, value(101)));
+  ASSERT_TRUE(registry.insert(7, value(7)));
+  ASSERT_TRUE(registry.insert(103, value(103)));
+  ASSERT_FALSE(registry.insert(7, value(7)));
+
+  ASSERT_EQ(7, *registry.at(7));
+  ASSERT_TRUE(registry.erase(101));
+  ASSERT_TRUE(registry.erase(103));
+  ASSERT_EQ(7, *registry.at(7));
+
+  // The window is empty again, start it somewhere below the old entry.
+  ASSERT_TRUE(registry.insert(5, value(5)));
+  ASSERT_FALSE(registry.insert(7, value(7)));
+  ASSERT_TRUE(registry.insert(9, value(9)));
+  ASSERT_EQ(3U, registry.size());
+  ASSERT_TRUE(registry.erase(7));
+  ASSERT_EQ(nullptr, registry.find(7));
+}
+
+TEST(StreamRegistryTest, LongLivedStreamSpillsOutOfWindow) {
+  Registry registry{8};
+  ASSERT_TRUE(registry.insert(1, value(1)));
+  for (StreamId id = 3; id < 1000; id += 2) {
+    ASSERT_TRUE(registry.insert(id, value(id)));
+    ASSERT_TRUE(registry.erase(id));
+  }
+  ASSERT_EQ(1U, registry.size());
+  ASSERT_EQ(1, *registry.at(1));
+  ASSERT_TRUE(registry.erase(1));
+  ASSERT_TRUE(registry.empty());
+}
+
+TEST(StreamRegistryTest, WindowShrinksAfterBurst) {
+  Registry registry;
+  for (StreamId id = 1; id < 2000; id += 2) {
+    ASSERT_TRUE(registry.insert(id, value(id)));
+  }
+  auto const peak = registry.capacity();
+  ASSERT_GE(peak, 1000u);
+
+  // The first stream outlives the burst.
+  for (StreamId id = 3; id < 2000; id += 2) {
+    ASSERT_TRUE(registry.erase(id));
+  }
+  ASSERT_EQ(1, *registry.at(1));
+  ASSERT_LE(registry.capacity(), 32u);
+
+  // Churn behind it spills it to the side map rather than growing the ring
+  // back.
+  for (StreamId id = 2001; id < 20000; id += 2) {
+    ASSERT_TRUE(registry.insert(id, value(id)));
+    ASSERT_TRUE(registry.erase(id));
+  }
+  ASSERT_LE(registry.capacity(), 32u);
+  ASSERT_EQ(1, *registry.at(1));
+}
+
+TEST(StreamRegistryTest, ExtractAny) {
+  Registry registry;
+  for (StreamId id = 1; id <= 20; ++id) {
+    ASSERT_TRUE(registry.insert(id, value(id)));
+  }
+  std::vector<int> extracted;
+  while (!registry.empty()) {
+    extracted.push_back(*registry.extractAny());
+  }
+  std::sort(extracted.begin(), extracted.end());
+  ASSERT_EQ(20U, extracted.size());
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_EQ(i + 1, extracted[i]);
+  }
+}
+
+TEST(StreamRegistryTest, ForEach) {
+  Registry registry{8};
+  // Stream 1 spills to the side map.
+  for (StreamId id = 1; id < 40; id += 2) {
+    ASSERT_TRUE(registry.insert(id, value(id)));
+  }
+  for (StreamId id = 3; id < 30; id += 2) {
+    ASSERT_TRUE(registry.erase(id));
+  }
+  ASSERT_TRUE(registry.insert(2, value(2)));
+
+  std::vector<int> visited;
+  registry.forEach([&](const Registry::Value& v) { visited.push_back(*v); });
+  std::sort(visited.begin(), visited.end());
+  ASSERT_THAT(visited, ::testing::ElementsAre(1, 2, 31, 33, 35, 37, 39));
+}
+
+TEST(StreamRegistryTest, MatchesUnorderedMap) {
+  Registry registry{64};
+  std::unordered_map<StreamId, std::shared_ptr<int>> reference;
+  std::mt19937 rng{42};
+  StreamId next[2] = {2, 1};
+
+  for (int i = 0; i < 100000; ++i) {
+    auto const parity = rng() % 2;
+    if (rng() % 3 != 0 || reference.empty()) {
+      // Mostly monotonic IDs, occasionally an old one.
+      StreamId id = next[parity];
+      if (rng() % 50 == 0 && id > 200) {
+        id -= 2 * (1 + rng() % 100);
+      } else {
+        next[parity] += 2;
+      }
+      auto const inserted = reference.emplace(id, value(id)).second;
+      ASSERT_EQ(inserted, registry.insert(id, value(id)));
+    } else {
+      auto it = reference.begin();
+      std::advance(it, rng() % std::min<size_t>(reference.size(), 16));
+      auto const id = it->first;
+      reference.erase(it);
+      ASSERT_TRUE(registry.erase(id));
+    }
+    ASSERT_EQ(reference.size(), registry.size());
+  }
+
+  for (auto const& entry : reference) {
+    ASSERT_EQ(entry.first, static_cast<StreamId>(*registry.at(entry.first)));
+  }
+  for (StreamId id = 1; id < next[0] + next[1]; ++id) {
+    ASSERT_EQ(reference.count(id), registry.count(id));
+  }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/StreamStatePool.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ::rsocket;
+
+namespace {
+struct Small {
+  explicit Small(int v) : value(v) {}
+  int value;
+};
+
+struct Large {
+  char bytes[4096];
+};
+
+/// Free lists are shared by every pool on a thread, start each test without
+/// blocks left over from the previous one.
+class StreamStatePoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    StreamStatePool::releaseThreadCache();
+  }
+
+  void TearDown() override {
+    StreamStatePool::releaseThreadCache();
+  }
+};
+} // namespace
+
+TEST_F(StreamStatePoolTest, RecyclesBlocks) {
+  auto pool = std::make_shared<StreamStatePool>();
+
+  auto first =
+      std::allocate_shared<Small>(StreamStateAllocator<Small>(pool), 1);
+  auto const address = first.get();
+  first.reset();
+
+  auto second =
+      std::allocate_shared<Small>(StreamStateAllocator<Small>(pool), 2);
+  EXPECT_EQ(address, second.get());
+  EXPECT_EQ(2, second->value);
+  EXPECT_EQ(1u, pool->stats().hits);
+  EXPECT_EQ(1u, pool->stats().misses);
+}
+
+TEST_F(StreamStatePoolTest, LargeBlocksBypassPool) {
+  auto pool = std::make_shared<StreamStatePool>();
+  for (int i = 0; i < 2; ++i) {
+    auto large =
+        std::allocate_shared<Large>(StreamStateAllocator<Large>(pool));
+    large->bytes[0] = 'a';
+  }
+  EXPECT_EQ(0u, pool->stats().hits);
+  EXPECT_EQ(0u, pool->stats().misses);
+}
+
+TEST_F(StreamStatePoolTest, CacheIsBounded) {
+  StreamStatePool pool;
+  auto const count = StreamStatePool::kMaxCachedBlocks + 10;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < count; ++i) {
+    blocks.push_back(pool.allocate(64));
+  }
+  for (auto block : blocks) {
+    pool.deallocate(block, 64);
+  }
+  blocks.clear();
+  for (size_t i = 0; i < count; ++i) {
+    blocks.push_back(pool.allocate(64));
+  }
+  for (auto block : blocks) {
+    pool.deallocate(block, 64);
+  }
+  EXPECT_EQ(StreamStatePool::kMaxCachedBlocks, pool.stats().hits);
+  EXPECT_EQ(count + 10, pool.stats().misses);
+}
+
+TEST_F(StreamStatePoolTest, SharedByPoolsOnAThread) {
+  StreamStatePool first;
+  StreamStatePool second;
+  first.deallocate(first.allocate(64), 64);
+  second.deallocate(second.allocate(64), 64);
+  EXPECT_EQ(1u, first.stats().misses);
+  EXPECT_EQ(1u, second.stats().hits);
+}
+
+TEST_F(StreamStatePoolTest, BlocksFreedOnAnotherThread) {
+  StreamStatePool pool;
+  auto block = pool.allocate(64);
+  std::thread([&] { pool.deallocate(block, 64); }).join();
+
+  // The block went to the other thread's free list, and back to the heap
+  // when that thread exited.
+  pool.deallocate(pool.allocate(64), 64);
+  EXPECT_EQ(0u, pool.stats().hits);
+  EXPECT_EQ(2u, pool.stats().misses);
+}
+
+TEST_F(StreamStatePoolTest, OutlivesOwner) {
+  std::shared_ptr<Small> small;
+  {
+    auto pool = std::make_shared<StreamStatePool>();
+    small = std::allocate_shared<Small>(StreamStateAllocator<Small>(pool), 3);
+  }
+  // The allocator inside the control block keeps the pool alive.
+  EXPECT_EQ(3, small->value);
+  small.reset();
+}
+
+TEST_F(StreamStatePoolTest, Disabled) {
+  StreamStatePool disabled(false);
+  disabled.deallocate(disabled.allocate(64), 64);
+  disabled.deallocate(disabled.allocate(64), 64);
+  EXPECT_EQ(0u, disabled.stats().hits);
+  EXPECT_EQ(2u, disabled.stats().misses);
+
+  // Nothing a disabled pool frees is cached.
+  StreamStatePool enabled;
+  enabled.deallocate(enabled.allocate(64), 64);
+  EXPECT_EQ(0u, enabled.stats().hits);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/internal/SubmissionQueue.h"
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace ::rsocket;
+
+namespace {
+
+/// Submits `perThread` tasks from each of `threads` threads, and checks each
+/// thread's tasks ran on the EventBase, in order.
+void submitFromThreads(size_t threads, size_t perThread) {
+  folly::ScopedEventBaseThread evbThread;
+  auto& evb = *evbThread.getEventBase();
+  auto queue = std::make_shared<SubmissionQueue>(evb);
+
+  // Only touched on the EventBase.
+  std::vector<size_t> next(threads, 0);
+  size_t outOfOrder = 0;
+  size_t offThread = 0;
+  folly::Baton<> done;
+  size_t remaining = threads * perThread;
+
+  std::vector<std::thread> submitters;
+  for (size_t t = 0; t < threads; ++t) {
+    submitters.emplace_back([&, t] {
+      for (size_t i = 0; i < perThread; ++i) {
+        queue->run([&, t, i] {
+          if (!evb.isInEventBaseThread()) {
+            ++offThread;
+          }
+          if (next[t]++ != i) {
+            ++outOfOrder;
+          }
+          if (--remaining == 0) {
+            done.post();
+          }
+        });
+      }
+    });
+  }
+  for (auto& submitter : submitters) {
+    submitter.join();
+  }
+
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(10)));
+  evb.runInEventBaseThreadAndWait([&] {
+    EXPECT_EQ(0u, outOfOrder);
+    EXPECT_EQ(0u, offThread);
+    for (auto n : next) {
+      EXPECT_EQ(perThread, n);
+    }
+  });
+}
+
+} // namespace
+
+TEST(SubmissionQueueTest, RunsInlineOnEventBase) {
+  folly::ScopedEventBaseThread evbThread;
+  auto& evb = *evbThread.getEventBase();
+  auto queue = std::make_shared<SubmissionQueue>(evb);
+
+  evb.runInEventBaseThreadAndWait([&] {
+    bool ran = false;
+    queue->run([&] { ran = true; });
+    EXPECT_TRUE(ran);
+  });
+}
+
+TEST(SubmissionQueueTest, ManyProducers) {
+  submitFromThreads(8, 10000);
+}
+
+TEST(SubmissionQueueTest, Disabled) {
+  SubmissionQueue::setEnabled(false);
+  submitFromThreads(4, 1000);
+  SubmissionQueue::setEnabled(true);
+}
+
+TEST(SubmissionQueueTest, OutlivesItsOwner) {
+  folly::ScopedEventBaseThread evbThread;
+  auto& evb = *evbThread.getEventBase();
+  folly::Baton<> ran;
+
+  // Block the EventBase so the task is still queued when the owner lets go.
+  folly::Baton<> blocked;
+  evb.runInEventBaseThread([&] { blocked.wait(); });
+
+  auto queue = std::make_shared<SubmissionQueue>(evb);
+  queue->run([&] { ran.post(); });
+  queue.reset();
+  blocked.post();
+
+  EXPECT_TRUE(ran.try_wait_for(std::chrono::seconds(10)));
+}
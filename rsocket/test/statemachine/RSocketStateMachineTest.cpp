@@ -13,16 +13,19 @@
 // limitations under the License.
 
 #include "rsocket/statemachine/RSocketStateMachine.h"
+#include <folly/io/async/EventBaseManager.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <yarpl/single/SingleSubscriptions.h>
 #include <yarpl/single/Singles.h>
 #include <yarpl/test_utils/Mocks.h>
+#include "rsocket/LeaseSender.h"
 #include "rsocket/RSocketConnectionEvents.h"
 #include "rsocket/RSocketResponder.h"
 #include "rsocket/framing/FrameSerializer_v1_0.h"
 #include "rsocket/framing/FrameTransportImpl.h"
 #include "rsocket/internal/Common.h"
+#include "rsocket/internal/WarmResumeManager.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
 #include "rsocket/statemachine/RequestResponseResponder.h"
@@ -68,6 +71,72 @@ class ResponderMock : public RSocketResponder {
   }
 };
 
+/// Grants one request at a time and records the load it was given.
+class RecordingLeaseSender : public LeaseSender {
+ public:
+  std::chrono::milliseconds renewalInterval() const override {
+    return std::chrono::minutes(1);
+  }
+
+  folly::Optional<Lease> nextLease(size_t activeStreams) override {
+    loads.push_back(activeStreams);
+    return Lease{std::chrono::minutes(1), 1};
+  }
+
+  std::vector<size_t> loads;
+};
+
+/// A connection whose output stays congested until drain() is called.
+class CongestedConnection : public MockDuplexConnection {
+ public:
+  size_t getQueuedWriteBytes() const override {
+    return queuedBytes;
+  }
+
+  void setWriteDrainedCallback(size_t, folly::Function<void()> callback)
+      override {
+    drainedCallback = std::move(callback);
+  }
+
+  void drain() {
+    queuedBytes = 0;
+    if (auto callback = std::move(drainedCallback)) {
+      callback();
+    }
+  }
+
+  size_t queuedBytes{1024 * 1024};
+  folly::Function<void()> drainedCallback;
+};
+
+/// Credit granted by a subscriber, for a producer the test drives by hand.
+class ManualSubscription : public yarpl::flowable::Subscription {
+ public:
+  void request(int64_t n) override {
+    requested += n;
+  }
+
+  void cancel() override {}
+
+  int64_t requested{0};
+};
+
+/// Keeps no frames, and counts the times each stream was closed.
+class ClosedStreamsResumeManager : public WarmResumeManager {
+ public:
+  ClosedStreamsResumeManager() : WarmResumeManager(nullptr, 0) {}
+
+  bool shouldTrackFrame(FrameType) const override {
+    return false;
+  }
+
+  void onStreamClosed(StreamId streamId) override {
+    ++closed[streamId];
+  }
+
+  std::unordered_map<StreamId, size_t> closed;
+};
+
 struct ConnectionEventsMock : public RSocketConnectionEvents {
   MOCK_METHOD1(onDisconnected, void(const folly::exception_wrapper&));
   MOCK_METHOD0(onStreamsPaused, void());
@@ -105,7 +174,9 @@ class RSocketStateMachineTest : public Test {
       std::unique_ptr<MockDuplexConnection> connection,
       std::shared_ptr<RSocketResponder> responder,
       folly::Optional<ResumeIdentificationToken> resumeToken = folly::none,
-      std::shared_ptr<RSocketConnectionEvents> connectionEvents = nullptr) {
+      std::shared_ptr<RSocketConnectionEvents> connectionEvents = nullptr,
+      std::shared_ptr<ResumeManager> resumeManager =
+          ResumeManager::makeEmpty()) {
     auto transport =
         std::make_shared<FrameTransportImpl>(std::move(connection));
 
@@ -115,7 +186,7 @@ class RSocketStateMachineTest : public Test {
         RSocketMode::SERVER,
         nullptr,
         std::move(connectionEvents),
-        ResumeManager::makeEmpty(),
+        std::move(resumeManager),
         nullptr);
 
     if (resumeToken) {
@@ -132,11 +203,15 @@ class RSocketStateMachineTest : public Test {
     return stateMachine;
   }
 
-  const std::unordered_map<StreamId, std::shared_ptr<StreamStateMachineBase>>&
-  getStreams(RSocketStateMachine& stateMachine) {
+  const StreamRegistry<StreamStateMachineBase>& getStreams(
+      RSocketStateMachine& stateMachine) {
     return stateMachine.streams_;
   }
 
+  void renewLease(RSocketStateMachine& stateMachine) {
+    stateMachine.sendLease();
+  }
+
   void setupRequestStream(
       RSocketStateMachine& stateMachine,
       StreamId streamId,
@@ -406,6 +481,249 @@ TEST_F(RSocketStateMachineTest, TransportOnNextClose) {
   rawTransport->onNext(std::move(buf));
 }
 
+TEST_F(RSocketStateMachineTest, RejectsRequestsWithoutLease) {
+  folly::EventBase evb;
+  folly::EventBaseManager::get()->setEventBase(&evb, false);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  ON_CALL(*connection, send_(_))
+      .WillByDefault(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        frames.push_back(std::move(frame));
+      }));
+
+  auto responder = std::make_shared<StrictMock<ResponderMock>>();
+  EXPECT_CALL(*responder, handleRequestStream_(1))
+      .WillOnce(Return(yarpl::flowable::Flowable<Payload>::never()));
+
+  auto leaseSender = std::make_shared<RecordingLeaseSender>();
+  auto stateMachine = std::make_shared<RSocketStateMachine>(
+      responder,
+      nullptr,
+      RSocketMode::SERVER,
+      nullptr,
+      nullptr,
+      ResumeManager::makeEmpty(),
+      nullptr);
+  stateMachine->setLeaseSender(leaseSender);
+  stateMachine->connectServer(
+      std::make_shared<FrameTransportImpl>(std::move(connection)),
+      SetupParameters{});
+
+  // The lease admits the first request and rejects the second.
+  setupRequestStream(*stateMachine, 1, 1, Payload{});
+  setupRequestResponse(*stateMachine, 3, Payload{});
+
+  FrameSerializerV1_0 serializer;
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(FrameType::LEASE, serializer.peekFrameType(*frames[0]));
+  Frame_ERROR error;
+  ASSERT_TRUE(serializer.deserializeFrom(error, std::move(frames[1])));
+  EXPECT_EQ(3u, error.header_.streamId);
+  EXPECT_EQ(ErrorCode::REJECTED, error.errorCode_);
+
+  // Streams the server opened itself are not load on the server.
+  stateMachine->requestStream(
+      Payload{}, std::make_shared<NiceMock<MockSubscriber<Payload>>>());
+  renewLease(*stateMachine);
+  EXPECT_THAT(leaseSender->loads, ElementsAre(0u, 1u));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+  folly::EventBaseManager::get()->clearEventBase();
+}
+
+TEST_F(RSocketStateMachineTest, StreamOpenedWhileCongestedReceivesItems) {
+  folly::EventBase evb;
+  folly::EventBaseManager::get()->setEventBase(&evb, false);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  auto connection = std::make_unique<NiceMock<CongestedConnection>>();
+  auto const congested = connection.get();
+  ON_CALL(*connection, send_(_))
+      .WillByDefault(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        frames.push_back(std::move(frame));
+      }));
+
+  auto stateMachine =
+      createClient(std::move(connection), std::make_shared<RSocketResponder>());
+
+  // The REQUEST_STREAM waits for the output to drain, and the REQUEST_N for
+  // the items asked for meanwhile must not overtake it.
+  auto subscriber = std::make_shared<NiceMock<MockSubscriber<Payload>>>(1);
+  stateMachine->requestStream(Payload{}, subscriber);
+  subscriber->subscription()->request(5);
+  evb.loopOnce();
+  ASSERT_EQ(1u, frames.size());
+
+  congested->drain();
+  evb.loopOnce();
+
+  // Like the real peer, ignore REQUEST_N for streams not opened yet.
+  FrameSerializerV1_0 serializer;
+  bool opened = false;
+  uint32_t credit = 0;
+  for (auto& frame : frames) {
+    switch (serializer.peekFrameType(*frame)) {
+      case FrameType::REQUEST_STREAM: {
+        Frame_REQUEST_STREAM request;
+        ASSERT_TRUE(serializer.deserializeFrom(request, std::move(frame)));
+        opened = true;
+        credit += request.requestN_;
+        break;
+      }
+      case FrameType::REQUEST_N: {
+        Frame_REQUEST_N requestN;
+        ASSERT_TRUE(serializer.deserializeFrom(requestN, std::move(frame)));
+        if (opened) {
+          credit += requestN.requestN_;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  EXPECT_EQ(6u, credit);
+
+  EXPECT_CALL(*subscriber, onNext_(_)).Times(6);
+  auto processor = std::dynamic_pointer_cast<FrameProcessor>(stateMachine);
+  for (uint32_t i = 0; i < credit; ++i) {
+    processor->processFrame(serializer.serializeOut(
+        Frame_PAYLOAD(1, FrameFlags::NEXT, Payload("item"))));
+  }
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+  folly::EventBaseManager::get()->clearEventBase();
+}
+
+TEST_F(RSocketStateMachineTest, FullPendingOutputPausesPublishers) {
+  auto subscription = std::make_shared<ManualSubscription>();
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber;
+  auto responder = std::make_shared<StrictMock<ResponderMock>>();
+  EXPECT_CALL(*responder, handleRequestStream_(1))
+      .WillOnce(Return(yarpl::flowable::Flowable<Payload>::fromPublisher(
+          [&](std::shared_ptr<yarpl::flowable::Subscriber<Payload>> s) {
+            subscriber = s;
+            s->onSubscribe(subscription);
+          })));
+
+  // Emits up to `count` items, as far as the credit granted goes.
+  auto produce = [&](size_t count) {
+    size_t produced = 0;
+    while (produced < count && subscription->requested > 0) {
+      --subscription->requested;
+      ++produced;
+      subscriber->onNext(Payload("item"));
+    }
+    return produced;
+  };
+
+  auto const resumeToken = ResumeIdentificationToken::generateNew();
+  auto stateMachine = createServer(
+      std::make_unique<NiceMock<MockDuplexConnection>>(),
+      responder,
+      resumeToken);
+  PendingOutputLimit limit;
+  limit.maxBytes = 100;
+  limit.policy = PendingOutputPolicy::BLOCK;
+  limit.publisherWindow = 4;
+  stateMachine->setPendingOutputLimit(limit);
+
+  // The peer's credit is granted a window at a time.
+  setupRequestStream(*stateMachine, 1, 1000, Payload{});
+  ASSERT_TRUE(subscriber);
+  EXPECT_EQ(4, subscription->requested);
+  EXPECT_EQ(100u, produce(100));
+
+  // Once the held frames exceed their budget, the producer only uses up the
+  // credit it already has.
+  stateMachine->disconnect(std::runtime_error("disconnected"));
+  EXPECT_LT(produce(100), 20u);
+  EXPECT_EQ(0, subscription->requested);
+  EXPECT_EQ(0u, produce(100));
+
+  // Writing the held frames resumes it.
+  auto transport = std::make_shared<FrameTransportImpl>(
+      std::make_unique<NiceMock<MockDuplexConnection>>());
+  ResumeParameters resumeParams{resumeToken, 0, 0, ProtocolVersion::Latest};
+  ASSERT_TRUE(stateMachine->resumeServer(transport, resumeParams));
+  EXPECT_EQ(4, subscription->requested);
+  EXPECT_EQ(100u, produce(100));
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+}
+
+TEST_F(RSocketStateMachineTest, OverflowingStreamFailsOnce) {
+  folly::EventBase evb;
+  folly::EventBaseManager::get()->setEventBase(&evb, false);
+
+  auto subscription = std::make_shared<ManualSubscription>();
+  std::shared_ptr<yarpl::flowable::Subscriber<Payload>> subscriber;
+  auto responder = std::make_shared<StrictMock<ResponderMock>>();
+  EXPECT_CALL(*responder, handleRequestStream_(1))
+      .WillOnce(Return(yarpl::flowable::Flowable<Payload>::fromPublisher(
+          [&](std::shared_ptr<yarpl::flowable::Subscriber<Payload>> s) {
+            subscriber = s;
+            s->onSubscribe(subscription);
+          })));
+
+  auto const resumeToken = ResumeIdentificationToken::generateNew();
+  auto const resumeManager = std::make_shared<ClosedStreamsResumeManager>();
+  auto stateMachine = createServer(
+      std::make_unique<NiceMock<MockDuplexConnection>>(),
+      responder,
+      resumeToken,
+      nullptr,
+      resumeManager);
+  PendingOutputLimit limit;
+  limit.maxBytes = 100;
+  limit.policy = PendingOutputPolicy::FAIL_STREAMS;
+  stateMachine->setPendingOutputLimit(limit);
+
+  setupRequestStream(*stateMachine, 1, 1000, Payload{});
+  ASSERT_TRUE(subscriber);
+  stateMachine->disconnect(std::runtime_error("disconnected"));
+
+  // The stream overflows the budget from within onNext(), and keeps writing
+  // until it is failed from the loop.
+  ASSERT_LE(20, subscription->requested);
+  for (int i = 0; i < 20; ++i) {
+    subscriber->onNext(Payload("item"));
+  }
+  EXPECT_EQ(1u, getStreams(*stateMachine).size());
+  evb.loopOnce();
+  EXPECT_EQ(0u, getStreams(*stateMachine).size());
+  EXPECT_EQ(1u, resumeManager->closed[1]);
+  subscriber->onNext(Payload("item"));
+
+  std::vector<std::unique_ptr<folly::IOBuf>> frames;
+  auto connection = std::make_unique<NiceMock<MockDuplexConnection>>();
+  ON_CALL(*connection, send_(_))
+      .WillByDefault(Invoke([&](std::unique_ptr<folly::IOBuf>& frame) {
+        frames.push_back(std::move(frame));
+      }));
+  auto transport = std::make_shared<FrameTransportImpl>(std::move(connection));
+  ResumeParameters resumeParams{resumeToken, 0, 0, ProtocolVersion::Latest};
+  ASSERT_TRUE(stateMachine->resumeServer(transport, resumeParams));
+
+  // The held items, then a single ERROR.
+  FrameSerializerV1_0 serializer;
+  std::vector<FrameType> types;
+  for (auto& frame : frames) {
+    if (serializer.peekStreamId(*frame, false) == StreamId{1}) {
+      types.push_back(serializer.peekFrameType(*frame));
+    }
+  }
+  ASSERT_LT(1u, types.size());
+  EXPECT_LT(types.size(), 20u);
+  EXPECT_EQ(FrameType::ERROR, types.back());
+  EXPECT_EQ(1, std::count(types.begin(), types.end(), FrameType::ERROR));
+  EXPECT_EQ(1u, resumeManager->closed[1]);
+
+  stateMachine->close({}, StreamCompletionSignal::CONNECTION_END);
+  folly::EventBaseManager::get()->clearEventBase();
+}
+
 TEST_F(RSocketStateMachineTest, ResumeWithCurrentConnection) {
   auto resumeToken = ResumeIdentificationToken::generateNew();
 
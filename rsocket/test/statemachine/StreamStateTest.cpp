@@ -18,6 +18,7 @@
 #include "rsocket/internal/Common.h"
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/statemachine/ChannelResponder.h"
+#include "rsocket/statemachine/StreamRequester.h"
 #include "rsocket/statemachine/StreamStateMachineBase.h"
 #include "rsocket/test/test_utils/MockStreamsWriter.h"
 
@@ -330,3 +331,63 @@ TEST(StreamState, ChannelResponderHandleCancel) {
   auto consumerSubscription = mockSubscriber->subscription();
   consumerSubscription->cancel();
 }
+
+TEST(StreamState, StreamRequesterCoalescesRequestNBetweenWatermarks) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  auto requester =
+      std::make_shared<StreamRequester>(writer, 1u, Payload("request"));
+  requester->setRequestNWatermarks(RequestNWatermarks(2, 8));
+
+  // The stream starts with the high watermark, and is topped back up to it
+  // every time the credit drops to the low watermark.
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, 8u, _));
+  EXPECT_CALL(*writer, writeRequestN_(Field(&Frame_REQUEST_N::requestN_, 6u)))
+      .Times(2);
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+
+  // Requests one payload at a time.
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<rsocket::Payload>>>(1);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*mockSubscriber, onNext_(_))
+      .Times(16)
+      .WillRepeatedly(Invoke([&](const Payload&) {
+        mockSubscriber->subscription()->request(1);
+      }));
+  EXPECT_CALL(*mockSubscriber, onComplete_());
+  requester->subscribe(mockSubscriber);
+
+  for (int i = 0; i < 16; ++i) {
+    requester->handlePayload(Payload("response"), false, true, false);
+  }
+  requester->handlePayload(Payload(), true, false, false);
+}
+
+TEST(StreamState, StreamRequesterCompletesAfterPrefetchedPayloads) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriter>>();
+  auto requester =
+      std::make_shared<StreamRequester>(writer, 1u, Payload("request"));
+  requester->setRequestNWatermarks(RequestNWatermarks(2, 4));
+
+  EXPECT_CALL(*writer, writeNewStream_(1u, StreamType::STREAM, 4u, _));
+  EXPECT_CALL(*writer, onStreamClosed(1u));
+
+  auto mockSubscriber =
+      std::make_shared<StrictMock<MockSubscriber<rsocket::Payload>>>(1);
+  EXPECT_CALL(*mockSubscriber, onSubscribe_(_));
+  requester->subscribe(mockSubscriber);
+
+  // Only the first payload has been requested, the others are held.
+  EXPECT_CALL(*mockSubscriber, onNext_(_));
+  for (int i = 0; i < 4; ++i) {
+    requester->handlePayload(Payload("response"), false, true, false);
+  }
+  requester->handlePayload(Payload(), true, false, false);
+  ASSERT_FALSE(requester->consumerClosed());
+  Mock::VerifyAndClearExpectations(mockSubscriber.get());
+
+  EXPECT_CALL(*mockSubscriber, onNext_(_)).Times(3);
+  EXPECT_CALL(*mockSubscriber, onComplete_());
+  mockSubscriber->subscription()->request(3);
+  ASSERT_TRUE(requester->consumerClosed());
+}
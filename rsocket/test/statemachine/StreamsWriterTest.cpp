@@ -16,6 +16,9 @@
 #include <gtest/gtest.h>
 #include <yarpl/test_utils/Mocks.h>
 
+#include <limits>
+#include <vector>
+
 #include "rsocket/statemachine/ChannelRequester.h"
 #include "rsocket/test/test_utils/MockStreamsWriter.h"
 
@@ -84,3 +87,326 @@ TEST(StreamsWriterTest, FlushQueuedFrames) {
   // it will not send the pending frames twice
   impl.sendPendingFrames();
 }
+
+namespace {
+
+using Written = std::vector<std::pair<StreamId, FrameType>>;
+
+/// Make `writer` record the stream and type of every frame it outputs.
+void recordOutput(MockStreamsWriterImpl& writer, Written& written) {
+  EXPECT_CALL(writer, outputFrame_(_))
+      .WillRepeatedly(Invoke([&](folly::IOBuf* frame) {
+        written.emplace_back(
+            *writer.frameSerializer.peekStreamId(*frame, false),
+            writer.frameSerializer.peekFrameType(*frame));
+      }));
+}
+
+Frame_PAYLOAD makePayload(StreamId streamId, size_t size) {
+  return Frame_PAYLOAD(
+      streamId,
+      FrameFlags::NEXT | FrameFlags::COMPLETE,
+      Payload(std::string(size, 'x')));
+}
+
+} // namespace
+
+TEST(StreamsWriterTest, FragmentsOfConcurrentStreamsInterleave) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+
+  Written written;
+  recordOutput(*writer, written);
+
+  // Only the first fragment of each large payload goes out right away, and
+  // the small payload doesn't wait for the rest.
+  writer->writePayload(makePayload(1, 24));
+  writer->writePayload(makePayload(3, 24));
+  writer->writePayload(makePayload(5, 4));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD},
+               {5, FrameType::PAYLOAD}}),
+      written);
+
+  written.clear();
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD},
+               {1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD}}),
+      written);
+}
+
+TEST(StreamsWriterTest, FramesQueueBehindTheirStreamsFragments) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+
+  Written written;
+  recordOutput(*writer, written);
+
+  writer->writePayload(makePayload(1, 16));
+  writer->writePayload(makePayload(1, 4));
+  writer->writeError(Frame_ERROR::applicationError(1, "boom"));
+  EXPECT_EQ((Written{{1, FrameType::PAYLOAD}}), written);
+
+  written.clear();
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {1, FrameType::PAYLOAD},
+               {1, FrameType::ERROR}}),
+      written);
+}
+
+TEST(StreamsWriterTest, ControlFramesQueueBehindTheirStreamsFragments) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+
+  Written written;
+  recordOutput(*writer, written);
+
+  // A CANCEL must not land in the middle of stream 1's fragmented payload,
+  // while stream 3's control frames don't wait for it.
+  writer->writePayload(makePayload(1, 16));
+  writer->writeRequestN(Frame_REQUEST_N(1, 10));
+  writer->writeCancel(Frame_CANCEL(1));
+  writer->writeRequestN(Frame_REQUEST_N(3, 10));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD}, {3, FrameType::REQUEST_N}}), written);
+
+  written.clear();
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {1, FrameType::REQUEST_N},
+               {1, FrameType::CANCEL}}),
+      written);
+}
+
+TEST(StreamsWriterTest, CancelDropsQueuedFragments) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+
+  Written written;
+  recordOutput(*writer, written);
+
+  writer->writePayload(makePayload(1, 24));
+  writer->writePayload(makePayload(3, 24));
+  writer->dropQueuedFrames(1);
+
+  written.clear();
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{3, FrameType::PAYLOAD}, {3, FrameType::PAYLOAD}}), written);
+}
+
+TEST(StreamsWriterTest, CancelDropsARequestNeverWritten) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->outputCongested_ = true;
+
+  Written written;
+  recordOutput(*writer, written);
+
+  writer->writeNewStream(1, StreamType::STREAM, 1, Payload("request"));
+  writer->writeRequestN(Frame_REQUEST_N(1, 10));
+  writer->writeCancel(Frame_CANCEL(1));
+  EXPECT_TRUE(written.empty());
+
+  writer->outputCongested_ = false;
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_TRUE(written.empty());
+}
+
+TEST(StreamsWriterTest, QueuedFramesRespectBudget) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+
+  Written written;
+  recordOutput(*writer, written);
+
+  writer->writePayload(makePayload(1, 32));
+  written.clear();
+
+  // At least one frame is written per call, however small the budget.
+  EXPECT_TRUE(writer->writeQueuedFrames(1));
+  EXPECT_EQ(1u, written.size());
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(3u, written.size());
+}
+
+TEST(StreamsWriterTest, CongestedOutputServesUrgentStreamsFirst) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->outputCongested_ = true;
+  writer->setStreamPriority(1, StreamPriority(StreamPriority::kLeastUrgent));
+  writer->setStreamPriority(3, StreamPriority(StreamPriority::kMostUrgent));
+
+  Written written;
+  recordOutput(*writer, written);
+
+  writer->writePayload(makePayload(1, 4));
+  writer->writePayload(makePayload(5, 4));
+  writer->writePayload(makePayload(3, 4));
+  writer->writeRequestN(Frame_REQUEST_N(7, 10));
+  writer->writeCancel(Frame_CANCEL(9));
+
+  // Only the control frames go out while the output is congested.
+  EXPECT_EQ(
+      (Written{{7, FrameType::REQUEST_N}, {9, FrameType::CANCEL}}), written);
+
+  written.clear();
+  writer->outputCongested_ = false;
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{3, FrameType::PAYLOAD},
+               {5, FrameType::PAYLOAD},
+               {1, FrameType::PAYLOAD}}),
+      written);
+}
+
+TEST(StreamsWriterTest, LessUrgentStreamsWaitForQueuedUrgentOnes) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->setMaxFragmentSize(8);
+  writer->setStreamPriority(1, StreamPriority(StreamPriority::kMostUrgent));
+
+  Written written;
+  recordOutput(*writer, written);
+
+  // Stream 3 queues behind the urgent stream's fragments, while stream 5, of
+  // the same class as stream 1, doesn't wait.
+  writer->writePayload(makePayload(1, 16));
+  writer->writePayload(makePayload(3, 4));
+  writer->setStreamPriority(5, StreamPriority(StreamPriority::kMostUrgent));
+  writer->writePayload(makePayload(5, 4));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD}, {5, FrameType::PAYLOAD}}), written);
+
+  written.clear();
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD}, {3, FrameType::PAYLOAD}}), written);
+}
+
+TEST(StreamsWriterTest, WeightsShareTheOutputWithinAClass) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->deferQueuedFrames_ = true;
+  writer->outputCongested_ = true;
+  writer->setStreamPriority(
+      1, StreamPriority(StreamPriority::kDefaultUrgency, 2));
+
+  Written written;
+  recordOutput(*writer, written);
+
+  for (int i = 0; i < 3; ++i) {
+    writer->writePayload(makePayload(1, 4));
+    writer->writePayload(makePayload(3, 4));
+  }
+
+  writer->outputCongested_ = false;
+  EXPECT_FALSE(writer->writeQueuedFrames(
+      std::numeric_limits<size_t>::max()));
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD},
+               {1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD}}),
+      written);
+}
+
+namespace {
+
+/// Budget for two of the frames makePayload(_, 100) serializes.
+PendingOutputLimit twoFrames(PendingOutputPolicy policy) {
+  PendingOutputLimit limit;
+  limit.maxBytes = 250;
+  limit.policy = policy;
+  return limit;
+}
+
+} // namespace
+
+TEST(StreamsWriterTest, BlockHoldsFramesBeyondTheBudget) {
+  auto writer = std::make_shared<StrictMock<MockStreamsWriterImpl>>();
+  writer->setPendingOutputLimit(twoFrames(PendingOutputPolicy::BLOCK));
+  writer->shouldQueue_ = true;
+  EXPECT_CALL(*writer, shouldQueue()).Times(AnyNumber());
+  EXPECT_CALL(*writer, onPendingOutputFull());
+
+  for (StreamId streamId = 1; streamId < 9; streamId += 2) {
+    writer->writePayload(makePayload(streamId, 100));
+  }
+
+  Mock::VerifyAndClearExpectations(writer.get());
+  EXPECT_CALL(*writer, shouldQueue()).Times(AnyNumber());
+  EXPECT_CALL(*writer, outputFrame_(_)).Times(4);
+  EXPECT_CALL(*writer, onPendingOutputDrained());
+  writer->shouldQueue_ = false;
+  writer->sendPendingFrames();
+}
+
+TEST(StreamsWriterTest, FailStreamsDropsFramesBeyondTheBudget) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->setPendingOutputLimit(twoFrames(PendingOutputPolicy::FAIL_STREAMS));
+  writer->shouldQueue_ = true;
+  EXPECT_CALL(*writer, onPendingOutputFull());
+  EXPECT_CALL(*writer, onPendingOutputOverflow(5u));
+
+  writer->writePayload(makePayload(1, 100));
+  writer->writePayload(makePayload(3, 100));
+  writer->writePayload(makePayload(5, 100));
+  // Control frames are held regardless of the budget.
+  writer->writeError(Frame_ERROR::applicationError(5, "overflow"));
+
+  Written written;
+  recordOutput(*writer, written);
+  writer->shouldQueue_ = false;
+  writer->sendPendingFrames();
+  EXPECT_EQ(
+      (Written{{1, FrameType::PAYLOAD},
+               {3, FrameType::PAYLOAD},
+               {5, FrameType::ERROR}}),
+      written);
+}
+
+TEST(StreamsWriterTest, DropOldestFireAndForgetMakesRoom) {
+  auto writer = std::make_shared<NiceMock<MockStreamsWriterImpl>>();
+  writer->setPendingOutputLimit(
+      twoFrames(PendingOutputPolicy::DROP_OLDEST_FNF));
+  writer->shouldQueue_ = true;
+
+  writer->writeNewStream(1, StreamType::FNF, 0, Payload(std::string(100, 'x')));
+  writer->writeNewStream(3, StreamType::FNF, 0, Payload(std::string(100, 'x')));
+  writer->writePayload(makePayload(5, 100));
+  writer->writePayload(makePayload(7, 100));
+  // Without a request left to drop, the frame is held anyway.
+  writer->writePayload(makePayload(9, 100));
+
+  Written written;
+  recordOutput(*writer, written);
+  writer->shouldQueue_ = false;
+  writer->sendPendingFrames();
+  EXPECT_EQ(
+      (Written{{5, FrameType::PAYLOAD},
+               {7, FrameType::PAYLOAD},
+               {9, FrameType::PAYLOAD}}),
+      written);
+}
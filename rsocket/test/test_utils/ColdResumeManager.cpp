@@ -108,7 +108,7 @@ ColdResumeManager::ColdResumeManager(
           item.values().begin()->getString().size());
       frames_.emplace_back(
           folly::to<int64_t>(item.keys().begin()->getString()),
-          std::move(ioBuf));
+          std::move(*ioBuf));
     }
   } catch (const std::exception& ex) {
     throw std::runtime_error(
@@ -143,7 +143,7 @@ void ColdResumeManager::persistState(std::string outputFile) {
     for (const auto& frame : frames_) {
       state[FRAMES].push_back(folly::dynamic::object(
           folly::to<std::string>(frame.first),
-          frame.second->moveToFbString().toStdString()));
+          frame.second.cloneAsValue().moveToFbString().toStdString()));
     }
     std::string jsonState = folly::toPrettyJson(state);
     std::ofstream f(outputFile);
@@ -39,9 +39,14 @@ class MockStats : public RSocketStats {
 
   MOCK_METHOD1(bytesWritten, void(size_t));
   MOCK_METHOD1(bytesRead, void(size_t));
+  MOCK_METHOD2(framesFlushed, void(size_t, size_t));
+  MOCK_METHOD1(zeroCopyWrite, void(size_t));
+  MOCK_METHOD0(zeroCopyUnavailable, void());
   MOCK_METHOD1(frameWritten, void(FrameType));
   MOCK_METHOD1(frameRead, void(FrameType));
   MOCK_METHOD2(resumeBufferChanged, void(int, int));
   MOCK_METHOD2(streamBufferChanged, void(int64_t, int64_t));
+  MOCK_METHOD2(pendingFramesDropped, void(size_t, size_t));
+  MOCK_METHOD1(rttMeasured, void(const RttStats&));
 };
 } // namespace rsocket
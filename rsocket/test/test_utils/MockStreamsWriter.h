@@ -27,6 +27,9 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
   MOCK_METHOD1(onStreamClosed, void(StreamId));
   MOCK_METHOD1(outputFrame_, void(folly::IOBuf*));
   MOCK_METHOD0(shouldQueue, bool());
+  MOCK_METHOD0(onPendingOutputFull, void());
+  MOCK_METHOD0(onPendingOutputDrained, void());
+  MOCK_METHOD1(onPendingOutputOverflow, void(StreamId));
 
   MockStreamsWriterImpl() {
     using namespace testing;
@@ -65,9 +68,24 @@ class MockStreamsWriterImpl : public StreamsWriterImpl {
     // ignoring...
   }
 
+  void scheduleQueuedFrames() override {
+    if (!deferQueuedFrames_) {
+      StreamsWriterImpl::scheduleQueuedFrames();
+    }
+  }
+
+  bool isOutputCongested() override {
+    return outputCongested_;
+  }
+
+  using StreamsWriterImpl::dropQueuedFrames;
   using StreamsWriterImpl::sendPendingFrames;
+  using StreamsWriterImpl::writeQueuedFrames;
 
   bool shouldQueue_{false};
+  /// Leave queued frames alone until writeQueuedFrames() is called.
+  bool deferQueuedFrames_{false};
+  bool outputCongested_{false};
   std::shared_ptr<RSocketStats> stats_ = RSocketStats::noop();
   FrameSerializerV1_0 frameSerializer;
 };
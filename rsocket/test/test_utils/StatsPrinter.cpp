@@ -48,6 +48,18 @@ void StatsPrinter::bytesRead(size_t bytes) {
   LOG(INFO) << "bytesRead " << bytes;
 }
 
+void StatsPrinter::framesFlushed(size_t frames, size_t bytes) {
+  LOG(INFO) << "framesFlushed " << frames << " " << bytes;
+}
+
+void StatsPrinter::zeroCopyWrite(size_t bytes) {
+  LOG(INFO) << "zeroCopyWrite " << bytes;
+}
+
+void StatsPrinter::zeroCopyUnavailable() {
+  LOG(INFO) << "zeroCopyUnavailable";
+}
+
 void StatsPrinter::frameWritten(FrameType frameType) {
   LOG(INFO) << "frameWritten " << frameType;
 }
@@ -63,6 +75,10 @@ void StatsPrinter::resumeBufferChanged(
             << " dataSizeDelta=" << dataSizeDelta;
 }
 
+void StatsPrinter::pendingFramesDropped(size_t frames, size_t bytes) {
+  LOG(INFO) << "pendingFramesDropped frames=" << frames << " bytes=" << bytes;
+}
+
 void StatsPrinter::streamBufferChanged(
     int64_t framesCountDelta,
     int64_t dataSizeDelta) {
@@ -77,4 +93,22 @@ void StatsPrinter::keepaliveSent() {
 void StatsPrinter::keepaliveReceived() {
   LOG(INFO) << "keepalive response received";
 }
+
+void StatsPrinter::rttMeasured(const RttStats& stats) {
+  LOG(INFO) << "rtt measured latest=" << stats.latest.count()
+            << "us smoothed=" << stats.smoothed.count()
+            << "us variance=" << stats.variance.count() << "us";
+}
+
+void StatsPrinter::leaseSent(uint32_t numberOfRequests) {
+  LOG(INFO) << "lease sent numberOfRequests=" << numberOfRequests;
+}
+
+void StatsPrinter::leaseReceived(uint32_t numberOfRequests) {
+  LOG(INFO) << "lease received numberOfRequests=" << numberOfRequests;
+}
+
+void StatsPrinter::requestRejectedWithoutLease() {
+  LOG(INFO) << "request rejected without lease";
+}
 } // namespace rsocket
@@ -33,13 +33,22 @@ class StatsPrinter : public RSocketStats {
 
   void bytesWritten(size_t bytes) override;
   void bytesRead(size_t bytes) override;
+  void framesFlushed(size_t frames, size_t bytes) override;
+  void zeroCopyWrite(size_t bytes) override;
+  void zeroCopyUnavailable() override;
   void frameWritten(FrameType frameType) override;
   void frameRead(FrameType frameType) override;
   void resumeBufferChanged(int framesCountDelta, int dataSizeDelta) override;
   void streamBufferChanged(int64_t framesCountDelta, int64_t dataSizeDelta)
       override;
+  void pendingFramesDropped(size_t frames, size_t bytes) override;
 
   void keepaliveSent() override;
   void keepaliveReceived() override;
+  void rttMeasured(const RttStats& stats) override;
+
+  void leaseSent(uint32_t numberOfRequests) override;
+  void leaseReceived(uint32_t numberOfRequests) override;
+  void requestRejectedWithoutLease() override;
 };
 } // namespace rsocket
@@ -15,6 +15,9 @@
 #include "DuplexConnectionTest.h"
 
 #include <folly/io/IOBuf.h>
+#include "rsocket/RSocket.h"
+#include "rsocket/test/test_utils/GenericRequestResponseHandler.h"
+#include "yarpl/single/SingleTestObserver.h"
 #include "yarpl/test_utils/Mocks.h"
 
 namespace rsocket {
@@ -210,5 +213,43 @@ void verifyClosingInputAndOutputDoesntCloseConnection(
       [connection = std::move(serverConnection)] {});
 }
 
+
+void verifyRequestResponse(
+    std::unique_ptr<DuplexConnection> serverConnection,
+    EventBase* serverEvb,
+    std::unique_ptr<DuplexConnection> clientConnection,
+    EventBase* clientEvb) {
+  auto server = std::make_unique<RSocketServer>(nullptr);
+  std::shared_ptr<RSocketResponder> responder =
+      std::make_shared<GenericRequestResponseHandler>(
+          [](StringPair const& request) {
+            return payload_response(
+                "Hello, " + request.first + "!", request.second);
+          });
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    server->acceptConnection(
+        std::move(serverConnection),
+        *serverEvb,
+        RSocketServiceHandler::create(
+            [responder](const SetupParameters&) { return responder; }));
+  });
+
+  std::unique_ptr<RSocketClient> client;
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    client = RSocket::createClientFromConnection(
+        std::move(clientConnection), *clientEvb);
+  });
+
+  auto to = yarpl::single::SingleTestObserver<StringPair>::create();
+  client->getRequester()
+      ->requestResponse(Payload("Jane", "meta"))
+      ->map([](Payload p) { return payload_to_stringpair(std::move(p)); })
+      ->subscribe(to);
+  to->awaitTerminalEvent();
+  to->assertOnSuccessValue({"Hello, Jane!", "meta"});
+
+  clientEvb->runInEventBaseThreadAndWait([client = std::move(client)] {});
+}
+
 } // namespace tests
 } // namespace rsocket
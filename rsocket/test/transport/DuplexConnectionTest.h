@@ -39,5 +39,13 @@ void verifyClosingInputAndOutputDoesntCloseConnection(
     std::unique_ptr<rsocket::DuplexConnection> clientConnection,
     folly::EventBase* clientEvb);
 
+/// Serve a request-response interaction across the two connections, with an
+/// RSocketServer on the server end and an RSocketClient on the client end.
+void verifyRequestResponse(
+    std::unique_ptr<rsocket::DuplexConnection> serverConnection,
+    folly::EventBase* serverEvb,
+    std::unique_ptr<rsocket::DuplexConnection> clientConnection,
+    folly::EventBase* clientEvb);
+
 } // namespace tests
 } // namespace rsocket
@@ -0,0 +1,200 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Conv.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/memory/MemoryDuplexConnection.h"
+#include "yarpl/test_utils/Mocks.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+class MockBatchSubscriber : public DuplexConnection::BatchSubscriber {
+ public:
+  MOCK_METHOD1(
+      onSubscribe_,
+      void(std::shared_ptr<yarpl::flowable::Subscription>));
+  MOCK_METHOD1(onNext_, void(std::unique_ptr<folly::IOBuf>&));
+  MOCK_METHOD1(onNextBatch_, void(std::vector<std::unique_ptr<folly::IOBuf>>&));
+  MOCK_METHOD0(onComplete_, void());
+  MOCK_METHOD1(onError_, void(folly::exception_wrapper));
+
+  void onSubscribe(
+      std::shared_ptr<yarpl::flowable::Subscription> subscription) override {
+    subscription_ = subscription;
+    subscription->request(std::numeric_limits<int64_t>::max());
+    onSubscribe_(std::move(subscription));
+  }
+
+  void onNext(std::unique_ptr<folly::IOBuf> frame) override {
+    onNext_(frame);
+  }
+
+  void onNextBatch(std::vector<std::unique_ptr<folly::IOBuf>> frames) override {
+    onNextBatch_(frames);
+  }
+
+  void onComplete() override {
+    onComplete_();
+  }
+
+  void onError(folly::exception_wrapper ew) override {
+    onError_(std::move(ew));
+  }
+
+  std::shared_ptr<yarpl::flowable::Subscription> subscription_;
+};
+
+} // namespace
+
+TEST(MemoryDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread server, client;
+  auto connections = MemoryDuplexConnection::makePair(
+      *server.getEventBase(), *client.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(connections.first),
+      server.getEventBase(),
+      std::move(connections.second),
+      client.getEventBase());
+}
+
+TEST(MemoryDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread server, client;
+  auto connections = MemoryDuplexConnection::makePair(
+      *server.getEventBase(), *client.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(connections.first),
+      server.getEventBase(),
+      std::move(connections.second),
+      client.getEventBase());
+}
+
+TEST(MemoryDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  folly::ScopedEventBaseThread server, client;
+  auto connections = MemoryDuplexConnection::makePair(
+      *server.getEventBase(), *client.getEventBase());
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(connections.first),
+      server.getEventBase(),
+      std::move(connections.second),
+      client.getEventBase());
+}
+
+TEST(MemoryDuplexConnection, SameEventBase) {
+  folly::ScopedEventBaseThread worker;
+  auto connections = MemoryDuplexConnection::makePair(
+      *worker.getEventBase(), *worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(connections.first),
+      worker.getEventBase(),
+      std::move(connections.second),
+      worker.getEventBase());
+}
+
+TEST(MemoryDuplexConnection, FramesOfOneLoopArriveAsOneBatch) {
+  folly::ScopedEventBaseThread server, client;
+  auto connections = MemoryDuplexConnection::makePair(
+      *server.getEventBase(), *client.getEventBase());
+  auto& serverConnection = connections.first;
+  auto& clientConnection = connections.second;
+
+  folly::Baton<> done;
+  std::vector<const folly::IOBuf*> sent;
+  auto subscriber = std::make_shared<StrictMock<MockBatchSubscriber>>();
+  EXPECT_CALL(*subscriber, onSubscribe_(_));
+  EXPECT_CALL(*subscriber, onNextBatch_(_))
+      .WillOnce(Invoke([&](std::vector<std::unique_ptr<folly::IOBuf>>& frames) {
+        ASSERT_EQ(sent.size(), frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+          // Handed over as is, without a copy.
+          EXPECT_EQ(sent[i], frames[i].get());
+        }
+        done.post();
+      }));
+
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(subscriber); });
+  client.getEventBase()->runInEventBaseThreadAndWait([&] {
+    for (int i = 0; i < 10; ++i) {
+      auto frame = folly::IOBuf::copyBuffer(folly::to<std::string>(i));
+      sent.push_back(frame.get());
+      clientConnection->send(std::move(frame));
+    }
+  });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(1)));
+
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { subscriber->subscription_->cancel(); });
+  client.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(MemoryDuplexConnection, ClosingCompletesPeerAfterPendingFrames) {
+  folly::ScopedEventBaseThread server, client;
+  auto connections = MemoryDuplexConnection::makePair(
+      *server.getEventBase(), *client.getEventBase());
+  auto& serverConnection = connections.first;
+  auto& clientConnection = connections.second;
+
+  folly::Baton<> done;
+  auto subscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  {
+    InSequence seq;
+    EXPECT_CALL(*subscriber, onSubscribe_(_));
+    EXPECT_CALL(*subscriber, onNext_(_));
+    EXPECT_CALL(*subscriber, onComplete_()).WillOnce(Invoke([&] {
+      done.post();
+    }));
+  }
+
+  client.getEventBase()->runInEventBaseThreadAndWait([&] {
+    clientConnection->send(folly::IOBuf::copyBuffer("last words"));
+    clientConnection.reset();
+  });
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(subscriber); });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(1)));
+
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(MemoryDuplexConnection, RequestResponse) {
+  folly::ScopedEventBaseThread serverThread, clientThread;
+  auto connections = MemoryDuplexConnection::makePair(
+      *serverThread.getEventBase(), *clientThread.getEventBase());
+  verifyRequestResponse(
+      std::move(connections.first),
+      serverThread.getEventBase(),
+      std::move(connections.second),
+      clientThread.getEventBase());
+}
+
+} // namespace tests
+} // namespace rsocket
@@ -0,0 +1,308 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Conv.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+#include "rsocket/transports/shm/ShmRing.h"
+#include "yarpl/test_utils/Mocks.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+/// Backing memory for a ShmRing within one process.
+struct RingMemory {
+  explicit RingMemory(size_t capacity)
+      : buffer(ShmRing::sizeFor(capacity) + 64),
+        producer(ShmRing::create(memory(), capacity)),
+        consumer(ShmRing::attach(memory(), ShmRing::sizeFor(capacity))) {}
+
+  /// The buffer, aligned to a cache line.
+  void* memory() {
+    auto const address = reinterpret_cast<uintptr_t>(buffer.data());
+    return reinterpret_cast<void*>((address + 63) & ~uintptr_t{63});
+  }
+
+  std::vector<uint8_t> buffer;
+  ShmRing producer;
+  ShmRing consumer;
+};
+
+std::string readString(ShmRing& ring) {
+  auto frame = ring.read();
+  return frame ? frame->moveToFbString().toStdString() : "<none>";
+}
+
+/**
+ * Create both ends of a channel, each on its own EventBase.
+ */
+void makeShmConnections(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase* serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb,
+    ShmDuplexConnection::Options options = ShmDuplexConnection::Options()) {
+  auto endpoints = ShmDuplexConnection::createChannel(options);
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    serverConnection = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.first), *serverEvb, options);
+  });
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    clientConnection = std::make_unique<ShmDuplexConnection>(
+        std::move(endpoints.second), *clientEvb, options);
+  });
+}
+
+} // namespace
+
+TEST(ShmRing, FramesWrapAroundInOrder) {
+  RingMemory ring(64);
+
+  // Records of 4 + 15 bytes, padded to 24, so frames wrap around the end.
+  for (int i = 0; i < 10; ++i) {
+    auto const frame = folly::to<std::string>("frame-", i, "-", 1000000 + i);
+    EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer(frame)));
+    ring.producer.publishWrites();
+    EXPECT_EQ(frame, readString(ring.consumer));
+    ring.consumer.releaseReads();
+  }
+  EXPECT_EQ(nullptr, ring.consumer.read());
+}
+
+TEST(ShmRing, AttachRejectsBadHeaders) {
+  RingMemory ring(64);
+  auto const size = ShmRing::sizeFor(64);
+
+  // The capacity must fit in the memory handed to attach().
+  EXPECT_THROW(ShmRing::attach(ring.memory(), size - 1), std::runtime_error);
+
+  // The header starts with the magic number and the capacity, both written
+  // by the peer.
+  auto const header = static_cast<uint64_t*>(ring.memory());
+  header[1] = 1 << 20;
+  EXPECT_THROW(ShmRing::attach(ring.memory(), size), std::runtime_error);
+  header[1] = 96;
+  EXPECT_THROW(ShmRing::attach(ring.memory(), size), std::runtime_error);
+  header[0] = 0;
+  EXPECT_THROW(ShmRing::attach(ring.memory(), size), std::runtime_error);
+}
+
+TEST(ShmRing, FramesAreInvisibleUntilPublished) {
+  RingMemory ring(64);
+
+  EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer("hello")));
+  EXPECT_EQ(nullptr, ring.consumer.read());
+  ring.producer.publishWrites();
+  EXPECT_EQ("hello", readString(ring.consumer));
+}
+
+TEST(ShmRing, ChainedFramesAreFlattened) {
+  RingMemory ring(64);
+
+  auto frame = folly::IOBuf::copyBuffer("hello, ");
+  frame->prependChain(folly::IOBuf::copyBuffer("world"));
+  EXPECT_TRUE(ring.producer.tryWrite(*frame));
+  ring.producer.publishWrites();
+  EXPECT_EQ("hello, world", readString(ring.consumer));
+}
+
+TEST(ShmRing, FullRingWakesParkedProducer) {
+  RingMemory ring(64);
+  auto const frame = folly::IOBuf::copyBuffer(std::string(20, 'x'));
+
+  // Two records of 24 bytes fit, a third does not.
+  EXPECT_TRUE(ring.producer.tryWrite(*frame));
+  EXPECT_TRUE(ring.producer.tryWrite(*frame));
+  EXPECT_FALSE(ring.producer.tryWrite(*frame));
+  EXPECT_FALSE(ring.producer.publishWrites());
+  EXPECT_TRUE(ring.producer.parkProducer(frame->length()));
+
+  ring.consumer.read();
+  EXPECT_TRUE(ring.consumer.releaseReads());
+  EXPECT_TRUE(ring.producer.tryWrite(*frame));
+}
+
+TEST(ShmRing, ParkedConsumerIsWokenOnce) {
+  RingMemory ring(64);
+
+  EXPECT_TRUE(ring.consumer.parkConsumer());
+  EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer("a")));
+  EXPECT_TRUE(ring.producer.publishWrites());
+  EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer("b")));
+  EXPECT_FALSE(ring.producer.publishWrites());
+
+  // Does not park while there is something to read.
+  EXPECT_FALSE(ring.consumer.parkConsumer());
+  EXPECT_EQ("a", readString(ring.consumer));
+  EXPECT_EQ("b", readString(ring.consumer));
+}
+
+TEST(ShmRing, ProducerIsDoneOnceDrained) {
+  RingMemory ring(64);
+
+  EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer("last")));
+  EXPECT_FALSE(ring.producer.closeProducer());
+  EXPECT_FALSE(ring.consumer.isProducerDone());
+  EXPECT_FALSE(ring.consumer.parkConsumer());
+  EXPECT_EQ("last", readString(ring.consumer));
+  EXPECT_TRUE(ring.consumer.isProducerDone());
+}
+
+TEST(ShmRing, OversizedLengthIsCorrupt) {
+  RingMemory ring(64);
+
+  EXPECT_TRUE(ring.producer.tryWrite(*folly::IOBuf::copyBuffer("hello")));
+  ring.producer.publishWrites();
+
+  // Overwrite the length prefix of the published record, past what was
+  // published but within the ring.
+  auto const data = static_cast<uint8_t*>(ring.memory()) +
+      ShmRing::sizeFor(64) - 64;
+  uint32_t const length = 40;
+  std::memcpy(data, &length, sizeof(length));
+
+  EXPECT_EQ(nullptr, ring.consumer.read());
+  EXPECT_TRUE(ring.consumer.isCorrupt());
+  EXPECT_EQ(nullptr, ring.consumer.read());
+}
+
+TEST(ShmDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread server, client;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  makeShmConnections(
+      serverConnection,
+      server.getEventBase(),
+      clientConnection,
+      client.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      server.getEventBase(),
+      std::move(clientConnection),
+      client.getEventBase());
+}
+
+TEST(ShmDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread server, client;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  makeShmConnections(
+      serverConnection,
+      server.getEventBase(),
+      clientConnection,
+      client.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      server.getEventBase(),
+      std::move(clientConnection),
+      client.getEventBase());
+}
+
+TEST(ShmDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  folly::ScopedEventBaseThread server, client;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  makeShmConnections(
+      serverConnection,
+      server.getEventBase(),
+      clientConnection,
+      client.getEventBase());
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(serverConnection),
+      server.getEventBase(),
+      std::move(clientConnection),
+      client.getEventBase());
+}
+
+TEST(ShmDuplexConnection, FramesLargerThanTheRingFreeSpaceArriveInOrder) {
+  folly::ScopedEventBaseThread server, client;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  ShmDuplexConnection::Options options;
+  options.ringCapacity = 4096;
+  makeShmConnections(
+      serverConnection,
+      server.getEventBase(),
+      clientConnection,
+      client.getEventBase(),
+      options);
+
+  // Many times the ring's capacity, so the writer parks until the reader
+  // catches up.
+  constexpr size_t kFrames = 200;
+  std::vector<std::string> received;
+  folly::Baton<> done;
+  auto serverSubscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*serverSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*serverSubscriber, onNext_(_))
+      .Times(kFrames)
+      .WillRepeatedly(Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+        received.push_back(buf->clone()->moveToFbString().toStdString());
+        if (received.size() == kFrames) {
+          done.post();
+        }
+      }));
+
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  client.getEventBase()->runInEventBaseThreadAndWait([&] {
+    for (size_t i = 0; i < kFrames; ++i) {
+      clientConnection->send(folly::IOBuf::copyBuffer(
+          folly::to<std::string>(i, std::string(1000, '.'))));
+    }
+  });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(5)));
+  for (size_t i = 0; i < kFrames; ++i) {
+    EXPECT_EQ(folly::to<std::string>(i, std::string(1000, '.')), received[i]);
+  }
+
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber)] {
+        subscriber->subscription()->cancel();
+      });
+  client.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  server.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(ShmDuplexConnection, RequestResponse) {
+  folly::ScopedEventBaseThread serverThread, clientThread;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  makeShmConnections(
+      serverConnection,
+      serverThread.getEventBase(),
+      clientConnection,
+      clientThread.getEventBase());
+  verifyRequestResponse(
+      std::move(serverConnection),
+      serverThread.getEventBase(),
+      std::move(clientConnection),
+      clientThread.getEventBase());
+}
+
+} // namespace tests
+} // namespace rsocket
@@ -12,21 +12,35 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <folly/Conv.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 #include <folly/io/async/ssl/SSLErrors.h>
+#include <folly/synchronization/Baton.h>
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include "rsocket/test/transport/DuplexConnectionTest.h"
 #include "rsocket/transports/tcp/TcpConnectionAcceptor.h"
 #include "rsocket/transports/tcp/TcpConnectionFactory.h"
+#include "yarpl/test_utils/Mocks.h"
 
 namespace rsocket {
 namespace tests {
 
 using namespace folly;
 using namespace rsocket;
+using namespace ::testing;
 
 /**
  * Synchronously create a server and a client.
@@ -109,5 +123,250 @@ TEST(TcpDuplexConnection, ConnectionAndSubscribersAreUntied) {
       worker.getEventBase());
 }
 
+TEST(TcpDuplexConnection, CoalescedWritesArriveInOrder) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeSingleClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+  auto serverSubscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*serverSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*serverSubscriber, onNext_(_))
+      .WillRepeatedly(Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+        received.append(buf->clone());
+        if (received.chainLength() == 30) {
+          done.post();
+        }
+      }));
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  // All of these sends happen in the same loop iteration and are flushed
+  // together.
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+    for (int i = 0; i < 10; ++i) {
+      clientConnection->send(folly::IOBuf::copyBuffer(folly::to<std::string>(
+          "<", i, ">")));
+    }
+  });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(1)));
+  EXPECT_EQ(
+      "<0><1><2><3><4><5><6><7><8><9>",
+      received.move()->moveToFbString().toStdString());
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber)] {
+        subscriber->subscription()->cancel();
+      });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(TcpDuplexConnection, ReusePortAcceptorSpreadsConnections) {
+  constexpr size_t kConnections = 64;
+
+  TcpConnectionAcceptor::Options options;
+  options.address = folly::SocketAddress{"::", 0};
+  options.threads = 4;
+  options.backlog = 128;
+  options.reusePort = true;
+
+  std::mutex mutex;
+  std::vector<std::pair<std::unique_ptr<DuplexConnection>, EventBase*>>
+      accepted;
+  std::set<EventBase*> acceptingEvbs;
+  folly::Baton<> allAccepted;
+
+  TcpConnectionAcceptor server(std::move(options));
+  server.start([&](std::unique_ptr<DuplexConnection> connection,
+                   EventBase& eventBase) {
+    // Accepted right on the worker, without a handoff.
+    EXPECT_TRUE(eventBase.isInEventBaseThread());
+    std::lock_guard<std::mutex> lock(mutex);
+    accepted.emplace_back(std::move(connection), &eventBase);
+    acceptingEvbs.insert(&eventBase);
+    if (accepted.size() == kConnections) {
+      allAccepted.post();
+    }
+  });
+
+  folly::ScopedEventBaseThread worker;
+  TcpConnectionFactory factory(
+      *worker.getEventBase(),
+      SocketAddress("localhost", server.listeningPort().value(), true));
+
+  std::vector<std::unique_ptr<DuplexConnection>> clientConnections;
+  for (size_t i = 0; i < kConnections; ++i) {
+    clientConnections.push_back(
+        factory.connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+            .get()
+            .connection);
+  }
+
+  ASSERT_TRUE(allAccepted.try_wait_for(std::chrono::seconds(5)));
+
+  // The kernel hashes connections across all four listeners, so all of them
+  // landing on one is vanishingly unlikely.
+  EXPECT_GT(acceptingEvbs.size(), 1u);
+
+  for (auto& connection : accepted) {
+    connection.second->runInEventBaseThreadAndWait(
+        [c = std::move(connection.first)] {});
+  }
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [connections = std::move(clientConnections)] {});
+  server.stop();
+}
+
+namespace {
+
+/// Counts the zero-copy stats events of a connection.
+class ZeroCopyStats : public RSocketStats {
+ public:
+  void zeroCopyWrite(size_t bytes) override {
+    ++writes;
+    zeroCopyBytes += bytes;
+  }
+
+  void zeroCopyUnavailable() override {
+    ++unavailable;
+  }
+
+  std::atomic<size_t> writes{0};
+  std::atomic<size_t> zeroCopyBytes{0};
+  std::atomic<size_t> unavailable{0};
+};
+
+/// Opens a connected pair of sockets of the given `domain`.
+std::pair<int, int> makeSocketPair(int domain) {
+  if (domain == AF_UNIX) {
+    int fds[2];
+    PCHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    return {fds[0], fds[1]};
+  }
+
+  int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(listener >= 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  PCHECK(::bind(listener, reinterpret_cast<sockaddr*>(&addr), len) == 0);
+  PCHECK(::listen(listener, 1) == 0);
+  PCHECK(
+      ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+
+  int client = ::socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(client >= 0);
+  PCHECK(::connect(client, reinterpret_cast<sockaddr*>(&addr), len) == 0);
+  int server = ::accept(listener, nullptr, nullptr);
+  PCHECK(server >= 0);
+  ::close(listener);
+  return {client, server};
+}
+
+/// Sends a burst of small frames and then a large frame from a connection
+/// that asks for zero-copy sends above 64KB, and checks that all arrive
+/// intact.  The small frames are coalesced into chains of 64KB or more.
+void sendWithZeroCopy(int domain, ZeroCopyStats& stats) {
+  constexpr size_t kSmall = 1024;
+  constexpr size_t kSmallFrames = 128;
+  constexpr size_t kLarge = 1024 * 1024;
+
+  folly::ScopedEventBaseThread clientThread;
+  folly::ScopedEventBaseThread serverThread;
+  auto const clientEvb = clientThread.getEventBase();
+  auto const serverEvb = serverThread.getEventBase();
+  auto const fds = makeSocketPair(domain);
+
+  std::unique_ptr<DuplexConnection> clientConnection, serverConnection;
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    TcpDuplexConnection::Options options;
+    options.zeroCopy = true;
+    options.zeroCopyThreshold = 64 * 1024;
+    folly::AsyncTransportWrapper::UniquePtr socket(new folly::AsyncSocket(
+        clientEvb, folly::NetworkSocket::fromFd(fds.first)));
+    clientConnection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket),
+        options,
+        std::shared_ptr<RSocketStats>(&stats, [](RSocketStats*) {}));
+  });
+  serverEvb->runInEventBaseThreadAndWait([&] {
+    folly::AsyncTransportWrapper::UniquePtr socket(new folly::AsyncSocket(
+        serverEvb, folly::NetworkSocket::fromFd(fds.second)));
+    serverConnection = std::make_unique<TcpDuplexConnection>(std::move(socket));
+  });
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+  auto serverSubscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*serverSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*serverSubscriber, onNext_(_))
+      .WillRepeatedly(Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+        received.append(buf->clone());
+        if (received.chainLength() == kSmall * kSmallFrames + kLarge) {
+          done.post();
+        }
+      }));
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    for (size_t i = 0; i < kSmallFrames; ++i) {
+      clientConnection->send(
+          folly::IOBuf::copyBuffer(std::string(kSmall, 's')));
+    }
+  });
+  clientEvb->runInEventBaseThreadAndWait([&] {
+    clientConnection->send(folly::IOBuf::copyBuffer(std::string(kLarge, 'l')));
+  });
+
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ(
+      std::string(kSmall * kSmallFrames, 's') + std::string(kLarge, 'l'),
+      received.move()->moveToFbString().toStdString());
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber)] {
+        subscriber->subscription()->cancel();
+      });
+  clientEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+} // namespace
+
+TEST(TcpDuplexConnection, ZeroCopyOnlyAboveThreshold) {
+  ZeroCopyStats stats;
+  sendWithZeroCopy(AF_INET, stats);
+
+  if (stats.unavailable > 0) {
+    // Kernel without MSG_ZEROCOPY support: everything was copied.
+    EXPECT_EQ(0u, stats.writes);
+    return;
+  }
+  EXPECT_EQ(1u, stats.writes);
+  EXPECT_EQ(1024u * 1024u, stats.zeroCopyBytes);
+}
+
+TEST(TcpDuplexConnection, ZeroCopyFallsBackToCopying) {
+  // Unix domain sockets don't support MSG_ZEROCOPY.
+  ZeroCopyStats stats;
+  sendWithZeroCopy(AF_UNIX, stats);
+
+  EXPECT_EQ(1u, stats.unavailable);
+  EXPECT_EQ(0u, stats.writes);
+}
+
 } // namespace tests
 } // namespace rsocket
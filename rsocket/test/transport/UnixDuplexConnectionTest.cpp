@@ -0,0 +1,275 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+#include "yarpl/test_utils/Mocks.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeUnixClientServer(
+    const std::string& path,
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  UnixConnectionAcceptor::Options options;
+  options.path = path;
+  options.threads = 1;
+  options.backlog = 0;
+
+  auto server = std::make_unique<UnixConnectionAcceptor>(std::move(options));
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  auto client = std::make_unique<UnixConnectionFactory>(*clientEvb, path);
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+std::string socketPath(const folly::test::TemporaryDirectory& dir) {
+  return (dir.path() / "rsocket.sock").string();
+}
+
+std::unique_ptr<UnixConnectionAcceptor> startAcceptor(const std::string& path) {
+  UnixConnectionAcceptor::Options options;
+  options.path = path;
+  options.threads = 1;
+  auto acceptor = std::make_unique<UnixConnectionAcceptor>(std::move(options));
+  acceptor->start([](std::unique_ptr<DuplexConnection>, EventBase&) {});
+  return acceptor;
+}
+
+bool exists(const std::string& path) {
+  struct stat st;
+  return ::lstat(path.c_str(), &st) == 0;
+}
+
+} // namespace
+
+TEST(UnixDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::test::TemporaryDirectory dir;
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUnixClientServer(
+      socketPath(dir),
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UnixDuplexConnection, InputAndOutputIsUntied) {
+  folly::test::TemporaryDirectory dir;
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUnixClientServer(
+      socketPath(dir),
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UnixDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  folly::test::TemporaryDirectory dir;
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUnixClientServer(
+      socketPath(dir),
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase());
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UnixDuplexConnection, WritesLargerThanSocketBufferArriveInOrder) {
+  folly::test::TemporaryDirectory dir;
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUnixClientServer(
+      socketPath(dir),
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase());
+
+  // Far more than the socket buffers hold, so the writer has to wait for
+  // the socket to become writable again.
+  constexpr size_t kFrames = 64;
+  constexpr size_t kFrameSize = 64 * 1024;
+  std::string expected;
+  for (size_t i = 0; i < kFrames; ++i) {
+    expected.append(kFrameSize, static_cast<char>('a' + i % 26));
+  }
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+  auto serverSubscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*serverSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*serverSubscriber, onNext_(_))
+      .WillRepeatedly(Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+        received.append(buf->clone());
+        if (received.chainLength() == expected.size()) {
+          done.post();
+        }
+      }));
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+    for (size_t i = 0; i < kFrames; ++i) {
+      clientConnection->send(folly::IOBuf::copyBuffer(
+          expected.data() + i * kFrameSize, kFrameSize));
+    }
+  });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(5)));
+  EXPECT_EQ(expected, received.move()->moveToFbString().toStdString());
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber)] {
+        subscriber->subscription()->cancel();
+      });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+TEST(UnixConnectionAcceptor, ReplacesStaleSocket) {
+  folly::test::TemporaryDirectory dir;
+  auto const path = socketPath(dir);
+
+  // A socket bound but never listened on, as left by a crashed server.
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_storage storage;
+  auto const length = SocketAddress::makeFromPath(path).getAddress(&storage);
+  ASSERT_EQ(0, ::bind(fd, reinterpret_cast<sockaddr*>(&storage), length));
+  ::close(fd);
+
+  auto acceptor = startAcceptor(path);
+  acceptor->stop();
+  EXPECT_FALSE(exists(path));
+}
+
+TEST(UnixConnectionAcceptor, DoesNotTakeOverLiveServer) {
+  folly::test::TemporaryDirectory dir;
+  auto const path = socketPath(dir);
+
+  auto live = startAcceptor(path);
+  try {
+    startAcceptor(path);
+    FAIL() << "Second acceptor started";
+  } catch (const std::system_error& ex) {
+    EXPECT_EQ(EADDRINUSE, ex.code().value());
+  }
+  // The failed acceptor leaves the live server's socket alone.
+  EXPECT_TRUE(exists(path));
+}
+
+TEST(UnixConnectionAcceptor, DoesNotRemoveOtherFiles) {
+  folly::test::TemporaryDirectory dir;
+  auto const path = socketPath(dir);
+  ASSERT_TRUE(folly::writeFile(std::string("data"), path.c_str()));
+
+  EXPECT_THROW(startAcceptor(path), std::system_error);
+  std::string content;
+  ASSERT_TRUE(folly::readFile(path.c_str(), content));
+  EXPECT_EQ("data", content);
+}
+
+TEST(UnixDuplexConnection, RequestResponse) {
+  folly::test::TemporaryDirectory dir;
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUnixClientServer(
+      socketPath(dir),
+      serverConnection,
+      &serverEvb,
+      clientConnection,
+      worker.getEventBase());
+  verifyRequestResponse(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+} // namespace tests
+} // namespace rsocket
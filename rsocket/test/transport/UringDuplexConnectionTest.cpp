@@ -0,0 +1,174 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <folly/Conv.h>
+#include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/synchronization/Baton.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "rsocket/test/transport/DuplexConnectionTest.h"
+#include "rsocket/transports/uring/UringConnectionAcceptor.h"
+#include "rsocket/transports/uring/UringConnectionFactory.h"
+#include "yarpl/test_utils/Mocks.h"
+
+namespace rsocket {
+namespace tests {
+
+using namespace folly;
+using namespace rsocket;
+using namespace ::testing;
+
+namespace {
+
+/**
+ * Synchronously create a server and a client.
+ */
+std::pair<
+    std::unique_ptr<ConnectionAcceptor>,
+    std::unique_ptr<ConnectionFactory>>
+makeUringClientServer(
+    std::unique_ptr<DuplexConnection>& serverConnection,
+    EventBase** serverEvb,
+    std::unique_ptr<DuplexConnection>& clientConnection,
+    EventBase* clientEvb) {
+  Promise<Unit> serverPromise;
+
+  UringConnectionAcceptor::Options options;
+  options.address = folly::SocketAddress{"::", 0};
+  options.threads = 1;
+  options.backlog = 0;
+
+  auto server = std::make_unique<UringConnectionAcceptor>(std::move(options));
+  server->start(
+      [&serverPromise, &serverConnection, &serverEvb](
+          std::unique_ptr<DuplexConnection> connection, EventBase& eventBase) {
+        serverConnection = std::move(connection);
+        *serverEvb = &eventBase;
+        serverPromise.setValue();
+      });
+
+  int16_t port = server->listeningPort().value();
+
+  auto client = std::make_unique<UringConnectionFactory>(
+      *clientEvb, SocketAddress("localhost", port, true));
+  client->connect(ProtocolVersion::Latest, ResumeStatus::NEW_SESSION)
+      .thenValue([&clientConnection](
+                     ConnectionFactory::ConnectedDuplexConnection connection) {
+        clientConnection = std::move(connection.connection);
+      })
+      .wait();
+
+  serverPromise.getSemiFuture().wait();
+  return std::make_pair(std::move(server), std::move(client));
+}
+
+} // namespace
+
+TEST(UringDuplexConnection, MultipleSetInputGetOutputCalls) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUringClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  makeMultipleSetInputGetOutputCalls(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UringDuplexConnection, InputAndOutputIsUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUringClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyInputAndOutputIsUntied(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UringDuplexConnection, ConnectionAndSubscribersAreUntied) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUringClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+  verifyClosingInputAndOutputDoesntCloseConnection(
+      std::move(serverConnection),
+      serverEvb,
+      std::move(clientConnection),
+      worker.getEventBase());
+}
+
+TEST(UringDuplexConnection, SendsOfOneLoopAreBatched) {
+  folly::ScopedEventBaseThread worker;
+  std::unique_ptr<DuplexConnection> serverConnection, clientConnection;
+  EventBase* serverEvb = nullptr;
+  auto keepAlive = makeUringClientServer(
+      serverConnection, &serverEvb, clientConnection, worker.getEventBase());
+
+  folly::IOBufQueue received{folly::IOBufQueue::cacheChainLength()};
+  folly::Baton<> done;
+  auto serverSubscriber = std::make_shared<
+      yarpl::mocks::MockSubscriber<std::unique_ptr<folly::IOBuf>>>();
+  EXPECT_CALL(*serverSubscriber, onSubscribe_(_));
+  EXPECT_CALL(*serverSubscriber, onNext_(_))
+      .WillRepeatedly(Invoke([&](const std::unique_ptr<folly::IOBuf>& buf) {
+        received.append(buf->clone());
+        if (received.chainLength() == 30) {
+          done.post();
+        }
+      }));
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [&] { serverConnection->setInput(serverSubscriber); });
+
+  size_t submits = 0;
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+    auto& uring = static_cast<UringDuplexConnection&>(*clientConnection);
+    submits = uring.getRing().stats().submits;
+    for (int i = 0; i < 10; ++i) {
+      clientConnection->send(folly::IOBuf::copyBuffer(folly::to<std::string>(
+          "<", i, ">")));
+    }
+  });
+  ASSERT_TRUE(done.try_wait_for(std::chrono::seconds(1)));
+  EXPECT_EQ(
+      "<0><1><2><3><4><5><6><7><8><9>",
+      received.move()->moveToFbString().toStdString());
+
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] {
+    auto& uring = static_cast<UringDuplexConnection&>(*clientConnection);
+    // All ten frames went out with one sendmsg() request, in one submission.
+    EXPECT_EQ(submits + 1, uring.getRing().stats().submits);
+  });
+
+  serverEvb->runInEventBaseThreadAndWait(
+      [subscriber = std::move(serverSubscriber)] {
+        subscriber->subscription()->cancel();
+      });
+  worker.getEventBase()->runInEventBaseThreadAndWait(
+      [connection = std::move(clientConnection)] {});
+  serverEvb->runInEventBaseThreadAndWait(
+      [connection = std::move(serverConnection)] {});
+}
+
+} // namespace tests
+} // namespace rsocket
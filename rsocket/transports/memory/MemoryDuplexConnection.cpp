@@ -0,0 +1,266 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/memory/MemoryDuplexConnection.h"
+
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+/// State shared by the two ends of a MemoryDuplexConnection pair.
+class MemoryChannel : public std::enable_shared_from_this<MemoryChannel> {
+ public:
+  MemoryChannel(folly::EventBase& first, folly::EventBase& second)
+      : first_(first), second_(second) {}
+
+  void send(size_t from, std::unique_ptr<folly::IOBuf> frame) {
+    auto const to = 1 - from;
+    auto& peer = side(to);
+    {
+      std::lock_guard<std::mutex> lock(peer.mutex);
+      if (peer.readerClosed) {
+        return;
+      }
+      peer.inbox.push_back(std::move(frame));
+      if (peer.deliveryScheduled) {
+        return;
+      }
+      peer.deliveryScheduled = true;
+    }
+    scheduleDelivery(to);
+  }
+
+  void setInput(
+      size_t index,
+      std::shared_ptr<DuplexConnection::Subscriber> subscriber) {
+    auto& self = side(index);
+    DCHECK(self.evb.isInEventBaseThread());
+
+    if (subscriber && self.closed) {
+      subscriber->onComplete();
+      return;
+    }
+
+    if (!subscriber) {
+      self.subscriber = nullptr;
+      return;
+    }
+
+    CHECK(!self.subscriber);
+    self.subscriber = std::move(subscriber);
+    self.takesBatches = dynamic_cast<DuplexConnection::BatchSubscriber*>(
+                            self.subscriber.get()) != nullptr;
+
+    // Frames that arrived while nobody was reading are still queued.
+    {
+      std::lock_guard<std::mutex> lock(self.mutex);
+      if (self.deliveryScheduled ||
+          (self.inbox.empty() && !self.writerClosed)) {
+        return;
+      }
+      self.deliveryScheduled = true;
+    }
+    scheduleDelivery(index);
+  }
+
+  void close(size_t index) {
+    auto& self = side(index);
+    DCHECK(self.evb.isInEventBaseThread());
+    if (self.closed) {
+      return;
+    }
+    self.closed = true;
+
+    {
+      std::lock_guard<std::mutex> lock(self.mutex);
+      self.readerClosed = true;
+      self.inbox.clear();
+    }
+
+    // The peer completes once it has read everything sent before this.
+    auto const to = 1 - index;
+    auto& peer = side(to);
+    bool schedule = false;
+    {
+      std::lock_guard<std::mutex> lock(peer.mutex);
+      peer.writerClosed = true;
+      if (!peer.readerClosed && !peer.deliveryScheduled) {
+        peer.deliveryScheduled = true;
+        schedule = true;
+      }
+    }
+    if (schedule) {
+      scheduleDelivery(to);
+    }
+
+    if (auto subscriber = std::move(self.subscriber)) {
+      subscriber->onComplete();
+    }
+  }
+
+ private:
+  struct Side {
+    explicit Side(folly::EventBase& eventBase) : evb(eventBase) {}
+
+    folly::EventBase& evb;
+
+    /// Guards the members below, which the peer touches from its thread.
+    std::mutex mutex;
+    std::vector<std::unique_ptr<folly::IOBuf>> inbox;
+    bool deliveryScheduled{false};
+    bool readerClosed{false};
+    bool writerClosed{false};
+
+    /// Only touched from `evb`.
+    std::shared_ptr<DuplexConnection::Subscriber> subscriber;
+    bool takesBatches{false};
+    bool closed{false};
+  };
+
+  Side& side(size_t index) {
+    return index == 0 ? first_ : second_;
+  }
+
+  void scheduleDelivery(size_t index) {
+    auto& evb = side(index).evb;
+    auto deliver = [self = shared_from_this(), index] {
+      self->deliver(index);
+    };
+    if (evb.isInEventBaseThread()) {
+      // Sent from the same EventBase: deliver everything sent during this
+      // loop iteration together, and never re-enter the sender.
+      evb.runInLoop(std::move(deliver));
+    } else {
+      evb.runInEventBaseThread(std::move(deliver));
+    }
+  }
+
+  void deliver(size_t index) {
+    auto& self = side(index);
+    if (!self.subscriber) {
+      std::lock_guard<std::mutex> lock(self.mutex);
+      self.deliveryScheduled = false;
+      return;
+    }
+
+    std::vector<std::unique_ptr<folly::IOBuf>> frames;
+    bool writerClosed;
+    {
+      std::lock_guard<std::mutex> lock(self.mutex);
+      frames.swap(self.inbox);
+      self.deliveryScheduled = false;
+      writerClosed = self.writerClosed;
+    }
+
+    auto const subscriber = self.subscriber;
+    if (frames.size() > 1 && self.takesBatches) {
+      static_cast<DuplexConnection::BatchSubscriber&>(*subscriber)
+          .onNextBatch(std::move(frames));
+    } else {
+      for (auto& frame : frames) {
+        if (self.subscriber != subscriber) {
+          break;
+        }
+        subscriber->onNext(std::move(frame));
+      }
+    }
+
+    if (writerClosed && self.subscriber == subscriber) {
+      self.subscriber = nullptr;
+      subscriber->onComplete();
+    }
+  }
+
+  Side first_;
+  Side second_;
+};
+
+namespace {
+
+class MemoryInputSubscription : public Subscription {
+ public:
+  MemoryInputSubscription(std::shared_ptr<MemoryChannel> channel, size_t side)
+      : channel_(std::move(channel)), side_(side) {
+    CHECK(channel_);
+  }
+
+  void request(int64_t n) noexcept override {
+    DCHECK(channel_);
+    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
+        << "MemoryDuplexConnection doesnt support proper flow control";
+  }
+
+  void cancel() noexcept override {
+    channel_->setInput(side_, nullptr);
+    channel_ = nullptr;
+  }
+
+ private:
+  std::shared_ptr<MemoryChannel> channel_;
+  const size_t side_;
+};
+
+} // namespace
+
+MemoryDuplexConnection::Pair MemoryDuplexConnection::makePair(
+    folly::EventBase& first,
+    folly::EventBase& second,
+    std::shared_ptr<RSocketStats> stats) {
+  auto channel = std::make_shared<MemoryChannel>(first, second);
+  return Pair(
+      std::unique_ptr<MemoryDuplexConnection>(
+          new MemoryDuplexConnection(channel, 0, stats)),
+      std::unique_ptr<MemoryDuplexConnection>(
+          new MemoryDuplexConnection(channel, 1, stats)));
+}
+
+MemoryDuplexConnection::MemoryDuplexConnection(
+    std::shared_ptr<MemoryChannel> channel,
+    size_t side,
+    std::shared_ptr<RSocketStats> stats)
+    : channel_(std::move(channel)), side_(side), stats_(std::move(stats)) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("memory", this);
+  }
+}
+
+MemoryDuplexConnection::~MemoryDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("memory", this);
+  }
+  channel_->close(side_);
+}
+
+void MemoryDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  channel_->send(side_, std::move(buf));
+}
+
+void MemoryDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  // we don't care if the subscriber will call request synchronously
+  inputSubscriber->onSubscribe(
+      std::make_shared<MemoryInputSubscription>(channel_, side_));
+  channel_->setInput(side_, std::move(inputSubscriber));
+}
+
+} // namespace rsocket
@@ -0,0 +1,76 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class MemoryChannel;
+
+/// DuplexConnection to a peer in the same process.
+///
+/// Frames are handed to the peer as the IOBufs they were sent as, without any
+/// copy or syscall, so RSocket can be measured with nothing but its own
+/// overhead.  The connection is framed, so RSocket does not put a
+/// FramedDuplexConnection in front of it.
+///
+/// Frames sent during an EventBase loop iteration are delivered together: at
+/// the end of the iteration if both peers share an EventBase, or in a single
+/// callback on the peer's EventBase otherwise.
+class MemoryDuplexConnection : public DuplexConnection {
+ public:
+  using Pair = std::pair<
+      std::unique_ptr<MemoryDuplexConnection>,
+      std::unique_ptr<MemoryDuplexConnection>>;
+
+  /// Create two connections talking to each other, driven by `first` and
+  /// `second` respectively, which can be the same EventBase.  Each connection
+  /// must only be used and destroyed on its EventBase's thread.
+  static Pair makePair(
+      folly::EventBase& first,
+      folly::EventBase& second,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+
+  ~MemoryDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  bool isFramed() const override {
+    return true;
+  }
+
+ private:
+  MemoryDuplexConnection(
+      std::shared_ptr<MemoryChannel> channel,
+      size_t side,
+      std::shared_ptr<RSocketStats> stats);
+
+  const std::shared_ptr<MemoryChannel> channel_;
+  const size_t side_;
+  const std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
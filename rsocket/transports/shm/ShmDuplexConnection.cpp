@@ -0,0 +1,544 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmDuplexConnection.h"
+
+#include <folly/Exception.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/Format.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "rsocket/transports/shm/ShmRing.h"
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+namespace {
+
+folly::File makeEventFd() {
+  auto const fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  folly::checkUnixError(fd, "eventfd() failed");
+  return folly::File(fd, true);
+}
+
+void signal(const folly::File& eventFd) {
+  uint64_t const one = 1;
+  while (::write(eventFd.fd(), &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+}
+
+void drain(int eventFd) {
+  uint64_t count;
+  while (::read(eventFd, &count, sizeof(count)) < 0 && errno == EINTR) {
+  }
+}
+
+/// Shared memory holding the two rings of a channel, mapped for as long as
+/// this is alive.
+class Mapping {
+ public:
+  explicit Mapping(const folly::File& file) {
+    struct stat st;
+    folly::checkUnixError(::fstat(file.fd(), &st), "fstat() failed");
+    size_ = static_cast<size_t>(st.st_size);
+    base_ = ::mmap(
+        nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd(), 0);
+    if (base_ == MAP_FAILED) {
+      folly::throwSystemError("mmap() failed");
+    }
+  }
+
+  ~Mapping() {
+    ::munmap(base_, size_);
+  }
+
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  /// Memory of ring `index`.
+  void* ring(size_t index) const {
+    return static_cast<uint8_t*>(base_) + index * ringSize();
+  }
+
+  /// Bytes of memory available to each ring.
+  size_t ringSize() const {
+    return size_ / 2;
+  }
+
+ private:
+  void* base_;
+  size_t size_;
+};
+
+} // namespace
+
+class ShmReaderWriter {
+  friend void intrusive_ptr_add_ref(ShmReaderWriter* x);
+  friend void intrusive_ptr_release(ShmReaderWriter* x);
+
+ public:
+  ShmReaderWriter(
+      ShmDuplexConnection::Endpoint endpoint,
+      folly::EventBase& evb,
+      ShmDuplexConnection::Options options,
+      std::shared_ptr<RSocketStats> stats)
+      : options_(std::move(options)),
+        stats_(std::move(stats)),
+        endpoint_(std::move(endpoint)),
+        txIndex_(endpoint_.side),
+        rxIndex_(1 - endpoint_.side),
+        mapping_(endpoint_.memory),
+        tx_(ShmRing::attach(mapping_.ring(txIndex_), mapping_.ringSize())),
+        rx_(ShmRing::attach(mapping_.ring(rxIndex_), mapping_.ringSize())),
+        dataWaiter_(*this, evb, endpoint_.dataReady[rxIndex_]),
+        spaceWaiter_(*this, evb, endpoint_.spaceReady[txIndex_]),
+        readCallback_(*this, evb),
+        publishCallback_(*this, evb) {
+    DCHECK_LE(endpoint_.side, 1u);
+    DCHECK_GT(options_.maxFramesPerLoop, 0u);
+  }
+
+  ~ShmReaderWriter() {
+    DCHECK(!inputSubscriber_);
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      dataWaiter_.unwatch();
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+    takesBatches_ = dynamic_cast<DuplexConnection::BatchSubscriber*>(
+                        inputSubscriber_.get()) != nullptr;
+
+    // Frames may have been published while nobody was reading, without a
+    // wakeup since we were not parked.
+    dataWaiter_.watch();
+    readCallback_.schedule();
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> frame) {
+    if (isClosed() || tx_.isConsumerClosed()) {
+      return;
+    }
+
+    auto const length = frame->computeChainDataLength();
+    if (length > tx_.maxFrameSize()) {
+      closeErr(folly::exception_wrapper{std::length_error(folly::sformat(
+          "Frame of {} bytes does not fit in a ring of {} bytes",
+          length,
+          tx_.maxFrameSize()))});
+      return;
+    }
+
+    if (pending_.empty() && tx_.tryWrite(*frame)) {
+      onWritten(length);
+      publishCallback_.schedule();
+      return;
+    }
+
+    pending_.push_back(std::move(frame));
+    if (pending_.size() == 1) {
+      writePending();
+    }
+  }
+
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+
+    // Frames sent before a clean close must still reach the peer, so the
+    // ring is only closed once pending frames have been written.
+    publishWrites();
+    if (pending_.empty()) {
+      closeTx();
+    }
+    closeRx();
+
+    auto subscriber = std::move(inputSubscriber_);
+    dataWaiter_.unwatch();
+    if (subscriber) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    pending_.clear();
+    if (!isClosed()) {
+      closed_ = true;
+      closeTx();
+      closeRx();
+    }
+
+    auto subscriber = std::move(inputSubscriber_);
+    dataWaiter_.unwatch();
+    spaceWaiter_.unwatch();
+    if (subscriber) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  /// Watches an eventfd and calls a ShmReaderWriter member function when it
+  /// is signalled.  Holds a reference to the owner while watching.
+  template <void (ShmReaderWriter::*Fn)()>
+  class Waiter : public folly::EventHandler {
+   public:
+    Waiter(
+        ShmReaderWriter& owner,
+        folly::EventBase& evb,
+        const folly::File& eventFd)
+        : folly::EventHandler(
+              &evb,
+              folly::NetworkSocket::fromFd(eventFd.fd())),
+          owner_(owner),
+          fd_(eventFd.fd()) {}
+
+    void watch() {
+      if (!isHandlerRegistered()) {
+        intrusive_ptr_add_ref(&owner_);
+        CHECK(registerHandler(READ | PERSIST));
+      }
+    }
+
+    void unwatch() {
+      if (isHandlerRegistered()) {
+        unregisterHandler();
+        // May destroy the owner, and this with it.
+        intrusive_ptr_release(&owner_);
+      }
+    }
+
+   private:
+    void handlerReady(uint16_t) noexcept override {
+      boost::intrusive_ptr<ShmReaderWriter> self(&owner_);
+      drain(fd_);
+      (owner_.*Fn)();
+    }
+
+    ShmReaderWriter& owner_;
+    const int fd_;
+  };
+
+  /// Calls a ShmReaderWriter member function at the end of the current
+  /// EventBase loop iteration.  Holds a reference to the owner until then.
+  template <void (ShmReaderWriter::*Fn)()>
+  class Deferred : public folly::EventBase::LoopCallback {
+   public:
+    Deferred(ShmReaderWriter& owner, folly::EventBase& evb)
+        : owner_(owner), evb_(evb) {}
+
+    void schedule() {
+      if (!isLoopCallbackScheduled()) {
+        intrusive_ptr_add_ref(&owner_);
+        evb_.runInLoop(this);
+      }
+    }
+
+   private:
+    void runLoopCallback() noexcept override {
+      boost::intrusive_ptr<ShmReaderWriter> self(&owner_, false);
+      (owner_.*Fn)();
+    }
+
+    ShmReaderWriter& owner_;
+    folly::EventBase& evb_;
+  };
+
+  bool isClosed() const {
+    return closed_;
+  }
+
+  void readFrames() {
+    if (!inputSubscriber_ || isClosed()) {
+      return;
+    }
+
+    size_t bytes = 0;
+    while (batch_.size() < options_.maxFramesPerLoop) {
+      auto frame = rx_.read();
+      if (!frame) {
+        break;
+      }
+      bytes += frame->length();
+      batch_.push_back(std::move(frame));
+    }
+    if (rx_.releaseReads()) {
+      signal(endpoint_.spaceReady[rxIndex_]);
+    }
+
+    auto const more = batch_.size() == options_.maxFramesPerLoop;
+    if (bytes > 0 && stats_) {
+      stats_->bytesRead(bytes);
+    }
+    deliverBatch();
+
+    if (!inputSubscriber_ || isClosed()) {
+      return;
+    }
+    if (rx_.isCorrupt()) {
+      closeErr(folly::exception_wrapper{
+          std::runtime_error("Corrupt frame in the shared memory ring")});
+      return;
+    }
+    if (more) {
+      // Let other work on the EventBase run before reading on.
+      readCallback_.schedule();
+    } else if (!rx_.parkConsumer()) {
+      if (rx_.isProducerDone()) {
+        close();
+      } else {
+        readCallback_.schedule();
+      }
+    }
+  }
+
+  void deliverBatch() {
+    auto const subscriber = inputSubscriber_;
+    if (batch_.size() > 1 && takesBatches_) {
+      static_cast<DuplexConnection::BatchSubscriber&>(*subscriber)
+          .onNextBatch(std::move(batch_));
+    } else {
+      for (auto& frame : batch_) {
+        if (!inputSubscriber_) {
+          break;
+        }
+        subscriber->onNext(std::move(frame));
+      }
+    }
+    batch_.clear();
+  }
+
+  void writePending() {
+    while (!pending_.empty()) {
+      if (tx_.isConsumerClosed()) {
+        pending_.clear();
+        break;
+      }
+
+      auto const length = pending_.front()->computeChainDataLength();
+      if (tx_.tryWrite(*pending_.front())) {
+        onWritten(length);
+        pending_.pop_front();
+        continue;
+      }
+
+      // Let the consumer at what is in the ring before waiting for room.
+      publishWrites();
+      if (tx_.parkProducer(length)) {
+        spaceWaiter_.watch();
+        return;
+      }
+    }
+
+    publishWrites();
+    if (isClosed()) {
+      closeTx();
+    }
+    spaceWaiter_.unwatch();
+  }
+
+  void onWritten(size_t length) {
+    ++unpublishedFrames_;
+    unpublishedBytes_ += length;
+  }
+
+  void publishWrites() {
+    if (unpublishedFrames_ == 0) {
+      return;
+    }
+    if (stats_) {
+      stats_->bytesWritten(unpublishedBytes_);
+      stats_->framesFlushed(unpublishedFrames_, unpublishedBytes_);
+    }
+    unpublishedFrames_ = 0;
+    unpublishedBytes_ = 0;
+    if (tx_.publishWrites()) {
+      signal(endpoint_.dataReady[txIndex_]);
+    }
+  }
+
+  void closeTx() {
+    if (tx_.closeProducer()) {
+      signal(endpoint_.dataReady[txIndex_]);
+    }
+  }
+
+  void closeRx() {
+    if (rx_.closeConsumer()) {
+      signal(endpoint_.spaceReady[rxIndex_]);
+    }
+  }
+
+  const ShmDuplexConnection::Options options_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  const ShmDuplexConnection::Endpoint endpoint_;
+  const size_t txIndex_;
+  const size_t rxIndex_;
+  const Mapping mapping_;
+  ShmRing tx_;
+  ShmRing rx_;
+
+  Waiter<&ShmReaderWriter::readFrames> dataWaiter_;
+  Waiter<&ShmReaderWriter::writePending> spaceWaiter_;
+  Deferred<&ShmReaderWriter::readFrames> readCallback_;
+  Deferred<&ShmReaderWriter::publishWrites> publishCallback_;
+
+  /// Frames read during the current pass, to be delivered together.
+  std::vector<std::unique_ptr<folly::IOBuf>> batch_;
+
+  /// Frames that did not fit in the ring, waiting for the consumer.
+  std::deque<std::unique_ptr<folly::IOBuf>> pending_;
+
+  /// Frames written to the ring but not published yet.
+  size_t unpublishedFrames_{0};
+  size_t unpublishedBytes_{0};
+
+  bool closed_{false};
+  bool takesBatches_{false};
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(ShmReaderWriter* x);
+void intrusive_ptr_release(ShmReaderWriter* x);
+
+inline void intrusive_ptr_add_ref(ShmReaderWriter* x) {
+  ++x->refCount_;
+}
+
+inline void intrusive_ptr_release(ShmReaderWriter* x) {
+  if (--x->refCount_ == 0)
+    delete x;
+}
+
+namespace {
+
+class ShmInputSubscription : public Subscription {
+ public:
+  explicit ShmInputSubscription(
+      boost::intrusive_ptr<ShmReaderWriter> readerWriter)
+      : readerWriter_(std::move(readerWriter)) {
+    CHECK(readerWriter_);
+  }
+
+  void request(int64_t n) noexcept override {
+    DCHECK(readerWriter_);
+    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
+        << "ShmDuplexConnection doesnt support proper flow control";
+  }
+
+  void cancel() noexcept override {
+    readerWriter_->setInput(nullptr);
+    readerWriter_ = nullptr;
+  }
+
+ private:
+  boost::intrusive_ptr<ShmReaderWriter> readerWriter_;
+};
+
+} // namespace
+
+std::pair<ShmDuplexConnection::Endpoint, ShmDuplexConnection::Endpoint>
+ShmDuplexConnection::createChannel(const Options& options) {
+  auto const ringSize = ShmRing::sizeFor(options.ringCapacity);
+
+  auto const fd = ::memfd_create("rsocket-shm", MFD_CLOEXEC);
+  folly::checkUnixError(fd, "memfd_create() failed");
+  folly::File memory(fd, true);
+  folly::checkUnixError(
+      ::ftruncate(memory.fd(), 2 * ringSize), "ftruncate() failed");
+  {
+    Mapping mapping(memory);
+    ShmRing::create(mapping.ring(0), options.ringCapacity);
+    ShmRing::create(mapping.ring(1), options.ringCapacity);
+  }
+
+  Endpoint first;
+  Endpoint second;
+  for (size_t i = 0; i < 2; ++i) {
+    first.dataReady[i] = makeEventFd();
+    first.spaceReady[i] = makeEventFd();
+    second.dataReady[i] = first.dataReady[i].dup();
+    second.spaceReady[i] = first.spaceReady[i].dup();
+  }
+  second.memory = memory.dup();
+  first.memory = std::move(memory);
+  first.side = 0;
+  second.side = 1;
+  return std::make_pair(std::move(first), std::move(second));
+}
+
+ShmDuplexConnection::ShmDuplexConnection(
+    Endpoint endpoint,
+    folly::EventBase& evb,
+    Options options,
+    std::shared_ptr<RSocketStats> stats)
+    : readerWriter_(new ShmReaderWriter(
+          std::move(endpoint),
+          evb,
+          std::move(options),
+          stats)),
+      stats_(stats) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("shm", this);
+  }
+}
+
+ShmDuplexConnection::~ShmDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("shm", this);
+  }
+  readerWriter_->close();
+}
+
+void ShmDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  if (readerWriter_) {
+    readerWriter_->send(std::move(buf));
+  }
+}
+
+void ShmDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  // we don't care if the subscriber will call request synchronously
+  inputSubscriber->onSubscribe(
+      std::make_shared<ShmInputSubscription>(readerWriter_));
+  readerWriter_->setInput(std::move(inputSubscriber));
+}
+
+} // namespace rsocket
@@ -0,0 +1,99 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <folly/File.h>
+
+#include <array>
+#include <utility>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class ShmReaderWriter;
+
+/// DuplexConnection exchanging frames through a pair of ShmRings, one per
+/// direction, in a shared memory segment.
+///
+/// Frames keep their boundaries in the rings, so the connection is framed
+/// and RSocket hands frames to it without a FramedDuplexConnection in front.
+/// Frames sent during an EventBase loop iteration are published together at
+/// its end.  A side that runs out of work parks on an eventfd, and is only
+/// signalled when it is parked, so two busy peers exchange frames without any
+/// syscalls.
+///
+/// The peers can live in different processes: pass the files of an Endpoint
+/// over a Unix domain socket with SCM_RIGHTS, or through fork().  A peer
+/// process dying is not detected; it looks like a peer that went quiet.
+class ShmDuplexConnection : public DuplexConnection {
+ public:
+  struct Options {
+    /// Bytes of frame storage in each direction.  Must be a power of two, and
+    /// bounds the largest frame that can be sent.
+    size_t ringCapacity{1 << 20};
+
+    /// Frames delivered per EventBase loop iteration, before yielding to
+    /// other work on the EventBase.
+    size_t maxFramesPerLoop{64};
+  };
+
+  /// Everything one side needs to attach to a channel.
+  struct Endpoint {
+    /// The shared memory, holding both rings.
+    folly::File memory;
+
+    /// eventfds signalled when ring i has frames to read, and when ring i has
+    /// room to write again.
+    std::array<folly::File, 2> dataReady;
+    std::array<folly::File, 2> spaceReady;
+
+    /// This side writes ring `side` and reads the other one.
+    size_t side{0};
+  };
+
+  /// Create the shared memory and eventfds for a new channel, and return its
+  /// two ends.
+  static std::pair<Endpoint, Endpoint> createChannel(
+      const Options& options = Options());
+
+  /// Must be created, used and destroyed on the `evb` thread.
+  ShmDuplexConnection(
+      Endpoint endpoint,
+      folly::EventBase& evb,
+      Options options = Options(),
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  ~ShmDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  bool isFramed() const override {
+    return true;
+  }
+
+ private:
+  boost::intrusive_ptr<ShmReaderWriter> readerWriter_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,257 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/shm/ShmRing.h"
+
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+namespace rsocket {
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+constexpr size_t kRecordAlignment = 8;
+constexpr uint64_t kMagic = 0x7273636b72696e67; // "rsckring"
+
+size_t recordSize(size_t frameLength) {
+  return (sizeof(uint32_t) + frameLength + kRecordAlignment - 1) &
+      ~(kRecordAlignment - 1);
+}
+
+} // namespace
+
+/// Lives at the start of the shared memory.  Only lock-free atomics are used,
+/// so the same layout works across processes.
+struct ShmRing::Header {
+  uint64_t magic{kMagic};
+  uint64_t capacity{0};
+
+  // Written by the producer, except producerParked which the consumer clears
+  // when it wakes the producer up.
+  alignas(kCacheLine) std::atomic<uint64_t> head{0};
+  std::atomic<uint32_t> producerParked{0};
+  std::atomic<uint32_t> producerClosed{0};
+
+  // Written by the consumer, except consumerParked which the producer clears
+  // when it wakes the consumer up.
+  alignas(kCacheLine) std::atomic<uint64_t> tail{0};
+  std::atomic<uint32_t> consumerParked{0};
+  std::atomic<uint32_t> consumerClosed{0};
+};
+
+size_t ShmRing::sizeFor(size_t capacity) {
+  static_assert(
+      sizeof(Header) % kCacheLine == 0,
+      "Frame storage must start on a cache line");
+  DCHECK(folly::isPowTwo(capacity));
+  return sizeof(Header) + capacity;
+}
+
+ShmRing ShmRing::create(void* memory, size_t capacity) {
+  CHECK(folly::isPowTwo(capacity));
+  CHECK_GE(capacity, kCacheLine);
+  CHECK_EQ(reinterpret_cast<uintptr_t>(memory) % kCacheLine, 0u);
+
+  auto const header = new (memory) Header();
+  CHECK(header->head.is_lock_free() && header->producerParked.is_lock_free());
+  header->capacity = capacity;
+  return ShmRing(header, capacity);
+}
+
+ShmRing ShmRing::attach(void* memory, size_t size) {
+  if (size < sizeof(Header) ||
+      reinterpret_cast<uintptr_t>(memory) % kCacheLine != 0) {
+    throw std::runtime_error("Shared memory cannot hold a ShmRing");
+  }
+  auto const header = static_cast<Header*>(memory);
+  if (header->magic != kMagic) {
+    throw std::runtime_error("Not a ShmRing");
+  }
+  // The header is written by the peer, so read the capacity once and never
+  // trust it beyond the memory we were given.
+  auto const capacity = header->capacity;
+  if (!folly::isPowTwo(capacity) || capacity < kCacheLine ||
+      capacity > size - sizeof(Header)) {
+    throw std::runtime_error("ShmRing capacity does not fit its memory");
+  }
+  return ShmRing(header, static_cast<size_t>(capacity));
+}
+
+ShmRing::ShmRing(Header* header, size_t capacity)
+    : header_(header),
+      data_(reinterpret_cast<uint8_t*>(header + 1)),
+      capacity_(capacity),
+      mask_(capacity - 1),
+      head_(header->head.load(std::memory_order_acquire)),
+      publishedHead_(head_),
+      cachedTail_(header->tail.load(std::memory_order_acquire)),
+      tail_(cachedTail_),
+      releasedTail_(tail_),
+      cachedHead_(head_) {}
+
+size_t ShmRing::maxFrameSize() const {
+  return std::min<size_t>(
+      capacity_ - sizeof(uint32_t), std::numeric_limits<uint32_t>::max());
+}
+
+bool ShmRing::hasRoom(size_t size) {
+  if (head_ + size - cachedTail_ <= capacity_) {
+    return true;
+  }
+  cachedTail_ = header_->tail.load(std::memory_order_seq_cst);
+  return head_ + size - cachedTail_ <= capacity_;
+}
+
+bool ShmRing::tryWrite(const folly::IOBuf& frame) {
+  auto const length = frame.computeChainDataLength();
+  DCHECK_LE(length, maxFrameSize());
+  auto const size = recordSize(length);
+  if (!hasRoom(size)) {
+    return false;
+  }
+
+  // Records are aligned, so the length prefix itself never wraps.
+  auto const prefix = static_cast<uint32_t>(length);
+  std::memcpy(data_ + (head_ & mask_), &prefix, sizeof(prefix));
+  auto position = head_ + sizeof(prefix);
+  for (auto const range : frame) {
+    copyIn(position, range.data(), range.size());
+    position += range.size();
+  }
+  head_ += size;
+  return true;
+}
+
+bool ShmRing::publishWrites() {
+  if (head_ == publishedHead_) {
+    return false;
+  }
+  publishedHead_ = head_;
+  // Sequentially consistent, like the consumer's parking below: either it
+  // sees the new head before it parks, or we see it parked.
+  header_->head.store(head_, std::memory_order_seq_cst);
+  return header_->consumerParked.load(std::memory_order_seq_cst) &&
+      header_->consumerParked.exchange(0) == 1;
+}
+
+bool ShmRing::parkProducer(size_t frameLength) {
+  header_->producerParked.store(1, std::memory_order_seq_cst);
+  if (hasRoom(recordSize(frameLength)) || isConsumerClosed()) {
+    header_->producerParked.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::closeProducer() {
+  publishWrites();
+  header_->producerClosed.store(1, std::memory_order_seq_cst);
+  return header_->consumerParked.exchange(0) == 1;
+}
+
+bool ShmRing::isConsumerClosed() const {
+  return header_->consumerClosed.load(std::memory_order_acquire);
+}
+
+std::unique_ptr<folly::IOBuf> ShmRing::read() {
+  if (corrupt_) {
+    return nullptr;
+  }
+  if (tail_ == cachedHead_) {
+    cachedHead_ = header_->head.load(std::memory_order_acquire);
+    if (tail_ == cachedHead_) {
+      return nullptr;
+    }
+  }
+
+  // The producer may live in another process, so neither its position nor
+  // the length prefix is trusted: the record must lie within what has been
+  // published, or copyOut() would read past it.
+  auto const available = cachedHead_ - tail_;
+  if (available > capacity_ || available % kRecordAlignment != 0) {
+    corrupt_ = true;
+    return nullptr;
+  }
+  uint32_t length;
+  std::memcpy(&length, data_ + (tail_ & mask_), sizeof(length));
+  if (length > maxFrameSize() || recordSize(length) > available) {
+    corrupt_ = true;
+    return nullptr;
+  }
+
+  auto frame = folly::IOBuf::create(length);
+  copyOut(tail_ + sizeof(length), frame->writableData(), length);
+  frame->append(length);
+  tail_ += recordSize(length);
+  return frame;
+}
+
+bool ShmRing::isCorrupt() const {
+  return corrupt_;
+}
+
+bool ShmRing::releaseReads() {
+  if (tail_ == releasedTail_) {
+    return false;
+  }
+  releasedTail_ = tail_;
+  header_->tail.store(tail_, std::memory_order_seq_cst);
+  return header_->producerParked.load(std::memory_order_seq_cst) &&
+      header_->producerParked.exchange(0) == 1;
+}
+
+bool ShmRing::parkConsumer() {
+  header_->consumerParked.store(1, std::memory_order_seq_cst);
+  cachedHead_ = header_->head.load(std::memory_order_seq_cst);
+  if (cachedHead_ != tail_ ||
+      header_->producerClosed.load(std::memory_order_seq_cst)) {
+    header_->consumerParked.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool ShmRing::closeConsumer() {
+  header_->consumerClosed.store(1, std::memory_order_seq_cst);
+  return header_->producerParked.exchange(0) == 1;
+}
+
+bool ShmRing::isProducerDone() const {
+  return header_->producerClosed.load(std::memory_order_acquire) &&
+      header_->head.load(std::memory_order_acquire) == tail_;
+}
+
+void ShmRing::copyIn(uint64_t position, const uint8_t* data, size_t length) {
+  auto const offset = position & mask_;
+  auto const first = std::min<size_t>(length, capacity_ - offset);
+  std::memcpy(data_ + offset, data, first);
+  std::memcpy(data_, data + first, length - first);
+}
+
+void ShmRing::copyOut(uint64_t position, uint8_t* data, size_t length) const {
+  auto const offset = position & mask_;
+  auto const first = std::min<size_t>(length, capacity_ - offset);
+  std::memcpy(data, data_ + offset, first);
+  std::memcpy(data + first, data_, length - first);
+}
+
+} // namespace rsocket
@@ -0,0 +1,135 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace rsocket {
+
+/// Single-producer single-consumer queue of frames, laid out in memory that
+/// can be shared between threads or processes.
+///
+/// Frames are stored back to back as a 32-bit length followed by the frame's
+/// bytes, padded to 8 bytes, and wrap around the end of the buffer.  The
+/// producer and the consumer each advance a local position and only publish
+/// it to the other side when asked to, so a whole batch of frames costs one
+/// cache line transfer.
+///
+/// Either side can park when it cannot make progress: the consumer when the
+/// ring is empty, the producer when a frame does not fit.  Publishing tells
+/// the caller whether the other side was parked and needs a wakeup; while
+/// nobody is parked no wakeups are needed at all.
+///
+/// A ShmRing is only a view of the shared memory, which the caller owns.
+class ShmRing {
+ public:
+  /// Bytes of shared memory needed for a ring storing up to `capacity` bytes
+  /// of frames.  `capacity` must be a power of two.
+  static size_t sizeFor(size_t capacity);
+
+  /// Lay out an empty ring in `memory`, which must be sizeFor(capacity) bytes
+  /// long and aligned to a cache line.
+  static ShmRing create(void* memory, size_t capacity);
+
+  /// Attach to a ring laid out by create(), possibly in another process.
+  /// `size` is the number of bytes available at `memory`.  Throws
+  /// std::runtime_error if the memory does not hold a ring fitting in them.
+  static ShmRing attach(void* memory, size_t size);
+
+  // Producer side.
+
+  /// Largest frame that fits in the ring.
+  size_t maxFrameSize() const;
+
+  /// Copy `frame` into the ring, or return false if there is no room for it
+  /// yet.  The frame is not visible to the consumer until publishWrites().
+  bool tryWrite(const folly::IOBuf& frame);
+
+  /// Make written frames visible to the consumer.  Returns true if the
+  /// consumer was parked and must be woken up.
+  bool publishWrites();
+
+  /// Park the producer until the consumer frees enough room for a frame of
+  /// `frameLength` bytes.  Returns false, without parking, if there is room
+  /// already or the consumer is gone.
+  bool parkProducer(size_t frameLength);
+
+  /// Publish written frames and tell the consumer no more are coming.
+  /// Returns true if the consumer was parked and must be woken up.
+  bool closeProducer();
+
+  /// Whether the consumer has gone away.  Frames written from now on are
+  /// never read.
+  bool isConsumerClosed() const;
+
+  // Consumer side.
+
+  /// Next published frame, or nullptr if there is none or the ring is
+  /// corrupt.  The frame's space is not handed back to the producer until
+  /// releaseReads().
+  std::unique_ptr<folly::IOBuf> read();
+
+  /// Whether read() found a record that cannot have been written by a
+  /// well-behaved producer.  Nothing more is read from a corrupt ring.
+  bool isCorrupt() const;
+
+  /// Hand the space of the frames read so far back to the producer.  Returns
+  /// true if the producer was parked and must be woken up.
+  bool releaseReads();
+
+  /// Park the consumer until more frames are published.  Returns false,
+  /// without parking, if there are frames to read or the producer is done.
+  bool parkConsumer();
+
+  /// Tell the producer that nothing it writes will be read anymore.  Returns
+  /// true if the producer was parked and must be woken up.
+  bool closeConsumer();
+
+  /// Whether the producer has closed and every frame it wrote has been read.
+  bool isProducerDone() const;
+
+ private:
+  struct Header;
+
+  ShmRing(Header* header, size_t capacity);
+
+  bool hasRoom(size_t recordSize);
+  void copyIn(uint64_t position, const uint8_t* data, size_t length);
+  void copyOut(uint64_t position, uint8_t* data, size_t length) const;
+
+  Header* header_;
+  uint8_t* data_;
+  size_t capacity_;
+  uint64_t mask_;
+
+  /// Producer state: next write position, last published position, and the
+  /// consumer's position as last seen.
+  uint64_t head_;
+  uint64_t publishedHead_;
+  uint64_t cachedTail_;
+
+  /// Consumer state: next read position, last released position, and the
+  /// producer's position as last seen.
+  uint64_t tail_;
+  uint64_t releasedTail_;
+  uint64_t cachedHead_;
+  bool corrupt_{false};
+};
+
+} // namespace rsocket
@@ -26,8 +26,16 @@ namespace rsocket {
 class TcpConnectionAcceptor::SocketCallback
     : public folly::AsyncServerSocket::AcceptCallback {
  public:
-  explicit SocketCallback(OnDuplexConnectionAccept& onAccept)
-      : thread_{folly::sformat("rstcp-acceptor")}, onAccept_{onAccept} {}
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      const TcpDuplexConnection::Options& connectionOptions)
+      : thread_{folly::sformat("rstcp-acceptor")},
+        onAccept_{onAccept},
+        connectionOptions_{connectionOptions} {}
+
+  ~SocketCallback() override {
+    stopListening();
+  }
 
   void connectionAccepted(
       folly::NetworkSocket fdNetworkSocket,
@@ -39,7 +47,8 @@ class TcpConnectionAcceptor::SocketCallback
     folly::AsyncTransportWrapper::UniquePtr socket(
         new folly::AsyncSocket(eventBase(), folly::NetworkSocket::fromFd(fd)));
 
-    auto connection = std::make_unique<TcpDuplexConnection>(std::move(socket));
+    auto connection = std::make_unique<TcpDuplexConnection>(
+        std::move(socket), connectionOptions_);
     onAccept_(std::move(connection), *eventBase());
   }
 
@@ -51,19 +60,63 @@ class TcpConnectionAcceptor::SocketCallback
     return thread_.getEventBase();
   }
 
+  /// Open a SO_REUSEPORT listening socket of our own, driven by our thread,
+  /// and accept connections from it directly.  Returns the bound address.
+  folly::SocketAddress listen(
+      const folly::SocketAddress& address,
+      int backlog) {
+    listener_.reset(new folly::AsyncServerSocket(eventBase()));
+
+    // Must be accessed from our thread only.
+    return folly::via(
+               eventBase(),
+               [this, &address, backlog] {
+                 listener_->setReusePortEnabled(true);
+                 listener_->bind(address);
+
+                 // Without an EventBase, the callback is invoked right in the
+                 // listener's thread, which is ours.
+                 listener_->addAcceptCallback(this, nullptr);
+                 listener_->listen(backlog);
+                 listener_->startAccepting();
+                 return listener_->getAddress();
+               })
+        .get();
+  }
+
+  void stopListening() {
+    if (listener_) {
+      eventBase()->runInEventBaseThreadAndWait(
+          [listener = std::move(listener_)]() {});
+    }
+  }
+
+  folly::Optional<uint16_t> listeningPort() const {
+    if (!listener_) {
+      return folly::none;
+    }
+    return listener_->getAddress().getPort();
+  }
+
  private:
   /// The thread running this callback.
   folly::ScopedEventBaseThread thread_;
 
   /// Reference to the ConnectionAcceptor's callback.
   OnDuplexConnectionAccept& onAccept_;
+
+  /// Reference to the ConnectionAcceptor's connection options.
+  const TcpDuplexConnection::Options& connectionOptions_;
+
+  /// Our own listening socket, with `reusePort`.
+  folly::AsyncServerSocket::UniquePtr listener_;
 };
 
 TcpConnectionAcceptor::TcpConnectionAcceptor(Options options)
     : options_(std::move(options)) {}
 
 TcpConnectionAcceptor::~TcpConnectionAcceptor() {
-  if (serverThread_) {
+  if (onAccept_) {
     stop();
     serverThread_.reset();
   }
@@ -75,14 +128,21 @@ void TcpConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
   }
 
   onAccept_ = std::move(onAccept);
-  serverThread_ =
-      std::make_unique<folly::ScopedEventBaseThread>("rstcp-listener");
 
   callbacks_.reserve(options_.threads);
   for (size_t i = 0; i < options_.threads; ++i) {
-    callbacks_.push_back(std::make_unique<SocketCallback>(onAccept_));
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_.connection));
   }
 
+  if (options_.reusePort) {
+    startReusePort();
+    return;
+  }
+
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rstcp-listener");
+
   VLOG(1) << "Starting TCP listener on port " << options_.address.getPort()
           << " with " << options_.threads << " request threads";
 
@@ -107,14 +167,39 @@ void TcpConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
   }).get();
 }
 
+void TcpConnectionAcceptor::startReusePort() {
+  VLOG(1) << "Starting " << options_.threads << " TCP listeners on port "
+          << options_.address.getPort() << " with SO_REUSEPORT";
+
+  auto address = options_.address;
+  for (auto const& callback : callbacks_) {
+    // Every listener after the first must bind to the port the kernel picked
+    // for it, when asked for an ephemeral one.
+    address = callback->listen(address, options_.backlog);
+  }
+
+  VLOG(1) << "Listening on " << address.describe();
+}
+
 void TcpConnectionAcceptor::stop() {
   VLOG(1) << "Shutting down TCP listener";
 
-  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
-      [serverSocket = std::move(serverSocket_)]() {});
+  if (serverThread_) {
+    serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+        [serverSocket = std::move(serverSocket_)]() {});
+  }
+  for (auto const& callback : callbacks_) {
+    callback->stopListening();
+  }
 }
 
 folly::Optional<uint16_t> TcpConnectionAcceptor::listeningPort() const {
+  if (options_.reusePort) {
+    if (callbacks_.empty()) {
+      return folly::none;
+    }
+    return callbacks_.front()->listeningPort();
+  }
   if (!serverSocket_) {
     return folly::none;
   }
@@ -18,6 +18,7 @@
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 namespace rsocket {
 
@@ -36,7 +37,18 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
     size_t threads{2};
 
     /// Number of connections to buffer before accept handlers process them.
+    /// With `reusePort` this applies to each listening socket.
     int backlog{10};
+
+    /// Open one SO_REUSEPORT listening socket per worker thread instead of a
+    /// single one on a dedicated listener thread.  The kernel then spreads
+    /// incoming connections across the workers, and each worker accepts its
+    /// own connections without a cross-thread handoff.  Helps when a large
+    /// number of clients reconnect at once.
+    bool reusePort{false};
+
+    /// Options applied to every accepted TcpDuplexConnection.
+    TcpDuplexConnection::Options connection;
   };
 
   explicit TcpConnectionAcceptor(Options);
@@ -45,7 +57,8 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
   // ConnectionAcceptor overrides.
 
   /**
-   * Bind an AsyncServerSocket and start accepting TCP connections.
+   * Bind an AsyncServerSocket, or one per worker thread with `reusePort`, and
+   * start accepting TCP connections.
    */
   void start(OnDuplexConnectionAccept) override;
 
@@ -62,10 +75,12 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
  private:
   class SocketCallback;
 
+  void startReusePort();
+
   /// Options this acceptor has been configured with.
   const Options options_;
 
-  /// The thread driving the AsyncServerSocket.
+  /// The thread driving the AsyncServerSocket.  Not used with `reusePort`.
   std::unique_ptr<folly::ScopedEventBaseThread> serverThread_;
 
   /// Function to run when a connection is accepted.
@@ -75,7 +90,8 @@ class TcpConnectionAcceptor : public ConnectionAcceptor {
   /// thread.
   std::vector<std::unique_ptr<SocketCallback>> callbacks_;
 
-  /// The socket listening for new connections.
+  /// The socket listening for new connections.  With `reusePort` each
+  /// callback owns its own listening socket instead.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
 };
 
@@ -31,9 +31,12 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
   ConnectCallback(
       folly::SocketAddress address,
       const std::shared_ptr<folly::SSLContext>& sslContext,
+      TcpDuplexConnection::Options connectionOptions,
       folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
           connectPromise)
-      : address_(address), connectPromise_(std::move(connectPromise)) {
+      : address_(address),
+        connectionOptions_(std::move(connectionOptions)),
+        connectPromise_(std::move(connectPromise)) {
     VLOG(2) << "Constructing ConnectCallback";
 
     // Set up by ScopedEventBaseThread.
@@ -69,7 +72,7 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
     VLOG(4) << "connectSuccess() on " << address_;
 
     auto connection = TcpConnectionFactory::createDuplexConnectionFromSocket(
-        std::move(socket_), RSocketStats::noop());
+        std::move(socket_), RSocketStats::noop(), connectionOptions_);
     auto evb = folly::EventBaseManager::get()->getExistingEventBase();
     CHECK(evb);
     connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
@@ -84,6 +87,7 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
 
  private:
   const folly::SocketAddress address_;
+  const TcpDuplexConnection::Options connectionOptions_;
   folly::AsyncSocket::UniquePtr socket_;
   folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
 };
@@ -93,10 +97,12 @@ class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
 TcpConnectionFactory::TcpConnectionFactory(
     folly::EventBase& eventBase,
     folly::SocketAddress address,
-    std::shared_ptr<folly::SSLContext> sslContext)
+    std::shared_ptr<folly::SSLContext> sslContext,
+    TcpDuplexConnection::Options connectionOptions)
     : eventBase_(&eventBase),
       address_(std::move(address)),
-      sslContext_(std::move(sslContext)) {}
+      sslContext_(std::move(sslContext)),
+      connectionOptions_(std::move(connectionOptions)) {}
 
 TcpConnectionFactory::~TcpConnectionFactory() = default;
 
@@ -107,7 +113,8 @@ TcpConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
 
   eventBase_->runInEventBaseThread(
       [this, promise = std::move(connectPromise)]() mutable {
-        new ConnectCallback(address_, sslContext_, std::move(promise));
+        new ConnectCallback(
+            address_, sslContext_, connectionOptions_, std::move(promise));
       });
   return connectFuture;
 }
@@ -115,9 +122,10 @@ TcpConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
 std::unique_ptr<DuplexConnection>
 TcpConnectionFactory::createDuplexConnectionFromSocket(
     folly::AsyncTransportWrapper::UniquePtr socket,
-    std::shared_ptr<RSocketStats> stats) {
+    std::shared_ptr<RSocketStats> stats,
+    TcpDuplexConnection::Options connectionOptions) {
   return std::make_unique<TcpDuplexConnection>(
-      std::move(socket), std::move(stats));
+      std::move(socket), std::move(connectionOptions), std::move(stats));
 }
 
 } // namespace rsocket
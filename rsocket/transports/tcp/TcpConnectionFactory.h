@@ -19,6 +19,7 @@
 
 #include "rsocket/ConnectionFactory.h"
 #include "rsocket/DuplexConnection.h"
+#include "rsocket/transports/tcp/TcpDuplexConnection.h"
 
 namespace folly {
 
@@ -39,7 +40,9 @@ class TcpConnectionFactory : public ConnectionFactory {
   TcpConnectionFactory(
       folly::EventBase& eventBase,
       folly::SocketAddress address,
-      std::shared_ptr<folly::SSLContext> sslContext = nullptr);
+      std::shared_ptr<folly::SSLContext> sslContext = nullptr,
+      TcpDuplexConnection::Options connectionOptions =
+          TcpDuplexConnection::Options());
   virtual ~TcpConnectionFactory();
 
   /**
@@ -53,11 +56,14 @@ class TcpConnectionFactory : public ConnectionFactory {
 
   static std::unique_ptr<DuplexConnection> createDuplexConnectionFromSocket(
       folly::AsyncTransportWrapper::UniquePtr socket,
-      std::shared_ptr<RSocketStats> stats = std::shared_ptr<RSocketStats>());
+      std::shared_ptr<RSocketStats> stats = std::shared_ptr<RSocketStats>(),
+      TcpDuplexConnection::Options connectionOptions =
+          TcpDuplexConnection::Options());
 
  private:
   folly::EventBase* eventBase_;
   const folly::SocketAddress address_;
   std::shared_ptr<folly::SSLContext> sslContext_;
+  const TcpDuplexConnection::Options connectionOptions_;
 };
 } // namespace rsocket
@@ -16,6 +16,9 @@
 
 #include <folly/ExceptionWrapper.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBase.h>
+#include <algorithm>
+#include <utility>
 
 #include "rsocket/internal/Common.h"
 #include "yarpl/flowable/Subscription.h"
@@ -25,15 +28,32 @@ namespace rsocket {
 using namespace yarpl::flowable;
 
 class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
-                        public folly::AsyncTransportWrapper::ReadCallback {
+                        public folly::AsyncTransportWrapper::ReadCallback,
+                        public folly::EventBase::LoopCallback {
   friend void intrusive_ptr_add_ref(TcpReaderWriter* x);
   friend void intrusive_ptr_release(TcpReaderWriter* x);
 
  public:
-  explicit TcpReaderWriter(
+  TcpReaderWriter(
       folly::AsyncTransportWrapper::UniquePtr&& socket,
+      TcpDuplexConnection::Options options,
       std::shared_ptr<RSocketStats> stats)
-      : socket_(std::move(socket)), stats_(std::move(stats)) {}
+      : socket_(std::move(socket)),
+        options_(std::move(options)),
+        stats_(std::move(stats)),
+        readBufferSize_(options_.minReadBufferSize) {
+    DCHECK_GT(options_.minReadBufferSize, 0u);
+    DCHECK_LE(options_.minReadBufferSize, options_.maxReadBufferSize);
+
+    if (options_.zeroCopy) {
+      auto const asyncSocket =
+          socket_->getUnderlyingTransport<folly::AsyncSocket>();
+      zeroCopy_ = asyncSocket && asyncSocket->setZeroCopy(true);
+      if (!zeroCopy_ && stats_) {
+        stats_->zeroCopyUnavailable();
+      }
+    }
+  }
 
   ~TcpReaderWriter() override {
     CHECK(isClosed());
@@ -71,16 +91,61 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
       return;
     }
 
-    if (stats_) {
-      stats_->bytesWritten(element->computeChainDataLength());
+    if (zeroCopy_ &&
+        element->computeChainDataLength() >= options_.zeroCopyThreshold) {
+      // Frames coalesced so far go out first, copied, to keep the order.
+      flushPendingWrites();
+      writeChain(std::move(element), 1, folly::WriteFlags::WRITE_MSG_ZEROCOPY);
+      return;
+    }
+
+    if (!options_.coalesceWrites) {
+      writeChain(std::move(element), 1);
+      return;
+    }
+
+    pendingWrites_.append(std::move(element));
+    ++pendingFrames_;
+
+    if (pendingWrites_.chainLength() >= options_.maxCoalescedBytes ||
+        pendingFrames_ >= options_.maxCoalescedFrames) {
+      flushPendingWrites();
+      return;
+    }
+
+    if (!isLoopCallbackScheduled()) {
+      // The EventBase will hold a reference to this instance until the end of
+      // the current loop iteration, when runLoopCallback flushes the chain.
+      intrusive_ptr_add_ref(this);
+      socket_->getEventBase()->runInLoop(this);
     }
-    // now AsyncSocket will hold a reference to this instance as a writer until
-    // they call writeComplete or writeErr
-    intrusive_ptr_add_ref(this);
-    socket_->writeChain(this, std::move(element));
+  }
+
+  size_t getQueuedWriteBytes() const {
+    if (isClosed()) {
+      return 0;
+    }
+    return pendingWrites_.chainLength() + socket_->getAppBytesBuffered();
+  }
+
+  void setWriteDrainedCallback(
+      size_t threshold,
+      folly::Function<void()> callback) {
+    if (isClosed()) {
+      return;
+    }
+    if (getQueuedWriteBytes() <= threshold) {
+      callback();
+      return;
+    }
+    drainedThreshold_ = threshold;
+    drainedCallback_ = std::move(callback);
   }
 
   void close() {
+    // Frames sent before a clean close must still make it to the wire.
+    flushPendingWrites();
+    drainedCallback_ = nullptr;
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -90,6 +155,9 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   }
 
   void closeErr(folly::exception_wrapper ew) {
+    pendingWrites_.move();
+    pendingFrames_ = 0;
+    drainedCallback_ = nullptr;
     if (auto socket = std::move(socket_)) {
       socket->close();
     }
@@ -103,7 +171,42 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
     return !socket_;
   }
 
+  void runLoopCallback() noexcept override {
+    flushPendingWrites();
+    intrusive_ptr_release(this);
+  }
+
+  void flushPendingWrites() {
+    if (pendingFrames_ == 0 || isClosed()) {
+      return;
+    }
+    auto const frames = std::exchange(pendingFrames_, 0);
+    writeChain(pendingWrites_.move(), frames);
+  }
+
+  void writeChain(
+      std::unique_ptr<folly::IOBuf> chain,
+      size_t frames,
+      folly::WriteFlags flags = folly::WriteFlags::NONE) {
+    auto const bytes = chain->computeChainDataLength();
+    if (stats_) {
+      stats_->bytesWritten(bytes);
+      stats_->framesFlushed(frames, bytes);
+      if (flags == folly::WriteFlags::WRITE_MSG_ZEROCOPY) {
+        stats_->zeroCopyWrite(bytes);
+      }
+    }
+    // now AsyncSocket will hold a reference to this instance as a writer until
+    // they call writeComplete or writeErr
+    intrusive_ptr_add_ref(this);
+    socket_->writeChain(this, std::move(chain), flags);
+  }
+
   void writeSuccess() noexcept override {
+    if (drainedCallback_ && getQueuedWriteBytes() <= drainedThreshold_) {
+      auto callback = std::move(drainedCallback_);
+      callback();
+    }
     intrusive_ptr_release(this);
   }
 
@@ -114,17 +217,20 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
   }
 
   void getReadBuffer(void** bufReturn, size_t* lenReturn) noexcept override {
-    std::tie(*bufReturn, *lenReturn) = readBuffer_.preallocate(4096, 4096);
+    std::tie(*bufReturn, *lenReturn) =
+        readBuffer_.preallocate(readBufferSize_, readBufferSize_);
+  }
+
+  size_t maxBufferSize() const override {
+    return readBufferSize_;
   }
 
   void readDataAvailable(size_t len) noexcept override {
     readBuffer_.postallocate(len);
-    if (stats_) {
-      stats_->bytesRead(len);
-    }
+    onBytesRead(len);
 
     if (inputSubscriber_) {
-      readBufferAvailable(readBuffer_.split(len));
+      inputSubscriber_->onNext(readBuffer_.split(len));
     }
   }
 
@@ -144,14 +250,59 @@ class TcpReaderWriter : public folly::AsyncTransportWrapper::WriteCallback,
 
   void readBufferAvailable(
       std::unique_ptr<folly::IOBuf> readBuf) noexcept override {
+    onBytesRead(readBuf->computeChainDataLength());
+
     CHECK(inputSubscriber_);
     inputSubscriber_->onNext(std::move(readBuf));
   }
 
+  void onBytesRead(size_t len) {
+    if (stats_) {
+      stats_->bytesRead(len);
+    }
+    adaptReadBufferSize(len);
+  }
+
+  /// Grow the read buffer toward the size of the data actually arriving, so
+  /// large frames land in one contiguous buffer and FramedReader can slice
+  /// them out without copying.  Shrink it again once reads stay small, so
+  /// idle connections don't pin large mostly-empty buffers.
+  void adaptReadBufferSize(size_t len) {
+    if (len >= readBufferSize_) {
+      readBufferSize_ =
+          std::min(readBufferSize_ * 2, options_.maxReadBufferSize);
+      shrinkPending_ = false;
+    } else if (len <= readBufferSize_ / 4) {
+      if (shrinkPending_) {
+        readBufferSize_ =
+            std::max(readBufferSize_ / 2, options_.minReadBufferSize);
+      }
+      shrinkPending_ = !shrinkPending_;
+    } else {
+      shrinkPending_ = false;
+    }
+  }
+
   folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
   folly::AsyncTransportWrapper::UniquePtr socket_;
+  const TcpDuplexConnection::Options options_;
   const std::shared_ptr<RSocketStats> stats_;
 
+  /// Frames sent during the current loop iteration, waiting to be flushed.
+  folly::IOBufQueue pendingWrites_{folly::IOBufQueue::cacheChainLength()};
+  size_t pendingFrames_{0};
+
+  /// Size of the next read buffer, see adaptReadBufferSize().
+  size_t readBufferSize_;
+  bool shrinkPending_{false};
+
+  /// Whether MSG_ZEROCOPY was successfully enabled on the socket.
+  bool zeroCopy_{false};
+
+  /// See DuplexConnection::setWriteDrainedCallback().
+  folly::Function<void()> drainedCallback_;
+  size_t drainedThreshold_{0};
+
   std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
   int refCount_{0};
 };
@@ -198,7 +349,14 @@ class TcpInputSubscription : public Subscription {
 TcpDuplexConnection::TcpDuplexConnection(
     folly::AsyncTransportWrapper::UniquePtr&& socket,
     std::shared_ptr<RSocketStats> stats)
-    : tcpReaderWriter_(new TcpReaderWriter(std::move(socket), stats)),
+    : TcpDuplexConnection(std::move(socket), Options(), std::move(stats)) {}
+
+TcpDuplexConnection::TcpDuplexConnection(
+    folly::AsyncTransportWrapper::UniquePtr&& socket,
+    Options options,
+    std::shared_ptr<RSocketStats> stats)
+    : tcpReaderWriter_(
+          new TcpReaderWriter(std::move(socket), std::move(options), stats)),
       stats_(stats) {
   if (stats_) {
     stats_->duplexConnectionCreated("tcp", this);
@@ -222,6 +380,16 @@ void TcpDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
   }
 }
 
+size_t TcpDuplexConnection::getQueuedWriteBytes() const {
+  return tcpReaderWriter_->getQueuedWriteBytes();
+}
+
+void TcpDuplexConnection::setWriteDrainedCallback(
+    size_t threshold,
+    folly::Function<void()> callback) {
+  tcpReaderWriter_->setWriteDrainedCallback(threshold, std::move(callback));
+}
+
 void TcpDuplexConnection::setInput(
     std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
   // we don't care if the subscriber will call request synchronously
@@ -28,15 +28,52 @@ class TcpReaderWriter;
 
 class TcpDuplexConnection : public DuplexConnection {
  public:
+  struct Options {
+    /// Whether frames sent during a single EventBase loop iteration are
+    /// coalesced into one IOBuf chain and written with a single writeChain().
+    bool coalesceWrites{true};
+
+    /// Flush the coalesced chain early once this many bytes are pending.
+    size_t maxCoalescedBytes{64 * 1024};
+
+    /// Flush the coalesced chain early once this many frames are pending.
+    size_t maxCoalescedFrames{256};
+
+    /// Bounds for the adaptive read buffer.  The buffer starts at the minimum,
+    /// doubles every time a read fills it completely, and halves back down
+    /// after consecutive reads that use less than a quarter of it.  Setting
+    /// both to the same value disables the adaptation.
+    size_t minReadBufferSize{4096};
+    size_t maxReadBufferSize{1024 * 1024};
+
+    /// Send frames of at least `zeroCopyThreshold` bytes on their own with
+    /// MSG_ZEROCOPY, so the kernel transmits straight out of the IOBufs
+    /// instead of copying them.  The AsyncSocket keeps the IOBufs alive until
+    /// the kernel reports the send complete.  Page pinning and completion
+    /// notifications cost more than copying small frames, hence the
+    /// threshold; coalesced chains of smaller frames are always copied, however
+    /// large they grow.  Ignored, with a call to
+    /// RSocketStats::zeroCopyUnavailable(), if the socket doesn't support it.
+    bool zeroCopy{false};
+    size_t zeroCopyThreshold{64 * 1024};
+  };
+
   explicit TcpDuplexConnection(
       folly::AsyncTransportWrapper::UniquePtr&& socket,
       std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  TcpDuplexConnection(
+      folly::AsyncTransportWrapper::UniquePtr&& socket,
+      Options options,
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
   ~TcpDuplexConnection();
 
   void send(std::unique_ptr<folly::IOBuf>) override;
 
   void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
 
+  size_t getQueuedWriteBytes() const override;
+  void setWriteDrainedCallback(size_t, folly::Function<void()>) override;
+
   // Only to be used for observation purposes.
   folly::AsyncTransportWrapper* getTransport();
 
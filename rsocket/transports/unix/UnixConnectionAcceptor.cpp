@@ -0,0 +1,178 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/unix/UnixConnectionAcceptor.h"
+
+#include <folly/Exception.h>
+#include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "rsocket/transports/unix/UnixDuplexConnection.h"
+
+namespace rsocket {
+
+namespace {
+
+/// bind() fails with EADDRINUSE while the socket file exists, even if nobody
+/// listens on it anymore.  Removes such a stale socket, but refuses to take
+/// over the path of a live server or to remove anything that isn't a socket.
+void removeStaleSocket(const std::string& path) {
+  struct stat st;
+  if (::lstat(path.c_str(), &st) != 0) {
+    if (errno == ENOENT) {
+      return;
+    }
+    folly::throwSystemError("Failed to stat ", path);
+  }
+  if (!S_ISSOCK(st.st_mode)) {
+    folly::throwSystemErrorExplicit(
+        EADDRINUSE, path, " exists and is not a socket");
+  }
+
+  // Only a socket nobody listens on refuses the connection.  A full backlog
+  // fails the non-blocking connect() with EAGAIN, so it counts as live.
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  folly::checkUnixError(fd, "Failed to create a socket");
+  SCOPE_EXIT {
+    ::close(fd);
+  };
+  folly::checkUnixError(
+      ::fcntl(fd, F_SETFL, O_NONBLOCK), "Failed to make a socket non-blocking");
+  sockaddr_storage storage;
+  const auto length =
+      folly::SocketAddress::makeFromPath(path).getAddress(&storage);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&storage), length) == 0 ||
+      errno != ECONNREFUSED) {
+    folly::throwSystemErrorExplicit(
+        EADDRINUSE, "Another server is listening on ", path);
+  }
+
+  VLOG(1) << "Removing stale socket " << path;
+  folly::checkUnixError(
+      ::unlink(path.c_str()), "Failed to remove stale socket ", path);
+}
+
+} // namespace
+
+class UnixConnectionAcceptor::SocketCallback
+    : public folly::AsyncServerSocket::AcceptCallback {
+ public:
+  SocketCallback(
+      OnDuplexConnectionAccept& onAccept,
+      const UnixDuplexConnection::Options& connectionOptions)
+      : thread_{folly::sformat("rsunix-acceptor")},
+        onAccept_{onAccept},
+        connectionOptions_{connectionOptions} {}
+
+  void connectionAccepted(
+      folly::NetworkSocket fdNetworkSocket,
+      const folly::SocketAddress&) noexcept override {
+    VLOG(2) << "Accepting unix connection on FD " << fdNetworkSocket.toFd();
+
+    auto connection = std::make_unique<UnixDuplexConnection>(
+        fdNetworkSocket, *eventBase(), connectionOptions_);
+    onAccept_(std::move(connection), *eventBase());
+  }
+
+  void acceptError(folly::exception_wrapper ex) noexcept override {
+    VLOG(2) << "Unix socket error: " << ex;
+  }
+
+  folly::EventBase* eventBase() const {
+    return thread_.getEventBase();
+  }
+
+ private:
+  /// The thread running this callback.
+  folly::ScopedEventBaseThread thread_;
+
+  /// Reference to the ConnectionAcceptor's callback.
+  OnDuplexConnectionAccept& onAccept_;
+
+  /// Reference to the ConnectionAcceptor's connection options.
+  const UnixDuplexConnection::Options& connectionOptions_;
+};
+
+UnixConnectionAcceptor::UnixConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+UnixConnectionAcceptor::~UnixConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    serverThread_.reset();
+  }
+}
+
+void UnixConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error("UnixConnectionAcceptor::start() already called");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsunix-listener");
+
+  callbacks_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    callbacks_.push_back(
+        std::make_unique<SocketCallback>(onAccept_, options_.connection));
+  }
+
+  VLOG(1) << "Starting unix listener on " << options_.path << " with "
+          << options_.threads << " request threads";
+
+  serverSocket_.reset(
+      new folly::AsyncServerSocket(serverThread_->getEventBase()));
+
+  // The AsyncServerSocket needs to be accessed from the listener thread only.
+  // This will propagate out any exceptions the listener throws.
+  folly::via(serverThread_->getEventBase(), [this] {
+    removeStaleSocket(options_.path);
+    serverSocket_->bind(folly::SocketAddress::makeFromPath(options_.path));
+    bound_ = true;
+
+    for (auto const& callback : callbacks_) {
+      serverSocket_->addAcceptCallback(callback.get(), callback->eventBase());
+    }
+
+    serverSocket_->listen(options_.backlog);
+    serverSocket_->startAccepting();
+
+    VLOG(1) << "Listening on " << options_.path;
+  }).get();
+}
+
+void UnixConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down unix listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait(
+      [this, serverSocket = std::move(serverSocket_)]() {
+        if (serverSocket && bound_) {
+          ::unlink(options_.path.c_str());
+        }
+      });
+}
+
+folly::Optional<uint16_t> UnixConnectionAcceptor::listeningPort() const {
+  return folly::none;
+}
+
+} // namespace rsocket
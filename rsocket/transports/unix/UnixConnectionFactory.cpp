@@ -0,0 +1,118 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/unix/UnixConnectionFactory.h"
+
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <glog/logging.h>
+
+#include "rsocket/transports/unix/UnixDuplexConnection.h"
+
+namespace rsocket {
+
+namespace {
+
+/// Connecting is left to AsyncSocket, which deals with a full listen backlog
+/// for us.  Once connected, the socket is detached from it and handed to a
+/// UnixDuplexConnection.
+class ConnectCallback : public folly::AsyncSocket::ConnectCallback {
+ public:
+  ConnectCallback(
+      folly::SocketAddress address,
+      UnixDuplexConnection::Options connectionOptions,
+      folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
+          connectPromise)
+      : address_(address),
+        connectionOptions_(std::move(connectionOptions)),
+        connectPromise_(std::move(connectPromise)) {
+    VLOG(2) << "Constructing ConnectCallback";
+
+    // Set up by ScopedEventBaseThread.
+    auto evb = folly::EventBaseManager::get()->getExistingEventBase();
+    DCHECK(evb);
+
+    socket_.reset(new folly::AsyncSocket(evb));
+
+    VLOG(3) << "Attempting connection to " << address_;
+
+    socket_->connect(this, address_);
+  }
+
+  ~ConnectCallback() override {
+    VLOG(2) << "Destroying ConnectCallback";
+  }
+
+  void connectSuccess() noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectSuccess() on " << address_;
+
+    auto evb = socket_->getEventBase();
+    auto fd = socket_->detachNetworkSocket();
+    socket_.reset();
+
+    auto connection = UnixConnectionFactory::createDuplexConnectionFromSocket(
+        fd, *evb, RSocketStats::noop(), connectionOptions_);
+    connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
+        std::move(connection), *evb});
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    std::unique_ptr<ConnectCallback> deleter(this);
+    VLOG(4) << "connectErr(" << ex.what() << ") on " << address_;
+    connectPromise_.setException(ex);
+  }
+
+ private:
+  const folly::SocketAddress address_;
+  const UnixDuplexConnection::Options connectionOptions_;
+  folly::AsyncSocket::UniquePtr socket_;
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
+};
+
+} // namespace
+
+UnixConnectionFactory::UnixConnectionFactory(
+    folly::EventBase& eventBase,
+    std::string path,
+    UnixDuplexConnection::Options connectionOptions)
+    : eventBase_(&eventBase),
+      address_(folly::SocketAddress::makeFromPath(path)),
+      connectionOptions_(std::move(connectionOptions)) {}
+
+UnixConnectionFactory::~UnixConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+UnixConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise;
+  auto connectFuture = connectPromise.getFuture();
+
+  eventBase_->runInEventBaseThread(
+      [this, promise = std::move(connectPromise)]() mutable {
+        new ConnectCallback(address_, connectionOptions_, std::move(promise));
+      });
+  return connectFuture;
+}
+
+std::unique_ptr<DuplexConnection>
+UnixConnectionFactory::createDuplexConnectionFromSocket(
+    folly::NetworkSocket fd,
+    folly::EventBase& eventBase,
+    std::shared_ptr<RSocketStats> stats,
+    UnixDuplexConnection::Options connectionOptions) {
+  return std::make_unique<UnixDuplexConnection>(
+      fd, eventBase, std::move(connectionOptions), std::move(stats));
+}
+
+} // namespace rsocket
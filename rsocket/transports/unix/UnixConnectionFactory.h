@@ -0,0 +1,69 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+#include <folly/net/NetworkSocket.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/transports/unix/UnixDuplexConnection.h"
+
+namespace rsocket {
+
+class RSocketStats;
+
+/**
+ * Unix domain socket implementation of ConnectionFactory for use with
+ * RSocket::createConnectedClient().
+ *
+ * Creation of this does nothing.  The `connect` method kicks off work.
+ */
+class UnixConnectionFactory : public ConnectionFactory {
+ public:
+  UnixConnectionFactory(
+      folly::EventBase& eventBase,
+      std::string path,
+      UnixDuplexConnection::Options connectionOptions =
+          UnixDuplexConnection::Options());
+  virtual ~UnixConnectionFactory();
+
+  /**
+   * Connect to the socket at the path given in the constructor.
+   *
+   * Each call to connect() creates a new AF_UNIX socket.
+   */
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus resume) override;
+
+  /**
+   * Wrap an already connected AF_UNIX stream socket, e.g. one end of a
+   * socketpair().  Must be called on the `eventBase` thread.
+   */
+  static std::unique_ptr<DuplexConnection> createDuplexConnectionFromSocket(
+      folly::NetworkSocket fd,
+      folly::EventBase& eventBase,
+      std::shared_ptr<RSocketStats> stats = std::shared_ptr<RSocketStats>(),
+      UnixDuplexConnection::Options connectionOptions =
+          UnixDuplexConnection::Options());
+
+ private:
+  folly::EventBase* eventBase_;
+  const folly::SocketAddress address_;
+  const UnixDuplexConnection::Options connectionOptions_;
+};
+
+} // namespace rsocket
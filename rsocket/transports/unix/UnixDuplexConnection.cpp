@@ -0,0 +1,380 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/unix/UnixDuplexConnection.h"
+
+#include <fcntl.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <climits>
+#include <limits>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+class UnixReaderWriter : public folly::EventHandler,
+                         public folly::EventBase::LoopCallback {
+  friend void intrusive_ptr_add_ref(UnixReaderWriter* x);
+  friend void intrusive_ptr_release(UnixReaderWriter* x);
+
+ public:
+  UnixReaderWriter(
+      int fd,
+      folly::EventBase& evb,
+      UnixDuplexConnection::Options options,
+      std::shared_ptr<RSocketStats> stats)
+      : folly::EventHandler(&evb, folly::NetworkSocket::fromFd(fd)),
+        fd_(fd),
+        evb_(evb),
+        options_(std::move(options)),
+        stats_(std::move(stats)) {
+    DCHECK_GT(options_.readBufferSize, 0u);
+    auto const flags = ::fcntl(fd_, F_GETFL);
+    if (flags >= 0 && !(flags & O_NONBLOCK)) {
+      ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK);
+    }
+  }
+
+  ~UnixReaderWriter() override {
+    DCHECK(!inputSubscriber_);
+    DCHECK_EQ(registeredEvents_, 0);
+    ::close(fd_);
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      updateRegistration();
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+    updateRegistration();
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> element) {
+    if (isClosed()) {
+      return;
+    }
+
+    pendingWrites_.append(std::move(element));
+    ++pendingFrames_;
+
+    if (!options_.coalesceWrites) {
+      flushPendingWrites();
+      return;
+    }
+
+    if (!isLoopCallbackScheduled()) {
+      // The EventBase will hold a reference to this instance until the end of
+      // the current loop iteration, when runLoopCallback flushes the chain.
+      intrusive_ptr_add_ref(this);
+      evb_.runInLoop(this);
+    }
+  }
+
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+
+    // Frames sent before a clean close must still make it to the wire.
+    flushPendingWrites();
+    closed_ = true;
+
+    ::shutdown(fd_, writing_.empty() ? SHUT_RDWR : SHUT_RD);
+    auto subscriber = std::move(inputSubscriber_);
+    updateRegistration();
+    if (subscriber) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    pendingWrites_.move();
+    pendingFrames_ = 0;
+    writing_.move();
+    writeBlocked_ = false;
+    if (!closed_) {
+      closed_ = true;
+      ::shutdown(fd_, SHUT_RDWR);
+    }
+    auto subscriber = std::move(inputSubscriber_);
+    updateRegistration();
+    if (subscriber) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  bool isClosed() const {
+    return closed_;
+  }
+
+  /// Watch the socket for exactly the events there is work for: readability
+  /// while someone consumes input, writability while a write is blocked.
+  /// The EventBase holds a reference to this instance while registered.
+  void updateRegistration() {
+    uint16_t events = 0;
+    if (inputSubscriber_ && !isClosed()) {
+      events |= READ;
+    }
+    if (writeBlocked_) {
+      events |= WRITE;
+    }
+    if (events == registeredEvents_) {
+      return;
+    }
+
+    if (events == 0) {
+      unregisterHandler();
+      registeredEvents_ = 0;
+      intrusive_ptr_release(this);
+      return;
+    }
+
+    if (registeredEvents_ == 0) {
+      intrusive_ptr_add_ref(this);
+    }
+    registeredEvents_ = events;
+    CHECK(registerHandler(events | PERSIST));
+  }
+
+  void handlerReady(uint16_t events) noexcept override {
+    boost::intrusive_ptr<UnixReaderWriter> self(this);
+    if (events & WRITE) {
+      writeOut();
+    }
+    if (events & READ) {
+      readIn();
+    }
+  }
+
+  void runLoopCallback() noexcept override {
+    flushPendingWrites();
+    intrusive_ptr_release(this);
+  }
+
+  void readIn() {
+    // Keep reading while the socket fills whole buffers, but bound the work
+    // done per wakeup so one busy peer cannot starve the EventBase.
+    for (size_t i = 0; i < kMaxReadsPerWakeup && inputSubscriber_; ++i) {
+      auto const buf = readBuffer_.preallocate(
+          options_.readBufferSize, options_.readBufferSize);
+      auto const n = ::recv(fd_, buf.first, buf.second, 0);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          closeErr(folly::exception_wrapper{std::system_error(
+              errno, std::system_category(), "unix socket read failed")});
+        }
+        return;
+      }
+      if (n == 0) {
+        close();
+        return;
+      }
+
+      auto const len = static_cast<size_t>(n);
+      readBuffer_.postallocate(len);
+      if (stats_) {
+        stats_->bytesRead(len);
+      }
+      inputSubscriber_->onNext(readBuffer_.split(len));
+
+      if (len < buf.second) {
+        return;
+      }
+    }
+  }
+
+  void flushPendingWrites() {
+    if (pendingFrames_ == 0 || isClosed()) {
+      return;
+    }
+    auto const frames = std::exchange(pendingFrames_, 0);
+    if (stats_) {
+      auto const bytes = pendingWrites_.chainLength();
+      stats_->bytesWritten(bytes);
+      stats_->framesFlushed(frames, bytes);
+    }
+    writing_.append(pendingWrites_.move());
+    if (!writeBlocked_) {
+      writeOut();
+    }
+  }
+
+  /// Write as much of `writing_` as the socket takes.  Sent with sendmsg()
+  /// only for MSG_NOSIGNAL; no ancillary data is ever attached.
+  void writeOut() {
+    while (!writing_.empty()) {
+      iovecs_.clear();
+      for (auto const range : *writing_.front()) {
+        if (iovecs_.size() == IOV_MAX) {
+          break;
+        }
+        if (!range.empty()) {
+          iovecs_.push_back(
+              {const_cast<uint8_t*>(range.data()), range.size()});
+        }
+      }
+      msghdr message{};
+      message.msg_iov = iovecs_.data();
+      message.msg_iovlen = iovecs_.size();
+
+      auto const n = ::sendmsg(fd_, &message, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          writeBlocked_ = true;
+          updateRegistration();
+          return;
+        }
+        closeErr(folly::exception_wrapper{std::system_error(
+            errno, std::system_category(), "unix socket write failed")});
+        return;
+      }
+      writing_.trimStart(static_cast<size_t>(n));
+    }
+
+    if (writeBlocked_) {
+      writeBlocked_ = false;
+      updateRegistration();
+    }
+    if (isClosed()) {
+      ::shutdown(fd_, SHUT_WR);
+    }
+  }
+
+  static constexpr size_t kMaxReadsPerWakeup = 4;
+
+  const int fd_;
+  folly::EventBase& evb_;
+  const UnixDuplexConnection::Options options_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
+
+  /// Frames sent during the current loop iteration, waiting to be flushed.
+  folly::IOBufQueue pendingWrites_{folly::IOBufQueue::cacheChainLength()};
+  size_t pendingFrames_{0};
+
+  /// Flushed bytes the socket has not taken yet.
+  folly::IOBufQueue writing_{folly::IOBufQueue::cacheChainLength()};
+  std::vector<iovec> iovecs_;
+
+  uint16_t registeredEvents_{0};
+  bool writeBlocked_{false};
+  bool closed_{false};
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(UnixReaderWriter* x);
+void intrusive_ptr_release(UnixReaderWriter* x);
+
+inline void intrusive_ptr_add_ref(UnixReaderWriter* x) {
+  ++x->refCount_;
+}
+
+inline void intrusive_ptr_release(UnixReaderWriter* x) {
+  if (--x->refCount_ == 0)
+    delete x;
+}
+
+namespace {
+
+class UnixInputSubscription : public Subscription {
+ public:
+  explicit UnixInputSubscription(
+      boost::intrusive_ptr<UnixReaderWriter> readerWriter)
+      : readerWriter_(std::move(readerWriter)) {
+    CHECK(readerWriter_);
+  }
+
+  void request(int64_t n) noexcept override {
+    DCHECK(readerWriter_);
+    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
+        << "UnixDuplexConnection doesnt support proper flow control";
+  }
+
+  void cancel() noexcept override {
+    readerWriter_->setInput(nullptr);
+    readerWriter_ = nullptr;
+  }
+
+ private:
+  boost::intrusive_ptr<UnixReaderWriter> readerWriter_;
+};
+
+} // namespace
+
+UnixDuplexConnection::UnixDuplexConnection(
+    folly::NetworkSocket fd,
+    folly::EventBase& evb,
+    Options options,
+    std::shared_ptr<RSocketStats> stats)
+    : readerWriter_(
+          new UnixReaderWriter(fd.toFd(), evb, std::move(options), stats)),
+      stats_(stats) {
+  if (stats_) {
+    stats_->duplexConnectionCreated("unix", this);
+  }
+}
+
+UnixDuplexConnection::~UnixDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("unix", this);
+  }
+  readerWriter_->close();
+}
+
+void UnixDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  if (readerWriter_) {
+    readerWriter_->send(std::move(buf));
+  }
+}
+
+void UnixDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  // we don't care if the subscriber will call request synchronously
+  inputSubscriber->onSubscribe(
+      std::make_shared<UnixInputSubscription>(readerWriter_));
+  readerWriter_->setInput(std::move(inputSubscriber));
+}
+
+} // namespace rsocket
@@ -0,0 +1,66 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <folly/net/NetworkSocket.h>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class UnixReaderWriter;
+
+/// DuplexConnection over a connected AF_UNIX stream socket.
+///
+/// Same-host peers need none of what AsyncSocket does for TCP: no socket
+/// options, no TLS, and no ancillary data since file descriptors are never
+/// passed.  This drives the socket directly from the EventBase with plain
+/// read() and writev() calls.
+class UnixDuplexConnection : public DuplexConnection {
+ public:
+  struct Options {
+    /// Whether frames sent during a single EventBase loop iteration are
+    /// written together with one writev().
+    bool coalesceWrites{true};
+
+    /// Size of the buffer each read() goes into.
+    size_t readBufferSize{64 * 1024};
+  };
+
+  /// Takes ownership of `fd`, which is made non-blocking.  Must be created,
+  /// used and destroyed on the `evb` thread.
+  UnixDuplexConnection(
+      folly::NetworkSocket fd,
+      folly::EventBase& evb,
+      Options options = Options(),
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  ~UnixDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+ private:
+  boost::intrusive_ptr<UnixReaderWriter> readerWriter_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
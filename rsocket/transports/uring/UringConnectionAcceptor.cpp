@@ -0,0 +1,172 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uring/UringConnectionAcceptor.h"
+
+#include <folly/Exception.h>
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
+#include <glog/logging.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace rsocket {
+
+class UringConnectionAcceptor::AcceptOperation : public UringRing::Operation {
+ public:
+  AcceptOperation(UringConnectionAcceptor& acceptor, UringRing& ring)
+      : acceptor_(acceptor), ring_(ring) {}
+
+  void start() {
+    ring_.prepare(*this, [&](io_uring_sqe* sqe) {
+      io_uring_prep_multishot_accept(
+          sqe, acceptor_.listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    });
+  }
+
+  void onCompletion(int32_t res, uint32_t flags) noexcept override {
+    if (res >= 0) {
+      if (acceptor_.listenFd_ < 0) {
+        ::close(res);
+      } else {
+        acceptor_.onAccepted(res);
+      }
+    } else if (res != -EINVAL && res != -ECANCELED) {
+      VLOG(2) << "io_uring accept error: " << folly::errnoStr(-res);
+    }
+
+    // The kernel ends a multishot accept on errors; keep listening unless
+    // the acceptor was stopped.
+    if (!(flags & IORING_CQE_F_MORE) && acceptor_.listenFd_ >= 0) {
+      start();
+    }
+  }
+
+ private:
+  UringConnectionAcceptor& acceptor_;
+  UringRing& ring_;
+};
+
+UringConnectionAcceptor::UringConnectionAcceptor(Options options)
+    : options_(std::move(options)) {}
+
+UringConnectionAcceptor::~UringConnectionAcceptor() {
+  if (serverThread_) {
+    stop();
+    // Tearing down the listener's EventBase also tears down its ring, so no
+    // completion can reach the accept request after this.
+    serverThread_.reset();
+  }
+}
+
+void UringConnectionAcceptor::start(OnDuplexConnectionAccept onAccept) {
+  if (onAccept_ != nullptr) {
+    throw std::runtime_error("UringConnectionAcceptor::start() already called");
+  }
+
+  onAccept_ = std::move(onAccept);
+  serverThread_ =
+      std::make_unique<folly::ScopedEventBaseThread>("rsuring-listener");
+
+  workers_.reserve(options_.threads);
+  for (size_t i = 0; i < options_.threads; ++i) {
+    workers_.push_back(
+        std::make_unique<folly::ScopedEventBaseThread>("rsuring-worker"));
+  }
+
+  VLOG(1) << "Starting io_uring listener on port "
+          << options_.address.getPort() << " with " << options_.threads
+          << " request threads";
+
+  // The listening socket and the accept request need to be accessed from the
+  // listener thread only.  This will propagate out any exceptions the
+  // listener throws.
+  folly::via(serverThread_->getEventBase(), [this] { listen(); }).get();
+}
+
+void UringConnectionAcceptor::listen() {
+  auto const fd = ::socket(
+      options_.address.getFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+  folly::checkUnixError(fd, "Failed to create listening socket");
+  auto fdGuard = folly::makeGuard([&] { ::close(fd); });
+
+  int one = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (options_.address.getFamily() == AF_INET6) {
+    int zero = 0;
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+  }
+
+  sockaddr_storage storage;
+  auto const length = options_.address.getAddress(&storage);
+  folly::checkUnixError(
+      ::bind(fd, reinterpret_cast<sockaddr*>(&storage), length),
+      "Failed to bind to ",
+      options_.address.describe());
+  folly::checkUnixError(
+      ::listen(fd, options_.backlog), "Failed to listen on socket");
+
+  folly::SocketAddress bound;
+  bound.setFromLocalAddress(folly::NetworkSocket::fromFd(fd));
+  VLOG(1) << "Listening on " << bound.describe();
+
+  auto& ring =
+      UringRing::get(*serverThread_->getEventBase(), options_.connection.ring);
+  fdGuard.dismiss();
+  listenFd_ = fd;
+  port_ = bound.getPort();
+
+  acceptOperation_ = std::make_unique<AcceptOperation>(*this, ring);
+  acceptOperation_->start();
+}
+
+void UringConnectionAcceptor::onAccepted(int fd) {
+  auto& worker = *workers_[nextWorker_++ % workers_.size()];
+  auto const evb = worker.getEventBase();
+
+  VLOG(2) << "Accepting io_uring connection on FD " << fd;
+
+  evb->runInEventBaseThread([this, fd, evb] {
+    auto connection = std::make_unique<UringDuplexConnection>(
+        folly::NetworkSocket::fromFd(fd), *evb, options_.connection);
+    onAccept_(std::move(connection), *evb);
+  });
+}
+
+void UringConnectionAcceptor::stop() {
+  VLOG(1) << "Shutting down io_uring listener";
+
+  serverThread_->getEventBase()->runInEventBaseThreadAndWait([this] {
+    if (listenFd_ < 0) {
+      return;
+    }
+    // Fails the pending accept request, which is not rearmed since the
+    // socket is gone.
+    ::shutdown(listenFd_, SHUT_RDWR);
+    ::close(listenFd_);
+    listenFd_ = -1;
+  });
+  port_ = 0;
+}
+
+folly::Optional<uint16_t> UringConnectionAcceptor::listeningPort() const {
+  auto const port = port_.load();
+  if (port == 0) {
+    return folly::none;
+  }
+  return port;
+}
+
+} // namespace rsocket
@@ -0,0 +1,103 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "rsocket/ConnectionAcceptor.h"
+#include "rsocket/transports/uring/UringDuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * io_uring implementation of ConnectionAcceptor for use with
+ * RSocket::createServer.
+ *
+ * A listener thread keeps one multishot accept request in its ring, and hands
+ * accepted sockets to the worker threads in turn.  All connections on a worker
+ * share that worker's ring.
+ *
+ * Construction of this does nothing.  The `start` method kicks off work.
+ */
+class UringConnectionAcceptor : public ConnectionAcceptor {
+ public:
+  struct Options {
+    /// Address to listen on
+    folly::SocketAddress address{"::", 8080};
+
+    /// Number of worker threads processing requests.
+    size_t threads{2};
+
+    /// Number of connections to buffer before they are accepted.
+    int backlog{10};
+
+    /// Options applied to every accepted UringDuplexConnection.
+    UringDuplexConnection::Options connection;
+  };
+
+  explicit UringConnectionAcceptor(Options);
+  ~UringConnectionAcceptor();
+
+  // ConnectionAcceptor overrides.
+
+  /**
+   * Bind a listening socket and start accepting connections.
+   */
+  void start(OnDuplexConnectionAccept) override;
+
+  /**
+   * Close the listening socket.
+   */
+  void stop() override;
+
+  /**
+   * Get the port being listened on.
+   */
+  folly::Optional<uint16_t> listeningPort() const override;
+
+ private:
+  class AcceptOperation;
+
+  void listen();
+  void onAccepted(int fd);
+
+  /// Options this acceptor has been configured with.
+  const Options options_;
+
+  /// The thread driving the accept request.
+  std::unique_ptr<folly::ScopedEventBaseThread> serverThread_;
+
+  /// The threads driving accepted connections.
+  std::vector<std::unique_ptr<folly::ScopedEventBaseThread>> workers_;
+  size_t nextWorker_{0};
+
+  /// Function to run when a connection is accepted.
+  OnDuplexConnectionAccept onAccept_;
+
+  std::unique_ptr<AcceptOperation> acceptOperation_;
+
+  /// The socket listening for new connections.  Only accessed from the
+  /// listener thread.
+  int listenFd_{-1};
+
+  std::atomic<uint16_t> port_{0};
+};
+
+} // namespace rsocket
@@ -0,0 +1,122 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uring/UringConnectionFactory.h"
+
+#include <folly/Exception.h>
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <system_error>
+
+namespace rsocket {
+
+namespace {
+
+/// An io_uring connect request.  Deletes itself once it is done.
+class ConnectOperation : public UringRing::Operation {
+ public:
+  ConnectOperation(
+      folly::EventBase& evb,
+      folly::SocketAddress address,
+      UringDuplexConnection::Options connectionOptions,
+      folly::Promise<ConnectionFactory::ConnectedDuplexConnection>
+          connectPromise)
+      : evb_(evb),
+        address_(std::move(address)),
+        connectionOptions_(std::move(connectionOptions)),
+        connectPromise_(std::move(connectPromise)) {}
+
+  void start() {
+    VLOG(3) << "Attempting connection to " << address_;
+    try {
+      auto& ring = UringRing::get(evb_, connectionOptions_.ring);
+      fd_ = ::socket(address_.getFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+      folly::checkUnixError(fd_, "Failed to create socket");
+      addressLength_ = address_.getAddress(&storage_);
+      ring.prepare(*this, [&](io_uring_sqe* sqe) {
+        io_uring_prep_connect(
+            sqe, fd_, reinterpret_cast<sockaddr*>(&storage_), addressLength_);
+      });
+    } catch (const std::exception&) {
+      fail(folly::exception_wrapper{std::current_exception()});
+    }
+  }
+
+  void onCompletion(int32_t res, uint32_t) noexcept override {
+    if (res < 0) {
+      fail(folly::exception_wrapper{std::system_error(
+          -res,
+          std::system_category(),
+          "Failed to connect to " + address_.describe())});
+      return;
+    }
+
+    std::unique_ptr<ConnectOperation> deleter(this);
+    VLOG(4) << "Connected to " << address_;
+    auto connection = std::make_unique<UringDuplexConnection>(
+        folly::NetworkSocket::fromFd(fd_), evb_, connectionOptions_);
+    connectPromise_.setValue(ConnectionFactory::ConnectedDuplexConnection{
+        std::move(connection), evb_});
+  }
+
+ private:
+  void fail(folly::exception_wrapper ew) {
+    std::unique_ptr<ConnectOperation> deleter(this);
+    VLOG(4) << "Failed to connect to " << address_ << ": " << ew;
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    connectPromise_.setException(std::move(ew));
+  }
+
+  folly::EventBase& evb_;
+  const folly::SocketAddress address_;
+  const UringDuplexConnection::Options connectionOptions_;
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise_;
+
+  int fd_{-1};
+  sockaddr_storage storage_{};
+  socklen_t addressLength_{0};
+};
+
+} // namespace
+
+UringConnectionFactory::UringConnectionFactory(
+    folly::EventBase& eventBase,
+    folly::SocketAddress address,
+    UringDuplexConnection::Options connectionOptions)
+    : eventBase_(&eventBase),
+      address_(std::move(address)),
+      connectionOptions_(std::move(connectionOptions)) {}
+
+UringConnectionFactory::~UringConnectionFactory() = default;
+
+folly::Future<ConnectionFactory::ConnectedDuplexConnection>
+UringConnectionFactory::connect(ProtocolVersion, ResumeStatus /* unused */) {
+  folly::Promise<ConnectionFactory::ConnectedDuplexConnection> connectPromise;
+  auto connectFuture = connectPromise.getFuture();
+
+  eventBase_->runInEventBaseThread(
+      [this, promise = std::move(connectPromise)]() mutable {
+        (new ConnectOperation(
+             *eventBase_, address_, connectionOptions_, std::move(promise)))
+            ->start();
+      });
+  return connectFuture;
+}
+
+} // namespace rsocket
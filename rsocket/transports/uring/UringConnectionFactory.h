@@ -0,0 +1,56 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/SocketAddress.h>
+
+#include "rsocket/ConnectionFactory.h"
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/transports/uring/UringDuplexConnection.h"
+
+namespace rsocket {
+
+/**
+ * io_uring implementation of ConnectionFactory for use with
+ * RSocket::createClient().
+ *
+ * Connections are established with an io_uring connect request on the
+ * factory's EventBase, and are driven by that EventBase's ring.
+ */
+class UringConnectionFactory : public ConnectionFactory {
+ public:
+  UringConnectionFactory(
+      folly::EventBase& eventBase,
+      folly::SocketAddress address,
+      UringDuplexConnection::Options connectionOptions =
+          UringDuplexConnection::Options());
+  virtual ~UringConnectionFactory();
+
+  /**
+   * Connect to server defined in constructor.
+   *
+   * Each call to connect() creates a new socket.
+   */
+  folly::Future<ConnectedDuplexConnection> connect(
+      ProtocolVersion,
+      ResumeStatus resume) override;
+
+ private:
+  folly::EventBase* eventBase_;
+  const folly::SocketAddress address_;
+  const UringDuplexConnection::Options connectionOptions_;
+};
+
+} // namespace rsocket
@@ -0,0 +1,372 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uring/UringDuplexConnection.h"
+
+#include <folly/Exception.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/ScopeGuard.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBase.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <climits>
+#include <limits>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "yarpl/flowable/Subscription.h"
+
+namespace rsocket {
+
+using namespace yarpl::flowable;
+
+class UringReaderWriter {
+  friend void intrusive_ptr_add_ref(UringReaderWriter* x);
+  friend void intrusive_ptr_release(UringReaderWriter* x);
+
+ public:
+  UringReaderWriter(
+      int fd,
+      UringRing& ring,
+      std::shared_ptr<RSocketStats> stats)
+      : fd_(fd), ring_(ring), stats_(std::move(stats)) {}
+
+  ~UringReaderWriter() {
+    DCHECK(!inputSubscriber_);
+    DCHECK(!receiving_);
+    DCHECK(!sending_);
+    ::close(fd_);
+  }
+
+  const UringRing& getRing() const {
+    return ring_;
+  }
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+    if (inputSubscriber && isClosed()) {
+      inputSubscriber->onComplete();
+      return;
+    }
+
+    if (!inputSubscriber) {
+      inputSubscriber_ = nullptr;
+      return;
+    }
+
+    CHECK(!inputSubscriber_);
+    inputSubscriber_ = std::move(inputSubscriber);
+
+    if (!receiving_) {
+      startReceive();
+    }
+  }
+
+  void send(std::unique_ptr<folly::IOBuf> element) {
+    if (isClosed()) {
+      return;
+    }
+
+    pendingWrites_.append(std::move(element));
+    ++pendingFrames_;
+
+    if (!sending_ && !flushScheduled_) {
+      // Everything sent until the ring submits its batch goes out in one
+      // request.  The callback holds a reference until then.
+      flushScheduled_ = true;
+      ring_.runBeforeSubmit(
+          [self = boost::intrusive_ptr<UringReaderWriter>(this)] {
+            self->flushScheduled_ = false;
+            self->flushPendingWrites();
+          });
+    }
+  }
+
+  void close() {
+    if (isClosed()) {
+      return;
+    }
+    closed_ = true;
+
+    // Stop reading now; the write side is shut down once frames sent before
+    // the close have made it to the wire.
+    ::shutdown(fd_, SHUT_RD);
+    if (!sending_ && pendingFrames_ == 0) {
+      ::shutdown(fd_, SHUT_WR);
+    }
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onComplete();
+    }
+  }
+
+  void closeErr(folly::exception_wrapper ew) {
+    failed_ = true;
+    pendingWrites_.move();
+    pendingFrames_ = 0;
+    if (!closed_) {
+      closed_ = true;
+      ::shutdown(fd_, SHUT_RDWR);
+    }
+    if (auto subscriber = std::move(inputSubscriber_)) {
+      subscriber->onError(std::move(ew));
+    }
+  }
+
+ private:
+  /// Forwards completions to a UringReaderWriter member function.
+  template <void (UringReaderWriter::*Fn)(int32_t, uint32_t)>
+  class Operation : public UringRing::Operation {
+   public:
+    explicit Operation(UringReaderWriter& owner) : owner_(owner) {}
+
+    void onCompletion(int32_t res, uint32_t flags) noexcept override {
+      (owner_.*Fn)(res, flags);
+    }
+
+   private:
+    UringReaderWriter& owner_;
+  };
+
+  bool isClosed() const {
+    return closed_;
+  }
+
+  void startReceive() {
+    // The ring holds a reference to this instance until the receive's final
+    // completion.
+    intrusive_ptr_add_ref(this);
+    receiving_ = true;
+    ring_.prepare(receiveOperation_, [&](io_uring_sqe* sqe) {
+      io_uring_prep_recv_multishot(sqe, fd_, nullptr, 0, 0);
+      sqe->flags |= IOSQE_BUFFER_SELECT;
+      sqe->buf_group = ring_.receiveBufferGroup();
+    });
+  }
+
+  void onReceive(int32_t res, uint32_t flags) {
+    boost::intrusive_ptr<UringReaderWriter> self;
+    if (!(flags & IORING_CQE_F_MORE)) {
+      // Final completion, adopt the reference taken in startReceive().
+      self = boost::intrusive_ptr<UringReaderWriter>(this, false);
+      receiving_ = false;
+    }
+
+    if (res > 0) {
+      auto buf = folly::IOBuf::copyBuffer(ring_.receiveBuffer(flags), res);
+      ring_.recycleReceiveBuffer(flags);
+      if (stats_) {
+        stats_->bytesRead(static_cast<size_t>(res));
+      }
+      if (inputSubscriber_) {
+        inputSubscriber_->onNext(std::move(buf));
+      }
+    } else if (flags & IORING_CQE_F_BUFFER) {
+      ring_.recycleReceiveBuffer(flags);
+    }
+
+    if (receiving_ || isClosed()) {
+      return;
+    }
+    if (res == 0) {
+      close();
+    } else if (res > 0 || res == -ENOBUFS) {
+      // The kernel ends a multishot receive when it runs out of provided
+      // buffers.  They have been recycled by now, so just keep reading.
+      startReceive();
+    } else {
+      closeErr(folly::exception_wrapper{std::system_error(
+          -res, std::system_category(), "io_uring receive failed")});
+    }
+  }
+
+  void flushPendingWrites() {
+    if (sending_ || failed_ || pendingFrames_ == 0) {
+      return;
+    }
+    auto const frames = std::exchange(pendingFrames_, 0);
+    writing_.append(pendingWrites_.move());
+    if (stats_) {
+      auto const bytes = writing_.chainLength();
+      stats_->bytesWritten(bytes);
+      stats_->framesFlushed(frames, bytes);
+    }
+    startSend();
+  }
+
+  void startSend() {
+    iovecs_.clear();
+    for (auto const range : *writing_.front()) {
+      if (iovecs_.size() == IOV_MAX) {
+        break;
+      }
+      if (!range.empty()) {
+        iovecs_.push_back(
+            {const_cast<uint8_t*>(range.data()), range.size()});
+      }
+    }
+    message_ = {};
+    message_.msg_iov = iovecs_.data();
+    message_.msg_iovlen = iovecs_.size();
+
+    // The ring holds a reference to this instance until the send completes.
+    intrusive_ptr_add_ref(this);
+    sending_ = true;
+    ring_.prepare(sendOperation_, [&](io_uring_sqe* sqe) {
+      io_uring_prep_sendmsg(sqe, fd_, &message_, MSG_NOSIGNAL);
+    });
+  }
+
+  void onSend(int32_t res, uint32_t) {
+    boost::intrusive_ptr<UringReaderWriter> self(this, false);
+    sending_ = false;
+
+    if (res < 0) {
+      writing_.move();
+      if (!failed_) {
+        closeErr(folly::exception_wrapper{std::system_error(
+            -res, std::system_category(), "io_uring send failed")});
+      }
+      return;
+    }
+
+    writing_.trimStart(static_cast<size_t>(res));
+    if (!writing_.empty()) {
+      // Short write, send the rest before anything queued behind it.
+      startSend();
+      return;
+    }
+
+    flushPendingWrites();
+    if (closed_ && !sending_ && !failed_) {
+      ::shutdown(fd_, SHUT_WR);
+    }
+  }
+
+  const int fd_;
+  UringRing& ring_;
+  const std::shared_ptr<RSocketStats> stats_;
+
+  Operation<&UringReaderWriter::onReceive> receiveOperation_{*this};
+  Operation<&UringReaderWriter::onSend> sendOperation_{*this};
+
+  /// Frames sent since the last request was prepared.
+  folly::IOBufQueue pendingWrites_{folly::IOBufQueue::cacheChainLength()};
+  size_t pendingFrames_{0};
+
+  /// Bytes of the sendmsg() request in flight, and its arguments.
+  folly::IOBufQueue writing_{folly::IOBufQueue::cacheChainLength()};
+  std::vector<iovec> iovecs_;
+  msghdr message_{};
+
+  bool receiving_{false};
+  bool sending_{false};
+  bool flushScheduled_{false};
+  bool closed_{false};
+  bool failed_{false};
+
+  std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber_;
+  int refCount_{0};
+};
+
+void intrusive_ptr_add_ref(UringReaderWriter* x);
+void intrusive_ptr_release(UringReaderWriter* x);
+
+inline void intrusive_ptr_add_ref(UringReaderWriter* x) {
+  ++x->refCount_;
+}
+
+inline void intrusive_ptr_release(UringReaderWriter* x) {
+  if (--x->refCount_ == 0)
+    delete x;
+}
+
+namespace {
+
+class UringInputSubscription : public Subscription {
+ public:
+  explicit UringInputSubscription(
+      boost::intrusive_ptr<UringReaderWriter> readerWriter)
+      : readerWriter_(std::move(readerWriter)) {
+    CHECK(readerWriter_);
+  }
+
+  void request(int64_t n) noexcept override {
+    DCHECK(readerWriter_);
+    DCHECK_EQ(n, std::numeric_limits<int64_t>::max())
+        << "UringDuplexConnection doesnt support proper flow control";
+  }
+
+  void cancel() noexcept override {
+    readerWriter_->setInput(nullptr);
+    readerWriter_ = nullptr;
+  }
+
+ private:
+  boost::intrusive_ptr<UringReaderWriter> readerWriter_;
+};
+
+} // namespace
+
+UringDuplexConnection::UringDuplexConnection(
+    folly::NetworkSocket fd,
+    folly::EventBase& evb,
+    Options options,
+    std::shared_ptr<RSocketStats> stats)
+    : stats_(stats) {
+  auto const rawFd = fd.toFd();
+  auto fdGuard = folly::makeGuard([&] { ::close(rawFd); });
+  auto& ring = UringRing::get(evb, options.ring);
+  fdGuard.dismiss();
+
+  if (options.noDelay) {
+    int one = 1;
+    ::setsockopt(rawFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  readerWriter_.reset(new UringReaderWriter(rawFd, ring, std::move(stats)));
+  if (stats_) {
+    stats_->duplexConnectionCreated("uring", this);
+  }
+}
+
+UringDuplexConnection::~UringDuplexConnection() {
+  if (stats_) {
+    stats_->duplexConnectionClosed("uring", this);
+  }
+  readerWriter_->close();
+}
+
+const UringRing& UringDuplexConnection::getRing() const {
+  return readerWriter_->getRing();
+}
+
+void UringDuplexConnection::send(std::unique_ptr<folly::IOBuf> buf) {
+  if (readerWriter_) {
+    readerWriter_->send(std::move(buf));
+  }
+}
+
+void UringDuplexConnection::setInput(
+    std::shared_ptr<DuplexConnection::Subscriber> inputSubscriber) {
+  // we don't care if the subscriber will call request synchronously
+  inputSubscriber->onSubscribe(
+      std::make_shared<UringInputSubscription>(readerWriter_));
+  readerWriter_->setInput(std::move(inputSubscriber));
+}
+
+} // namespace rsocket
@@ -0,0 +1,72 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <folly/net/NetworkSocket.h>
+
+#include "rsocket/DuplexConnection.h"
+#include "rsocket/RSocketStats.h"
+#include "rsocket/transports/uring/UringRing.h"
+
+namespace folly {
+class EventBase;
+}
+
+namespace rsocket {
+
+class UringReaderWriter;
+
+/// DuplexConnection over a connected TCP socket, driven by the io_uring
+/// shared by all uring connections on the socket's EventBase.
+///
+/// Input is read with a multishot receive into the ring's provided buffers,
+/// so an idle connection has no pending syscall of its own.  Frames sent while
+/// a write is in flight, or during the same loop iteration, are written
+/// together with one sendmsg() request.
+class UringDuplexConnection : public DuplexConnection {
+ public:
+  struct Options {
+    /// Disable Nagle's algorithm on the socket.
+    bool noDelay{true};
+
+    /// Options for the EventBase's ring, if this connection is the first
+    /// uring object created on it.
+    UringRing::Options ring;
+  };
+
+  /// Takes ownership of `fd`.  Must be created, used and destroyed on the
+  /// `evb` thread.
+  UringDuplexConnection(
+      folly::NetworkSocket fd,
+      folly::EventBase& evb,
+      Options options = Options(),
+      std::shared_ptr<RSocketStats> stats = RSocketStats::noop());
+  ~UringDuplexConnection();
+
+  void send(std::unique_ptr<folly::IOBuf>) override;
+
+  void setInput(std::shared_ptr<DuplexConnection::Subscriber>) override;
+
+  /// The ring this connection submits to.  Only to be used for observation
+  /// purposes.
+  const UringRing& getRing() const;
+
+ private:
+  boost::intrusive_ptr<UringReaderWriter> readerWriter_;
+  std::shared_ptr<RSocketStats> stats_;
+};
+
+} // namespace rsocket
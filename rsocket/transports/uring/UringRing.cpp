@@ -0,0 +1,194 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rsocket/transports/uring/UringRing.h"
+
+#include <folly/Exception.h>
+#include <folly/ScopeGuard.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace rsocket {
+
+constexpr uint16_t UringRing::kReceiveBufferGroup;
+
+namespace {
+
+folly::EventBaseLocal<std::unique_ptr<UringRing>>& rings() {
+  static auto* rings = new folly::EventBaseLocal<std::unique_ptr<UringRing>>();
+  return *rings;
+}
+
+} // namespace
+
+UringRing& UringRing::get(folly::EventBase& evb, const Options& options) {
+  DCHECK(evb.isInEventBaseThread());
+  return *rings().getOrCreateFn(
+      evb, [&] { return std::make_unique<UringRing>(evb, options); });
+}
+
+UringRing::UringRing(folly::EventBase& evb, const Options& options)
+    : evb_(&evb), options_(options) {
+  CHECK(folly::isPowTwo(options_.receiveBuffers));
+
+  io_uring_params params{};
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = 2 * options_.entries;
+  auto ret = io_uring_queue_init_params(options_.entries, &ring_, &params);
+  if (ret < 0) {
+    folly::throwSystemErrorExplicit(-ret, "Failed to set up io_uring");
+  }
+  auto ringGuard = folly::makeGuard([&] { io_uring_queue_exit(&ring_); });
+
+  eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  folly::checkUnixError(eventFd_, "Failed to create io_uring eventfd");
+  auto eventFdGuard = folly::makeGuard([&] { ::close(eventFd_); });
+
+  ret = io_uring_register_eventfd(&ring_, eventFd_);
+  if (ret < 0) {
+    folly::throwSystemErrorExplicit(-ret, "Failed to register eventfd");
+  }
+
+  bufferRing_ = io_uring_setup_buf_ring(
+      &ring_, options_.receiveBuffers, kReceiveBufferGroup, 0, &ret);
+  if (!bufferRing_) {
+    folly::throwSystemErrorExplicit(-ret, "Failed to register buffer ring");
+  }
+  bufferMemory_.reset(
+      new uint8_t[options_.receiveBuffers * options_.receiveBufferSize]);
+  auto const mask = io_uring_buf_ring_mask(options_.receiveBuffers);
+  for (unsigned i = 0; i < options_.receiveBuffers; ++i) {
+    io_uring_buf_ring_add(
+        bufferRing_,
+        bufferMemory_.get() + i * options_.receiveBufferSize,
+        static_cast<unsigned>(options_.receiveBufferSize),
+        static_cast<unsigned short>(i),
+        mask,
+        static_cast<int>(i));
+  }
+  io_uring_buf_ring_advance(bufferRing_, options_.receiveBuffers);
+
+  initHandler(evb_, folly::NetworkSocket::fromFd(eventFd_));
+  registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+
+  eventFdGuard.dismiss();
+  ringGuard.dismiss();
+}
+
+UringRing::~UringRing() {
+  unregisterHandler();
+  cancelLoopCallback();
+  io_uring_free_buf_ring(
+      &ring_, bufferRing_, options_.receiveBuffers, kReceiveBufferGroup);
+  io_uring_queue_exit(&ring_);
+  ::close(eventFd_);
+}
+
+io_uring_sqe* UringRing::nextSqe() {
+  auto sqe = io_uring_get_sqe(&ring_);
+  if (!sqe) {
+    // The submission queue is full, hand it over now rather than at the end
+    // of the loop.
+    submit();
+    sqe = io_uring_get_sqe(&ring_);
+    CHECK(sqe) << "io_uring submission queue is still full";
+  }
+  scheduleSubmit();
+  return sqe;
+}
+
+void UringRing::runBeforeSubmit(folly::Function<void()> callback) {
+  beforeSubmit_.push_back(std::move(callback));
+  scheduleSubmit();
+}
+
+const uint8_t* UringRing::receiveBuffer(uint32_t flags) const {
+  DCHECK(flags & IORING_CQE_F_BUFFER);
+  auto const id = flags >> IORING_CQE_BUFFER_SHIFT;
+  return bufferMemory_.get() + id * options_.receiveBufferSize;
+}
+
+void UringRing::recycleReceiveBuffer(uint32_t flags) {
+  DCHECK(flags & IORING_CQE_F_BUFFER);
+  auto const id = flags >> IORING_CQE_BUFFER_SHIFT;
+  io_uring_buf_ring_add(
+      bufferRing_,
+      bufferMemory_.get() + id * options_.receiveBufferSize,
+      static_cast<unsigned>(options_.receiveBufferSize),
+      static_cast<unsigned short>(id),
+      io_uring_buf_ring_mask(options_.receiveBuffers),
+      0);
+  io_uring_buf_ring_advance(bufferRing_, 1);
+}
+
+void UringRing::handlerReady(uint16_t) noexcept {
+  eventfd_t value;
+  ::eventfd_read(eventFd_, &value);
+  ++stats_.wakeups;
+  reapCompletions();
+}
+
+void UringRing::runLoopCallback() noexcept {
+  submitScheduled_ = false;
+
+  auto callbacks = std::move(beforeSubmit_);
+  beforeSubmit_.clear();
+  for (auto& callback : callbacks) {
+    callback();
+  }
+
+  submit();
+}
+
+void UringRing::scheduleSubmit() {
+  if (!submitScheduled_) {
+    submitScheduled_ = true;
+    evb_->runInLoop(this);
+  }
+}
+
+void UringRing::submit() {
+  if (io_uring_sq_ready(&ring_) == 0) {
+    return;
+  }
+  auto const ret = io_uring_submit(&ring_);
+  ++stats_.submits;
+  if (ret < 0) {
+    LOG(ERROR) << "io_uring_submit failed: " << folly::errnoStr(-ret);
+    // Whatever is left in the queue goes out with the next batch.
+    scheduleSubmit();
+    return;
+  }
+  stats_.submitted += static_cast<size_t>(ret);
+}
+
+void UringRing::reapCompletions() {
+  io_uring_cqe* cqe;
+  while (io_uring_peek_cqe(&ring_, &cqe) == 0) {
+    auto const operation = static_cast<Operation*>(io_uring_cqe_get_data(cqe));
+    auto const res = cqe->res;
+    auto const flags = cqe->flags;
+    io_uring_cqe_seen(&ring_, cqe);
+
+    ++stats_.completions;
+    if (operation) {
+      operation->onCompletion(res, flags);
+    }
+  }
+}
+
+} // namespace rsocket
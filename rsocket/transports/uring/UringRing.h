@@ -0,0 +1,144 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventHandler.h>
+#include <liburing.h>
+
+#include <memory>
+#include <vector>
+
+namespace rsocket {
+
+/// An io_uring instance shared by every uring transport object on one
+/// EventBase.
+///
+/// Submissions are batched across connections: SQEs prepared during an
+/// EventBase loop iteration are handed to the kernel with a single
+/// io_uring_enter() at the end of it.  Completions are signalled through an
+/// eventfd that the EventBase watches, and are dispatched to the Operation
+/// whose address was stored as the SQE's user data.
+///
+/// The ring also owns a pool of receive buffers, registered with the kernel
+/// as a provided buffer ring, for multishot receives.
+///
+/// Not thread safe; use from the EventBase thread only.
+class UringRing : private folly::EventHandler,
+                  private folly::EventBase::LoopCallback {
+ public:
+  struct Options {
+    /// Size of the submission queue.  The completion queue is twice as large.
+    unsigned entries{1024};
+
+    /// Number of provided receive buffers.  Must be a power of two.
+    unsigned receiveBuffers{512};
+
+    /// Size of each provided receive buffer.
+    size_t receiveBufferSize{16 * 1024};
+  };
+
+  /// An in-flight request.  Must outlive all of its completions, including
+  /// every completion of a multishot request.
+  class Operation {
+   public:
+    virtual ~Operation() = default;
+
+    /// `res` and `flags` are the CQE's result and flags.
+    virtual void onCompletion(int32_t res, uint32_t flags) noexcept = 0;
+  };
+
+  /// Syscall counters, to weigh against the number of frames moved.
+  struct Stats {
+    /// io_uring_enter() calls made to submit SQEs.
+    size_t submits{0};
+    /// SQEs submitted.
+    size_t submitted{0};
+    /// Completions dispatched.
+    size_t completions{0};
+    /// Reads of the completion eventfd.
+    size_t wakeups{0};
+  };
+
+  /// The ring for `evb`, created with `options` on first use.  Must be called
+  /// from the EventBase thread.
+  static UringRing& get(folly::EventBase& evb, const Options& options);
+  static UringRing& get(folly::EventBase& evb) {
+    return get(evb, Options());
+  }
+
+  UringRing(folly::EventBase& evb, const Options& options);
+  ~UringRing() override;
+
+  folly::EventBase& getEventBase() const {
+    return *evb_;
+  }
+
+  /// Fill in a fresh SQE with `prep`, and point its user data at
+  /// `operation`.  The SQE is submitted at the end of the current loop
+  /// iteration.
+  template <typename Prep>
+  void prepare(Operation& operation, Prep&& prep) {
+    auto const sqe = nextSqe();
+    prep(sqe);
+    io_uring_sqe_set_data(sqe, &operation);
+  }
+
+  /// Run `callback` right before the next batch is submitted, so it can still
+  /// prepare SQEs for it.  Used to coalesce the writes of a loop iteration.
+  void runBeforeSubmit(folly::Function<void()> callback);
+
+  /// Buffer group to use with IOSQE_BUFFER_SELECT receives.
+  uint16_t receiveBufferGroup() const {
+    return kReceiveBufferGroup;
+  }
+
+  /// Data of the provided buffer selected by a receive completion with
+  /// `flags`.  Must be handed back with recycleReceiveBuffer().
+  const uint8_t* receiveBuffer(uint32_t flags) const;
+  void recycleReceiveBuffer(uint32_t flags);
+
+  const Stats& stats() const {
+    return stats_;
+  }
+
+ private:
+  static constexpr uint16_t kReceiveBufferGroup = 0;
+
+  void handlerReady(uint16_t events) noexcept override;
+  void runLoopCallback() noexcept override;
+
+  io_uring_sqe* nextSqe();
+  void scheduleSubmit();
+  void submit();
+  void reapCompletions();
+
+  folly::EventBase* const evb_;
+  const Options options_;
+
+  io_uring ring_;
+  int eventFd_{-1};
+
+  io_uring_buf_ring* bufferRing_{nullptr};
+  std::unique_ptr<uint8_t[]> bufferMemory_;
+
+  std::vector<folly::Function<void()>> beforeSubmit_;
+  bool submitScheduled_{false};
+
+  Stats stats_;
+};
+
+} // namespace rsocket